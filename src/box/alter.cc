@@ -668,6 +668,17 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 			 "local space can't be synchronous");
 		return NULL;
 	}
+	if (opts.compression == compression_type_MAX) {
+		diag_set(ClientError, errcode, tt_cstr(name, name_len),
+			 "unknown compression type");
+		return NULL;
+	}
+	if (opts.dense_field_map &&
+	    opts.compression != COMPRESSION_TYPE_NONE) {
+		diag_set(ClientError, errcode, tt_cstr(name, name_len),
+			 "dense field map can't be used with compression");
+		return NULL;
+	}
 	struct space_def *def =
 		space_def_new(id, uid, exact_field_count, name, name_len,
 			      engine_name, engine_name_len, &opts, fields,
@@ -2439,6 +2450,12 @@ on_replace_dd_space(struct trigger * /* trigger */, void *event)
 				  "a view and vice versa");
 			return -1;
 		}
+		if (def->opts.compression != old_space->def->opts.compression) {
+			diag_set(ClientError, ER_ALTER_SPACE,
+				  space_name(old_space),
+				  "space compression is immutable");
+			return -1;
+		}
 		if (strcmp(def->name, old_space->def->name) != 0 &&
 		    old_space->def->view_ref_count > 0) {
 			diag_set(ClientError, ER_ALTER_SPACE,
@@ -4038,6 +4055,7 @@ grant_or_revoke(struct priv_def *priv)
 	struct user *grantee = user_by_id(priv->grantee_id);
 	if (grantee == NULL)
 		return 0;
+	++func_access_version;
 	/*
 	 * Grant a role to a user only when privilege type is 'execute'
 	 * and the role is specified.
@@ -765,11 +765,31 @@ applier_txn_rollback_cb(struct trigger *trigger, void *event)
 	return 0;
 }
 
+/** WAL write trigger of a transaction received by an applier. */
+struct applier_txn_wal_write_trigger {
+	struct trigger base;
+	/** Id of the instance the transaction was received from. */
+	uint32_t instance_id;
+	/** Time when the transaction was submitted to WAL. */
+	double submit_time;
+};
+
 static int
 applier_txn_wal_write_cb(struct trigger *trigger, void *event)
 {
-	(void) trigger;
 	(void) event;
+	struct applier_txn_wal_write_trigger *t =
+		(struct applier_txn_wal_write_trigger *)trigger;
+	/*
+	 * Look the applier up by id rather than keep a pointer
+	 * to it, because the applier may be deleted while the
+	 * transaction is being written.
+	 */
+	struct replica *replica = replica_by_id(t->instance_id);
+	if (replica != NULL && replica->applier != NULL) {
+		latency_collect(&replica->applier->wal_latency,
+				ev_monotonic_now(loop()) - t->submit_time);
+	}
 	/* Broadcast the WAL write across all appliers. */
 	trigger_run(&replicaset.applier.on_wal_write, NULL);
 	return 0;
@@ -1023,7 +1043,8 @@ applier_apply_tx(struct applier *applier, struct stailq *rows)
 	}
 
 	/* We are ready to submit txn to wal. */
-	struct trigger *on_rollback, *on_wal_write;
+	struct trigger *on_rollback;
+	struct applier_txn_wal_write_trigger *on_wal_write;
 	size_t size;
 	on_rollback = region_alloc_object(&txn->region, typeof(*on_rollback),
 					  &size);
@@ -1038,8 +1059,11 @@ applier_apply_tx(struct applier *applier, struct stailq *rows)
 	trigger_create(on_rollback, applier_txn_rollback_cb, NULL, NULL);
 	txn_on_rollback(txn, on_rollback);
 
-	trigger_create(on_wal_write, applier_txn_wal_write_cb, NULL, NULL);
-	txn_on_wal_write(txn, on_wal_write);
+	trigger_create(&on_wal_write->base, applier_txn_wal_write_cb,
+		       NULL, NULL);
+	on_wal_write->instance_id = applier->instance_id;
+	on_wal_write->submit_time = ev_monotonic_now(loop());
+	txn_on_wal_write(txn, &on_wal_write->base);
 
 	if (txn_commit_async(txn) < 0)
 		goto fail;
@@ -1126,7 +1150,9 @@ applier_subscribe(struct applier *applier)
 	 */
 	uint32_t id_filter = box_is_orphan() ? 0 : 1 << instance_id;
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock, replication_anon, id_filter);
+				 &vclock, replication_anon, id_filter,
+				 replication_space_filter,
+				 replication_space_filter_size);
 	coio_write_xrow(coio, &row);
 
 	/* Read SUBSCRIBE response */
@@ -1212,6 +1238,8 @@ applier_subscribe(struct applier *applier)
 	}
 
 	applier->lag = TIMEOUT_INFINITY;
+	latency_reset(&applier->apply_latency);
+	latency_reset(&applier->wal_latency);
 
 	/*
 	 * Register triggers to handle WAL writes and rollbacks.
@@ -1265,8 +1293,12 @@ applier_subscribe(struct applier *applier)
 					diag_raise();
 			}
 			applier_signal_ack(applier);
-		} else if (applier_apply_tx(applier, &rows) != 0) {
-			diag_raise();
+		} else {
+			if (applier_apply_tx(applier, &rows) != 0)
+				diag_raise();
+			latency_collect(&applier->apply_latency,
+					ev_monotonic_now(loop()) -
+					applier->last_row_time);
 		}
 
 		if (ibuf_used(ibuf) == 0)
@@ -1505,6 +1537,11 @@ applier_new(const char *uri)
 	assert(rc == 0 && applier->uri.service != NULL);
 	(void) rc;
 
+	if (latency_create(&applier->apply_latency) != 0)
+		goto fail_apply_latency;
+	if (latency_create(&applier->wal_latency) != 0)
+		goto fail_wal_latency;
+
 	applier->last_row_time = ev_monotonic_now(loop());
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
@@ -1512,6 +1549,15 @@ applier_new(const char *uri)
 	diag_create(&applier->diag);
 
 	return applier;
+
+fail_wal_latency:
+	latency_destroy(&applier->apply_latency);
+fail_apply_latency:
+	diag_set(OutOfMemory, sizeof(struct latency), "malloc",
+		 "struct latency");
+	ibuf_destroy(&applier->ibuf);
+	free(applier);
+	return NULL;
 }
 
 void
@@ -1522,6 +1568,8 @@ applier_delete(struct applier *applier)
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	diag_destroy(&applier->diag);
+	latency_destroy(&applier->apply_latency);
+	latency_destroy(&applier->wal_latency);
 	free(applier);
 }
 
@@ -38,6 +38,7 @@
 #include <small/ibuf.h>
 
 #include "fiber_cond.h"
+#include "latency.h"
 #include "trigger.h"
 #include "trivia/util.h"
 #include "uuid/tt_uuid.h"
@@ -93,6 +94,16 @@ struct applier {
 	ev_tstamp last_row_time;
 	/** Number of seconds this replica is behind the remote master */
 	ev_tstamp lag;
+	/**
+	 * Time it takes to apply a transaction received from
+	 * the master and submit it to WAL.
+	 */
+	struct latency apply_latency;
+	/**
+	 * Time it takes to write a transaction received from
+	 * the master to WAL.
+	 */
+	struct latency wal_latency;
 	/** The last box_error_code() logged to avoid log flooding */
 	uint32_t last_logged_errcode;
 	/** Remote instance ID. */
@@ -74,12 +74,14 @@
 #include "sql.h"
 #include "systemd.h"
 #include "call.h"
+#include "cursor.h"
 #include "func.h"
 #include "sequence.h"
 #include "sql_stmt_cache.h"
 #include "msgpack.h"
 #include "raft.h"
 #include "trivia/util.h"
+#include "info/info.h"
 
 static char status[64] = "unknown";
 
@@ -198,6 +200,16 @@ box_check_memtx_min_tuple_size(ssize_t memtx_min_tuple_size)
 		  "specified value is out of bounds");
 }
 
+static double
+box_check_memtx_defrag_threshold(double threshold)
+{
+	if (threshold < 0 || threshold >= 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_defrag_threshold",
+			  "the value must be >= 0 and < 1");
+	}
+	return threshold;
+}
+
 int
 box_process_rw(struct request *request, struct space *space,
 	       struct tuple **result)
@@ -206,8 +218,11 @@ box_process_rw(struct request *request, struct space *space,
 	bool return_tuple = false;
 	struct txn *txn = in_txn();
 	bool is_autocommit = txn == NULL;
-	if (is_autocommit && (txn = txn_begin()) == NULL)
-		return -1;
+	if (is_autocommit) {
+		if ((txn = txn_begin()) == NULL)
+			return -1;
+		txn_set_flag(txn, TXN_IS_AUTOCOMMIT);
+	}
 	assert(iproto_type_is_dml(request->type));
 	rmean_collect(rmean_box, request->type, 1);
 	if (access_check_space(space, PRIV_W) != 0)
@@ -643,6 +658,33 @@ box_check_replication_anon(void)
 	return anon;
 }
 
+/**
+ * Check box.cfg.replication_space_filter. If @a ids is not NULL,
+ * store the space ids in it. Return the number of ids.
+ */
+static int
+box_check_replication_space_filter(uint32_t *ids)
+{
+	int count = cfg_getarr_size("replication_space_filter");
+	for (int i = 0; i < count; i++) {
+		const char *str = cfg_getarr_elem("replication_space_filter",
+						  i);
+		char *end = NULL;
+		errno = 0;
+		unsigned long long id = str != NULL ?
+					strtoull(str, &end, 10) : 0;
+		if (str == NULL || end == str || *end != '\0' ||
+		    errno != 0 || id > BOX_SPACE_MAX) {
+			tnt_raise(ClientError, ER_CFG,
+				  "replication_space_filter",
+				  "expected an array of space ids");
+		}
+		if (ids != NULL)
+			ids[i] = id;
+	}
+	return count;
+}
+
 static void
 box_check_instance_uuid(struct tt_uuid *uuid)
 {
@@ -760,6 +802,28 @@ box_check_sql_cache_size(int size)
 	return 0;
 }
 
+static int
+box_check_net_cursor_max(int max)
+{
+	if (max < 1) {
+		diag_set(ClientError, ER_CFG, "net_cursor_max",
+			 "must be greater than zero");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+box_check_net_cursor_timeout(double timeout)
+{
+	if (timeout <= 0) {
+		diag_set(ClientError, ER_CFG, "net_cursor_timeout",
+			 "must be greater than zero");
+		return -1;
+	}
+	return 0;
+}
+
 void
 box_check_config(void)
 {
@@ -784,6 +848,7 @@ box_check_config(void)
 	if (box_check_replication_synchro_timeout() < 0)
 		diag_raise();
 	box_check_replication_sync_timeout();
+	box_check_replication_space_filter(NULL);
 	box_check_readahead(cfg_geti("readahead"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
@@ -791,9 +856,14 @@ box_check_config(void)
 	if (box_check_memory_quota("memtx_memory") < 0)
 		diag_raise();
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_defrag_threshold(cfg_getd("memtx_defrag_threshold"));
 	box_check_vinyl_options();
 	if (box_check_sql_cache_size(cfg_geti("sql_cache_size")) != 0)
 		diag_raise();
+	if (box_check_net_cursor_max(cfg_geti("net_cursor_max")) != 0)
+		diag_raise();
+	if (box_check_net_cursor_timeout(cfg_getd("net_cursor_timeout")) != 0)
+		diag_raise();
 }
 
 int
@@ -968,6 +1038,24 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_space_filter(void)
+{
+	int count = box_check_replication_space_filter(NULL);
+	uint32_t *ids = NULL;
+	if (count > 0) {
+		ids = (uint32_t *)calloc(count, sizeof(*ids));
+		if (ids == NULL) {
+			tnt_raise(OutOfMemory, count * sizeof(*ids),
+				  "calloc", "replication_space_filter");
+		}
+		box_check_replication_space_filter(ids);
+	}
+	free(replication_space_filter);
+	replication_space_filter = ids;
+	replication_space_filter_size = count;
+}
+
 void
 box_set_replication_anon(void)
 {
@@ -1137,6 +1225,17 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_defrag_threshold(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	double threshold = box_check_memtx_defrag_threshold(
+		cfg_getd("memtx_defrag_threshold"));
+	memtx_engine_set_defrag_threshold(memtx, threshold);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -1223,6 +1322,26 @@ box_set_net_msg_max(void)
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
+int
+box_set_net_cursor_max(void)
+{
+	int max = cfg_geti("net_cursor_max");
+	if (box_check_net_cursor_max(max) != 0)
+		return -1;
+	box_cursor_set_max(max);
+	return 0;
+}
+
+int
+box_set_net_cursor_timeout(void)
+{
+	double timeout = cfg_getd("net_cursor_timeout");
+	if (box_check_net_cursor_timeout(timeout) != 0)
+		return -1;
+	box_cursor_set_timeout(timeout);
+	return 0;
+}
+
 int
 box_set_prepared_stmt_cache_size(void)
 {
@@ -1378,6 +1497,60 @@ box_process1(struct request *request, box_tuple_t **result)
 	return box_process_rw(request, space, result);
 }
 
+int
+box_process_many(struct request *request, uint32_t *count)
+{
+	assert(request->type == IPROTO_INSERT_MANY ||
+	       request->type == IPROTO_REPLACE_MANY);
+	const char *data = request->tuple;
+	if (data == NULL || mp_typeof(*data) != MP_ARRAY) {
+		diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+		return -1;
+	}
+	uint32_t size = mp_decode_array(&data);
+	bool is_autocommit = in_txn() == NULL;
+	box_txn_savepoint_t *svp = NULL;
+	if (is_autocommit) {
+		if (box_txn_begin() != 0)
+			return -1;
+	} else if ((svp = box_txn_savepoint()) == NULL) {
+		return -1;
+	}
+	/*
+	 * Every tuple becomes a usual INSERT or REPLACE
+	 * statement, so the rows written to WAL and sent to
+	 * replicas do not differ from the ones of single tuple
+	 * requests, but they all go in one journal entry.
+	 */
+	struct request row;
+	memset(&row, 0, sizeof(row));
+	row.type = request->type == IPROTO_INSERT_MANY ?
+		   IPROTO_INSERT : IPROTO_REPLACE;
+	row.space_id = request->space_id;
+	row.index_base = request->index_base;
+	for (uint32_t i = 0; i < size; i++) {
+		if (mp_typeof(*data) != MP_ARRAY) {
+			diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+			goto rollback;
+		}
+		row.tuple = data;
+		mp_next(&data);
+		row.tuple_end = data;
+		if (box_process1(&row, NULL) != 0)
+			goto rollback;
+	}
+	if (is_autocommit && box_txn_commit() != 0)
+		return -1;
+	*count = size;
+	return 0;
+rollback:
+	if (is_autocommit)
+		box_txn_rollback();
+	else
+		box_txn_rollback_to_savepoint(svp);
+	return -1;
+}
+
 API_EXPORT int
 box_select(uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
@@ -2064,8 +2237,11 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	vclock_create(&replica_clock);
 	bool anon;
 	uint32_t id_filter;
+	uint32_t *space_filter;
+	uint32_t space_filter_size;
 	xrow_decode_subscribe_xc(header, NULL, &replica_uuid, &replica_clock,
-				 &replica_version_id, &anon, &id_filter);
+				 &replica_version_id, &anon, &id_filter,
+				 &space_filter, &space_filter_size);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -2194,7 +2370,8 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id, id_filter);
+			replica_version_id, id_filter, space_filter,
+			space_filter_size);
 }
 
 void
@@ -2270,9 +2447,11 @@ engine_init()
 				    cfg_getd("memtx_memory"),
 				    cfg_geti("memtx_min_tuple_size"),
 				    cfg_geti("strip_core"),
+				    cfg_geti("memtx_use_huge_pages"),
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_defrag_threshold();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -2668,6 +2847,8 @@ box_cfg_xc(void)
 	fiber_pool_create(&tx_fiber_pool, "tx",
 			  IPROTO_MSG_MAX_MIN * IPROTO_FIBER_POOL_SIZE_FACTOR,
 			  FIBER_POOL_IDLE_TIMEOUT);
+	fiber_pool_set_classifier(&tx_fiber_pool, iproto_msg_class_MAX,
+				  iproto_msg_class);
 	/* Add an extra endpoint for WAL wake up/rollback messages. */
 	cbus_endpoint_create(&tx_prio_endpoint, "tx_prio", tx_prio_cb, &tx_prio_endpoint);
 
@@ -2699,6 +2880,9 @@ box_cfg_xc(void)
 	if (box_set_prepared_stmt_cache_size() != 0)
 		diag_raise();
 	box_set_net_msg_max();
+	if (box_set_net_cursor_max() != 0 ||
+	    box_set_net_cursor_timeout() != 0)
+		diag_raise();
 	box_set_readahead();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
@@ -2711,6 +2895,7 @@ box_cfg_xc(void)
 		diag_raise();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_space_filter();
 	box_set_replication_anon();
 
 	struct gc_checkpoint *checkpoint = gc_last_checkpoint();
@@ -2919,4 +3104,40 @@ box_reset_stat(void)
 	rmean_cleanup(rmean_error);
 	engine_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
+	fiber_pool_reset_stat(&tx_fiber_pool);
+}
+
+void
+box_set_net_msg_class(int cls, int weight, int max_size)
+{
+	fiber_pool_set_class(&tx_fiber_pool, cls, weight, max_size);
+}
+
+void
+box_use_net_msg_classes(bool use_classes)
+{
+	fiber_pool_use_classes(&tx_fiber_pool, use_classes);
+}
+
+void
+box_net_msg_class_stat(struct info_handler *h)
+{
+	info_begin(h);
+	for (int i = 0; i < iproto_msg_class_MAX; i++) {
+		struct fiber_pool_class *cls = &tx_fiber_pool.classes[i];
+		info_table_begin(h, iproto_msg_class_strs[i]);
+		info_append_int(h, "queued", cls->queue_size);
+		info_append_int(h, "running", cls->size);
+		info_append_int(h, "total", cls->total);
+		info_table_begin(h, "queue_time");
+		info_append_double(h, "p50",
+				   fiber_pool_class_queue_time(cls, 50));
+		info_append_double(h, "p90",
+				   fiber_pool_class_queue_time(cls, 90));
+		info_append_double(h, "p99",
+				   fiber_pool_class_queue_time(cls, 99));
+		info_table_end(h);
+		info_table_end(h);
+	}
+	info_end(h);
 }
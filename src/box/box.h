@@ -50,6 +50,7 @@ struct xrow_header;
 struct obuf;
 struct ev_io;
 struct auth_request;
+struct info_handler;
 struct space;
 struct vclock;
 
@@ -182,6 +183,26 @@ const char *box_status(void);
 void
 box_reset_stat(void);
 
+/**
+ * Set the weight and the limit on the number of fibers of a
+ * class of requests, see box.cfg.net_msg_classes.
+ */
+void
+box_set_net_msg_class(int cls, int weight, int max_size);
+
+/**
+ * Turn scheduling of requests by classes on or off.
+ */
+void
+box_use_net_msg_classes(bool use_classes);
+
+/**
+ * Queue sizes and queue time of classes of requests, shown in
+ * box.stat.classes().
+ */
+void
+box_net_msg_class_stat(struct info_handler *h);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
@@ -241,6 +262,7 @@ void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_defrag_threshold(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
@@ -256,8 +278,11 @@ int box_set_replication_synchro_quorum(void);
 int box_set_replication_synchro_timeout(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_space_filter(void);
 void box_set_replication_anon(void);
 void box_set_net_msg_max(void);
+int box_set_net_cursor_max(void);
+int box_set_net_cursor_timeout(void);
 
 int
 box_set_prepared_stmt_cache_size(void);
@@ -517,6 +542,20 @@ box_session_push(const char *data, const char *data_end);
 int
 box_process1(struct request *request, box_tuple_t **result);
 
+/**
+ * Execute an INSERT_MANY or REPLACE_MANY request: insert or
+ * replace every tuple of the request->tuple array in one
+ * transaction, written to WAL as one journal entry. If a
+ * transaction is already active, the tuples are added to it
+ * and it is left open. Either all tuples are written, or none.
+ *
+ * @param[out] count Number of tuples written.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+int
+box_process_many(struct request *request, uint32_t *count);
+
 /**
  * Execute request on given space.
  *
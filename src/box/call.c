@@ -42,6 +42,7 @@
 #include "rmean.h"
 #include "small/obuf.h"
 #include "tt_static.h"
+#include "assoc.h"
 
 static const struct port_vtab port_msgpack_vtab;
 
@@ -138,16 +139,129 @@ box_module_reload(const char *name)
 	return -1;
 }
 
+/**
+ * Find a function prepared for CALL in the current session.
+ * Returns NULL if the function is not prepared or the prepared
+ * calls are invalidated by a change of privileges, functions
+ * or the session user.
+ */
+static struct func *
+prepared_call_find(struct session *session, uint32_t fid)
+{
+	struct mh_i32ptr_t *h = session->prepared_calls;
+	if (h == NULL)
+		return NULL;
+	if (session->prepared_calls_version != func_access_version ||
+	    session->prepared_calls_uid != effective_user()->uid) {
+		mh_i32ptr_clear(h);
+		return NULL;
+	}
+	mh_int_t k = mh_i32ptr_find(h, fid, NULL);
+	if (k == mh_end(h))
+		return NULL;
+	return (struct func *) mh_i32ptr_node(h, k)->val;
+}
+
+/**
+ * Check the access to a function and remember it as prepared
+ * for CALL in the current session.
+ */
+static int
+prepared_call_add(struct session *session, struct func *func)
+{
+	if (func_access_check(func) != 0)
+		return -1;
+	struct mh_i32ptr_t *h = session->prepared_calls;
+	if (h == NULL) {
+		h = mh_i32ptr_new();
+		if (h == NULL) {
+			diag_set(OutOfMemory, 0, "mh_i32ptr_new",
+				 "session prepared calls");
+			return -1;
+		}
+		session->prepared_calls = h;
+	}
+	if (session->prepared_calls_version != func_access_version ||
+	    session->prepared_calls_uid != effective_user()->uid) {
+		mh_i32ptr_clear(h);
+		session->prepared_calls_version = func_access_version;
+		session->prepared_calls_uid = effective_user()->uid;
+	}
+	const struct mh_i32ptr_node_t node = { func->def->fid, func };
+	if (mh_i32ptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		diag_set(OutOfMemory, 0, "mh_i32ptr_put",
+			 "session prepared calls");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Call a function by id. The access check is done only once
+ * for the session, until privileges or functions change.
+ */
+static int
+box_call_by_id(uint32_t fid, struct port *args, struct port *ret)
+{
+	struct session *session = current_session();
+	struct func *func = prepared_call_find(session, fid);
+	if (func != NULL)
+		return func_call_nocheck(func, args, ret);
+	func = func_by_id(fid);
+	if (func == NULL) {
+		diag_set(ClientError, ER_NO_SUCH_FUNCTION, int2str(fid));
+		return -1;
+	}
+	if (prepared_call_add(session, func) != 0)
+		return -1;
+	return func_call_nocheck(func, args, ret);
+}
+
 int
-box_process_call(struct call_request *request, struct port *port)
+box_prepare_call(struct call_request *request, struct port *port)
 {
-	rmean_collect(rmean_box, IPROTO_CALL, 1);
-	/**
-	 * Find the function definition and check access.
-	 */
 	const char *name = request->name;
 	assert(name != NULL);
 	uint32_t name_len = mp_decode_strl(&name);
+	struct func *func = func_by_name(name, name_len);
+	if (func == NULL) {
+		diag_set(ClientError, ER_NO_SUCH_FUNCTION,
+			 tt_cstr(name, name_len));
+		return -1;
+	}
+	if (prepared_call_add(current_session(), func) != 0)
+		return -1;
+	char data[16];
+	char *data_end = mp_encode_uint(data, func->def->fid);
+	port_c_create(port);
+	if (port_c_add_mp(port, data, data_end) != 0) {
+		port_destroy(port);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Find the function definition by name, check access and
+ * call the function.
+ */
+static int
+box_call_by_name(const char *name, struct port *args, struct port *ret)
+{
+	uint32_t name_len = mp_decode_strl(&name);
+	struct func *func = func_by_name(name, name_len);
+	if (func != NULL)
+		return func_call(func, args, ret);
+	if (access_check_universe_object(PRIV_X | PRIV_U, SC_FUNCTION,
+					 tt_cstr(name, name_len)) != 0)
+		return -1;
+	return box_lua_call(name, name_len, args, ret);
+}
+
+int
+box_process_call(struct call_request *request, struct port *port)
+{
+	rmean_collect(rmean_box, IPROTO_CALL, 1);
 	/* Transaction is not started. */
 	assert(!in_txn());
 
@@ -155,13 +269,10 @@ box_process_call(struct call_request *request, struct port *port)
 	struct port args;
 	port_msgpack_create(&args, request->args,
 			    request->args_end - request->args);
-	struct func *func = func_by_name(name, name_len);
-	if (func != NULL) {
-		rc = func_call(func, &args, port);
-	} else if ((rc = access_check_universe_object(PRIV_X | PRIV_U,
-				SC_FUNCTION, tt_cstr(name, name_len))) == 0) {
-		rc = box_lua_call(name, name_len, &args, port);
-	}
+	if (request->name != NULL)
+		rc = box_call_by_name(request->name, &args, port);
+	else
+		rc = box_call_by_id(request->func_id, &args, port);
 	if (rc != 0)
 		return -1;
 	if (in_txn() != NULL) {
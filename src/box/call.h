@@ -51,6 +51,16 @@ box_module_reload(const char *name);
 int
 box_process_call(struct call_request *request, struct port *port);
 
+/**
+ * Resolve the name of a CALL request to the function id, which
+ * is dumped to @a port, and check the access to the function
+ * once for the session. The function is called by id then
+ * without the name lookup and the access check, see
+ * IPROTO_PREPARE_CALL.
+ */
+int
+box_prepare_call(struct call_request *request, struct port *port);
+
 int
 box_process_eval(struct call_request *request, struct port *port);
 
@@ -0,0 +1,391 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "cursor.h"
+
+#include <string.h>
+#include <msgpuck.h>
+
+#include "assoc.h"
+#include "box.h"
+#include "diag.h"
+#include "error.h"
+#include "fiber.h"
+#include "index.h"
+#include "port.h"
+#include "schema.h"
+#include "session.h"
+#include "space.h"
+#include "tuple_compression.h"
+#include "small/region.h"
+#include "small/rlist.h"
+
+struct cursor {
+	/** Cursor id, unique within the session. */
+	uint32_t id;
+	/** Session the cursor is open in. */
+	struct session *session;
+	/** Space the cursor reads, for the access check. */
+	uint32_t space_id;
+	/**
+	 * Iterator positioned after the last fetched tuple, NULL
+	 * if the cursor reads a read view.
+	 */
+	struct iterator *it;
+	/**
+	 * Read view of a memtx primary index positioned after
+	 * the last fetched tuple, NULL if the cursor uses @a it.
+	 */
+	struct snapshot_iterator *snapshot;
+	/** Format of the space, to decompress @a snapshot data. */
+	struct tuple_format *format;
+	/** Time of the last fetch, for the idle timeout. */
+	double last_used;
+	/** Set while a fetch is in progress, it may yield. */
+	bool is_busy;
+	/** Set if the cursor is closed during a fetch. */
+	bool is_closed;
+	/** Link in cursor_lru. */
+	struct rlist in_lru;
+	/** Copy of the search key, the iterator refers to it. */
+	char key[0];
+};
+
+/** Maximal number of cursors open in a session. */
+static uint32_t cursor_max = CURSOR_MAX_DEFAULT;
+/** Time after which an unused cursor is closed. */
+static double cursor_timeout = CURSOR_TIMEOUT_DEFAULT;
+/**
+ * Cursors of all sessions which are not being fetched, the least
+ * recently used first.
+ */
+static RLIST_HEAD(cursor_lru);
+/** Closes cursors unused for cursor_timeout. */
+static struct ev_timer cursor_timer;
+
+static void
+cursor_delete(struct cursor *cursor)
+{
+	if (cursor->snapshot != NULL) {
+		cursor->snapshot->free(cursor->snapshot);
+		tuple_format_unref(cursor->format);
+	} else {
+		iterator_delete(cursor->it);
+	}
+	free(cursor);
+}
+
+/**
+ * Remove a cursor from its session and delete it, or leave it
+ * to the fetch in progress.
+ */
+static void
+cursor_close(struct cursor *cursor)
+{
+	struct mh_i32ptr_t *h = cursor->session->cursors;
+	mh_int_t k = mh_i32ptr_find(h, cursor->id, NULL);
+	assert(k != mh_end(h));
+	mh_i32ptr_del(h, k, NULL);
+	if (cursor->is_busy) {
+		cursor->is_closed = true;
+		return;
+	}
+	rlist_del_entry(cursor, in_lru);
+	cursor_delete(cursor);
+}
+
+static void
+cursor_timer_cb(ev_loop *loop, struct ev_timer *timer, int events);
+
+/** Arm the timer to fire when the least recently used expires. */
+static void
+cursor_timer_rearm(void)
+{
+	if (cursor_timer.cb == NULL)
+		ev_timer_init(&cursor_timer, cursor_timer_cb, 0, 0);
+	ev_timer_stop(loop(), &cursor_timer);
+	if (rlist_empty(&cursor_lru) || cursor_timeout == TIMEOUT_INFINITY)
+		return;
+	struct cursor *cursor = rlist_first_entry(&cursor_lru, struct cursor,
+						  in_lru);
+	double delay = cursor->last_used + cursor_timeout -
+		       ev_monotonic_now(loop());
+	ev_timer_set(&cursor_timer, MAX(delay, 0), 0);
+	ev_timer_start(loop(), &cursor_timer);
+}
+
+static void
+cursor_timer_cb(ev_loop *loop, struct ev_timer *timer, int events)
+{
+	(void)timer;
+	(void)events;
+	double now = ev_monotonic_now(loop);
+	struct cursor *cursor, *tmp;
+	rlist_foreach_entry_safe(cursor, &cursor_lru, in_lru, tmp) {
+		if (cursor->last_used + cursor_timeout > now)
+			break;
+		cursor_close(cursor);
+	}
+	cursor_timer_rearm();
+}
+
+void
+box_cursor_set_max(uint32_t max)
+{
+	cursor_max = max;
+}
+
+void
+box_cursor_set_timeout(double timeout)
+{
+	cursor_timeout = timeout;
+	cursor_timer_rearm();
+}
+
+/** Find a cursor of the current session by id. */
+static struct cursor *
+cursor_find(uint32_t id)
+{
+	struct mh_i32ptr_t *h = current_session()->cursors;
+	if (h != NULL) {
+		mh_int_t k = mh_i32ptr_find(h, id, NULL);
+		if (k != mh_end(h))
+			return (struct cursor *) mh_i32ptr_node(h, k)->val;
+	}
+	diag_set(ClientError, ER_NO_SUCH_CURSOR, id);
+	return NULL;
+}
+
+/**
+ * Check if a cursor can read a read view of the index instead
+ * of the index itself. This is the case for a full scan of a
+ * memtx primary index: the read view is the one a checkpoint
+ * uses, so the changes made between fetches neither skip nor
+ * repeat tuples of the result set.
+ */
+static bool
+cursor_can_use_snapshot(struct space *space, struct index *index,
+			int iterator, const char *key)
+{
+	if (!space_is_memtx(space) || index->def->iid != 0 ||
+	    iterator != ITER_ALL)
+		return false;
+	if (index->def->type != TREE && index->def->type != HASH)
+		return false;
+	return mp_decode_array(&key) == 0;
+}
+
+int
+box_cursor_open(uint32_t space_id, uint32_t index_id, int iterator,
+		const char *key, const char *key_end, uint32_t *id)
+{
+	struct session *session = current_session();
+	struct mh_i32ptr_t *h = session->cursors;
+	if (h != NULL && mh_size(h) >= cursor_max) {
+		diag_set(ClientError, ER_CURSOR_LIMIT, cursor_max);
+		return -1;
+	}
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL || access_check_space(space, PRIV_R) != 0)
+		return -1;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL)
+		return -1;
+	if (h == NULL) {
+		h = mh_i32ptr_new();
+		if (h == NULL) {
+			diag_set(OutOfMemory, 0, "mh_i32ptr_new",
+				 "session cursors");
+			return -1;
+		}
+		session->cursors = h;
+	}
+	if (key == NULL) {
+		static const char empty_key[] = { (char)0x90 };
+		key = empty_key;
+		key_end = empty_key + sizeof(empty_key);
+	}
+	size_t key_size = key_end - key;
+	size_t size = sizeof(struct cursor) + key_size;
+	struct cursor *cursor = (struct cursor *) malloc(size);
+	if (cursor == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "cursor");
+		return -1;
+	}
+	memcpy(cursor->key, key, key_size);
+	cursor->it = NULL;
+	cursor->snapshot = NULL;
+	cursor->format = NULL;
+	if (cursor_can_use_snapshot(space, index, iterator, key)) {
+		cursor->snapshot = index_create_snapshot_iterator(index);
+		if (cursor->snapshot == NULL) {
+			free(cursor);
+			return -1;
+		}
+		cursor->format = space->format;
+		tuple_format_ref(cursor->format);
+	} else {
+		cursor->it = box_index_iterator(space_id, index_id, iterator,
+						cursor->key,
+						cursor->key + key_size);
+		if (cursor->it == NULL) {
+			free(cursor);
+			return -1;
+		}
+	}
+	cursor->id = ++session->cursor_id_max;
+	cursor->session = session;
+	cursor->space_id = space_id;
+	cursor->is_busy = false;
+	cursor->is_closed = false;
+	const struct mh_i32ptr_node_t node = { cursor->id, cursor };
+	if (mh_i32ptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		diag_set(OutOfMemory, 0, "mh_i32ptr_put", "session cursors");
+		cursor_delete(cursor);
+		return -1;
+	}
+	cursor->last_used = ev_monotonic_now(loop());
+	rlist_add_tail_entry(&cursor_lru, cursor, in_lru);
+	if (!ev_is_active(&cursor_timer))
+		cursor_timer_rearm();
+	*id = cursor->id;
+	return 0;
+}
+
+/**
+ * Add the next tuple of a cursor to a port.
+ *
+ * @retval 0 Success.
+ * @retval 1 The cursor is exhausted.
+ * @retval -1 Error, diag is set.
+ */
+static int
+cursor_next(struct cursor *cursor, struct port *port)
+{
+	if (cursor->snapshot == NULL) {
+		struct tuple *tuple;
+		if (iterator_next(cursor->it, &tuple) != 0)
+			return -1;
+		if (tuple == NULL)
+			return 1;
+		return port_c_add_tuple(port, tuple);
+	}
+	const char *data;
+	uint32_t size;
+	if (cursor->snapshot->next(cursor->snapshot, &data, &size) != 0)
+		return -1;
+	if (data == NULL)
+		return 1;
+	const char *data_end = data + size;
+	struct region *region = &fiber()->gc;
+	size_t used = region_used(region);
+	if (cursor->format->compression != COMPRESSION_TYPE_NONE &&
+	    tuple_decompress_raw(cursor->format, &data, &data_end) != 0)
+		return -1;
+	int rc = port_c_add_mp(port, data, data_end);
+	region_truncate(region, used);
+	return rc;
+}
+
+int
+box_cursor_fetch(uint32_t id, uint32_t limit, struct port *port)
+{
+	struct cursor *cursor = cursor_find(id);
+	if (cursor == NULL)
+		return -1;
+	if (cursor->is_busy) {
+		diag_set(ClientError, ER_CURSOR_BUSY, id);
+		return -1;
+	}
+	/* The user may have lost the access since the open. */
+	struct space *space = space_by_id(cursor->space_id);
+	if (space != NULL && access_check_space(space, PRIV_R) != 0)
+		return -1;
+	/* A vinyl iterator may yield, keep the cursor alive. */
+	cursor->is_busy = true;
+	rlist_del_entry(cursor, in_lru);
+
+	int rc = 0;
+	uint32_t found = 0;
+	port_c_create(port);
+	while (found < limit) {
+		rc = cursor_next(cursor, port);
+		if (rc != 0)
+			break;
+		found++;
+	}
+	if (rc > 0)
+		rc = 0;
+
+	cursor->is_busy = false;
+	if (cursor->is_closed) {
+		/* Closed by the timeout or with the session. */
+		cursor_delete(cursor);
+	} else if (rc == 0 && found < limit) {
+		/* Exhausted. */
+		rlist_create(&cursor->in_lru);
+		cursor_close(cursor);
+	} else {
+		cursor->last_used = ev_monotonic_now(loop());
+		rlist_add_tail_entry(&cursor_lru, cursor, in_lru);
+		/* The timer stops if it fires while the LRU is empty. */
+		if (!ev_is_active(&cursor_timer))
+			cursor_timer_rearm();
+	}
+	if (rc != 0) {
+		port_destroy(port);
+		return -1;
+	}
+	return 0;
+}
+
+int
+box_cursor_close(uint32_t id)
+{
+	struct cursor *cursor = cursor_find(id);
+	if (cursor == NULL)
+		return -1;
+	cursor_close(cursor);
+	return 0;
+}
+
+void
+box_cursor_close_all(struct session *session)
+{
+	struct mh_i32ptr_t *h = session->cursors;
+	if (h == NULL)
+		return;
+	while (mh_size(h) > 0) {
+		mh_int_t k = mh_first(h);
+		cursor_close((struct cursor *) mh_i32ptr_node(h, k)->val);
+	}
+	mh_i32ptr_delete(h);
+	session->cursors = NULL;
+}
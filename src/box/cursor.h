@@ -0,0 +1,105 @@
+#ifndef TARANTOOL_BOX_CURSOR_H_INCLUDED
+#define TARANTOOL_BOX_CURSOR_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct port;
+struct session;
+
+/**
+ * Server-side cursors: an index iterator kept open in a session
+ * between fetches, so that a big result set is read in batches
+ * without a new index lookup per batch. A full scan of a memtx
+ * primary index reads a read view of the index taken at the
+ * open. A cursor is closed when it is exhausted, on the idle
+ * timeout, or with the session.
+ */
+
+enum {
+	/** Default maximal number of cursors open in a session. */
+	CURSOR_MAX_DEFAULT = 64,
+	/**
+	 * Default time in seconds after which an unused cursor
+	 * is closed. A cursor over a memtx space pins a read
+	 * view, so it must not be left open forever.
+	 */
+	CURSOR_TIMEOUT_DEFAULT = 60,
+};
+
+/** Set the maximal number of cursors open in a session. */
+void
+box_cursor_set_max(uint32_t max);
+
+/** Set the time after which an unused cursor is closed. */
+void
+box_cursor_set_timeout(double timeout);
+
+/**
+ * Open a cursor over an index of a space in the current
+ * session.
+ *
+ * @param[out] id Cursor id, unique within the session.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+int
+box_cursor_open(uint32_t space_id, uint32_t index_id, int iterator,
+		const char *key, const char *key_end, uint32_t *id);
+
+/**
+ * Fetch up to @a limit tuples from a cursor of the current
+ * session to @a port. The cursor is closed if less than
+ * @a limit tuples are fetched.
+ *
+ * @retval 0 Success, the port is created.
+ * @retval -1 Error, diag is set.
+ */
+int
+box_cursor_fetch(uint32_t id, uint32_t limit, struct port *port);
+
+/** Close a cursor of the current session. */
+int
+box_cursor_close(uint32_t id);
+
+/** Close all cursors of a session. */
+void
+box_cursor_close_all(struct session *session);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_CURSOR_H_INCLUDED */
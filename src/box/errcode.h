@@ -273,6 +273,9 @@ struct errcode_record {
 	/*218 */_(ER_TUPLE_METADATA_IS_TOO_BIG,	"Can't create tuple: metadata size %u is too big") \
 	/*219 */_(ER_XLOG_GAP,			"%s") \
 	/*220 */_(ER_TOO_EARLY_SUBSCRIBE,	"Can't subscribe non-anonymous replica %s until join is done") \
+	/*221 */_(ER_NO_SUCH_CURSOR,		"Cursor %u does not exist") \
+	/*222 */_(ER_CURSOR_LIMIT,		"Too many cursors open in the session, the limit is %u") \
+	/*223 */_(ER_CURSOR_BUSY,		"Cursor %u is being fetched") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
@@ -38,6 +38,7 @@ field_map_builder_create(struct field_map_builder *builder,
 			 struct region *region)
 {
 	builder->extents_size = 0;
+	builder->dense_extent = NULL;
 	builder->slot_count = minimal_field_map_size / sizeof(uint32_t);
 	if (minimal_field_map_size == 0) {
 		builder->slots = NULL;
@@ -75,10 +76,55 @@ field_map_builder_slot_extent_new(struct field_map_builder *builder,
 	extent->size = multikey_count;
 	builder->slots[offset_slot].extent = extent;
 	builder->slots[offset_slot].has_extent = true;
-	builder->extents_size += sz;
+	/* Size of the extent in the built field map. */
+	builder->extents_size += sizeof(uint32_t) +
+				 multikey_count * sizeof(uint32_t);
 	return extent;
 }
 
+struct field_map_builder_slot_extent *
+field_map_builder_dense_extent_new(struct field_map_builder *builder,
+				   int32_t offset_slot, uint32_t field_count,
+				   struct region *region)
+{
+	assert(builder->dense_extent == NULL);
+	assert(!builder->slots[offset_slot].has_extent);
+	struct field_map_builder_slot_extent *extent;
+	uint32_t sz = sizeof(*extent) +
+		      field_count * sizeof(extent->offset[0]);
+	extent = (struct field_map_builder_slot_extent *)
+		region_aligned_alloc(region, sz, alignof(*extent));
+	if (extent == NULL) {
+		diag_set(OutOfMemory, sz, "region_aligned_alloc", "extent");
+		return NULL;
+	}
+	extent->size = field_count;
+	builder->slots[offset_slot].extent = extent;
+	builder->slots[offset_slot].has_extent = true;
+	builder->dense_extent = extent;
+	return extent;
+}
+
+/** Dump the dense extent in its compact form if possible. */
+static char *
+field_map_build_dense_extent(struct field_map_builder_slot_extent *extent,
+			     char *wptr)
+{
+	bool is_compact = field_map_dense_extent_is_compact(extent);
+	store_u32(wptr, extent->size << 1 | (is_compact ? 1 : 0));
+	wptr += sizeof(uint32_t);
+	if (!is_compact) {
+		uint32_t sz = extent->size * sizeof(uint32_t);
+		memcpy(wptr, extent->offset, sz);
+		return wptr + sz;
+	}
+	for (uint32_t i = 0; i < extent->size; i++) {
+		store_u16(wptr, extent->offset[i]);
+		wptr += sizeof(uint16_t);
+	}
+	return wptr;
+}
+
 void
 field_map_build(struct field_map_builder *builder, char *buffer)
 {
@@ -115,11 +161,18 @@ field_map_build(struct field_map_builder *builder, char *buffer)
 						builder->slots[i].extent;
 		/** Retrive memory for the extent. */
 		store_u32(&field_map[i], extent_wptr - (char *)field_map);
+		if (extent == builder->dense_extent) {
+			extent_wptr = field_map_build_dense_extent(extent,
+								   extent_wptr);
+			continue;
+		}
 		store_u32(extent_wptr, extent->size);
 		uint32_t extent_offset_sz = extent->size * sizeof(uint32_t);
 		memcpy(&((uint32_t *) extent_wptr)[1], extent->offset,
 			extent_offset_sz);
 		extent_wptr += sizeof(uint32_t) + extent_offset_sz;
 	}
-	assert(extent_wptr == buffer + builder->extents_size);
+	assert(extent_wptr == buffer + builder->extents_size +
+	       (builder->dense_extent == NULL ? 0 :
+		field_map_dense_extent_size(builder->dense_extent)));
 }
@@ -79,6 +79,13 @@ enum { MULTIKEY_NONE = -1 };
  * represents int32_t negative value - the offset relative to
  * the field_map pointer. The i-th extent's slot contains the
  * positive offset of the i-th key field of the multikey index.
+ *
+ * A space may also ask for a dense extent which holds offsets
+ * of all top-level fields of the tuple, indexed or not. It has
+ * the form [cnt << 1 | is_compact|off0|..|offN-1], where the
+ * offsets are 16-bit when is_compact is set and 32-bit
+ * otherwise. Its slot is never used by indexes, so it holds
+ * the negative extent offset as is.
  */
 struct field_map_builder {
 	/**
@@ -97,6 +104,12 @@ struct field_map_builder {
 	 * extents.
 	 */
 	uint32_t extents_size;
+	/**
+	 * The dense extent if any. It is told from multikey
+	 * extents by this pointer and is accounted separately,
+	 * because its size depends on the offsets stored in it.
+	 */
+	struct field_map_builder_slot_extent *dense_extent;
 };
 
 /**
@@ -198,6 +211,55 @@ field_map_builder_slot_extent_new(struct field_map_builder *builder,
 				  int32_t offset_slot, uint32_t multikey_count,
 				  struct region *region);
 
+/**
+ * Allocate the dense extent for @a field_count top-level fields
+ * by offset_slot. The caller fills the offsets in ascending
+ * order before the field map size is calculated.
+ */
+struct field_map_builder_slot_extent *
+field_map_builder_dense_extent_new(struct field_map_builder *builder,
+				   int32_t offset_slot, uint32_t field_count,
+				   struct region *region);
+
+/** True if offsets of the dense extent fit in 16 bits. */
+static inline bool
+field_map_dense_extent_is_compact(struct field_map_builder_slot_extent *extent)
+{
+	return extent->size == 0 ||
+	       extent->offset[extent->size - 1] <= UINT16_MAX;
+}
+
+/** Size of the dense extent in the built field map. */
+static inline uint32_t
+field_map_dense_extent_size(struct field_map_builder_slot_extent *extent)
+{
+	uint32_t offset_size = field_map_dense_extent_is_compact(extent) ?
+			       sizeof(uint16_t) : sizeof(uint32_t);
+	return sizeof(uint32_t) + extent->size * offset_size;
+}
+
+/**
+ * Get offset of the top-level field @a fieldno from the dense
+ * extent referenced by offset_slot. Returns 0 if the tuple
+ * has no dense extent or no such field.
+ */
+static inline uint32_t
+field_map_get_dense_offset(const uint32_t *field_map, int32_t offset_slot,
+			   uint32_t fieldno)
+{
+	int32_t extent_offset = (int32_t)load_u32(&field_map[offset_slot]);
+	if (extent_offset == 0)
+		return 0;
+	const char *extent = (const char *)field_map + extent_offset;
+	uint32_t header = load_u32(extent);
+	if (fieldno >= header >> 1)
+		return 0;
+	extent += sizeof(uint32_t);
+	if ((header & 1) != 0)
+		return load_u16(extent + fieldno * sizeof(uint16_t));
+	return load_u32(extent + fieldno * sizeof(uint32_t));
+}
+
 /**
  * Set data offset for a field identified by unique offset_slot.
  *
@@ -245,8 +307,11 @@ field_map_builder_set_slot(struct field_map_builder *builder,
 static inline uint32_t
 field_map_build_size(struct field_map_builder *builder)
 {
-	return builder->slot_count * sizeof(uint32_t) +
-	       builder->extents_size;
+	uint32_t size = builder->slot_count * sizeof(uint32_t) +
+			builder->extents_size;
+	if (builder->dense_extent != NULL)
+		size += field_map_dense_extent_size(builder->dense_extent);
+	return size;
 }
 
 /**
@@ -603,8 +603,7 @@ func_delete(struct func *func)
 	free(def);
 }
 
-/** Check "EXECUTE" permissions for a given function. */
-static int
+int
 func_access_check(struct func *func)
 {
 	struct credentials *credentials = effective_user();
@@ -640,6 +639,12 @@ func_call(struct func *base, struct port *args, struct port *ret)
 {
 	if (func_access_check(base) != 0)
 		return -1;
+	return func_call_nocheck(base, args, ret);
+}
+
+int
+func_call_nocheck(struct func *base, struct port *args, struct port *ret)
+{
 	/**
 	 * Change the current user id if the function is
 	 * a set-definer-uid one. If the function is not
@@ -108,6 +108,17 @@ func_delete(struct func *func);
 int
 func_call(struct func *func, struct port *args, struct port *ret);
 
+/** Check "EXECUTE" permissions for a given function. */
+int
+func_access_check(struct func *func);
+
+/**
+ * Call function without the access check, which is done by the
+ * caller with func_access_check().
+ */
+int
+func_call_nocheck(struct func *func, struct port *args, struct port *ret);
+
 /**
  * Reload dynamically loadable module.
  *
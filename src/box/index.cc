@@ -38,9 +38,12 @@
 #include "txn.h"
 #include "rmean.h"
 #include "info/info.h"
+#include "crc32.h"
 
 /* {{{ Utilities. **********************************************/
 
+const char *aggregate_func_strs[] = { "count", "sum", "min", "max" };
+
 UnsupportedIndexFeature::UnsupportedIndexFeature(const char *file,
 	unsigned line, struct index_def *index_def, const char *what)
 	: ClientError(file, line, ER_UNKNOWN)
@@ -431,6 +434,167 @@ box_index_compact(uint32_t space_id, uint32_t index_id)
 	return 0;
 }
 
+enum {
+	/** Number of tuples index:checksum() visits between yields. */
+	INDEX_CHECKSUM_YIELD_BATCH = 1000,
+};
+
+/**
+ * Calculate the checksum of a range over a read view of the
+ * index. The read view isn't affected by changes made while
+ * the function yields, so the result is consistent.
+ */
+static int
+index_checksum_read_view(struct snapshot_iterator *it,
+			 struct key_def *key_def, const char *end,
+			 uint32_t end_part_count, uint32_t *checksum,
+			 uint64_t *count)
+{
+	struct region *region = &fiber()->gc;
+	uint32_t crc = 0;
+	uint64_t found = 0;
+	const char *data;
+	uint32_t size;
+	while (true) {
+		/* Don't block tx on a big range. */
+		if (found > 0 && found % INDEX_CHECKSUM_YIELD_BATCH == 0)
+			fiber_sleep(0);
+		if (it->next(it, &data, &size) != 0)
+			return -1;
+		if (data == NULL)
+			break;
+		/* An empty end key means the range is unbounded. */
+		if (end_part_count > 0) {
+			size_t region_svp = region_used(region);
+			const char *key = tuple_extract_key_raw(data,
+								data + size,
+								key_def,
+								MULTIKEY_NONE,
+								NULL);
+			if (key == NULL)
+				return -1;
+			int cmp = key_compare(key, HINT_NONE, end, HINT_NONE,
+					      key_def);
+			region_truncate(region, region_svp);
+			if (cmp >= 0)
+				break;
+		}
+		crc = crc32_calc(crc, data, size);
+		found++;
+	}
+	*checksum = crc;
+	*count = found;
+	return 0;
+}
+
+int
+box_index_checksum(uint32_t space_id, uint32_t index_id,
+		   const char *begin, const char *begin_end,
+		   const char *end, const char *end_end,
+		   uint32_t *checksum, uint64_t *count)
+{
+	assert(begin != NULL && begin_end != NULL);
+	assert(end != NULL && end_end != NULL);
+	mp_tuple_assert(begin, begin_end);
+	mp_tuple_assert(end, end_end);
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	const char *end_key = end;
+	uint32_t begin_part_count = mp_decode_array(&begin);
+	if (key_validate(index->def, ITER_GE, begin, begin_part_count))
+		return -1;
+	uint32_t end_part_count = mp_decode_array(&end);
+	if (key_validate(index->def, ITER_LT, end, end_part_count))
+		return -1;
+	struct key_def *key_def = index->def->key_def;
+	/*
+	 * A transaction can't yield, so it scans the range at
+	 * once. Otherwise scan a read view, which lets us yield
+	 * without getting a checksum of a range that changed or
+	 * of an index that was dropped in the middle.
+	 */
+	if (in_txn() == NULL) {
+		struct snapshot_iterator *rv =
+			index_create_read_view_iterator(index, begin,
+							begin_part_count);
+		if (rv != NULL) {
+			int rc = index_checksum_read_view(rv, key_def,
+							  end_key,
+							  end_part_count,
+							  checksum, count);
+			rv->free(rv);
+			return rc;
+		}
+		struct error *e = diag_last_error(diag_get());
+		if (type_cast(UnsupportedIndexFeature, e) == NULL)
+			return -1;
+		diag_clear(diag_get());
+	}
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	struct iterator *it = index_create_iterator(index, ITER_GE, begin,
+						    begin_part_count);
+	if (it == NULL) {
+		txn_rollback_stmt(txn);
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	uint32_t crc = 0;
+	uint64_t found = 0;
+	struct tuple *tuple;
+	int rc;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		/* An empty end key means the range is unbounded. */
+		if (end_part_count > 0 &&
+		    tuple_compare_with_key(tuple, HINT_NONE, end,
+					   end_part_count, HINT_NONE,
+					   key_def) >= 0)
+			break;
+		uint32_t bsize;
+		const char *data = tuple_data_range(tuple, &bsize);
+		crc = crc32_calc(crc, data, bsize);
+		found++;
+	}
+	iterator_delete(it);
+	if (rc != 0)
+		return -1;
+	*checksum = crc;
+	*count = found;
+	return 0;
+}
+
+int
+box_index_aggregate(uint32_t space_id, uint32_t index_id,
+		    const struct index_aggregate *aggregate,
+		    char *result, char **result_end)
+{
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	uint32_t part_count = index->def->key_def->part_count;
+	if (aggregate->part >= part_count ||
+	    (aggregate->filter_type != ITER_ALL &&
+	     aggregate->filter_part >= part_count)) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "index part number is out of range");
+		return -1;
+	}
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	*result_end = index_aggregate(index, aggregate, result);
+	if (*result_end == NULL) {
+		txn_rollback_stmt(txn);
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	return 0;
+}
+
 /* }}} */
 
 /* {{{ Internal API */
@@ -698,6 +862,26 @@ generic_index_create_snapshot_iterator(struct index *index)
 	return NULL;
 }
 
+struct snapshot_iterator *
+generic_index_create_read_view_iterator(struct index *index, const char *key,
+					uint32_t part_count)
+{
+	(void)key;
+	(void)part_count;
+	diag_set(UnsupportedIndexFeature, index->def, "consistent read view");
+	return NULL;
+}
+
+char *
+generic_index_aggregate(struct index *index,
+			const struct index_aggregate *aggregate, char *result)
+{
+	(void)aggregate;
+	(void)result;
+	diag_set(UnsupportedIndexFeature, index->def, "aggregate()");
+	return NULL;
+}
+
 void
 generic_index_stat(struct index *index, struct info_handler *handler)
 {
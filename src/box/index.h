@@ -235,6 +235,93 @@ box_index_stat(uint32_t space_id, uint32_t index_id,
 int
 box_index_compact(uint32_t space_id, uint32_t index_id);
 
+/**
+ * Calculate a checksum of all tuples in the key range
+ * [begin, end) of an index (index:checksum()). Tuples are
+ * visited in index order and their MsgPack data is fed to
+ * crc32, so two instances holding the same rows in a range
+ * return the same value. Comparing checksums of ranges lets
+ * a lagging replica find the parts of a space that differ
+ * from the master without fetching all data.
+ *
+ * Outside a transaction the function scans a read view of
+ * a memtx TREE index and yields periodically not to block tx
+ * on a big range. The result reflects the index as of the
+ * call: neither changes nor DDL made during a yield affect
+ * it. Other indexes, and any index inside a transaction,
+ * are scanned at once without yields.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param begin encoded lower bound key, inclusive
+ * \param begin_end the end of encoded \a begin
+ * \param end encoded upper bound key, exclusive; an empty
+ *        key means the range is unbounded
+ * \param end_end the end of encoded \a end
+ * \param[out] checksum crc32 of tuples in the range
+ * \param[out] count number of tuples in the range
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_checksum(uint32_t space_id, uint32_t index_id,
+		   const char *begin, const char *begin_end,
+		   const char *end, const char *end_end,
+		   uint32_t *checksum, uint64_t *count);
+
+/** Aggregate functions supported by index:aggregate(). */
+enum aggregate_func {
+	AGGREGATE_COUNT,
+	AGGREGATE_SUM,
+	AGGREGATE_MIN,
+	AGGREGATE_MAX,
+	aggregate_func_MAX,
+};
+
+extern const char *aggregate_func_strs[];
+
+enum {
+	/** Max size of a MsgPack encoded aggregate result. */
+	INDEX_AGGREGATE_RESULT_MAX = 16,
+};
+
+/** Arguments of index:aggregate(). */
+struct index_aggregate {
+	/** Aggregate function. */
+	enum aggregate_func func;
+	/** Index key part the function is applied to. */
+	uint32_t part;
+	/**
+	 * Comparison applied to @a filter_part before
+	 * aggregation, ITER_ALL if all rows are aggregated.
+	 */
+	enum iterator_type filter_type;
+	/** Index key part the filter is applied to. */
+	uint32_t filter_part;
+	/** MsgPack value @a filter_part is compared with. */
+	const char *filter_value;
+};
+
+/**
+ * Compute an aggregate function over an index part, optionally
+ * restricted to rows whose other part matches a comparison
+ * (index:aggregate()). Supported only by indexes that store
+ * their parts column-wise.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param aggregate aggregate function and filter
+ * \param result buffer of INDEX_AGGREGATE_RESULT_MAX bytes
+ * \param[out] result_end the end of MsgPack encoded result,
+ *             nil if no rows matched min() or max()
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_aggregate(uint32_t space_id, uint32_t index_id,
+		    const struct index_aggregate *aggregate,
+		    char *result, char **result_end);
+
 struct iterator {
 	/**
 	 * Iterate to the next tuple.
@@ -425,6 +512,24 @@ struct index_vtab {
 	 * Must be destroyed by iterator_delete() after usage.
 	 */
 	struct snapshot_iterator *(*create_snapshot_iterator)(struct index *);
+	/**
+	 * Create a GE iterator over a personal read view of the
+	 * index, positioned at the first tuple not less than the
+	 * key. Tuples are returned in index order. Must be
+	 * destroyed by snapshot_iterator::free after usage.
+	 */
+	struct snapshot_iterator *(*create_read_view_iterator)(
+			struct index *index, const char *key,
+			uint32_t part_count);
+	/**
+	 * Compute an aggregate over the index (index:aggregate()).
+	 * The result is encoded in MsgPack into @a result, which
+	 * must be at least INDEX_AGGREGATE_RESULT_MAX bytes long.
+	 * Returns the end of the encoded result or NULL on error.
+	 */
+	char *(*aggregate)(struct index *index,
+			   const struct index_aggregate *aggregate,
+			   char *result);
 	/** Introspection (index:stat()) */
 	void (*stat)(struct index *, struct info_handler *);
 	/**
@@ -643,6 +748,20 @@ index_create_snapshot_iterator(struct index *index)
 	return index->vtab->create_snapshot_iterator(index);
 }
 
+static inline struct snapshot_iterator *
+index_create_read_view_iterator(struct index *index, const char *key,
+				uint32_t part_count)
+{
+	return index->vtab->create_read_view_iterator(index, key, part_count);
+}
+
+static inline char *
+index_aggregate(struct index *index, const struct index_aggregate *aggregate,
+		char *result)
+{
+	return index->vtab->aggregate(index, aggregate, result);
+}
+
 static inline void
 index_stat(struct index *index, struct info_handler *handler)
 {
@@ -707,6 +826,11 @@ int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
+struct snapshot_iterator *
+generic_index_create_read_view_iterator(struct index *, const char *,
+					uint32_t);
+char *generic_index_aggregate(struct index *, const struct index_aggregate *,
+			      char *);
 void generic_index_stat(struct index *, struct info_handler *);
 void generic_index_compact(struct index *);
 void generic_index_reset_stat(struct index *);
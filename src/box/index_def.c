@@ -35,7 +35,9 @@
 #include "json/json.h"
 #include "fiber.h"
 
-const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
+const char *index_type_strs[] = {
+	"HASH", "TREE", "BITSET", "RTREE", "COLUMN"
+};
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
@@ -51,6 +53,7 @@ const struct index_opts index_opts_default = {
 	/* .lsn                 = */ 0,
 	/* .stat                = */ NULL,
 	/* .func                = */ 0,
+	/* .normalized_key      = */ false,
 };
 
 const struct opt_def index_opts_reg[] = {
@@ -65,6 +68,7 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
+	OPT_DEF("normalized_key", OPT_BOOL, struct index_opts, normalized_key),
 	OPT_DEF_LEGACY("sql"),
 	OPT_END,
 };
@@ -109,6 +113,8 @@ index_def_new(uint32_t space_id, uint32_t iid, const char *name,
 		index_def_delete(def);
 		return NULL;
 	}
+	key_def_set_normalized_hint(def->key_def, opts->normalized_key);
+	key_def_set_normalized_hint(def->cmp_def, opts->normalized_key);
 	def->type = type;
 	def->space_id = space_id;
 	def->iid = iid;
@@ -44,6 +44,7 @@ enum index_type {
 	TREE,     /* TREE Index */
 	BITSET,   /* BITSET Index */
 	RTREE,    /* R-Tree Index */
+	COLUMN,   /* Column-wise Index */
 	index_type_MAX,
 };
 
@@ -165,6 +166,16 @@ struct index_opts {
 	struct index_stat *stat;
 	/** Identifier of the functional index function. */
 	uint32_t func_id;
+	/**
+	 * Store a normalized key prefix covering all key parts
+	 * in comparison hints instead of a hint of the first
+	 * key part. Makes ties in the first part cheap to
+	 * resolve at the cost of a full rebuild on any change
+	 * of part types. The prefix is as long as a hint, i.e.
+	 * 8 bytes, so keys sharing a longer prefix still fall
+	 * back to full comparison. Memtx TREE only.
+	 */
+	bool normalized_key;
 };
 
 extern const struct index_opts index_opts_default;
@@ -211,6 +222,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
 	if (o1->func_id != o2->func_id)
 		return o1->func_id - o2->func_id;
+	if (o1->normalized_key != o2->normalized_key)
+		return o1->normalized_key < o2->normalized_key ? -1 : 1;
 	return 0;
 }
 
@@ -48,11 +48,14 @@
 #include "scoped_guard.h"
 #include "memory.h"
 #include "random.h"
+#include "shm_channel.h"
 
 #include "bind.h"
 #include "port.h"
 #include "box.h"
 #include "call.h"
+#include "cursor.h"
+#include "tuple.h"
 #include "tuple_convert.h"
 #include "session.h"
 #include "xrow.h"
@@ -63,10 +66,19 @@
 #include "execute.h"
 #include "errinj.h"
 #include "tt_static.h"
+#include "assoc.h"
 
 enum {
 	IPROTO_SALT_SIZE = 32,
 	IPROTO_PACKET_SIZE_MAX = 2UL * 1024 * 1024 * 1024,
+	/**
+	 * Data of selected tuples of at least this size is sent
+	 * right from the tuple memory rather than copied to the
+	 * output buffer, see struct iproto_tuple_refs.
+	 */
+	IPROTO_TUPLE_REF_SIZE_MIN = 1024,
+	/** Max number of tuples written with one writev(). */
+	IPROTO_TUPLE_REF_IOV_MAX = 64,
 };
 
 /**
@@ -109,6 +121,29 @@ struct iproto_kharon {
 	struct iproto_wpos wpos;
 };
 
+/**
+ * A message sent by the iproto thread to free output buffers of
+ * a connection which has flushed all its output and has no
+ * requests in flight. The buffers are allocated and reset in tx,
+ * so tx has to free them, but only iproto knows when the output
+ * is flushed.
+ */
+struct iproto_release_output {
+	struct cmsg base;
+	/**
+	 * Iproto sets wpos to the last flushed position. If tx
+	 * frees the buffers, it sets wpos to the beginning of
+	 * the current output buffer, and iproto continues
+	 * flushing from it.
+	 */
+	struct iproto_wpos wpos;
+	/**
+	 * Set by tx if the buffers were freed. They are not if
+	 * a push was written after the message departed.
+	 */
+	bool is_released;
+};
+
 /**
  * Network readahead. A signed integer to avoid
  * automatic type coercion to an unsigned type.
@@ -173,6 +208,24 @@ iproto_reset_input(struct ibuf *ibuf)
 	}
 }
 
+/**
+ * Reset a flushed output buffer. If the buffer has grown beyond
+ * its first chunk, give the memory back to the slab cache, so
+ * that the buffer does not stay sized by the largest response
+ * ever sent on the connection.
+ */
+static inline void
+iproto_reset_output(struct obuf *obuf)
+{
+	if (obuf->iov[1].iov_base == NULL) {
+		obuf_reset(obuf);
+	} else {
+		struct slab_cache *slabc = obuf->slabc;
+		obuf_destroy(obuf);
+		obuf_create(obuf, slabc, iproto_readahead);
+	}
+}
+
 /* {{{ iproto_msg - declaration */
 
 /**
@@ -232,6 +285,19 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/**
+	 * Tuples of the response not copied to the output
+	 * buffer, set by the tx thread. May be NULL.
+	 */
+	struct iproto_tuple_refs *tuple_refs;
+	/**
+	 * Time after which the client does not wait for the
+	 * response, TIMEOUT_INFINITY if it did not send
+	 * IPROTO_TIMEOUT.
+	 */
+	double deadline;
+	/** Set by the tx thread if the request was expired. */
+	bool is_expired;
 };
 
 static struct mempool iproto_msg_pool;
@@ -239,6 +305,60 @@ static struct mempool iproto_msg_pool;
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con);
 
+/** A tuple sent to the client right from the tuple memory. */
+struct iproto_tuple_ref {
+	/** Position in the output buffer the data follows. */
+	struct obuf_svp svp;
+	/** The tuple, referenced until the data is written. */
+	struct tuple *tuple;
+	/** The tuple data. */
+	struct iovec iov;
+};
+
+/**
+ * Tuples of a SELECT response which are sent without copying
+ * their data to the output buffer. The tx thread references
+ * the tuples and records positions in the output buffer their
+ * data goes after. The iproto thread writes the output buffer
+ * up to the position of the first tuple not written yet, then
+ * the tuple data itself, and so on. When all the tuples are
+ * written, the object is sent back to tx to unreference them.
+ */
+struct iproto_tuple_refs {
+	/** Message to release the tuples in tx thread. */
+	struct cmsg base;
+	/** Link in iproto_connection::tuple_refs. */
+	struct stailq_entry in_connection;
+	/** The output buffer the positions are in. */
+	struct obuf *obuf;
+	/** Number of tuples. */
+	uint32_t count;
+	/** Number of tuples written to the socket. */
+	uint32_t flushed;
+	/** Number of bytes of refs[flushed] written. */
+	size_t offset;
+	/** The tuples, in the order of the positions. */
+	struct iproto_tuple_ref refs[0];
+};
+
+static void
+iproto_tuple_refs_delete(struct iproto_tuple_refs *refs)
+{
+	for (uint32_t i = 0; i < refs->count; i++)
+		tuple_unref(refs->refs[i].tuple);
+	free(refs);
+}
+
+static void
+tx_release_tuple_refs(struct cmsg *m)
+{
+	iproto_tuple_refs_delete((struct iproto_tuple_refs *)m);
+}
+
+static const struct cmsg_hop release_tuple_refs_route[] = {
+	{ tx_release_tuple_refs, NULL },
+};
+
 /**
  * Resume stopped connections, if any.
  */
@@ -288,6 +408,10 @@ enum rmean_net_name {
 	IPROTO_RECEIVED,
 	IPROTO_CONNECTIONS,
 	IPROTO_REQUESTS,
+	/** Requests dropped by the net thread being expired. */
+	IPROTO_REQUESTS_SHED,
+	/** Requests failed by the tx thread being expired. */
+	IPROTO_REQUESTS_EXPIRED,
 	IPROTO_LAST,
 };
 
@@ -296,6 +420,8 @@ const char *rmean_net_strings[IPROTO_LAST] = {
 	"RECEIVED",
 	"CONNECTIONS",
 	"REQUESTS",
+	"SHED",
+	"EXPIRED",
 };
 
 static void
@@ -344,6 +470,19 @@ static const struct cmsg_hop push_route[] = {
 	{ tx_end_push, NULL }
 };
 
+/** Free output buffers of an idle connection in tx thread. */
+static void
+tx_release_output(struct cmsg *m);
+
+/** Continue flushing from the position set by tx. */
+static void
+net_end_release_output(struct cmsg *m);
+
+static const struct cmsg_hop release_output_route[] = {
+	{ tx_release_output, &net_pipe },
+	{ net_end_release_output, NULL }
+};
+
 
 /* }}} */
 
@@ -375,6 +514,29 @@ enum iproto_connection_state {
 	IPROTO_CONNECTION_DESTROYED,
 };
 
+/**
+ * Shared memory transport of a connection, see
+ * IPROTO_SHM_ATTACH. Requests and responses go through the
+ * channel instead of the socket. The input and output watchers
+ * of the connection watch descriptors the client signals when
+ * it writes requests to the channel and reads responses from
+ * it correspondingly.
+ */
+struct iproto_shm {
+	struct shm_channel channel;
+	/**
+	 * The socket the channel was attached over, watched to
+	 * learn the client is gone.
+	 */
+	struct ev_io socket;
+	/** Descriptor the client sleeps on. */
+	int client_fd;
+	/** The input descriptor may need to be reset. */
+	bool is_input_armed;
+	/** The output descriptor may need to be reset. */
+	bool is_output_armed;
+};
+
 /**
  * Context of a single client connection.
  * Interaction scheme:
@@ -441,6 +603,13 @@ struct iproto_connection
 	 * output is available (see iproto_msg::wpos).
 	 */
 	struct iproto_wpos wend;
+	/**
+	 * Responses with tuples not copied to the output buffer
+	 * and waiting to be flushed, linked by
+	 * iproto_tuple_refs::in_connection. Ordered by the
+	 * output buffer position.
+	 */
+	struct stailq tuple_refs;
 	/*
 	 * Size of readahead which is not parsed yet, i.e. size of
 	 * a piece of request which is not fully read. Is always
@@ -453,6 +622,11 @@ struct iproto_connection
 	 * meaningless.
 	 */
 	size_t parse_size;
+	/**
+	 * Time of the last read from the socket. Request timeouts
+	 * are counted from it, see IPROTO_TIMEOUT.
+	 */
+	double input_time;
 	/**
 	 * Nubmer of active long polling requests that have already
 	 * discarded their arguments in order not to stall other
@@ -461,6 +635,11 @@ struct iproto_connection
 	int long_poll_count;
 	struct ev_io input;
 	struct ev_io output;
+	/**
+	 * Shared memory transport, NULL if the socket is used.
+	 * Owned by the iproto thread.
+	 */
+	struct iproto_shm *shm;
 	/** Logical session. */
 	struct session *session;
 	ev_loop *loop;
@@ -516,6 +695,19 @@ struct iproto_connection
 	 *                          ...
 	 */
 	struct iproto_kharon kharon;
+	/**
+	 * Message to free output buffers grown by a big response
+	 * once the connection becomes idle. Otherwise tx would
+	 * free them only on the next request.
+	 */
+	struct iproto_release_output release_output;
+	/**
+	 * True if an output buffer has grown beyond its first
+	 * chunk since the buffers were freed last time.
+	 */
+	bool is_output_grown;
+	/** True if release_output is travelling. */
+	bool is_output_release_sent;
 	/**
 	 * The following fields are used exclusively by the tx thread.
 	 * Align them to prevent false-sharing.
@@ -550,6 +742,13 @@ iproto_check_msg_max(void)
 	return request_count > (size_t) iproto_msg_max;
 }
 
+/** Socket of the connection. */
+static inline int
+iproto_connection_fd(struct iproto_connection *con)
+{
+	return con->shm != NULL ? con->shm->socket.fd : con->input.fd;
+}
+
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
@@ -562,10 +761,14 @@ iproto_msg_new(struct iproto_connection *con)
 	if (msg == NULL) {
 		diag_set(OutOfMemory, sizeof(*msg), "mempool_alloc", "msg");
 		say_warn("can not allocate memory for a new message, "
-			 "connection %s", sio_socketname(con->input.fd));
+			 "connection %s",
+			 sio_socketname(iproto_connection_fd(con)));
 		return NULL;
 	}
 	msg->connection = con;
+	msg->tuple_refs = NULL;
+	msg->deadline = TIMEOUT_INFINITY;
+	msg->is_expired = false;
 	rmean_collect(rmean_net, IPROTO_REQUESTS, 1);
 	return msg;
 }
@@ -585,6 +788,23 @@ iproto_msg_new(struct iproto_connection *con)
  * is therefore non-zero as long as there is at least
  * one request in the tx queue.
  */
+/**
+ * Best effort at sending an error to the client right before
+ * closing the connection.
+ */
+static inline void
+iproto_connection_write_error(struct iproto_connection *con,
+			      const struct error *e, uint64_t sync)
+{
+	/*
+	 * The client doesn't read the socket of a shared memory
+	 * connection, and a response may be partially written
+	 * to the channel.
+	 */
+	if (con->shm == NULL)
+		iproto_write_error(con->input.fd, e, ::schema_version, sync);
+}
+
 static inline bool
 iproto_connection_is_idle(struct iproto_connection *con)
 {
@@ -593,6 +813,50 @@ iproto_connection_is_idle(struct iproto_connection *con)
 	       ibuf_used(&con->ibuf[1]) == 0;
 }
 
+/**
+ * Give the input buffers of an idle connection which have grown
+ * by a big request back to the slab cache of the net cord, which
+ * keeps free slabs by size classes for all connections. The next
+ * read borrows a buffer again, so connections waiting for
+ * requests don't stay sized by the largest request ever read.
+ * Buffers of the initial size are kept, so that a connection
+ * doing small requests does not allocate on each of them.
+ */
+static inline void
+iproto_connection_release_input(struct iproto_connection *con)
+{
+	assert(iproto_connection_is_idle(con));
+	for (int i = 0; i < 2; i++) {
+		struct ibuf *ibuf = &con->ibuf[i];
+		/*
+		 * The first slab of a buffer is rounded up to
+		 * the slab order, a grown one is at least twice
+		 * the read-ahead.
+		 */
+		if (ibuf_capacity(ibuf) < 2 * iproto_readahead)
+			continue;
+		ibuf_destroy(ibuf);
+		ibuf_create(ibuf, cord_slab_cache(), iproto_readahead);
+	}
+}
+
+/**
+ * Ask tx to free the output buffers of an idle connection, if
+ * they have grown by a big response and all the output is
+ * flushed.
+ */
+static inline void
+iproto_connection_release_output(struct iproto_connection *con)
+{
+	if (!con->is_output_grown || con->is_output_release_sent ||
+	    !iproto_connection_is_idle(con) ||
+	    !stailq_empty(&con->tuple_refs))
+		return;
+	con->release_output.wpos = con->wpos;
+	con->is_output_release_sent = true;
+	cpipe_push(&tx_pipe, &con->release_output.base);
+}
+
 /**
  * Stop input when readahead limit is reached. When
  * we process some messages *on this connection*, the input can be
@@ -603,7 +867,7 @@ iproto_connection_stop_readahead_limit(struct iproto_connection *con)
 {
 	say_warn_ratelimited("stopping input on connection %s, "
 			     "readahead limit is reached",
-			     sio_socketname(con->input.fd));
+			     sio_socketname(iproto_connection_fd(con)));
 	assert(rlist_empty(&con->in_stop_list));
 	ev_io_stop(con->loop, &con->input);
 }
@@ -615,7 +879,7 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 
 	say_warn_ratelimited("stopping input on connection %s, "
 			     "net_msg_max limit is reached",
-			     sio_socketname(con->input.fd));
+			     sio_socketname(iproto_connection_fd(con)));
 	ev_io_stop(con->loop, &con->input);
 	/*
 	 * Important to add to tail and fetch from head to ensure
@@ -653,6 +917,24 @@ iproto_connection_try_to_start_destroy(struct iproto_connection *con)
 	cpipe_push(&tx_pipe, &con->destroy_msg);
 }
 
+/**
+ * Release the shared memory transport of a connection being
+ * closed, except the input descriptor closed by the caller.
+ */
+static void
+iproto_shm_close(struct iproto_connection *con)
+{
+	struct iproto_shm *shm = con->shm;
+	ev_io_stop(con->loop, &shm->socket);
+	shm_channel_close(&shm->channel);
+	shm_notify_signal(shm->client_fd);
+	shm_channel_destroy(&shm->channel);
+	close(shm->client_fd);
+	close(con->output.fd);
+	close(shm->socket.fd);
+	shm->socket.fd = -1;
+}
+
 /**
  * Initiate a connection shutdown. This method may
  * be invoked many times, and does the internal
@@ -666,6 +948,8 @@ iproto_connection_close(struct iproto_connection *con)
 		ev_io_stop(con->loop, &con->input);
 		ev_io_stop(con->loop, &con->output);
 
+		if (con->shm != NULL)
+			iproto_shm_close(con);
 		int fd = con->input.fd;
 		/* Make evio_has_fd() happy */
 		con->input.fd = con->output.fd = -1;
@@ -854,16 +1138,33 @@ err_msgpack:
 		msg->len = reqend - reqstart; /* total request length */
 
 		iproto_msg_decode(msg, &pos, reqend, &stop_input);
+		/* Request is parsed */
+		assert(reqend > reqstart);
+		assert(con->parse_size >= (size_t) (reqend - reqstart));
+		con->parse_size -= reqend - reqstart;
+		if (msg->header.timeout > 0 && !stop_input &&
+		    msg->base.route != error_route) {
+			msg->deadline = con->input_time + msg->header.timeout;
+			/*
+			 * The request was read before the input was
+			 * stopped by net_msg_max and the client
+			 * does not wait for it anymore. Drop it
+			 * without a response.
+			 */
+			if (msg->deadline <= ev_monotonic_time()) {
+				rmean_collect(rmean_net, IPROTO_REQUESTS_SHED,
+					      1);
+				msg->p_ibuf->rpos += msg->len;
+				iproto_msg_delete(msg);
+				continue;
+			}
+		}
 		/*
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
 		cpipe_push_input(&tx_pipe, &msg->base);
 		n_requests++;
-		/* Request is parsed */
-		assert(reqend > reqstart);
-		assert(con->parse_size >= (size_t) (reqend - reqstart));
-		con->parse_size -= reqend - reqstart;
 	}
 	if (stop_input) {
 		/**
@@ -916,7 +1217,7 @@ iproto_connection_resume(struct iproto_connection *con)
 	 */
 	if (iproto_enqueue_batch(con, con->p_ibuf) != 0) {
 		struct error *e = box_error_last();
-		iproto_write_error(con->input.fd, e, ::schema_version, 0);
+		iproto_connection_write_error(con, e, 0);
 		error_log(e);
 		iproto_connection_close(con);
 	}
@@ -947,14 +1248,90 @@ iproto_resume(void)
 	}
 }
 
+/**
+ * Read up to @a count bytes of input of the connection, like
+ * sio_read().
+ */
+static ssize_t
+iproto_connection_read(struct iproto_connection *con, void *buf, size_t count)
+{
+	struct iproto_shm *shm = con->shm;
+	if (shm == NULL)
+		return sio_read(con->input.fd, buf, count);
+	if (shm->is_input_armed) {
+		shm_notify_clear(con->input.fd);
+		shm->is_input_armed = false;
+	}
+	size_t nrd = shm_channel_read(&shm->channel, buf, count);
+	if (nrd == 0 && shm_channel_is_closed(&shm->channel))
+		return 0;
+	/*
+	 * Unlike a socket, the notification descriptor isn't
+	 * readable while there's input unless the client is asked
+	 * to signal it. Make sure the input watcher fires when
+	 * there's more input.
+	 */
+	shm->is_input_armed = true;
+	if (! shm_channel_prepare_read_wait(&shm->channel))
+		shm_notify_signal(con->input.fd);
+	if (nrd == 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+	if (shm_channel_peer_waits_space(&shm->channel))
+		shm_notify_signal(shm->client_fd);
+	return nrd;
+}
+
+/**
+ * Write output of the connection, like sio_writev().
+ */
+static ssize_t
+iproto_connection_writev(struct iproto_connection *con,
+			 const struct iovec *iov, int iovcnt)
+{
+	struct iproto_shm *shm = con->shm;
+	if (shm == NULL)
+		return sio_writev(con->output.fd, iov, iovcnt);
+	if (shm_channel_is_closed(&shm->channel)) {
+		errno = EPIPE;
+		diag_set(SocketError, sio_socketname(shm->socket.fd),
+			 "shared memory channel is closed");
+		return -1;
+	}
+	if (shm->is_output_armed) {
+		shm_notify_clear(con->output.fd);
+		shm->is_output_armed = false;
+	}
+	size_t nwr = shm_channel_writev(&shm->channel, iov, iovcnt);
+	size_t size = 0;
+	for (int i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+	if (nwr < size) {
+		/*
+		 * Make sure the output watcher fires when the
+		 * client frees space in the channel.
+		 */
+		shm->is_output_armed = true;
+		if (! shm_channel_prepare_write_wait(&shm->channel, 1))
+			shm_notify_signal(con->output.fd);
+	}
+	if (nwr > 0 && shm_channel_peer_waits_data(&shm->channel))
+		shm_notify_signal(shm->client_fd);
+	if (nwr == 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+	return nwr;
+}
+
 static void
 iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			   int /* revents */)
 {
 	struct iproto_connection *con =
 		(struct iproto_connection *) watcher->data;
-	int fd = con->input.fd;
-	assert(fd >= 0);
+	assert(con->input.fd >= 0);
 	assert(rlist_empty(&con->in_stop_list));
 	assert(loop == con->loop);
 	/*
@@ -975,7 +1352,8 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Read input. */
-		int nrd = sio_read(fd, in->wpos, ibuf_unused(in));
+		int nrd = iproto_connection_read(con, in->wpos,
+						 ibuf_unused(in));
 		if (nrd < 0) {                  /* Socket is not ready. */
 			if (! sio_wouldblock(errno))
 				diag_raise();
@@ -988,6 +1366,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 		}
 		/* Count statistics */
 		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		con->input_time = ev_monotonic_time();
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -997,23 +1376,78 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			diag_raise();
 	} catch (Exception *e) {
 		/* Best effort at sending the error message to the client. */
-		iproto_write_error(fd, e, ::schema_version, 0);
+		iproto_connection_write_error(con, e, 0);
 		e->log();
 		iproto_connection_close(con);
 	}
 }
 
+/**
+ * Write data of tuples following the current write position
+ * in the output buffer to the socket.
+ */
+static int
+iproto_flush_tuple_refs(struct iproto_connection *con,
+			struct iproto_tuple_refs *refs)
+{
+	struct iovec iov[IPROTO_TUPLE_REF_IOV_MAX];
+	int iovcnt = 0;
+	size_t used = refs->refs[refs->flushed].svp.used;
+	for (uint32_t i = refs->flushed; i < refs->count &&
+	     iovcnt < IPROTO_TUPLE_REF_IOV_MAX &&
+	     refs->refs[i].svp.used == used; i++)
+		iov[iovcnt++] = refs->refs[i].iov;
+	sio_add_to_iov(iov, -refs->offset);
+
+	ssize_t nwr = iproto_connection_writev(con, iov, iovcnt);
+
+	if (nwr < 0) {
+		if (! sio_wouldblock(errno))
+			diag_raise();
+		return -1;
+	}
+	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	size_t offset = 0;
+	int advance = sio_move_iov(iov, nwr, &offset);
+	refs->offset = advance == 0 ? refs->offset + offset : offset;
+	refs->flushed += advance;
+	if (refs->flushed == refs->count) {
+		stailq_shift(&con->tuple_refs);
+		cpipe_push(&tx_pipe, &refs->base);
+		return 0;
+	}
+	return advance == iovcnt ? 0 : -1;
+}
+
 /** writev() to the socket and handle the result. */
 
 static int
 iproto_flush(struct iproto_connection *con)
 {
-	int fd = con->output.fd;
 	struct obuf *obuf = con->wpos.obuf;
 	struct obuf_svp obuf_end = obuf_create_svp(obuf);
 	struct obuf_svp *begin = &con->wpos.svp;
 	struct obuf_svp *end = &con->wend.svp;
-	if (con->wend.obuf != obuf) {
+	/*
+	 * Tuple data goes right after the output buffer data
+	 * preceding it, before any buffer rotation.
+	 */
+	struct iproto_tuple_refs *refs = NULL;
+	if (!stailq_empty(&con->tuple_refs)) {
+		refs = stailq_first_entry(&con->tuple_refs,
+					  struct iproto_tuple_refs,
+					  in_connection);
+		if (refs->obuf != obuf)
+			refs = NULL;
+	}
+	if (refs != NULL) {
+		struct obuf_svp *svp = &refs->refs[refs->flushed].svp;
+		if (begin->used == svp->used)
+			return iproto_flush_tuple_refs(con, refs);
+		assert(begin->used < svp->used);
+		obuf_end = *svp;
+		end = &obuf_end;
+	} else if (con->wend.obuf != obuf) {
 		/*
 		 * Flush the current buffer before
 		 * advancing to the next one.
@@ -1042,7 +1476,7 @@ iproto_flush(struct iproto_connection *con)
 	/* *Overwrite* iov_len of the last pos as it may be garbage. */
 	iov[iovcnt-1].iov_len = end->iov_len - begin->iov_len * (iovcnt == 1);
 
-	ssize_t nwr = sio_writev(fd, iov, iovcnt);
+	ssize_t nwr = iproto_connection_writev(con, iov, iovcnt);
 
 	if (nwr > 0) {
 		/* Count statistics */
@@ -1084,6 +1518,7 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 		}
 		if (ev_is_active(&con->output))
 			ev_io_stop(con->loop, &con->output);
+		iproto_connection_release_output(con);
 	} catch (Exception *e) {
 		e->log();
 		iproto_connection_close(con);
@@ -1111,7 +1546,10 @@ iproto_connection_new(int fd)
 	con->tx.p_obuf = &con->obuf[0];
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
 	iproto_wpos_create(&con->wend, con->tx.p_obuf);
+	stailq_create(&con->tuple_refs);
+	con->shm = NULL;
 	con->parse_size = 0;
+	con->input_time = 0;
 	con->long_poll_count = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
@@ -1121,6 +1559,9 @@ iproto_connection_new(int fd)
 	con->state = IPROTO_CONNECTION_ALIVE;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
+	cmsg_init(&con->release_output.base, release_output_route);
+	con->is_output_grown = false;
+	con->is_output_release_sent = false;
 	rmean_collect(rmean_net, IPROTO_CONNECTIONS, 1);
 	return con;
 }
@@ -1132,6 +1573,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	assert(iproto_connection_is_idle(con));
 	assert(!evio_has_fd(&con->output));
 	assert(!evio_has_fd(&con->input));
+	assert(!con->is_output_release_sent);
 	assert(con->session == NULL);
 	assert(con->state == IPROTO_CONNECTION_DESTROYED);
 	/*
@@ -1144,6 +1586,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
+	free(con->shm);
 	mempool_free(&iproto_connection_pool, con);
 }
 
@@ -1160,9 +1603,15 @@ tx_process_call(struct cmsg *msg);
 static void
 tx_process1(struct cmsg *msg);
 
+static void
+tx_process_many(struct cmsg *msg);
+
 static void
 tx_process_select(struct cmsg *msg);
 
+static void
+tx_process_cursor(struct cmsg *msg);
+
 static void
 tx_process_sql(struct cmsg *msg);
 
@@ -1187,6 +1636,12 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
+static void
+tx_process_shm_attach(struct cmsg *msg);
+
+static void
+net_shm_attach(struct cmsg *msg);
+
 static const struct cmsg_hop misc_route[] = {
 	{ tx_process_misc, &net_pipe },
 	{ net_send_msg, NULL },
@@ -1202,11 +1657,21 @@ static const struct cmsg_hop select_route[] = {
 	{ net_send_msg, NULL },
 };
 
+static const struct cmsg_hop cursor_route[] = {
+	{ tx_process_cursor, &net_pipe },
+	{ net_send_msg, NULL },
+};
+
 static const struct cmsg_hop process1_route[] = {
 	{ tx_process1, &net_pipe },
 	{ net_send_msg, NULL },
 };
 
+static const struct cmsg_hop process_many_route[] = {
+	{ tx_process_many, &net_pipe },
+	{ net_send_msg, NULL },
+};
+
 static const struct cmsg_hop sql_route[] = {
 	{ tx_process_sql, &net_pipe },
 	{ net_send_msg, NULL },
@@ -1244,6 +1709,101 @@ static const struct cmsg_hop error_route[] = {
 	{ net_send_error, NULL },
 };
 
+static const struct cmsg_hop shm_attach_route[] = {
+	{ tx_process_shm_attach, &net_pipe },
+	{ net_shm_attach, NULL },
+};
+
+const char *iproto_msg_class_strs[] = {
+	"system",
+	"read",
+	"write",
+	"call",
+};
+
+static_assert(lengthof(iproto_msg_class_strs) == iproto_msg_class_MAX,
+	      "each iproto message class must have a name");
+
+/**
+ * Classes of CALL requests by the function name, the name is
+ * owned by the hash. Is accessed in the tx thread only.
+ */
+static struct mh_strnptr_t *iproto_function_classes = NULL;
+
+int
+iproto_msg_class(struct cmsg *m)
+{
+	const struct cmsg_hop *route = m->route;
+	if (route == select_route || route == cursor_route)
+		return IPROTO_MSG_CLASS_READ;
+	if (route == process1_route || route == process_many_route)
+		return IPROTO_MSG_CLASS_WRITE;
+	if (route == sql_route)
+		return IPROTO_MSG_CLASS_CALL;
+	if (route != call_route)
+		return IPROTO_MSG_CLASS_SYSTEM;
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	if (msg->call.name == NULL || iproto_function_classes == NULL)
+		return IPROTO_MSG_CLASS_CALL;
+	const char *data = msg->call.name;
+	uint32_t name_len;
+	const char *name = mp_decode_str(&data, &name_len);
+	mh_int_t k = mh_strnptr_find_inp(iproto_function_classes, name,
+					 name_len);
+	if (k == mh_end(iproto_function_classes))
+		return IPROTO_MSG_CLASS_CALL;
+	return (intptr_t) mh_strnptr_node(iproto_function_classes, k)->val;
+}
+
+int
+iproto_set_function_class(const char *name, uint32_t name_len,
+			  enum iproto_msg_class cls)
+{
+	if (iproto_function_classes == NULL) {
+		iproto_function_classes = mh_strnptr_new();
+		if (iproto_function_classes == NULL) {
+			diag_set(OutOfMemory, sizeof(*iproto_function_classes),
+				 "mh_strnptr_new", "iproto_function_classes");
+			return -1;
+		}
+	}
+	struct mh_strnptr_t *h = iproto_function_classes;
+	mh_int_t k = mh_strnptr_find_inp(h, name, name_len);
+	if (k != mh_end(h)) {
+		mh_strnptr_node(h, k)->val = (void *)(intptr_t) cls;
+		return 0;
+	}
+	char *str = (char *) malloc(name_len);
+	if (str == NULL) {
+		diag_set(OutOfMemory, name_len, "malloc", "str");
+		return -1;
+	}
+	memcpy(str, name, name_len);
+	const struct mh_strnptr_node_t node = {
+		str, name_len, mh_strn_hash(str, name_len),
+		(void *)(intptr_t) cls
+	};
+	if (mh_strnptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		free(str);
+		diag_set(OutOfMemory, sizeof(node), "mh_strnptr_put", "node");
+		return -1;
+	}
+	return 0;
+}
+
+void
+iproto_reset_function_classes(void)
+{
+	struct mh_strnptr_t *h = iproto_function_classes;
+	if (h == NULL)
+		return;
+	mh_int_t k;
+	mh_foreach(h, k)
+		free((char *) mh_strnptr_node(h, k)->str);
+	mh_strnptr_delete(h);
+	iproto_function_classes = NULL;
+}
+
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
@@ -1274,9 +1834,36 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		assert(type < sizeof(dml_route)/sizeof(*dml_route));
 		cmsg_init(&msg->base, dml_route[type]);
 		break;
+	case IPROTO_INSERT_MANY:
+	case IPROTO_REPLACE_MANY:
+		if (xrow_decode_dml(&msg->header, &msg->dml,
+				    dml_request_key_map(IPROTO_INSERT)))
+			goto error;
+		cmsg_init(&msg->base, process_many_route);
+		break;
+	case IPROTO_CURSOR_OPEN:
+		if (xrow_decode_dml(&msg->header, &msg->dml,
+				    iproto_key_bit(IPROTO_SPACE_ID)))
+			goto error;
+		cmsg_init(&msg->base, cursor_route);
+		break;
+	case IPROTO_CURSOR_FETCH:
+		if (xrow_decode_dml(&msg->header, &msg->dml,
+				    iproto_key_bit(IPROTO_CURSOR_ID) |
+				    iproto_key_bit(IPROTO_LIMIT)))
+			goto error;
+		cmsg_init(&msg->base, cursor_route);
+		break;
+	case IPROTO_CURSOR_CLOSE:
+		if (xrow_decode_dml(&msg->header, &msg->dml,
+				    iproto_key_bit(IPROTO_CURSOR_ID)))
+			goto error;
+		cmsg_init(&msg->base, cursor_route);
+		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
+	case IPROTO_PREPARE_CALL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
 		cmsg_init(&msg->base, call_route);
@@ -1293,11 +1880,24 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 	case IPROTO_JOIN:
 	case IPROTO_FETCH_SNAPSHOT:
 	case IPROTO_REGISTER:
-		cmsg_init(&msg->base, join_route);
+	case IPROTO_SUBSCRIBE:
+		/* Replication uses the socket directly. */
+		if (msg->connection->shm != NULL) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 "Shared memory transport", "replication");
+			goto error;
+		}
+		cmsg_init(&msg->base, type == IPROTO_SUBSCRIBE ?
+			  subscribe_route : join_route);
 		*stop_input = true;
 		break;
-	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+	case IPROTO_SHM_ATTACH:
+		if (msg->connection->shm != NULL) {
+			diag_set(ClientError, ER_PROTOCOL,
+				 "Shared memory channel is already attached");
+			goto error;
+		}
+		cmsg_init(&msg->base, shm_attach_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
@@ -1388,6 +1988,14 @@ tx_process_destroy(struct cmsg *m)
 	 */
 	obuf_destroy(&con->obuf[0]);
 	obuf_destroy(&con->obuf[1]);
+	/*
+	 * The iproto thread doesn't touch the tuples of
+	 * a closed connection anymore.
+	 */
+	struct iproto_tuple_refs *refs, *tmp;
+	stailq_foreach_entry_safe(refs, tmp, &con->tuple_refs, in_connection)
+		iproto_tuple_refs_delete(refs);
+	stailq_create(&con->tuple_refs);
 }
 
 /**
@@ -1466,7 +2074,7 @@ tx_accept_wpos(struct iproto_connection *con, const struct iproto_wpos *wpos)
 		 * buffers are never flushed out of order.
 		 */
 		if (obuf_size(prev) != 0)
-			obuf_reset(prev);
+			iproto_reset_output(prev);
 	}
 	if (obuf_size(con->tx.p_obuf) != 0 && obuf_size(prev) == 0) {
 		/*
@@ -1487,6 +2095,23 @@ tx_accept_msg(struct cmsg *m)
 	return msg;
 }
 
+/**
+ * Fail a request which waited in the queue for longer than the
+ * client waits for the response, see IPROTO_TIMEOUT. Is checked
+ * before the request is executed, to not waste time on it when
+ * tx is overloaded.
+ */
+static inline int
+tx_check_deadline(struct iproto_msg *msg)
+{
+	if (msg->deadline == TIMEOUT_INFINITY ||
+	    msg->deadline > ev_monotonic_time())
+		return 0;
+	msg->is_expired = true;
+	diag_set(ClientError, ER_TIMEOUT);
+	return -1;
+}
+
 /**
  * Write error message to the output buffer and advance
  * write position. Doesn't throw.
@@ -1528,7 +2153,8 @@ static void
 tx_process1(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
-	if (tx_check_schema(msg->header.schema_version))
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
 		goto error;
 
 	struct tuple *tuple;
@@ -1550,6 +2176,115 @@ error:
 	tx_reply_error(msg);
 }
 
+/**
+ * Execute INSERT_MANY or REPLACE_MANY. The reply has the number
+ * of written tuples as the only item of IPROTO_DATA.
+ */
+static void
+tx_process_many(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	uint32_t count;
+	struct obuf_svp svp;
+	struct obuf *out;
+	tx_inject_delay();
+	if (box_process_many(&msg->dml, &count) != 0)
+		goto error;
+	out = msg->connection->tx.p_obuf;
+	if (iproto_prepare_select(out, &svp) != 0)
+		goto error;
+	char *pos;
+	pos = (char *)obuf_alloc(out, mp_sizeof_uint(count));
+	if (pos == NULL) {
+		obuf_rollback_to_svp(out, &svp);
+		diag_set(OutOfMemory, mp_sizeof_uint(count), "obuf_alloc",
+			 "pos");
+		goto error;
+	}
+	mp_encode_uint(pos, count);
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version, 1);
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+/** Check if the tuple data is sent without copying. */
+static inline bool
+tx_tuple_is_ref(struct tuple *tuple)
+{
+	return tuple_bsize(tuple) >= IPROTO_TUPLE_REF_SIZE_MIN &&
+	       tuple_format(tuple)->compression == COMPRESSION_TYPE_NONE;
+}
+
+/**
+ * Dump tuples of a SELECT response to the output buffer. Data
+ * of big tuples is not copied: the tuples are referenced in
+ * msg->tuple_refs and written to the socket from the tuple
+ * memory by the iproto thread.
+ *
+ * @param[out] ref_size Size of the data not copied.
+ * @retval >= 0 Number of tuples.
+ * @retval -1 Error, diag is set.
+ */
+static int
+tx_dump_select(struct iproto_msg *msg, struct port *base, struct obuf *out,
+	       size_t *ref_size)
+{
+	struct port_c *port = (struct port_c *)base;
+	struct port_c_entry *pe;
+	*ref_size = 0;
+	for (pe = port->first; pe != NULL; pe = pe->next) {
+		if (pe->mp_size == 0 && tx_tuple_is_ref(pe->tuple))
+			break;
+	}
+	if (pe == NULL)
+		return port_dump_msgpack_16(base, out);
+	struct iproto_tuple_refs *refs = (struct iproto_tuple_refs *)
+		malloc(sizeof(*refs) + port->size * sizeof(refs->refs[0]));
+	if (refs == NULL) {
+		/* Not critical, copy the data then. */
+		return port_dump_msgpack_16(base, out);
+	}
+	cmsg_init(&refs->base, release_tuple_refs_route);
+	refs->obuf = out;
+	refs->count = 0;
+	refs->flushed = 0;
+	refs->offset = 0;
+	for (pe = port->first; pe != NULL; pe = pe->next) {
+		uint32_t size = pe->mp_size;
+		if (size != 0) {
+			if (obuf_dup(out, pe->mp, size) != size) {
+				diag_set(OutOfMemory, size, "obuf_dup", "data");
+				goto error;
+			}
+			continue;
+		}
+		struct tuple *tuple = pe->tuple;
+		if (!tx_tuple_is_ref(tuple)) {
+			if (tuple_to_obuf(tuple, out) != 0)
+				goto error;
+			continue;
+		}
+		struct iproto_tuple_ref *ref = &refs->refs[refs->count++];
+		ref->svp = obuf_create_svp(out);
+		ref->tuple = tuple;
+		tuple_ref(tuple);
+		ref->iov.iov_base = (void *)tuple_data_range(tuple, &size);
+		ref->iov.iov_len = size;
+		*ref_size += size;
+	}
+	msg->tuple_refs = refs;
+	return port->size;
+error:
+	iproto_tuple_refs_delete(refs);
+	return -1;
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
@@ -1557,10 +2292,12 @@ tx_process_select(struct cmsg *m)
 	struct obuf *out;
 	struct obuf_svp svp;
 	struct port port;
+	size_t ref_size;
 	int count;
 	int rc;
 	struct request *req = &msg->dml;
-	if (tx_check_schema(msg->header.schema_version))
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
 		goto error;
 
 	tx_inject_delay();
@@ -1578,21 +2315,88 @@ tx_process_select(struct cmsg *m)
 	/*
 	 * SELECT output format has not changed since Tarantool 1.6
 	 */
-	count = port_dump_msgpack_16(&port, out);
+	count = tx_dump_select(msg, &port, out, &ref_size);
 	port_destroy(&port);
 	if (count < 0) {
 		/* Discard the prepared select. */
 		obuf_rollback_to_svp(out, &svp);
 		goto error;
 	}
-	iproto_reply_select(out, &svp, msg->header.sync,
-			    ::schema_version, count);
+	iproto_reply_select_ref(out, &svp, msg->header.sync,
+				::schema_version, count, ref_size);
 	iproto_wpos_create(&msg->wpos, out);
 	return;
 error:
 	tx_reply_error(msg);
 }
 
+static void
+tx_process_cursor(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out = msg->connection->tx.p_obuf;
+	struct obuf_svp svp;
+	struct port port;
+	size_t ref_size;
+	int count;
+	struct request *req = &msg->dml;
+	/* Id of a cursor opened by this request, 0 if none. */
+	uint32_t open_id = 0;
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	switch (msg->header.type) {
+	case IPROTO_CURSOR_OPEN: {
+		if (box_cursor_open(req->space_id, req->index_id,
+				    req->iterator, req->key, req->key_end,
+				    &open_id) != 0)
+			goto error;
+		char data[16];
+		char *data_end = mp_encode_uint(data, open_id);
+		port_c_create(&port);
+		if (port_c_add_mp(&port, data, data_end) != 0) {
+			port_destroy(&port);
+			goto error;
+		}
+		break;
+	}
+	case IPROTO_CURSOR_FETCH:
+		if (box_cursor_fetch(req->cursor_id, req->limit, &port) != 0)
+			goto error;
+		break;
+	case IPROTO_CURSOR_CLOSE:
+		if (box_cursor_close(req->cursor_id) != 0 ||
+		    iproto_reply_ok(out, msg->header.sync,
+				    ::schema_version) != 0)
+			goto error;
+		iproto_wpos_create(&msg->wpos, out);
+		return;
+	default:
+		unreachable();
+	}
+
+	if (iproto_prepare_select(out, &svp) != 0) {
+		port_destroy(&port);
+		goto error;
+	}
+	count = tx_dump_select(msg, &port, out, &ref_size);
+	port_destroy(&port);
+	if (count < 0) {
+		obuf_rollback_to_svp(out, &svp);
+		goto error;
+	}
+	iproto_reply_select_ref(out, &svp, msg->header.sync,
+				::schema_version, count, ref_size);
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error:
+	/* The client won't learn the id to close the cursor. */
+	if (open_id != 0)
+		box_cursor_close(open_id);
+	tx_reply_error(msg);
+}
+
 static int
 tx_process_call_on_yield(struct trigger *trigger, void *event)
 {
@@ -1608,7 +2412,8 @@ static void
 tx_process_call(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
-	if (tx_check_schema(msg->header.schema_version))
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
 		goto error;
 
 	/*
@@ -1631,6 +2436,9 @@ tx_process_call(struct cmsg *m)
 	case IPROTO_EVAL:
 		rc = box_process_eval(&msg->call, &port);
 		break;
+	case IPROTO_PREPARE_CALL:
+		rc = box_prepare_call(&msg->call, &port);
+		break;
 	default:
 		unreachable();
 	}
@@ -1689,7 +2497,8 @@ tx_process_misc(struct cmsg *m)
 	struct iproto_msg *msg = tx_accept_msg(m);
 	struct iproto_connection *con = msg->connection;
 	struct obuf *out = con->tx.p_obuf;
-	if (tx_check_schema(msg->header.schema_version))
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
 		goto error;
 
 	try {
@@ -1738,7 +2547,8 @@ tx_process_sql(struct cmsg *m)
 	uint32_t len;
 	bool is_unprepare = false;
 
-	if (tx_check_schema(msg->header.schema_version))
+	if (tx_check_deadline(msg) != 0 ||
+	    tx_check_schema(msg->header.schema_version))
 		goto error;
 	assert(msg->header.type == IPROTO_EXECUTE ||
 	       msg->header.type == IPROTO_PREPARE);
@@ -1871,6 +2681,8 @@ net_send_msg(struct cmsg *m)
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
+	if (msg->is_expired)
+		rmean_collect(rmean_net, IPROTO_REQUESTS_EXPIRED, 1);
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
 		msg->p_ibuf->rpos += msg->len;
@@ -1879,11 +2691,19 @@ net_send_msg(struct cmsg *m)
 		assert(con->long_poll_count > 0);
 		con->long_poll_count--;
 	}
+	if (msg->tuple_refs != NULL) {
+		stailq_add_tail_entry(&con->tuple_refs, msg->tuple_refs,
+				      in_connection);
+	}
 	con->wend = msg->wpos;
+	if (con->wend.svp.pos > 0)
+		con->is_output_grown = true;
 
 	if (evio_has_fd(&con->output)) {
 		if (! ev_is_active(&con->output))
 			ev_feed_event(con->loop, &con->output, EV_WRITE);
+		if (iproto_connection_is_idle(con))
+			iproto_connection_release_input(con);
 	} else if (iproto_connection_is_idle(con)) {
 		iproto_connection_close(con);
 	}
@@ -1935,6 +2755,159 @@ net_end_subscribe(struct cmsg *m)
 	iproto_connection_close(con);
 }
 
+static void
+tx_process_shm_attach(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	/* The response is sent by the iproto thread. */
+	msg->header.schema_version = ::schema_version;
+}
+
+/** Watch the socket of a shared memory connection. */
+static void
+iproto_shm_on_socket(ev_loop * /* loop */, struct ev_io *watcher,
+		     int /* revents */)
+{
+	struct iproto_connection *con =
+		(struct iproto_connection *) watcher->data;
+	char c;
+	ssize_t nrd = sio_read(watcher->fd, &c, sizeof(c));
+	if (nrd < 0 && sio_wouldblock(errno))
+		return;
+	if (nrd > 0) {
+		say_warn("closing connection %s: unexpected data in the "
+			 "socket of a shared memory connection",
+			 sio_socketname(watcher->fd));
+	}
+	iproto_connection_close(con);
+}
+
+/**
+ * Create a shared memory channel and send it to the client
+ * in the response to IPROTO_SHM_ATTACH, with its descriptors
+ * and the descriptors to notify each other.
+ */
+static struct iproto_shm *
+iproto_shm_attach(struct iproto_connection *con, uint64_t sync,
+		  uint32_t schema_version, int *input_fd, int *output_fd)
+{
+	int fd = con->input.fd;
+	struct sockaddr_storage addr;
+	socklen_t addrlen = sizeof(addr);
+	if (sio_getsockname(fd, (struct sockaddr *)&addr, &addrlen) != 0 ||
+	    addr.ss_family != AF_UNIX) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Non-Unix socket",
+			 "shared memory transport");
+		return NULL;
+	}
+	struct iproto_shm *shm = (struct iproto_shm *) calloc(1, sizeof(*shm));
+	if (shm == NULL) {
+		diag_set(OutOfMemory, sizeof(*shm), "calloc", "shm");
+		return NULL;
+	}
+	/* Channel memory, input, output and client notifications. */
+	int fds[4] = {-1, -1, -1, -1};
+	if (shm_channel_create(&shm->channel, SHM_CHANNEL_RING_SIZE,
+			       &fds[0]) != 0) {
+		free(shm);
+		return NULL;
+	}
+	for (int i = 1; i < 4; i++) {
+		fds[i] = shm_notify_create();
+		if (fds[i] < 0)
+			goto error;
+	}
+	char reply[IPROTO_HEADER_LEN + 1];
+	iproto_header_encode(reply, IPROTO_OK, sync, schema_version, 1);
+	reply[IPROTO_HEADER_LEN] = 0x80; /* empty MessagePack Map */
+	ssize_t nwr;
+	nwr = sio_sendfds(fd, reply, sizeof(reply), fds, lengthof(fds));
+	if (nwr != sizeof(reply)) {
+		/*
+		 * The socket is flushed and the response is tiny,
+		 * so it's written at once unless the socket is
+		 * broken.
+		 */
+		if (nwr >= 0 || sio_wouldblock(errno)) {
+			diag_set(SocketError, sio_socketname(fd),
+				 "failed to send a shared memory channel");
+		}
+		goto error;
+	}
+	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	/* The channel stays mapped. */
+	close(fds[0]);
+	*input_fd = fds[1];
+	*output_fd = fds[2];
+	shm->client_fd = fds[3];
+	ev_io_init(&shm->socket, iproto_shm_on_socket, fd, EV_READ);
+	shm->socket.data = con;
+	return shm;
+error:
+	shm_channel_destroy(&shm->channel);
+	for (int i = 0; i < 4; i++) {
+		if (fds[i] >= 0)
+			close(fds[i]);
+	}
+	free(shm);
+	return NULL;
+}
+
+/**
+ * Switch the connection to a shared memory channel. The request
+ * must be the only one in flight and the output must be flushed,
+ * otherwise responses to other requests could be lost. The
+ * connection is closed if it is not.
+ */
+static void
+net_shm_attach(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	uint64_t sync = msg->header.sync;
+	uint32_t schema_version = msg->header.schema_version;
+
+	msg->p_ibuf->rpos += msg->len;
+	iproto_msg_delete(msg);
+
+	assert(! ev_is_active(&con->input));
+	if (! evio_has_fd(&con->input)) {
+		if (iproto_connection_is_idle(con))
+			iproto_connection_close(con);
+		return;
+	}
+	if (! iproto_connection_is_idle(con) || con->parse_size != 0 ||
+	    con->wpos.obuf != con->wend.obuf ||
+	    con->wpos.svp.used != con->wend.svp.used ||
+	    ! stailq_empty(&con->tuple_refs)) {
+		diag_set(ClientError, ER_PROTOCOL, "Shared memory attach "
+			 "request must be the only one in flight");
+		goto error;
+	}
+	int input_fd, output_fd;
+	struct iproto_shm *shm;
+	shm = iproto_shm_attach(con, sync, schema_version,
+				&input_fd, &output_fd);
+	if (shm == NULL) {
+		/* The output is flushed, the error can be sent. */
+		iproto_write_error(con->input.fd, diag_last_error(diag_get()),
+				   schema_version, sync);
+		diag_log();
+		if (iproto_enqueue_batch(con, con->p_ibuf) != 0)
+			goto error;
+		return;
+	}
+	con->shm = shm;
+	ev_io_set(&con->input, input_fd, EV_READ);
+	ev_io_set(&con->output, output_fd, EV_READ);
+	ev_io_start(con->loop, &shm->socket);
+	ev_feed_event(con->loop, &con->input, EV_READ);
+	return;
+error:
+	diag_log();
+	iproto_connection_close(con);
+}
+
 /**
  * Handshake a connection: invoke the on-connect trigger
  * and possibly authenticate. Try to send the client an error
@@ -2098,7 +3071,7 @@ iproto_session_fd(struct session *session)
 {
 	struct iproto_connection *con =
 		(struct iproto_connection *) session->meta.connection;
-	return con->output.fd;
+	return iproto_connection_fd(con);
 }
 
 int64_t
@@ -2118,6 +3091,8 @@ iproto_process_push(struct cmsg *m)
 	struct iproto_connection *con =
 		container_of(kharon, struct iproto_connection, kharon);
 	con->wend = kharon->wpos;
+	if (con->wend.svp.pos > 0)
+		con->is_output_grown = true;
 	kharon->wpos = con->wpos;
 	if (evio_has_fd(&con->output) && !ev_is_active(&con->output))
 		ev_feed_event(con->loop, &con->output, EV_WRITE);
@@ -2150,6 +3125,46 @@ tx_end_push(struct cmsg *m)
 		tx_begin_push(con);
 }
 
+static void
+tx_release_output(struct cmsg *m)
+{
+	struct iproto_release_output *msg = (struct iproto_release_output *) m;
+	struct iproto_connection *con =
+		container_of(msg, struct iproto_connection, release_output);
+	struct obuf *obuf = con->tx.p_obuf;
+	/*
+	 * A push may have been written after the message
+	 * departed. The previous buffer is always flushed
+	 * before the current one.
+	 */
+	msg->is_released = !con->tx.is_push_sent &&
+			   msg->wpos.obuf == obuf &&
+			   msg->wpos.svp.used == obuf_size(obuf);
+	if (!msg->is_released)
+		return;
+	iproto_reset_output(&con->obuf[0]);
+	iproto_reset_output(&con->obuf[1]);
+	iproto_wpos_create(&msg->wpos, obuf);
+}
+
+static void
+net_end_release_output(struct cmsg *m)
+{
+	struct iproto_release_output *msg = (struct iproto_release_output *) m;
+	struct iproto_connection *con =
+		container_of(msg, struct iproto_connection, release_output);
+	con->is_output_release_sent = false;
+	/*
+	 * Any output tx has written after freeing the buffers
+	 * comes after this message, so nothing is lost.
+	 */
+	if (msg->is_released) {
+		con->wpos = msg->wpos;
+		con->wend = msg->wpos;
+		con->is_output_grown = false;
+	}
+}
+
 /**
  * Push a message from @a port to a remote client.
  * @param session iproto session.
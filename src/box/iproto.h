@@ -32,11 +32,14 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+struct cmsg;
+
 enum {
 	/** The minimal value for net_msg_max. */
 	IPROTO_MSG_MAX_MIN = 2,
@@ -56,6 +59,51 @@ enum {
 
 extern unsigned iproto_readahead;
 
+/**
+ * Classes of messages handled by the tx fiber pool, see
+ * box.cfg.net_msg_classes.
+ */
+enum iproto_msg_class {
+	/**
+	 * Connection events, AUTH, PING, VOTE, replication and
+	 * messages of other threads, e.g. relay status updates.
+	 */
+	IPROTO_MSG_CLASS_SYSTEM,
+	/** SELECT. */
+	IPROTO_MSG_CLASS_READ,
+	/** INSERT, REPLACE, UPDATE, DELETE, UPSERT and batches. */
+	IPROTO_MSG_CLASS_WRITE,
+	/** CALL, EVAL and SQL requests. */
+	IPROTO_MSG_CLASS_CALL,
+	iproto_msg_class_MAX
+};
+
+extern const char *iproto_msg_class_strs[];
+
+/**
+ * Return the class of a message delivered to the tx thread,
+ * a fiber_pool_classify_f of the tx fiber pool. CALL requests
+ * go to the class of the called function, if it is set with
+ * iproto_set_function_class().
+ */
+int
+iproto_msg_class(struct cmsg *msg);
+
+/**
+ * Make CALL requests of the function go to the class.
+ * @retval 0 Success.
+ * @retval -1 Memory error, diag is set.
+ */
+int
+iproto_set_function_class(const char *name, uint32_t name_len,
+			  enum iproto_msg_class cls);
+
+/**
+ * Make CALL requests of all functions go to the CALL class.
+ */
+void
+iproto_reset_function_classes(void);
+
 /**
  * Return size of memory used for storing network buffers.
  */
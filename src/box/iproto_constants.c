@@ -51,7 +51,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x0c */	MP_UINT,
 		/* 0x0d */	MP_UINT,
 		/* 0x0e */	MP_UINT,
-		/* 0x0f */	MP_UINT,
+	/* }}} */
+
+	/* {{{ header */
+		/* 0x0f */	MP_DOUBLE, /* IPROTO_TIMEOUT */
 	/* }}} */
 
 	/* {{{ body -- integer keys */
@@ -61,10 +64,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x13 */	MP_UINT, /* IPROTO_OFFSET */
 		/* 0x14 */	MP_UINT, /* IPROTO_ITERATOR */
 		/* 0x15 */	MP_UINT, /* IPROTO_INDEX_BASE */
+		/* 0x16 */	MP_UINT, /* IPROTO_CURSOR_ID */
 	/* }}} */
 
 	/* {{{ unused */
-		/* 0x16 */	MP_UINT,
 		/* 0x17 */	MP_UINT,
 		/* 0x18 */	MP_UINT,
 		/* 0x19 */	MP_UINT,
@@ -145,14 +148,14 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	NULL,               /* 0x0c */
 	NULL,               /* 0x0d */
 	NULL,               /* 0x0e */
-	NULL,               /* 0x0f */
+	"timeout",          /* 0x0f */
 	"space id",         /* 0x10 */
 	"index id",         /* 0x11 */
 	"limit",            /* 0x12 */
 	"offset",           /* 0x13 */
 	"iterator",         /* 0x14 */
 	"index base",       /* 0x15 */
-	NULL,               /* 0x16 */
+	"cursor id",        /* 0x16 */
 	NULL,               /* 0x17 */
 	NULL,               /* 0x18 */
 	NULL,               /* 0x19 */
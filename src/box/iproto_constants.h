@@ -67,6 +67,13 @@ enum iproto_key {
 	IPROTO_GROUP_ID = 0x07,
 	IPROTO_TSN = 0x08,
 	IPROTO_FLAGS = 0x09,
+	/**
+	 * Time in seconds the client waits for the response,
+	 * MP_DOUBLE or MP_UINT. The request is not executed if
+	 * it is not started in time. Takes the last key of the
+	 * header gap: 0x0a is reserved for IPROTO_STREAM_ID.
+	 */
+	IPROTO_TIMEOUT = 0x0f,
 	/* Leave a gap for other keys in the header. */
 	IPROTO_SPACE_ID = 0x10,
 	IPROTO_INDEX_ID = 0x11,
@@ -74,6 +81,7 @@ enum iproto_key {
 	IPROTO_OFFSET = 0x13,
 	IPROTO_ITERATOR = 0x14,
 	IPROTO_INDEX_BASE = 0x15,
+	IPROTO_CURSOR_ID = 0x16,
 
 	/* Leave a gap between integer values and other keys */
 	IPROTO_KEY = 0x20,
@@ -127,6 +135,9 @@ enum iproto_key {
 	IPROTO_REPLICA_ANON = 0x50,
 	IPROTO_ID_FILTER = 0x51,
 	IPROTO_ERROR = 0x52,
+	IPROTO_SPACE_FILTER = 0x53,
+	/** Function id for CALL instead of IPROTO_FUNCTION_NAME. */
+	IPROTO_FUNCTION_ID = 0x54,
 	IPROTO_KEY_MAX
 };
 
@@ -158,7 +169,8 @@ enum iproto_ballot_key {
 			  bit(LSN) | bit(SCHEMA_VERSION))
 #define IPROTO_DML_BODY_BMAP (bit(SPACE_ID) | bit(INDEX_ID) | bit(LIMIT) |\
 			      bit(OFFSET) | bit(ITERATOR) | bit(INDEX_BASE) |\
-			      bit(KEY) | bit(TUPLE) | bit(OPS) | bit(TUPLE_META))
+			      bit(KEY) | bit(TUPLE) | bit(OPS) | bit(TUPLE_META) |\
+			      bit(CURSOR_ID))
 
 static inline bool
 xrow_header_has_key(const char *pos, const char *end)
@@ -220,6 +232,30 @@ enum iproto_type {
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
+	/**
+	 * INSERT and REPLACE of many tuples of one space in one
+	 * transaction. The tuples are stored in IPROTO_TUPLE as
+	 * an array. Are not written to WAL as is: every tuple
+	 * becomes a usual INSERT or REPLACE row.
+	 */
+	IPROTO_INSERT_MANY = 20,
+	IPROTO_REPLACE_MANY = 21,
+	/**
+	 * Resolve IPROTO_FUNCTION_NAME to the function id for
+	 * CALL by IPROTO_FUNCTION_ID and check the access to it
+	 * once for the session. Returns the id as CALL does.
+	 */
+	IPROTO_PREPARE_CALL = 22,
+	/**
+	 * Server-side cursors: OPEN takes the arguments of SELECT
+	 * but LIMIT and OFFSET and returns IPROTO_CURSOR_ID, FETCH
+	 * returns the next IPROTO_LIMIT tuples of the cursor as
+	 * SELECT does, CLOSE drops it.
+	 */
+	IPROTO_CURSOR_OPEN = 23,
+	IPROTO_CURSOR_FETCH = 24,
+	IPROTO_CURSOR_CLOSE = 25,
+
 	IPROTO_RAFT = 30,
 
 	/** A confirmation message for synchronous transactions. */
@@ -241,6 +277,8 @@ enum iproto_type {
 	IPROTO_FETCH_SNAPSHOT = 69,
 	/** REGISTER request to leave anonymous replication. */
 	IPROTO_REGISTER = 70,
+	/** Switch the connection to a shared memory channel. */
+	IPROTO_SHM_ATTACH = 71,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -286,6 +324,18 @@ iproto_type_name(uint32_t type)
 		return iproto_type_strs[type];
 
 	switch (type) {
+	case IPROTO_INSERT_MANY:
+		return "INSERT_MANY";
+	case IPROTO_REPLACE_MANY:
+		return "REPLACE_MANY";
+	case IPROTO_PREPARE_CALL:
+		return "PREPARE_CALL";
+	case IPROTO_CURSOR_OPEN:
+		return "CURSOR_OPEN";
+	case IPROTO_CURSOR_FETCH:
+		return "CURSOR_FETCH";
+	case IPROTO_CURSOR_CLOSE:
+		return "CURSOR_CLOSE";
 	case IPROTO_CONFIRM:
 		return "CONFIRM";
 	case IPROTO_ROLLBACK:
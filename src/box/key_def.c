@@ -440,6 +440,15 @@ key_def_update_optionality(struct key_def *def, uint32_t min_field_count)
 	key_def_set_func(def);
 }
 
+void
+key_def_set_normalized_hint(struct key_def *def, bool value)
+{
+	if (def->has_normalized_hint == value)
+		return;
+	def->has_normalized_hint = value;
+	key_def_set_func(def);
+}
+
 int
 key_def_snprint_parts(char *buf, int size, const struct key_part_def *parts,
 		      uint32_t part_count)
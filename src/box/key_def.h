@@ -208,6 +208,12 @@ struct key_def {
 	 * fields assumed to be MP_NIL.
 	 */
 	bool has_optional_parts;
+	/**
+	 * True if comparison hints store a memcmp-comparable
+	 * prefix of the whole key rather than a hint of the
+	 * first key part. See index option normalized_key.
+	 */
+	bool has_normalized_hint;
 	/** Key fields mask. @sa column_mask.h for details. */
 	uint64_t column_mask;
 	/**
@@ -376,6 +382,15 @@ key_def_dump_parts(const struct key_def *def, struct key_part_def *parts,
 void
 key_def_update_optionality(struct key_def *def, uint32_t min_field_count);
 
+/**
+ * Switch comparison hints of @a key_def between normalized
+ * key prefixes and first key part hints.
+ * @param def Key definition to update.
+ * @param value True to use normalized key hints.
+ */
+void
+key_def_set_normalized_hint(struct key_def *def, bool value);
+
 /**
  * An snprint-style function to print a key definition.
  */
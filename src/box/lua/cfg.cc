@@ -37,12 +37,17 @@
 #include "lua/utils.h"
 
 #include "box/box.h"
+#include "box/error.h"
+#include "box/iproto.h"
 #include "libeio/eio.h"
 
 extern "C" {
 	#include <lua.h>
 } // extern "C"
 
+static int
+lbox_cfg_parse_net_msg_classes(struct lua_State *L, bool apply);
+
 static int
 lbox_cfg_check(struct lua_State *L)
 {
@@ -51,6 +56,18 @@ lbox_cfg_check(struct lua_State *L)
 	} catch (Exception *) {
 		luaT_error(L);
 	}
+	/*
+	 * box_check_config() can't look into a table option,
+	 * so box.cfg.net_msg_classes is checked here, before
+	 * any other option is applied.
+	 */
+	lua_getfield(L, LUA_GLOBALSINDEX, "box");
+	lua_getfield(L, -1, "cfg");
+	lua_getfield(L, -1, "net_msg_classes");
+	if (!lua_isnil(L, -1) &&
+	    lbox_cfg_parse_net_msg_classes(L, false) != 0)
+		return luaT_error(L);
+	lua_pop(L, 3);
 	return 0;
 }
 
@@ -197,6 +214,17 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_defrag_threshold(struct lua_State *L)
+{
+	try {
+		box_set_memtx_defrag_threshold();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_memory(struct lua_State *L)
 {
@@ -241,6 +269,126 @@ lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 	return 0;
 }
 
+/**
+ * Check a class of box.cfg.net_msg_classes at the top of the
+ * stack and, if @a apply is set, apply it.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+static int
+lbox_cfg_parse_net_msg_class(struct lua_State *L, int cls, bool apply)
+{
+	int weight = 1;
+	int max_size = 0;
+	lua_getfield(L, -1, "weight");
+	if (!lua_isnil(L, -1)) {
+		if (!lua_isnumber(L, -1) || lua_tointeger(L, -1) < 1) {
+			diag_set(ClientError, ER_CFG, "net_msg_classes",
+				 "weight must be a positive integer");
+			return -1;
+		}
+		weight = lua_tointeger(L, -1);
+	}
+	lua_pop(L, 1);
+	lua_getfield(L, -1, "max");
+	if (!lua_isnil(L, -1)) {
+		if (!lua_isnumber(L, -1) || lua_tointeger(L, -1) < 0) {
+			diag_set(ClientError, ER_CFG, "net_msg_classes",
+				 "max must be a non-negative integer");
+			return -1;
+		}
+		max_size = lua_tointeger(L, -1);
+	}
+	lua_pop(L, 1);
+	lua_getfield(L, -1, "functions");
+	if (!lua_isnil(L, -1) && !lua_istable(L, -1)) {
+		diag_set(ClientError, ER_CFG, "net_msg_classes",
+			 "functions must be an array of function names");
+		return -1;
+	}
+	int count = lua_isnil(L, -1) ? 0 : lua_objlen(L, -1);
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(L, -1, i);
+		if (lua_type(L, -1) != LUA_TSTRING) {
+			diag_set(ClientError, ER_CFG, "net_msg_classes",
+				 "functions must be an array of function names");
+			return -1;
+		}
+		size_t len;
+		const char *name = lua_tolstring(L, -1, &len);
+		if (apply && iproto_set_function_class(name, len,
+				(enum iproto_msg_class) cls) != 0)
+			return -1;
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+	if (apply)
+		box_set_net_msg_class(cls, weight, max_size);
+	return 0;
+}
+
+/**
+ * Check box.cfg.net_msg_classes at the top of the stack and, if
+ * @a apply is set, apply it. It is a table of classes of
+ * requests by their names, e.g.
+ *
+ *     {read = {weight = 4},
+ *      call = {weight = 1, max = 100, functions = {'report'}}}
+ *
+ * A class which is not mentioned gets weight 1 and no limit.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+static int
+lbox_cfg_parse_net_msg_classes(struct lua_State *L, bool apply)
+{
+	if (apply) {
+		iproto_reset_function_classes();
+		for (int i = 0; i < iproto_msg_class_MAX; i++)
+			box_set_net_msg_class(i, 1, 0);
+	}
+	lua_pushnil(L);
+	while (lua_next(L, -2) != 0) {
+		int cls = iproto_msg_class_MAX;
+		if (lua_type(L, -2) == LUA_TSTRING) {
+			cls = strindex(iproto_msg_class_strs,
+				       lua_tostring(L, -2),
+				       iproto_msg_class_MAX);
+		}
+		if (cls == iproto_msg_class_MAX || !lua_istable(L, -1)) {
+			diag_set(ClientError, ER_CFG, "net_msg_classes",
+				 "expected a table of classes 'system', "
+				 "'read', 'write' and 'call'");
+			return -1;
+		}
+		if (lbox_cfg_parse_net_msg_class(L, cls, apply) != 0)
+			return -1;
+		lua_pop(L, 1);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_net_msg_classes(struct lua_State *L)
+{
+	lua_getfield(L, LUA_GLOBALSINDEX, "box");
+	lua_getfield(L, -1, "cfg");
+	lua_getfield(L, -1, "net_msg_classes");
+	if (lua_isnil(L, -1)) {
+		iproto_reset_function_classes();
+		box_use_net_msg_classes(false);
+		return 0;
+	}
+	int top = lua_gettop(L);
+	if (lbox_cfg_parse_net_msg_classes(L, false) != 0)
+		return luaT_error(L);
+	lua_settop(L, top);
+	if (lbox_cfg_parse_net_msg_classes(L, true) != 0)
+		return luaT_error(L);
+	box_use_net_msg_classes(true);
+	return 0;
+}
+
 static int
 lbox_cfg_set_net_msg_max(struct lua_State *L)
 {
@@ -252,6 +400,22 @@ lbox_cfg_set_net_msg_max(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_net_cursor_max(struct lua_State *L)
+{
+	if (box_set_net_cursor_max() != 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_net_cursor_timeout(struct lua_State *L)
+{
+	if (box_set_net_cursor_timeout() != 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_set_prepared_stmt_cache_size(struct lua_State *L)
 {
@@ -402,6 +566,7 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_defrag_threshold", lbox_cfg_set_memtx_defrag_threshold},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
@@ -419,6 +584,9 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
 		{"cfg_set_replication_anon", lbox_cfg_set_replication_anon},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_net_msg_classes", lbox_cfg_set_net_msg_classes},
+		{"cfg_set_net_cursor_max", lbox_cfg_set_net_cursor_max},
+		{"cfg_set_net_cursor_timeout", lbox_cfg_set_net_cursor_timeout},
 		{"cfg_set_sql_cache_size", lbox_set_prepared_stmt_cache_size},
 		{NULL, NULL}
 	};
@@ -31,11 +31,16 @@
 #include "box/lua/index.h"
 #include "lua/utils.h"
 #include "lua/info.h"
+#include "lua/msgpack.h"
 #include "info/info.h"
 #include "box/box.h"
 #include "box/index.h"
+#include "box/error.h"
+#include "box/xrow.h"
+#include "box/iproto_constants.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+#include "msgpuck.h"
 
 /** {{{ box.index Lua library: access to spaces and indexes
  */
@@ -74,6 +79,42 @@ lbox_replace(lua_State *L)
 	return luaT_pushtupleornil(L, result);
 }
 
+static int
+lbox_insert_or_replace_many(lua_State *L, uint32_t type)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) ||
+	    lua_type(L, 2) != LUA_TTABLE)
+		return luaL_error(L, "Usage space:%s(tuples)",
+				  type == IPROTO_INSERT_MANY ? "insert_many" :
+				  "replace_many");
+
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = type;
+	request.space_id = lua_tonumber(L, 1);
+	size_t tuples_len;
+	request.tuple = lbox_encode_tuple_on_gc(L, 2, &tuples_len);
+	request.tuple_end = request.tuple + tuples_len;
+
+	uint32_t count;
+	if (box_process_many(&request, &count) != 0)
+		return luaT_error(L);
+	lua_pushinteger(L, count);
+	return 1;
+}
+
+static int
+lbox_insert_many(lua_State *L)
+{
+	return lbox_insert_or_replace_many(L, IPROTO_INSERT_MANY);
+}
+
+static int
+lbox_replace_many(lua_State *L)
+{
+	return lbox_insert_or_replace_many(L, IPROTO_REPLACE_MANY);
+}
+
 static int
 lbox_index_update(lua_State *L)
 {
@@ -328,6 +369,68 @@ lbox_index_compact(lua_State *L)
 	return 0;
 }
 
+static int
+lbox_index_checksum(lua_State *L)
+{
+	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2))
+		return luaL_error(L, "usage index.checksum(space_id, index_id, "
+				  "from, to)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t from_len, to_len;
+	const char *from = lbox_encode_tuple_on_gc(L, 3, &from_len);
+	const char *to = lbox_encode_tuple_on_gc(L, 4, &to_len);
+
+	uint32_t checksum;
+	uint64_t count;
+	if (box_index_checksum(space_id, index_id, from, from + from_len,
+			       to, to + to_len, &checksum, &count) != 0)
+		return luaT_error(L);
+	lua_pushinteger(L, checksum);
+	lua_pushnumber(L, count);
+	return 2;
+}
+
+static int
+lbox_index_aggregate(lua_State *L)
+{
+	if (lua_gettop(L) != 7 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_isstring(L, 3) || !lua_isnumber(L, 4) ||
+	    !lua_isnumber(L, 5) || !lua_isnumber(L, 6))
+		return luaL_error(L, "usage index.aggregate(space_id, index_id, "
+				  "func, part, filter_part, filter_type, "
+				  "filter_key)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	struct index_aggregate aggregate;
+	aggregate.func = STR2ENUM(aggregate_func, lua_tostring(L, 3));
+	if (aggregate.func == aggregate_func_MAX)
+		return luaL_error(L, "unknown aggregate function");
+	aggregate.part = lua_tonumber(L, 4);
+	aggregate.filter_part = lua_tonumber(L, 5);
+	aggregate.filter_type = lua_tonumber(L, 6);
+	size_t key_len;
+	const char *key = lbox_encode_tuple_on_gc(L, 7, &key_len);
+	uint32_t part_count = mp_decode_array(&key);
+	if (aggregate.filter_type != ITER_ALL && part_count != 1) {
+		diag_set(ClientError, ER_KEY_PART_COUNT, 1, part_count);
+		return luaT_error(L);
+	}
+	aggregate.filter_value = key;
+
+	char result[INDEX_AGGREGATE_RESULT_MAX];
+	char *result_end;
+	if (box_index_aggregate(space_id, index_id, &aggregate,
+				result, &result_end) != 0)
+		return luaT_error(L);
+	assert(result_end <= result + sizeof(result));
+	const char *data = result;
+	luamp_decode(L, luaL_msgpack_default, &data);
+	return 1;
+}
+
 /* }}} */
 
 void
@@ -352,6 +455,8 @@ box_lua_index_init(struct lua_State *L)
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"insert", lbox_insert},
 		{"replace",  lbox_replace},
+		{"insert_many", lbox_insert_many},
+		{"replace_many", lbox_replace_many},
 		{"update", lbox_index_update},
 		{"upsert",  lbox_upsert},
 		{"delete",  lbox_index_delete},
@@ -365,6 +470,8 @@ box_lua_index_init(struct lua_State *L)
 		{"truncate", lbox_truncate},
 		{"stat", lbox_index_stat},
 		{"compact", lbox_index_compact},
+		{"checksum", lbox_index_checksum},
+		{"aggregate", lbox_index_aggregate},
 		{NULL, NULL}
 	};
 
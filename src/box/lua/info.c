@@ -82,6 +82,19 @@ lbox_push_replication_error_message(struct lua_State *L, struct error *e,
 	lua_settable(L, idx - 2);
 }
 
+void
+lbox_pushlatency(struct lua_State *L, const char *name,
+		 double p50, double p99)
+{
+	lua_pushstring(L, name);
+	lua_createtable(L, 0, 2);
+	lua_pushnumber(L, p50);
+	lua_setfield(L, -2, "p50");
+	lua_pushnumber(L, p99);
+	lua_setfield(L, -2, "p99");
+	lua_settable(L, -3);
+}
+
 static void
 lbox_pushapplier(lua_State *L, struct applier *applier)
 {
@@ -107,6 +120,16 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 			       applier->last_row_time);
 		lua_settable(L, -3);
 
+		lua_pushstring(L, "latency");
+		lua_createtable(L, 0, 2);
+		lbox_pushlatency(L, "apply",
+				 latency_get(&applier->apply_latency, 50),
+				 latency_get(&applier->apply_latency, 99));
+		lbox_pushlatency(L, "wal",
+				 latency_get(&applier->wal_latency, 50),
+				 latency_get(&applier->wal_latency, 99));
+		lua_settable(L, -3);
+
 		char name[APPLIER_SOURCE_MAXLEN];
 		int total = uri_format(name, sizeof(name), &applier->uri, false);
 		/*
@@ -142,6 +165,13 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 		lua_pushnumber(L, ev_monotonic_now(loop()) -
 			       relay_last_row_time(relay));
 		lua_settable(L, -3);
+		const struct relay_stat *stat = relay_get_stat(relay);
+		lua_pushstring(L, "latency");
+		lua_createtable(L, 0, 3);
+		lbox_pushlatency(L, "read", stat->read_p50, stat->read_p99);
+		lbox_pushlatency(L, "send", stat->send_p50, stat->send_p99);
+		lbox_pushlatency(L, "ack", stat->ack_p50, stat->ack_p99);
+		lua_settable(L, -3);
 		break;
 	case RELAY_STOPPED:
 	{
@@ -42,6 +42,14 @@ struct info_handler;
 void
 box_lua_info_init(struct lua_State *L);
 
+/**
+ * Push a table with 50th and 99th percentiles of a replication
+ * stage latency to the table on top of the stack, under @a name.
+ */
+void
+lbox_pushlatency(struct lua_State *L, const char *name,
+		 double p50, double p99);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -44,6 +44,7 @@
 #include "box/vclock.h"
 #include "box/session.h"
 #include "box/mp_error.h"
+#include "box/tuple_compression.h"
 
 #include "box/lua/error.h"
 #include "box/lua/tuple.h"
@@ -421,12 +422,27 @@ luamp_encode_extension_box(struct lua_State *L, int idx,
 }
 
 /**
- * A MsgPack extensions handler that supports errors decode.
+ * A MsgPack extensions handler that supports errors and
+ * compressed fields decode.
  */
 static void
 luamp_decode_extension_box(struct lua_State *L, const char **data)
 {
 	assert(mp_typeof(**data) == MP_EXT);
+	if (mp_is_compressed(*data)) {
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		uint32_t size;
+		const char *field = mp_decompress(data, &size);
+		if (field == NULL) {
+			region_truncate(region, region_svp);
+			luaT_error(L);
+			return;
+		}
+		luamp_decode(L, luaL_msgpack_default, &field);
+		region_truncate(region, region_svp);
+		return;
+	}
 	int8_t ext_type;
 	uint32_t len = mp_decode_extl(data, &ext_type);
 
@@ -42,6 +42,8 @@ local default_cfg = {
     strip_core          = true,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_use_huge_pages = false,
+    memtx_defrag_threshold = 0,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -103,6 +105,8 @@ local default_cfg = {
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    net_cursor_max        = 64,
+    net_cursor_timeout    = 60,
     sql_cache_size        = 5 * 1024 * 1024,
 }
 
@@ -123,6 +127,8 @@ local template_cfg = {
     strip_core          = 'boolean',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_use_huge_pages  = 'boolean',
+    memtx_defrag_threshold = 'number',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -180,10 +186,14 @@ local template_cfg = {
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
     replication_anon      = 'boolean',
+    replication_space_filter = 'number, table',
     feedback_enabled      = ifdef_feedback('boolean'),
     feedback_host         = ifdef_feedback('string'),
     feedback_interval     = ifdef_feedback('number'),
     net_msg_max           = 'number',
+    net_msg_classes       = 'table',
+    net_cursor_max        = 'number',
+    net_cursor_timeout    = 'number',
     sql_cache_size        = 'number',
 }
 
@@ -270,6 +280,7 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_defrag_threshold  = private.cfg_set_memtx_defrag_threshold,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
@@ -302,6 +313,9 @@ local dynamic_cfg = {
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
+    net_msg_classes         = private.cfg_set_net_msg_classes,
+    net_cursor_max          = private.cfg_set_net_cursor_max,
+    net_cursor_timeout      = private.cfg_set_net_cursor_timeout,
     sql_cache_size          = private.cfg_set_sql_cache_size,
 }
 
@@ -359,6 +373,7 @@ local dynamic_cfg_skip_at_load = {
     listen                  = true,
     memtx_memory            = true,
     memtx_max_tuple_size    = true,
+    memtx_defrag_threshold  = true,
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
@@ -383,6 +398,8 @@ local dynamic_cfg_skip_at_load = {
     instance_uuid           = true,
     replicaset_uuid         = true,
     net_msg_max             = true,
+    net_cursor_max          = true,
+    net_cursor_timeout      = true,
     readahead               = true,
 }
 
@@ -532,7 +549,8 @@ local function apply_default_cfg(cfg, default_cfg, module_cfg)
     end
 end
 
--- Return true if two configurations are equivalent.
+-- Return true if two configurations are equivalent. Tables are
+-- compared recursively, so a change of a nested map is noticed.
 local function compare_cfg(cfg1, cfg2)
     if type(cfg1) ~= type(cfg2) then
         return false
@@ -540,11 +558,13 @@ local function compare_cfg(cfg1, cfg2)
     if type(cfg1) ~= 'table' then
         return cfg1 == cfg2
     end
-    if #cfg1 ~= #cfg2 then
-        return false
+    for k, v in pairs(cfg1) do
+        if not compare_cfg(v, cfg2[k]) then
+            return false
+        end
     end
-    for k, v in ipairs(cfg1) do
-        if v ~= cfg2[k] then
+    for k in pairs(cfg2) do
+        if cfg1[k] == nil then
             return false
         end
     end
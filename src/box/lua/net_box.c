@@ -40,11 +40,19 @@
 #include "box/xrow.h"
 #include "box/tuple.h"
 #include "box/execute.h"
+#include "box/error.h"
+#include "box/mp_error.h"
 
 #include "lua/msgpack.h"
+#include "lua/error.h"
+#include "lua/utils.h"
 #include "third_party/base64.h"
 
+#include "assoc.h"
 #include "coio.h"
+#include "fiber_cond.h"
+#include "sio.h"
+#include "shm_channel.h"
 #include "box/errcode.h"
 #include "lua/fiber.h"
 #include "mpstream/mpstream.h"
@@ -57,6 +65,11 @@ netbox_prepare_request(lua_State *L, struct mpstream *stream, uint32_t r_type)
 {
 	struct ibuf *ibuf = (struct ibuf *) lua_topointer(L, 1);
 	uint64_t sync = luaL_touint64(L, 2);
+	/*
+	 * Time the client waits for the response, see
+	 * IPROTO_TIMEOUT. nil if the request has no timeout.
+	 */
+	double timeout = lua_isnil(L, 3) ? 0 : lua_tonumber(L, 3);
 
 	mpstream_init(stream, ibuf, ibuf_reserve_cb, ibuf_alloc_cb,
 		      luamp_error, L);
@@ -70,7 +83,7 @@ netbox_prepare_request(lua_State *L, struct mpstream *stream, uint32_t r_type)
 	mpstream_advance(stream, fixheader_size);
 
 	/* encode header */
-	mpstream_encode_map(stream, 2);
+	mpstream_encode_map(stream, timeout > 0 ? 3 : 2);
 
 	mpstream_encode_uint(stream, IPROTO_SYNC);
 	mpstream_encode_uint(stream, sync);
@@ -78,6 +91,11 @@ netbox_prepare_request(lua_State *L, struct mpstream *stream, uint32_t r_type)
 	mpstream_encode_uint(stream, IPROTO_REQUEST_TYPE);
 	mpstream_encode_uint(stream, r_type);
 
+	if (timeout > 0) {
+		mpstream_encode_uint(stream, IPROTO_TIMEOUT);
+		mpstream_encode_double(stream, timeout);
+	}
+
 	/* Caller should remember how many bytes was used in ibuf */
 	return used;
 }
@@ -111,8 +129,9 @@ netbox_encode_request(struct mpstream *stream, size_t initial_size)
 static int
 netbox_encode_ping(lua_State *L)
 {
-	if (lua_gettop(L) < 2)
-		return luaL_error(L, "Usage: netbox.encode_ping(ibuf, sync)");
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_ping(ibuf, sync, "
+				  "timeout)");
 
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PING);
@@ -123,20 +142,20 @@ netbox_encode_ping(lua_State *L)
 static int
 netbox_encode_auth(lua_State *L)
 {
-	if (lua_gettop(L) < 5) {
+	if (lua_gettop(L) < 6) {
 		return luaL_error(L, "Usage: netbox.encode_update(ibuf, sync, "
-				     "user, password, greeting)");
+				     "timeout, user, password, greeting)");
 	}
 
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_AUTH);
 
 	size_t user_len;
-	const char *user = lua_tolstring(L, 3, &user_len);
+	const char *user = lua_tolstring(L, 4, &user_len);
 	size_t password_len;
-	const char *password = lua_tolstring(L, 4, &password_len);
+	const char *password = lua_tolstring(L, 5, &password_len);
 	size_t salt_len;
-	const char *salt = lua_tolstring(L, 5, &salt_len);
+	const char *salt = lua_tolstring(L, 6, &salt_len);
 	if (salt_len < SCRAMBLE_SIZE)
 		return luaL_error(L, "Invalid salt");
 
@@ -160,9 +179,9 @@ netbox_encode_auth(lua_State *L)
 static int
 netbox_encode_call_impl(lua_State *L, enum iproto_type type)
 {
-	if (lua_gettop(L) < 4) {
+	if (lua_gettop(L) < 5) {
 		return luaL_error(L, "Usage: netbox.encode_call(ibuf, sync, "
-				     "function_name, args)");
+				     "timeout, function_name, args)");
 	}
 
 	struct mpstream stream;
@@ -170,15 +189,21 @@ netbox_encode_call_impl(lua_State *L, enum iproto_type type)
 
 	mpstream_encode_map(&stream, 2);
 
-	/* encode proc name */
-	size_t name_len;
-	const char *name = lua_tolstring(L, 3, &name_len);
-	mpstream_encode_uint(&stream, IPROTO_FUNCTION_NAME);
-	mpstream_encode_strn(&stream, name, name_len);
+	/* encode proc name or id, see netbox_encode_prepare_call() */
+	if (lua_type(L, 4) == LUA_TNUMBER) {
+		uint32_t func_id = lua_tointeger(L, 4);
+		mpstream_encode_uint(&stream, IPROTO_FUNCTION_ID);
+		mpstream_encode_uint(&stream, func_id);
+	} else {
+		size_t name_len;
+		const char *name = lua_tolstring(L, 4, &name_len);
+		mpstream_encode_uint(&stream, IPROTO_FUNCTION_NAME);
+		mpstream_encode_strn(&stream, name, name_len);
+	}
 
 	/* encode args */
 	mpstream_encode_uint(&stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -197,11 +222,33 @@ netbox_encode_call(lua_State *L)
 }
 
 static int
-netbox_encode_eval(lua_State *L)
+netbox_encode_prepare_call(lua_State *L)
 {
 	if (lua_gettop(L) < 4) {
+		return luaL_error(L, "Usage: netbox.encode_prepare_call(ibuf, "
+				     "sync, timeout, function_name)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE_CALL);
+
+	mpstream_encode_map(&stream, 1);
+
+	size_t name_len;
+	const char *name = lua_tolstring(L, 4, &name_len);
+	mpstream_encode_uint(&stream, IPROTO_FUNCTION_NAME);
+	mpstream_encode_strn(&stream, name, name_len);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_eval(lua_State *L)
+{
+	if (lua_gettop(L) < 5) {
 		return luaL_error(L, "Usage: netbox.encode_eval(ibuf, sync, "
-				     "expr, args)");
+				     "timeout, expr, args)");
 	}
 
 	struct mpstream stream;
@@ -211,13 +258,13 @@ netbox_encode_eval(lua_State *L)
 
 	/* encode expr */
 	size_t expr_len;
-	const char *expr = lua_tolstring(L, 3, &expr_len);
+	const char *expr = lua_tolstring(L, 4, &expr_len);
 	mpstream_encode_uint(&stream, IPROTO_EXPR);
 	mpstream_encode_strn(&stream, expr, expr_len);
 
 	/* encode args */
 	mpstream_encode_uint(&stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -226,10 +273,10 @@ netbox_encode_eval(lua_State *L)
 static int
 netbox_encode_select(lua_State *L)
 {
-	if (lua_gettop(L) < 8) {
+	if (lua_gettop(L) < 9) {
 		return luaL_error(L, "Usage netbox.encode_select(ibuf, sync, "
-				     "space_id, index_id, iterator, offset, "
-				     "limit, key)");
+				     "timeout, space_id, index_id, iterator, "
+				     "offset, limit, key)");
 	}
 
 	struct mpstream stream;
@@ -237,11 +284,11 @@ netbox_encode_select(lua_State *L)
 
 	mpstream_encode_map(&stream, 6);
 
-	uint32_t space_id = lua_tonumber(L, 3);
-	uint32_t index_id = lua_tonumber(L, 4);
-	int iterator = lua_tointeger(L, 5);
-	uint32_t offset = lua_tonumber(L, 6);
-	uint32_t limit = lua_tonumber(L, 7);
+	uint32_t space_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
+	int iterator = lua_tointeger(L, 6);
+	uint32_t offset = lua_tonumber(L, 7);
+	uint32_t limit = lua_tonumber(L, 8);
 
 	/* encode space_id */
 	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
@@ -265,7 +312,84 @@ netbox_encode_select(lua_State *L)
 
 	/* encode key */
 	mpstream_encode_uint(&stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 8);
+	luamp_convert_key(L, cfg, &stream, 9);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_open(lua_State *L)
+{
+	if (lua_gettop(L) < 7) {
+		return luaL_error(L, "Usage netbox.encode_cursor_open(ibuf, "
+				     "sync, timeout, space_id, index_id, "
+				     "iterator, key)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_OPEN);
+
+	mpstream_encode_map(&stream, 4);
+
+	uint32_t space_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
+	int iterator = lua_tointeger(L, 6);
+
+	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
+	mpstream_encode_uint(&stream, space_id);
+	mpstream_encode_uint(&stream, IPROTO_INDEX_ID);
+	mpstream_encode_uint(&stream, index_id);
+	mpstream_encode_uint(&stream, IPROTO_ITERATOR);
+	mpstream_encode_uint(&stream, iterator);
+	mpstream_encode_uint(&stream, IPROTO_KEY);
+	luamp_convert_key(L, cfg, &stream, 7);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_fetch(lua_State *L)
+{
+	if (lua_gettop(L) < 5) {
+		return luaL_error(L, "Usage netbox.encode_cursor_fetch(ibuf, "
+				     "sync, timeout, cursor_id, limit)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_FETCH);
+
+	mpstream_encode_map(&stream, 2);
+
+	uint32_t cursor_id = lua_tonumber(L, 4);
+	uint32_t limit = lua_tonumber(L, 5);
+
+	mpstream_encode_uint(&stream, IPROTO_CURSOR_ID);
+	mpstream_encode_uint(&stream, cursor_id);
+	mpstream_encode_uint(&stream, IPROTO_LIMIT);
+	mpstream_encode_uint(&stream, limit);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_close(lua_State *L)
+{
+	if (lua_gettop(L) < 4) {
+		return luaL_error(L, "Usage netbox.encode_cursor_close(ibuf, "
+				     "sync, timeout, cursor_id)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_CLOSE);
+
+	mpstream_encode_map(&stream, 1);
+
+	uint32_t cursor_id = lua_tonumber(L, 4);
+	mpstream_encode_uint(&stream, IPROTO_CURSOR_ID);
+	mpstream_encode_uint(&stream, cursor_id);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -274,9 +398,9 @@ netbox_encode_select(lua_State *L)
 static inline int
 netbox_encode_insert_or_replace(lua_State *L, uint32_t reqtype)
 {
-	if (lua_gettop(L) < 4) {
+	if (lua_gettop(L) < 5) {
 		return luaL_error(L, "Usage: netbox.encode_insert(ibuf, sync, "
-				     "space_id, tuple)");
+				     "timeout, space_id, tuple)");
 	}
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, reqtype);
@@ -284,13 +408,13 @@ netbox_encode_insert_or_replace(lua_State *L, uint32_t reqtype)
 	mpstream_encode_map(&stream, 2);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
 	mpstream_encode_uint(&stream, space_id);
 
 	/* encode args */
 	mpstream_encode_uint(&stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -308,12 +432,59 @@ netbox_encode_replace(lua_State *L)
 	return netbox_encode_insert_or_replace(L, IPROTO_REPLACE);
 }
 
+/**
+ * Encode INSERT_MANY or REPLACE_MANY: the argument 4 is a Lua
+ * array of tuples or tables.
+ */
+static inline int
+netbox_encode_insert_or_replace_many(lua_State *L, uint32_t reqtype)
+{
+	if (lua_gettop(L) < 5 || lua_type(L, 5) != LUA_TTABLE) {
+		return luaL_error(L, "Usage: netbox.encode_insert_many(ibuf, "
+				     "sync, timeout, space_id, tuples)");
+	}
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, reqtype);
+
+	mpstream_encode_map(&stream, 2);
+
+	/* encode space_id */
+	uint32_t space_id = lua_tonumber(L, 4);
+	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
+	mpstream_encode_uint(&stream, space_id);
+
+	/* encode tuples */
+	mpstream_encode_uint(&stream, IPROTO_TUPLE);
+	uint32_t count = lua_objlen(L, 5);
+	mpstream_encode_array(&stream, count);
+	for (uint32_t i = 1; i <= count; i++) {
+		lua_rawgeti(L, 5, i);
+		luamp_encode_tuple(L, cfg, &stream, lua_gettop(L));
+		lua_pop(L, 1);
+	}
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_insert_many(lua_State *L)
+{
+	return netbox_encode_insert_or_replace_many(L, IPROTO_INSERT_MANY);
+}
+
+static int
+netbox_encode_replace_many(lua_State *L)
+{
+	return netbox_encode_insert_or_replace_many(L, IPROTO_REPLACE_MANY);
+}
+
 static int
 netbox_encode_delete(lua_State *L)
 {
-	if (lua_gettop(L) < 5) {
+	if (lua_gettop(L) < 6) {
 		return luaL_error(L, "Usage: netbox.encode_delete(ibuf, sync, "
-				     "space_id, index_id, key)");
+				     "timeout, space_id, index_id, key)");
 	}
 
 	struct mpstream stream;
@@ -322,18 +493,18 @@ netbox_encode_delete(lua_State *L)
 	mpstream_encode_map(&stream, 3);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
 	mpstream_encode_uint(&stream, space_id);
 
 	/* encode space_id */
-	uint32_t index_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
 	mpstream_encode_uint(&stream, IPROTO_INDEX_ID);
 	mpstream_encode_uint(&stream, index_id);
 
 	/* encode key */
 	mpstream_encode_uint(&stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 5);
+	luamp_convert_key(L, cfg, &stream, 6);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -342,9 +513,9 @@ netbox_encode_delete(lua_State *L)
 static int
 netbox_encode_update(lua_State *L)
 {
-	if (lua_gettop(L) < 6) {
+	if (lua_gettop(L) < 7) {
 		return luaL_error(L, "Usage: netbox.encode_update(ibuf, sync, "
-				     "space_id, index_id, key, ops)");
+				     "timeout, space_id, index_id, key, ops)");
 	}
 
 	struct mpstream stream;
@@ -353,12 +524,12 @@ netbox_encode_update(lua_State *L)
 	mpstream_encode_map(&stream, 5);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
 	mpstream_encode_uint(&stream, space_id);
 
 	/* encode index_id */
-	uint32_t index_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
 	mpstream_encode_uint(&stream, IPROTO_INDEX_ID);
 	mpstream_encode_uint(&stream, index_id);
 
@@ -369,12 +540,12 @@ netbox_encode_update(lua_State *L)
 	/* encode in reverse order for speedup - see luamp_encode() code */
 	/* encode ops */
 	mpstream_encode_uint(&stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 6);
+	luamp_encode_tuple(L, cfg, &stream, 7);
 	lua_pop(L, 1); /* ops */
 
 	/* encode key */
 	mpstream_encode_uint(&stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 5);
+	luamp_convert_key(L, cfg, &stream, 6);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -383,9 +554,9 @@ netbox_encode_update(lua_State *L)
 static int
 netbox_encode_upsert(lua_State *L)
 {
-	if (lua_gettop(L) != 5) {
+	if (lua_gettop(L) != 6) {
 		return luaL_error(L, "Usage: netbox.encode_upsert(ibuf, sync, "
-				     "space_id, tuple, ops)");
+				     "timeout, space_id, tuple, ops)");
 	}
 
 	struct mpstream stream;
@@ -394,7 +565,7 @@ netbox_encode_upsert(lua_State *L)
 	mpstream_encode_map(&stream, 4);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
 	mpstream_encode_uint(&stream, space_id);
 
@@ -405,12 +576,12 @@ netbox_encode_upsert(lua_State *L)
 	/* encode in reverse order for speedup - see luamp_encode() code */
 	/* encode ops */
 	mpstream_encode_uint(&stream, IPROTO_OPS);
-	luamp_encode_tuple(L, cfg, &stream, 5);
+	luamp_encode_tuple(L, cfg, &stream, 6);
 	lua_pop(L, 1); /* ops */
 
 	/* encode tuple */
 	mpstream_encode_uint(&stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -559,33 +730,284 @@ handle_error:
 	return 2;
 }
 
+static const char netbox_shm_typename[] = "net.box.shm";
+
+/** The client end of a shared memory connection. */
+struct netbox_shm {
+	struct shm_channel channel;
+	/** Signalled when there's data for the server to read. */
+	int input_fd;
+	/** Signalled when the server may write more. */
+	int output_fd;
+	/** Signalled by the server, the client sleeps on it. */
+	int fd;
+	bool is_closed;
+};
+
+static inline struct netbox_shm *
+netbox_check_shm(struct lua_State *L, int idx)
+{
+	return (struct netbox_shm *) luaL_checkudata(L, idx,
+						     netbox_shm_typename);
+}
+
+static int
+netbox_shm_close(struct lua_State *L)
+{
+	struct netbox_shm *shm = netbox_check_shm(L, 1);
+	if (shm->is_closed)
+		return 0;
+	shm->is_closed = true;
+	shm_channel_close(&shm->channel);
+	/* Wake up the server to let it see the channel closed. */
+	shm_notify_signal(shm->input_fd);
+	shm_channel_destroy(&shm->channel);
+	close(shm->input_fd);
+	close(shm->output_fd);
+	close(shm->fd);
+	return 0;
+}
+
+static int
+netbox_encode_shm_attach(lua_State *L)
+{
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_shm_attach(ibuf, "
+				  "sync, timeout)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SHM_ATTACH);
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+/**
+ * shm_attach(fd, send_buf, recv_buf, timeout)
+ *  -> errno, error
+ *  -> nil, shm
+ *  -> nil, nil
+ *
+ * Send an encoded IPROTO_SHM_ATTACH request and receive the
+ * response to recv_buf along with the descriptors of a shared
+ * memory channel, which is returned. If the server refused to
+ * attach, the channel is nil and the error is in the response.
+ */
+static int
+netbox_shm_attach(lua_State *L)
+{
+	uint32_t fd = lua_tonumber(L, 1);
+	struct ibuf *send_buf = (struct ibuf *) lua_topointer(L, 2);
+	struct ibuf *recv_buf = (struct ibuf *) lua_topointer(L, 3);
+	ev_tstamp timeout = TIMEOUT_INFINITY;
+	if (lua_type(L, 4) == LUA_TNUMBER)
+		timeout = lua_tonumber(L, 4);
+
+	ev_tstamp deadline = ev_monotonic_now(loop()) + timeout;
+	if (coio_write_fd_timeout(fd, send_buf->rpos, ibuf_used(send_buf),
+				  timeout) != 0)
+		goto error;
+	send_buf->rpos = send_buf->wpos;
+
+	int fds[SIO_FDS_MAX];
+	int fd_count = 0;
+	/* Receive the whole response, the descriptors come with it. */
+	size_t required = 5;
+	while (ibuf_used(recv_buf) < required) {
+		if (ibuf_reserve(recv_buf, required) == NULL)
+			luaL_error(L, "out of memory");
+		int received[SIO_FDS_MAX];
+		int count;
+		ssize_t rc = sio_recvfds(fd, recv_buf->wpos,
+					 required - ibuf_used(recv_buf),
+					 received, &count);
+		for (int i = 0; i < count; i++) {
+			if (fd_count < SIO_FDS_MAX)
+				fds[fd_count++] = received[i];
+			else
+				close(received[i]);
+		}
+		if (rc == 0) {
+			diag_set(SocketError, sio_socketname(fd), "Peer closed");
+			goto error_close;
+		} else if (rc < 0 && sio_wouldblock(errno)) {
+			timeout = deadline - ev_monotonic_now(loop());
+			if (timeout <= 0) {
+				diag_set(TimedOut);
+				goto error_close;
+			}
+			coio_wait(fd, COIO_READ, timeout);
+			luaL_testcancel(L);
+			continue;
+		} else if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			goto error_close;
+		}
+		recv_buf->wpos += rc;
+		if (ibuf_used(recv_buf) == 5) {
+			const char *p = recv_buf->rpos;
+			if (mp_typeof(*p) != MP_UINT ||
+			    mp_check_uint(p, recv_buf->wpos) > 0) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "packet length");
+				goto error_close;
+			}
+			uint64_t len = mp_decode_uint(&p);
+			required = (p - recv_buf->rpos) + len;
+		}
+	}
+	struct netbox_shm *shm = NULL;
+	if (fd_count == 4) {
+		shm = (struct netbox_shm *) lua_newuserdata(L, sizeof(*shm));
+		if (shm_channel_attach(&shm->channel, fds[0]) != 0)
+			goto error_close;
+		close(fds[0]);
+		shm->input_fd = fds[1];
+		shm->output_fd = fds[2];
+		shm->fd = fds[3];
+		shm->is_closed = false;
+		luaL_getmetatable(L, netbox_shm_typename);
+		lua_setmetatable(L, -2);
+	} else {
+		for (int i = 0; i < fd_count; i++)
+			close(fds[i]);
+		lua_pushnil(L);
+	}
+	lua_pushnil(L);
+	lua_insert(L, -2);
+	return 2;
+error_close:
+	for (int i = 0; i < fd_count; i++)
+		close(fds[i]);
+error:;
+	struct error *e = diag_last_error(diag_get());
+	lua_pushinteger(L, e->saved_errno == ETIMEDOUT ? ER_TIMEOUT :
+			ER_NO_CONNECTION);
+	lua_pushstring(L, e->errmsg);
+	return 2;
+}
+
+/**
+ * shm_communicate(shm, send_buf, recv_buf, limit, timeout)
+ *  -> errno, error
+ *  -> nil, limit
+ *
+ * The same as communicate(), but over a shared memory channel
+ * returned by shm_attach().
+ */
+static int
+netbox_shm_communicate(lua_State *L)
+{
+	struct netbox_shm *shm = netbox_check_shm(L, 1);
+	struct shm_channel *channel = &shm->channel;
+	const int NETBOX_READAHEAD = 16320;
+	struct ibuf *send_buf = (struct ibuf *) lua_topointer(L, 2);
+	struct ibuf *recv_buf = (struct ibuf *) lua_topointer(L, 3);
+	size_t limit = lua_tonumber(L, 4);
+
+	ev_tstamp timeout = TIMEOUT_INFINITY;
+	if (lua_type(L, 5) == LUA_TNUMBER)
+		timeout = lua_tonumber(L, 5);
+	if (timeout < 0) {
+		lua_pushinteger(L, ER_TIMEOUT);
+		lua_pushstring(L, "Timeout exceeded");
+		return 2;
+	}
+	if (shm->is_closed) {
+		lua_pushinteger(L, ER_NO_CONNECTION);
+		lua_pushstring(L, "Connection closed");
+		return 2;
+	}
+	while (true) {
+		/* reader serviced first */
+		if (ibuf_used(recv_buf) >= limit) {
+			lua_pushnil(L);
+			lua_pushinteger(L, (lua_Integer)limit);
+			return 2;
+		}
+		if (ibuf_reserve(recv_buf, NETBOX_READAHEAD) == NULL)
+			luaL_error(L, "out of memory");
+		size_t nrd = shm_channel_read(channel, recv_buf->wpos,
+					      ibuf_unused(recv_buf));
+		if (nrd > 0) {
+			recv_buf->wpos += nrd;
+			if (shm_channel_peer_waits_space(channel))
+				shm_notify_signal(shm->output_fd);
+			continue;
+		}
+		if (ibuf_used(send_buf) != 0 &&
+		    ! shm_channel_is_closed(channel)) {
+			size_t nwr = shm_channel_write(channel, send_buf->rpos,
+						       ibuf_used(send_buf));
+			if (nwr > 0) {
+				send_buf->rpos += nwr;
+				if (shm_channel_peer_waits_data(channel))
+					shm_notify_signal(shm->input_fd);
+				continue;
+			}
+		}
+		/*
+		 * The server sets the flag before signalling, so
+		 * it's checked after clearing not to miss it.
+		 */
+		shm_notify_clear(shm->fd);
+		if (shm_channel_is_closed(channel)) {
+			lua_pushinteger(L, ER_NO_CONNECTION);
+			lua_pushstring(L, "Peer closed");
+			return 2;
+		}
+		if (! shm_channel_prepare_read_wait(channel))
+			continue;
+		if (ibuf_used(send_buf) != 0 &&
+		    ! shm_channel_prepare_write_wait(channel, 1))
+			continue;
+
+		ev_tstamp deadline = ev_monotonic_now(loop()) + timeout;
+		int revents = coio_wait(shm->fd, EV_READ, timeout);
+		luaL_testcancel(L);
+		if (shm->is_closed) {
+			lua_pushinteger(L, ER_NO_CONNECTION);
+			lua_pushstring(L, "Connection closed");
+			return 2;
+		}
+		timeout = deadline - ev_monotonic_now(loop());
+		timeout = MAX(0.0, timeout);
+		if (revents == 0 && timeout == 0.0) {
+			lua_pushinteger(L, ER_TIMEOUT);
+			lua_pushstring(L, "Timeout exceeded");
+			return 2;
+		}
+	}
+}
+
 static int
 netbox_encode_execute(lua_State *L)
 {
-	if (lua_gettop(L) < 5)
+	if (lua_gettop(L) < 6)
 		return luaL_error(L, "Usage: netbox.encode_execute(ibuf, "\
-				  "sync, query, parameters, options)");
+				  "sync, timeout, query, parameters, "\
+				  "options)");
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_EXECUTE);
 
 	mpstream_encode_map(&stream, 3);
 
-	if (lua_type(L, 3) == LUA_TNUMBER) {
-		uint32_t query_id = lua_tointeger(L, 3);
+	if (lua_type(L, 4) == LUA_TNUMBER) {
+		uint32_t query_id = lua_tointeger(L, 4);
 		mpstream_encode_uint(&stream, IPROTO_STMT_ID);
 		mpstream_encode_uint(&stream, query_id);
 	} else {
 		size_t len;
-		const char *query = lua_tolstring(L, 3, &len);
+		const char *query = lua_tolstring(L, 4, &len);
 		mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
 		mpstream_encode_strn(&stream, query, len);
 	}
 
 	mpstream_encode_uint(&stream, IPROTO_SQL_BIND);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	mpstream_encode_uint(&stream, IPROTO_OPTIONS);
-	luamp_encode_tuple(L, cfg, &stream, 5);
+	luamp_encode_tuple(L, cfg, &stream, 6);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -594,21 +1016,21 @@ netbox_encode_execute(lua_State *L)
 static int
 netbox_encode_prepare(lua_State *L)
 {
-	if (lua_gettop(L) < 3)
+	if (lua_gettop(L) < 4)
 		return luaL_error(L, "Usage: netbox.encode_prepare(ibuf, "\
-				     "sync, query)");
+				     "sync, timeout, query)");
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE);
 
 	mpstream_encode_map(&stream, 1);
 
-	if (lua_type(L, 3) == LUA_TNUMBER) {
-		uint32_t query_id = lua_tointeger(L, 3);
+	if (lua_type(L, 4) == LUA_TNUMBER) {
+		uint32_t query_id = lua_tointeger(L, 4);
 		mpstream_encode_uint(&stream, IPROTO_STMT_ID);
 		mpstream_encode_uint(&stream, query_id);
 	} else {
 		size_t len;
-		const char *query = lua_tolstring(L, 3, &len);
+		const char *query = lua_tolstring(L, 4, &len);
 		mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
 		mpstream_encode_strn(&stream, query, len);
 	};
@@ -643,31 +1065,22 @@ netbox_decode_data(struct lua_State *L, const char **data,
 /**
  * Decode Tarantool response body consisting of single
  * IPROTO_DATA key into array of tuples.
- * @param Lua stack[1] Raw MessagePack pointer.
- * @retval Tuples array and position of the body end.
+ * @param L Lua stack to push result on.
+ * @param data MessagePack.
  */
-static int
-netbox_decode_select(struct lua_State *L)
+static void
+netbox_decode_select(struct lua_State *L, const char **data,
+		     struct tuple_format *format)
 {
-	uint32_t ctypeid;
-	assert(lua_gettop(L) == 3);
-	struct tuple_format *format;
-	if (lua_type(L, 3) == LUA_TCDATA)
-		format = lbox_check_tuple_format(L, 3);
-	else
-		format = tuple_format_runtime;
-	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
-	assert(mp_typeof(*data) == MP_MAP);
-	uint32_t map_size = mp_decode_map(&data);
+	assert(mp_typeof(**data) == MP_MAP);
+	uint32_t map_size = mp_decode_map(data);
 	/* Until 2.0 body has no keys except DATA. */
 	assert(map_size == 1);
 	(void) map_size;
-	uint32_t key = mp_decode_uint(&data);
+	uint32_t key = mp_decode_uint(data);
 	assert(key == IPROTO_DATA);
 	(void) key;
-	netbox_decode_data(L, &data, format);
-	*(const char **)luaL_pushcdata(L, ctypeid) = data;
-	return 2;
+	netbox_decode_data(L, data, format);
 }
 
 /** Decode optional (i.e. may be present in response) metadata fields. */
@@ -786,28 +1199,31 @@ netbox_decode_sql_info(struct lua_State *L, const char **data)
 	}
 }
 
-static int
-netbox_decode_execute(struct lua_State *L)
+/**
+ * Decode the response to an SQL statement execution.
+ * @param L Lua stack to push result on.
+ * @param data MessagePack.
+ */
+static void
+netbox_decode_execute(struct lua_State *L, const char **data)
 {
-	uint32_t ctypeid;
-	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
-	assert(mp_typeof(*data) == MP_MAP);
-	uint32_t map_size = mp_decode_map(&data);
+	assert(mp_typeof(**data) == MP_MAP);
+	uint32_t map_size = mp_decode_map(data);
 	int rows_index = 0, meta_index = 0, info_index = 0;
 	for (uint32_t i = 0; i < map_size; ++i) {
-		uint32_t key = mp_decode_uint(&data);
+		uint32_t key = mp_decode_uint(data);
 		switch(key) {
 		case IPROTO_DATA:
-			netbox_decode_data(L, &data, tuple_format_runtime);
+			netbox_decode_data(L, data, tuple_format_runtime);
 			rows_index = i - map_size;
 			break;
 		case IPROTO_METADATA:
-			netbox_decode_metadata(L, &data);
+			netbox_decode_metadata(L, data);
 			meta_index = i - map_size;
 			break;
 		default:
 			assert(key == IPROTO_SQL_INFO);
-			netbox_decode_sql_info(L, &data);
+			netbox_decode_sql_info(L, data);
 			info_index = i - map_size;
 			break;
 		}
@@ -820,46 +1236,50 @@ netbox_decode_execute(struct lua_State *L)
 		lua_setfield(L, -2, "metadata");
 		lua_pushvalue(L, rows_index - 1);
 		lua_setfield(L, -2, "rows");
+		/* Leave only the result on the stack. */
+		lua_replace(L, -3);
+		lua_pop(L, 1);
 	} else {
 		assert(meta_index == 0);
 		assert(rows_index == 0);
 	}
-	*(const char **)luaL_pushcdata(L, ctypeid) = data;
-	return 2;
 }
 
-static int
-netbox_decode_prepare(struct lua_State *L)
+/**
+ * Decode the response to an SQL statement preparation.
+ * @param L Lua stack to push result on.
+ * @param data MessagePack.
+ */
+static void
+netbox_decode_prepare(struct lua_State *L, const char **data)
 {
-	uint32_t ctypeid;
-	const char *data = *(const char **)luaL_checkcdata(L, 1, &ctypeid);
-	assert(mp_typeof(*data) == MP_MAP);
-	uint32_t map_size = mp_decode_map(&data);
+	assert(mp_typeof(**data) == MP_MAP);
+	uint32_t map_size = mp_decode_map(data);
 	int stmt_id_idx = 0, meta_idx = 0, bind_meta_idx = 0,
 	    bind_count_idx = 0;
 	uint32_t stmt_id = 0;
 	for (uint32_t i = 0; i < map_size; ++i) {
-		uint32_t key = mp_decode_uint(&data);
+		uint32_t key = mp_decode_uint(data);
 		switch(key) {
 		case IPROTO_STMT_ID: {
-			stmt_id = mp_decode_uint(&data);
+			stmt_id = mp_decode_uint(data);
 			luaL_pushuint64(L, stmt_id);
 			stmt_id_idx = i - map_size;
 			break;
 		}
 		case IPROTO_METADATA: {
-			netbox_decode_metadata(L, &data);
+			netbox_decode_metadata(L, data);
 			meta_idx = i - map_size;
 			break;
 		}
 		case IPROTO_BIND_METADATA: {
-			netbox_decode_metadata(L, &data);
+			netbox_decode_metadata(L, data);
 			bind_meta_idx = i - map_size;
 			break;
 		}
 		default: {
 			assert(key == IPROTO_BIND_COUNT);
-			uint32_t bind_count = mp_decode_uint(&data);
+			uint32_t bind_count = mp_decode_uint(data);
 			luaL_pushuint64(L, bind_count);
 			bind_count_idx = i - map_size;
 			break;
@@ -879,9 +1299,869 @@ netbox_decode_prepare(struct lua_State *L)
 		lua_pushvalue(L, meta_idx - 1);
 		lua_setfield(L, -2, "metadata");
 	}
+	/* Leave only the result on the stack. */
+	lua_replace(L, -(int)map_size - 1);
+	lua_pop(L, map_size - 1);
+}
 
-	*(const char **)luaL_pushcdata(L, ctypeid) = data;
-	return 2;
+/**
+ * Methods of a connection with their own response decoding, see
+ * method_encoder in net_box.lua.
+ */
+enum netbox_method {
+	NETBOX_PING,
+	NETBOX_CALL_16,
+	NETBOX_CALL_17,
+	NETBOX_EVAL,
+	NETBOX_INSERT,
+	NETBOX_REPLACE,
+	NETBOX_DELETE,
+	NETBOX_UPDATE,
+	NETBOX_UPSERT,
+	NETBOX_SELECT,
+	NETBOX_EXECUTE,
+	NETBOX_PREPARE,
+	NETBOX_UNPREPARE,
+	NETBOX_GET,
+	NETBOX_MIN,
+	NETBOX_MAX,
+	NETBOX_COUNT,
+	NETBOX_INJECT,
+	NETBOX_INSERT_MANY,
+	NETBOX_REPLACE_MANY,
+	NETBOX_PREPARE_CALL,
+	NETBOX_CURSOR_OPEN,
+	NETBOX_CURSOR_FETCH,
+	NETBOX_CURSOR_CLOSE,
+	netbox_method_MAX
+};
+
+static const char *netbox_method_strs[] = {
+	"ping",
+	"call_16",
+	"call_17",
+	"eval",
+	"insert",
+	"replace",
+	"delete",
+	"update",
+	"upsert",
+	"select",
+	"execute",
+	"prepare",
+	"unprepare",
+	"get",
+	"min",
+	"max",
+	"count",
+	"inject",
+	"insert_many",
+	"replace_many",
+	"prepare_call",
+	"cursor_open",
+	"cursor_fetch",
+	"cursor_close",
+};
+
+static_assert(lengthof(netbox_method_strs) == netbox_method_MAX,
+	      "each netbox method must have a name");
+
+static const char netbox_registry_typename[] = "net.box.registry";
+static const char netbox_request_typename[] = "net.box.request";
+
+/** Requests of a connection waiting for responses. */
+struct netbox_registry {
+	/** sync -> struct netbox_request. */
+	struct mh_i64ptr_t *requests;
+};
+
+/**
+ * A request sent to the server, the future object returned by
+ * asynchronous calls. The registry doesn't hold a Lua reference
+ * to the request: a request nobody waits for is garbage collected
+ * and its response is ignored.
+ */
+struct netbox_request {
+	enum netbox_method method;
+	/** Request id, the response is matched by it. */
+	uint64_t sync;
+	/**
+	 * The registry the request is in while waiting for the
+	 * response, NULL once it's complete.
+	 */
+	struct netbox_registry *registry;
+	/**
+	 * If not NULL, the raw response body is appended to this
+	 * buffer instead of being decoded.
+	 */
+	struct ibuf *buffer;
+	/** Lua reference to the buffer object. */
+	int buffer_ref;
+	/** Copy only the IPROTO_DATA value to the buffer. */
+	bool skip_header;
+	/** Format of tuples in the response, and its reference. */
+	struct tuple_format *format;
+	int format_ref;
+	/** on_push(on_push_ctx, message) is called on IPROTO_CHUNK. */
+	int on_push_ref;
+	int on_push_ctx_ref;
+	/** Reference to the decoded response. */
+	int result_ref;
+	/** The error the request failed with, if any. */
+	struct error *error;
+	/** Signalled when the request is complete or pushed to. */
+	struct fiber_cond cond;
+};
+
+static inline bool
+netbox_request_is_ready(const struct netbox_request *request)
+{
+	return request->registry == NULL;
+}
+
+static void
+netbox_request_unregister(struct netbox_request *request)
+{
+	struct mh_i64ptr_t *h = request->registry->requests;
+	mh_int_t k = mh_i64ptr_find(h, request->sync, NULL);
+	assert(k != mh_end(h));
+	assert(mh_i64ptr_node(h, k)->val == request);
+	mh_i64ptr_del(h, k, NULL);
+	request->registry = NULL;
+}
+
+/** Mark the request complete and wake up its waiters. */
+static void
+netbox_request_complete(struct netbox_request *request)
+{
+	netbox_request_unregister(request);
+	fiber_cond_broadcast(&request->cond);
+}
+
+static void
+netbox_request_set_error(struct netbox_request *request, struct error *error)
+{
+	assert(request->error == NULL);
+	error_ref(error);
+	request->error = error;
+}
+
+/** Pop the value from the top of the stack into the result. */
+static void
+netbox_request_set_result(struct lua_State *L, struct netbox_request *request)
+{
+	assert(request->result_ref == LUA_NOREF);
+	request->result_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+/**
+ * Pass the message on the top of the stack to the on_push
+ * callback of the request, the message is popped.
+ */
+static void
+netbox_request_push(struct lua_State *L, struct netbox_request *request)
+{
+	lua_rawgeti(L, LUA_REGISTRYINDEX, request->on_push_ref);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, request->on_push_ctx_ref);
+	lua_pushvalue(L, -3);
+	lua_call(L, 2, 0);
+	lua_pop(L, 1);
+	fiber_cond_broadcast(&request->cond);
+}
+
+/**
+ * Wait for the request to complete or for a push for at most
+ * @a timeout seconds, the time left is returned in @a timeout.
+ * Raises a Lua error if the fiber is cancelled.
+ */
+static void
+netbox_request_wait(struct lua_State *L, struct netbox_request *request,
+		    double *timeout)
+{
+	double start = fiber_clock();
+	fiber_cond_wait_timeout(&request->cond, *timeout);
+	luaL_testcancel(L);
+	*timeout -= fiber_clock() - start;
+	*timeout = MAX(0.0, *timeout);
+}
+
+/** Fail all the requests of the registry with the error. */
+static void
+netbox_registry_reset(struct netbox_registry *registry, struct error *error)
+{
+	struct mh_i64ptr_t *h = registry->requests;
+	mh_int_t k;
+	mh_foreach(h, k) {
+		struct netbox_request *request = mh_i64ptr_node(h, k)->val;
+		request->registry = NULL;
+		netbox_request_set_error(request, error);
+		fiber_cond_broadcast(&request->cond);
+	}
+	mh_i64ptr_clear(h);
+}
+
+/**
+ * Decode an error response body to an error object. The error is
+ * taken from IPROTO_ERROR if the server sent it, otherwise it's
+ * built from the code and the IPROTO_ERROR_24 message.
+ */
+static struct error *
+netbox_decode_error(const char **data, uint32_t errcode)
+{
+	struct error *error = NULL;
+	const char *msg = "";
+	uint32_t msg_len = 0;
+	uint32_t map_size = mp_decode_map(data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		uint32_t key = mp_decode_uint(data);
+		if (key == IPROTO_ERROR && error == NULL) {
+			error = error_unpack_unsafe(data);
+			if (error == NULL)
+				return diag_last_error(diag_get());
+		} else if (key == IPROTO_ERROR_24 &&
+			   mp_typeof(**data) == MP_STR) {
+			msg = mp_decode_str(data, &msg_len);
+		} else {
+			mp_next(data);
+		}
+	}
+	if (error == NULL) {
+		error = box_error_new(__FILE__, __LINE__, errcode, NULL,
+				      "%.*s", (int)msg_len, msg);
+	}
+	return error;
+}
+
+/**
+ * Decode the value of IPROTO_DATA as a Lua object, nil if the
+ * body has no such key.
+ */
+static void
+netbox_decode_value(struct lua_State *L, const char **data)
+{
+	uint32_t map_size = mp_decode_map(data);
+	bool is_found = false;
+	for (uint32_t i = 0; i < map_size; ++i) {
+		uint32_t key = mp_decode_uint(data);
+		if (key == IPROTO_DATA && !is_found) {
+			luamp_decode(L, cfg, data);
+			is_found = true;
+		} else {
+			mp_next(data);
+		}
+	}
+	if (!is_found)
+		lua_pushnil(L);
+}
+
+/**
+ * Decode the only tuple of a DML or get() response, nil if the
+ * response is empty. A get() response must have one tuple at
+ * most, the error is returned otherwise.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set and nothing is pushed.
+ */
+static int
+netbox_decode_tuple(struct lua_State *L, const char **data,
+		    struct tuple_format *format, bool is_get)
+{
+	uint32_t map_size = mp_decode_map(data);
+	assert(map_size == 1);
+	(void) map_size;
+	uint32_t key = mp_decode_uint(data);
+	assert(key == IPROTO_DATA);
+	(void) key;
+	uint32_t count = mp_decode_array(data);
+	if (count == 0) {
+		lua_pushnil(L);
+		return 0;
+	}
+	if (is_get && count > 1) {
+		for (uint32_t i = 0; i < count; ++i)
+			mp_next(data);
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	const char *begin = *data;
+	mp_next(data);
+	struct tuple *tuple = box_tuple_new(format, begin, *data);
+	if (tuple == NULL)
+		luaT_error(L);
+	luaT_pushtuple(L, tuple);
+	for (uint32_t i = 1; i < count; ++i)
+		mp_next(data);
+	return 0;
+}
+
+/**
+ * Decode a successful response body according to the request
+ * method.
+ * @retval 0 Success, the result is pushed.
+ * @retval -1 Error, diag is set and nothing is pushed.
+ */
+static int
+netbox_decode_response(struct lua_State *L, enum netbox_method method,
+		       const char **data, const char *data_end,
+		       struct tuple_format *format)
+{
+	switch (method) {
+	case NETBOX_PING:
+	case NETBOX_UPSERT:
+	case NETBOX_UNPREPARE:
+	case NETBOX_CURSOR_CLOSE:
+		lua_pushnil(L);
+		*data = data_end;
+		return 0;
+	case NETBOX_CALL_16:
+	case NETBOX_SELECT:
+	case NETBOX_CURSOR_FETCH:
+		netbox_decode_select(L, data, format);
+		return 0;
+	case NETBOX_CALL_17:
+	case NETBOX_EVAL:
+	case NETBOX_INJECT:
+		netbox_decode_value(L, data);
+		return 0;
+	case NETBOX_INSERT:
+	case NETBOX_REPLACE:
+	case NETBOX_DELETE:
+	case NETBOX_UPDATE:
+		return netbox_decode_tuple(L, data, format, false);
+	case NETBOX_GET:
+	case NETBOX_MIN:
+	case NETBOX_MAX:
+		return netbox_decode_tuple(L, data, format, true);
+	case NETBOX_COUNT:
+	case NETBOX_INSERT_MANY:
+	case NETBOX_REPLACE_MANY:
+	case NETBOX_PREPARE_CALL:
+	case NETBOX_CURSOR_OPEN:
+		netbox_decode_value(L, data);
+		lua_rawgeti(L, -1, 1);
+		lua_remove(L, -2);
+		return 0;
+	case NETBOX_EXECUTE:
+		netbox_decode_execute(L, data);
+		return 0;
+	case NETBOX_PREPARE:
+		netbox_decode_prepare(L, data);
+		return 0;
+	default:
+		unreachable();
+	}
+	return 0;
+}
+
+/**
+ * Complete the request with the given sync, or pass it a push,
+ * by its response body. Responses nobody waits for are ignored.
+ */
+static void
+netbox_registry_dispatch(struct lua_State *L, struct netbox_registry *registry,
+			 uint64_t sync, uint32_t status, const char *data,
+			 const char *data_end)
+{
+	struct mh_i64ptr_t *h = registry->requests;
+	mh_int_t k = mh_i64ptr_find(h, sync, NULL);
+	if (k == mh_end(h))
+		return;
+	struct netbox_request *request = mh_i64ptr_node(h, k)->val;
+	if (iproto_type_is_error(status)) {
+		uint32_t errcode = status & (IPROTO_TYPE_ERROR - 1);
+		netbox_request_set_error(request,
+					 netbox_decode_error(&data, errcode));
+		netbox_request_complete(request);
+		return;
+	}
+	if (request->buffer != NULL) {
+		/* Copy the body to the user-provided buffer. */
+		if (request->skip_header) {
+			/* Skip {[IPROTO_DATA] = ...} wrapper. */
+			uint32_t map_size = mp_decode_map(&data);
+			assert(map_size == 1);
+			(void) map_size;
+			uint32_t key = mp_decode_uint(&data);
+			assert(key == IPROTO_DATA);
+			(void) key;
+		}
+		size_t size = data_end - data;
+		void *wpos = ibuf_alloc(request->buffer, size);
+		if (wpos == NULL)
+			luaL_error(L, "out of memory");
+		memcpy(wpos, data, size);
+		lua_pushinteger(L, size);
+		if (status == IPROTO_OK) {
+			netbox_request_set_result(L, request);
+			netbox_request_complete(request);
+		} else {
+			netbox_request_push(L, request);
+		}
+		return;
+	}
+	if (status == IPROTO_OK) {
+		if (netbox_decode_response(L, request->method, &data, data_end,
+					   request->format) == 0)
+			netbox_request_set_result(L, request);
+		else
+			netbox_request_set_error(request,
+						 diag_last_error(diag_get()));
+		assert(data == data_end);
+		netbox_request_complete(request);
+	} else {
+		/* A push message is the first element of the data. */
+		netbox_decode_value(L, &data);
+		assert(data == data_end);
+		lua_rawgeti(L, -1, 1);
+		lua_remove(L, -2);
+		netbox_request_push(L, request);
+	}
+}
+
+static inline struct netbox_registry *
+luaT_check_netbox_registry(struct lua_State *L, int idx)
+{
+	return (struct netbox_registry *) luaL_checkudata(L, idx,
+						netbox_registry_typename);
+}
+
+static inline struct netbox_request *
+luaT_check_netbox_request(struct lua_State *L, int idx)
+{
+	return (struct netbox_request *) luaL_checkudata(L, idx,
+						netbox_request_typename);
+}
+
+/** new_registry() -> registry */
+static int
+luaT_netbox_new_registry(struct lua_State *L)
+{
+	struct netbox_registry *registry = (struct netbox_registry *)
+		lua_newuserdata(L, sizeof(*registry));
+	registry->requests = mh_i64ptr_new();
+	if (registry->requests == NULL)
+		luaL_error(L, "out of memory");
+	luaL_getmetatable(L, netbox_registry_typename);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int
+luaT_netbox_registry_gc(struct lua_State *L)
+{
+	struct netbox_registry *registry = luaT_check_netbox_registry(L, 1);
+	if (registry->requests == NULL)
+		return 0;
+	if (mh_size(registry->requests) > 0) {
+		diag_set(ClientError, ER_NO_CONNECTION);
+		netbox_registry_reset(registry, diag_last_error(diag_get()));
+	}
+	mh_i64ptr_delete(registry->requests);
+	registry->requests = NULL;
+	return 0;
+}
+
+/**
+ * registry:reset(errno, error)
+ *
+ * Fail all the requests waiting for responses, e.g. when the
+ * connection is lost. The error message defaults to the one of
+ * the error code.
+ */
+static int
+luaT_netbox_registry_reset(struct lua_State *L)
+{
+	struct netbox_registry *registry = luaT_check_netbox_registry(L, 1);
+	if (mh_size(registry->requests) == 0)
+		return 0;
+	uint32_t errcode = luaL_optinteger(L, 2, ER_NO_CONNECTION);
+	const char *msg = lua_tostring(L, 3);
+	if (msg == NULL)
+		msg = tnt_errcode_desc(errcode);
+	struct error *error = box_error_new(__FILE__, __LINE__, errcode, NULL,
+					    "%s", msg);
+	error_ref(error);
+	netbox_registry_reset(registry, error);
+	error_unref(error);
+	return 0;
+}
+
+/**
+ * registry:new_request(method, sync, buffer, skip_header,
+ *                      on_push, on_push_ctx, format) -> request
+ *
+ * Register a request sent to the server to wait for its response.
+ */
+static int
+luaT_netbox_registry_new_request(struct lua_State *L)
+{
+	struct netbox_registry *registry = luaT_check_netbox_registry(L, 1);
+	struct netbox_request *request = (struct netbox_request *)
+		lua_newuserdata(L, sizeof(*request));
+	request->method = lua_tointeger(L, 2);
+	assert(request->method < netbox_method_MAX);
+	request->sync = lua_tointeger(L, 3);
+	request->registry = NULL;
+	request->buffer = NULL;
+	request->buffer_ref = LUA_NOREF;
+	if (!lua_isnil(L, 4)) {
+		request->buffer = luaL_checkibuf(L, 4);
+		if (request->buffer == NULL)
+			luaL_error(L, "net.box: buffer must be an ibuf");
+		lua_pushvalue(L, 4);
+		request->buffer_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+	request->skip_header = lua_toboolean(L, 5);
+	request->format = tuple_format_runtime;
+	request->format_ref = LUA_NOREF;
+	if (lua_type(L, 8) == LUA_TCDATA) {
+		request->format = lbox_check_tuple_format(L, 8);
+		lua_pushvalue(L, 8);
+		request->format_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+	lua_pushvalue(L, 6);
+	request->on_push_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	lua_pushvalue(L, 7);
+	request->on_push_ctx_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	request->result_ref = LUA_NOREF;
+	request->error = NULL;
+	fiber_cond_create(&request->cond);
+	luaL_getmetatable(L, netbox_request_typename);
+	lua_setmetatable(L, -2);
+
+	struct mh_i64ptr_node_t node = {request->sync, request};
+	struct mh_i64ptr_node_t old, *p_old = &old;
+	struct mh_i64ptr_t *h = registry->requests;
+	if (mh_i64ptr_put(h, &node, &p_old, NULL) == mh_end(h))
+		luaL_error(L, "out of memory");
+	/* A request with the same sync is never answered. */
+	if (p_old != NULL)
+		((struct netbox_request *)p_old->val)->registry = NULL;
+	request->registry = registry;
+	return 1;
+}
+
+/**
+ * registry:complete(sync, response) -> boolean
+ *
+ * Complete the request with the given result, false if there's
+ * no such request. Used by the text protocol.
+ */
+static int
+luaT_netbox_registry_complete(struct lua_State *L)
+{
+	struct netbox_registry *registry = luaT_check_netbox_registry(L, 1);
+	uint64_t sync = lua_tointeger(L, 2);
+	struct mh_i64ptr_t *h = registry->requests;
+	mh_int_t k = mh_i64ptr_find(h, sync, NULL);
+	if (k == mh_end(h)) {
+		lua_pushboolean(L, false);
+		return 1;
+	}
+	struct netbox_request *request = mh_i64ptr_node(h, k)->val;
+	lua_pushvalue(L, 3);
+	netbox_request_set_result(L, request);
+	netbox_request_complete(request);
+	lua_pushboolean(L, true);
+	return 1;
+}
+
+/**
+ * registry:dispatch(sync, status, body, body_end)
+ *
+ * Handle the response body of a request by its header fields.
+ */
+static int
+luaT_netbox_registry_dispatch(struct lua_State *L)
+{
+	struct netbox_registry *registry = luaT_check_netbox_registry(L, 1);
+	uint64_t sync = lua_tointeger(L, 2);
+	uint32_t status = lua_tointeger(L, 3);
+	uint32_t ctypeid;
+	const char *data = *(const char **)luaL_checkcdata(L, 4, &ctypeid);
+	const char *data_end = *(const char **)luaL_checkcdata(L, 5, &ctypeid);
+	netbox_registry_dispatch(L, registry, sync, status, data, data_end);
+	return 0;
+}
+
+/**
+ * registry:dispatch_responses(recv_buf, schema_version)
+ *  -> required
+ *  -> nil, response_schema_version
+ *
+ * Handle all the complete responses in the buffer. Returns the
+ * buffer size needed to handle the next response, or the schema
+ * version of the response which has changed it: the rest of the
+ * responses are left in the buffer then.
+ */
+static int
+luaT_netbox_registry_dispatch_responses(struct lua_State *L)
+{
+	struct netbox_registry *registry = luaT_check_netbox_registry(L, 1);
+	struct ibuf *ibuf = (struct ibuf *) lua_topointer(L, 2);
+	uint64_t schema_version = lua_tointeger(L, 3);
+	while (true) {
+		const char *data = ibuf->rpos;
+		size_t used = ibuf_used(ibuf);
+		if (used < 5) {
+			lua_pushinteger(L, 5);
+			return 1;
+		}
+		if (mp_typeof(*data) != MP_UINT)
+			return luaL_error(L, "net.box: invalid response");
+		if (mp_check_uint(data, ibuf->wpos) > 0) {
+			lua_pushinteger(L, mp_sizeof_uint(UINT64_MAX));
+			return 1;
+		}
+		uint64_t len = mp_decode_uint(&data);
+		size_t required = (data - ibuf->rpos) + len;
+		if (used < required) {
+			lua_pushinteger(L, required);
+			return 1;
+		}
+		const char *data_end = data + len;
+		uint32_t status = 0;
+		uint64_t sync = 0;
+		uint64_t response_schema_version = 0;
+		if (mp_typeof(*data) != MP_MAP)
+			return luaL_error(L, "net.box: invalid response");
+		uint32_t map_size = mp_decode_map(&data);
+		for (uint32_t i = 0; i < map_size; ++i) {
+			if (mp_typeof(*data) != MP_UINT)
+				return luaL_error(L, "net.box: invalid response");
+			uint32_t key = mp_decode_uint(&data);
+			if (mp_typeof(*data) != MP_UINT) {
+				mp_next(&data);
+				continue;
+			}
+			switch (key) {
+			case IPROTO_REQUEST_TYPE:
+				status = mp_decode_uint(&data);
+				break;
+			case IPROTO_SYNC:
+				sync = mp_decode_uint(&data);
+				break;
+			case IPROTO_SCHEMA_VERSION:
+				response_schema_version = mp_decode_uint(&data);
+				break;
+			default:
+				mp_next(&data);
+			}
+		}
+		ibuf->rpos = (char *)data_end;
+		netbox_registry_dispatch(L, registry, sync, status, data,
+					 data_end);
+		if (response_schema_version > 0 &&
+		    response_schema_version != schema_version) {
+			lua_pushnil(L);
+			luaL_pushuint64(L, response_schema_version);
+			return 2;
+		}
+	}
+}
+
+static int
+luaT_netbox_request_gc(struct lua_State *L)
+{
+	struct netbox_request *request = luaT_check_netbox_request(L, 1);
+	if (!netbox_request_is_ready(request))
+		netbox_request_unregister(request);
+	luaL_unref(L, LUA_REGISTRYINDEX, request->buffer_ref);
+	luaL_unref(L, LUA_REGISTRYINDEX, request->format_ref);
+	luaL_unref(L, LUA_REGISTRYINDEX, request->on_push_ref);
+	luaL_unref(L, LUA_REGISTRYINDEX, request->on_push_ctx_ref);
+	luaL_unref(L, LUA_REGISTRYINDEX, request->result_ref);
+	if (request->error != NULL)
+		error_unref(request->error);
+	fiber_cond_destroy(&request->cond);
+	return 0;
+}
+
+/**
+ * Push the result of a complete request: the response, or nil
+ * and the error.
+ */
+static int
+netbox_request_push_result(struct lua_State *L, struct netbox_request *request)
+{
+	assert(netbox_request_is_ready(request));
+	if (request->error != NULL) {
+		lua_pushnil(L);
+		luaT_pusherror(L, request->error);
+		return 2;
+	}
+	lua_rawgeti(L, LUA_REGISTRYINDEX, request->result_ref);
+	return 1;
+}
+
+/**
+ * request:is_ready() -> boolean
+ *
+ * A request is ready when it's complete with a response or an
+ * error.
+ */
+static int
+luaT_netbox_request_is_ready(struct lua_State *L)
+{
+	struct netbox_request *request = luaT_check_netbox_request(L, 1);
+	lua_pushboolean(L, netbox_request_is_ready(request));
+	return 1;
+}
+
+/**
+ * request:result()
+ *  -> result
+ *  -> nil, error
+ */
+static int
+luaT_netbox_request_result(struct lua_State *L)
+{
+	struct netbox_request *request = luaT_check_netbox_request(L, 1);
+	if (!netbox_request_is_ready(request)) {
+		diag_set(ClientError, ER_PROC_LUA, "Response is not ready");
+		return luaT_push_nil_and_error(L);
+	}
+	return netbox_request_push_result(L, request);
+}
+
+/**
+ * request:wait_result(timeout)
+ *  -> result
+ *  -> nil, error
+ *
+ * Wait for the response for at most timeout seconds.
+ */
+static int
+luaT_netbox_request_wait_result(struct lua_State *L)
+{
+	struct netbox_request *request = luaT_check_netbox_request(L, 1);
+	double timeout = TIMEOUT_INFINITY;
+	if (!lua_isnoneornil(L, 2)) {
+		if (lua_type(L, 2) != LUA_TNUMBER ||
+		    (timeout = lua_tonumber(L, 2)) < 0)
+			luaL_error(L, "Usage: future:wait_result(timeout)");
+	}
+	while (!netbox_request_is_ready(request) && timeout > 0)
+		netbox_request_wait(L, request, &timeout);
+	if (!netbox_request_is_ready(request)) {
+		diag_set(ClientError, ER_TIMEOUT);
+		return luaT_push_nil_and_error(L);
+	}
+	return netbox_request_push_result(L, request);
+}
+
+/**
+ * request:discard()
+ *
+ * Forget about the request: the response is ignored when it
+ * arrives.
+ */
+static int
+luaT_netbox_request_discard(struct lua_State *L)
+{
+	struct netbox_request *request = luaT_check_netbox_request(L, 1);
+	if (netbox_request_is_ready(request))
+		return 0;
+	diag_set(ClientError, ER_PROC_LUA, "Response is discarded");
+	netbox_request_set_error(request, diag_last_error(diag_get()));
+	netbox_request_complete(request);
+	return 0;
+}
+
+/**
+ * Get the next message or the final result.
+ * @param Lua stack[1] Iterator state: {request, timeout}.
+ * @param Lua stack[2] Index to get a next message from.
+ *
+ * @retval nil, nil The request is finished.
+ * @retval i + 1, object A message/response and its index.
+ * @retval box.NULL, error An error occured. When this
+ *         function is called in 'for k, v in future:pairs()',
+ *         `k` becomes box.NULL, and `v` becomes error object.
+ *         On error the key becomes exactly box.NULL instead
+ *         of nil, because nil is treated by Lua as iteration
+ *         end marker. Nil does not participate in iteration,
+ *         and does not allow to continue it.
+ */
+static int
+luaT_netbox_request_iterator_next(struct lua_State *L)
+{
+	if (lua_type(L, 2) != LUA_TNUMBER) {
+		/* box.NULL after an error. */
+		lua_pushnil(L);
+		lua_pushnil(L);
+		return 2;
+	}
+	int i = lua_tointeger(L, 2) + 1;
+	lua_rawgeti(L, 1, 1);
+	struct netbox_request *request = luaT_check_netbox_request(L, -1);
+	lua_rawgeti(L, 1, 2);
+	double timeout = lua_tonumber(L, -1);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, request->on_push_ctx_ref);
+	int messages_idx = lua_gettop(L);
+	while (true) {
+		int message_count = lua_istable(L, messages_idx) ?
+				    lua_objlen(L, messages_idx) : 0;
+		if (i <= message_count) {
+			lua_pushinteger(L, i);
+			lua_rawgeti(L, messages_idx, i);
+			return 2;
+		}
+		if (netbox_request_is_ready(request)) {
+			/*
+			 * After all the messages are iterated, `i`
+			 * is equal to #messages + 1. After response
+			 * reading `i` becomes #messages + 2. It is
+			 * the trigger to finish the iteration.
+			 */
+			if (i > message_count + 1) {
+				lua_pushnil(L);
+				lua_pushnil(L);
+				return 2;
+			}
+			if (request->error != NULL) {
+				luaL_pushnull(L);
+				luaT_pusherror(L, request->error);
+				return 2;
+			}
+			lua_pushinteger(L, i);
+			lua_rawgeti(L, LUA_REGISTRYINDEX, request->result_ref);
+			return 2;
+		}
+		if (timeout <= 0) {
+			diag_set(ClientError, ER_TIMEOUT);
+			luaL_pushnull(L);
+			luaT_pusherror(L, diag_last_error(diag_get()));
+			return 2;
+		}
+		netbox_request_wait(L, request, &timeout);
+	}
+}
+
+/**
+ * request:pairs(timeout) -> iterator
+ *
+ * Iterate over all messages received by a request, then over
+ * its result. See luaT_netbox_request_iterator_next() for the
+ * key/value pairs to expect. The timeout is per iteration.
+ */
+static int
+luaT_netbox_request_pairs(struct lua_State *L)
+{
+	luaT_check_netbox_request(L, 1);
+	double timeout = TIMEOUT_INFINITY;
+	if (!lua_isnoneornil(L, 2)) {
+		if (lua_type(L, 2) != LUA_TNUMBER ||
+		    (timeout = lua_tonumber(L, 2)) < 0)
+			luaL_error(L, "Usage: future:pairs(timeout)");
+	}
+	lua_pushcfunction(L, luaT_netbox_request_iterator_next);
+	lua_createtable(L, 2, 0);
+	lua_pushvalue(L, 1);
+	lua_rawseti(L, -2, 1);
+	lua_pushnumber(L, timeout);
+	lua_rawseti(L, -2, 2);
+	lua_pushinteger(L, 0);
+	return 3;
 }
 
 int
@@ -891,10 +2171,16 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_ping",    netbox_encode_ping },
 		{ "encode_call_16", netbox_encode_call_16 },
 		{ "encode_call",    netbox_encode_call },
+		{ "encode_prepare_call", netbox_encode_prepare_call },
 		{ "encode_eval",    netbox_encode_eval },
 		{ "encode_select",  netbox_encode_select },
+		{ "encode_cursor_open", netbox_encode_cursor_open },
+		{ "encode_cursor_fetch", netbox_encode_cursor_fetch },
+		{ "encode_cursor_close", netbox_encode_cursor_close },
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
+		{ "encode_insert_many", netbox_encode_insert_many },
+		{ "encode_replace_many", netbox_encode_replace_many },
 		{ "encode_delete",  netbox_encode_delete },
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
@@ -903,14 +2189,49 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_auth",    netbox_encode_auth },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
-		{ "decode_select",  netbox_decode_select },
-		{ "decode_execute", netbox_decode_execute },
-		{ "decode_prepare", netbox_decode_prepare },
+		{ "encode_shm_attach", netbox_encode_shm_attach },
+		{ "shm_attach",     netbox_shm_attach },
+		{ "shm_communicate",netbox_shm_communicate },
+		{ "new_registry",   luaT_netbox_new_registry },
 		{ NULL, NULL}
 	};
+	static const struct luaL_Reg netbox_shm_meta[] = {
+		{ "__gc",           netbox_shm_close },
+		{ "close",          netbox_shm_close },
+		{ NULL, NULL }
+	};
+	luaL_register_type(L, netbox_shm_typename, netbox_shm_meta);
+	static const struct luaL_Reg netbox_registry_meta[] = {
+		{ "__gc",           luaT_netbox_registry_gc },
+		{ "reset",          luaT_netbox_registry_reset },
+		{ "new_request",    luaT_netbox_registry_new_request },
+		{ "complete",       luaT_netbox_registry_complete },
+		{ "dispatch",       luaT_netbox_registry_dispatch },
+		{ "dispatch_responses",
+				luaT_netbox_registry_dispatch_responses },
+		{ NULL, NULL }
+	};
+	luaL_register_type(L, netbox_registry_typename, netbox_registry_meta);
+	static const struct luaL_Reg netbox_request_meta[] = {
+		{ "__gc",           luaT_netbox_request_gc },
+		{ "is_ready",       luaT_netbox_request_is_ready },
+		{ "result",         luaT_netbox_request_result },
+		{ "wait_result",    luaT_netbox_request_wait_result },
+		{ "discard",        luaT_netbox_request_discard },
+		{ "pairs",          luaT_netbox_request_pairs },
+		{ NULL, NULL }
+	};
+	luaL_register_type(L, netbox_request_typename, netbox_request_meta);
 	/* luaL_register_module polutes _G */
 	lua_newtable(L);
 	luaL_openlib(L, NULL, net_box_lib, 0);
+	/* Method name -> enum netbox_method. */
+	lua_createtable(L, 0, netbox_method_MAX);
+	for (int i = 0; i < netbox_method_MAX; i++) {
+		lua_pushinteger(L, i);
+		lua_setfield(L, -2, netbox_method_strs[i]);
+	}
+	lua_setfield(L, -2, "method");
 	lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED");
 	lua_pushvalue(L, -2);
 	lua_setfield(L, -2, "net.box.lib");
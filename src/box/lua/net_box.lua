@@ -14,19 +14,20 @@ local max               = math.max
 local fiber_clock       = fiber.clock
 local fiber_self        = fiber.self
 local decode            = msgpack.decode_unchecked
-local decode_map_header = msgpack.decode_map_header
-local buffer_reg        = buffer.reg1
 
-local table_new           = require('table.new')
 local check_iterator_type = box.internal.check_iterator_type
 local check_index_arg     = box.internal.check_index_arg
 local check_space_arg     = box.internal.check_space_arg
 local check_primary_index = box.internal.check_primary_index
 
 local communicate     = internal.communicate
+local shm_communicate = internal.shm_communicate
+local shm_attach      = internal.shm_attach
+local encode_shm_attach = internal.encode_shm_attach
 local encode_auth     = internal.encode_auth
 local encode_select   = internal.encode_select
 local decode_greeting = internal.decode_greeting
+local netbox_method   = internal.method
 
 local TIMEOUT_INFINITY = 500 * 365 * 86400
 local VSPACE_ID        = 281
@@ -40,56 +41,17 @@ local IPROTO_SYNC_KEY      = 0x01
 local IPROTO_SCHEMA_VERSION_KEY = 0x05
 local IPROTO_DATA_KEY      = 0x30
 local IPROTO_ERROR_24      = 0x31
-local IPROTO_ERROR         = 0x52
 local IPROTO_GREETING_SIZE = 128
-local IPROTO_CHUNK_KEY     = 128
-local IPROTO_OK_KEY        = 0
 
 -- select errors from box.error
 local E_UNKNOWN              = box.error.UNKNOWN
 local E_NO_CONNECTION        = box.error.NO_CONNECTION
-local E_TIMEOUT              = box.error.TIMEOUT
 local E_PROC_LUA             = box.error.PROC_LUA
 local E_NO_SUCH_SPACE        = box.error.NO_SUCH_SPACE
 
-ffi.cdef[[
-struct error *
-error_unpack_unsafe(const char **data);
-
-void
-error_unref(struct error *e);
-]]
-
 -- utility tables
 local is_final_state         = {closed = 1, error = 1}
 
-local function decode_nil(raw_data, raw_data_end) -- luacheck: no unused args
-    return nil, raw_data_end
-end
-local function decode_data(raw_data)
-    local response, raw_end = decode(raw_data)
-    return response[IPROTO_DATA_KEY], raw_end
-end
-local function decode_tuple(raw_data, raw_data_end, format) -- luacheck: no unused args
-    local response, raw_end = internal.decode_select(raw_data, nil, format)
-    return response[1], raw_end
-end
-local function decode_get(raw_data, raw_data_end, format) -- luacheck: no unused args
-    local body, raw_end = internal.decode_select(raw_data, nil, format)
-    if body[2] then
-        return nil, raw_end, box.error.MORE_THAN_ONE_TUPLE
-    end
-    return body[1], raw_end
-end
-local function decode_count(raw_data)
-    local response, raw_end = decode(raw_data)
-    return response[IPROTO_DATA_KEY][1], raw_end
-end
-local function decode_push(raw_data)
-    local response, raw_end = decode(raw_data)
-    return response[IPROTO_DATA_KEY][1], raw_end
-end
-
 local function version_id(major, minor, patch)
     return bit.bor(bit.lshift(major, 16), bit.lshift(minor, 8), patch)
 end
@@ -116,60 +78,20 @@ local method_encoder = {
     min     = internal.encode_select,
     max     = internal.encode_select,
     count   = internal.encode_call,
+    insert_many  = internal.encode_insert_many,
+    replace_many = internal.encode_replace_many,
+    prepare_call = internal.encode_prepare_call,
+    cursor_open  = internal.encode_cursor_open,
+    cursor_fetch = internal.encode_cursor_fetch,
+    cursor_close = internal.encode_cursor_close,
     -- inject raw data into connection, used by console and tests
-    inject = function(buf, id, bytes) -- luacheck: no unused args
+    inject = function(buf, id, timeout, bytes) -- luacheck: no unused args
         local ptr = buf:reserve(#bytes)
         ffi.copy(ptr, bytes, #bytes)
         buf.wpos = ptr + #bytes
     end
 }
 
-local method_decoder = {
-    ping    = decode_nil,
-    call_16 = internal.decode_select,
-    call_17 = decode_data,
-    eval    = decode_data,
-    insert  = decode_tuple,
-    replace = decode_tuple,
-    delete  = decode_tuple,
-    update  = decode_tuple,
-    upsert  = decode_nil,
-    select  = internal.decode_select,
-    execute = internal.decode_execute,
-    prepare = internal.decode_prepare,
-    unprepare = decode_nil,
-    get     = decode_get,
-    min     = decode_get,
-    max     = decode_get,
-    count   = decode_count,
-    inject  = decode_data,
-    push    = decode_push,
-}
-
-local function decode_error(raw_data)
-    local ptr = buffer_reg.acucp
-    ptr[0] = raw_data
-    local err = ffi.C.error_unpack_unsafe(ptr)
-    if err ~= nil then
-        err._refs = err._refs + 1
-        err = ffi.gc(err, ffi.C.error_unref)
-        -- From FFI it is returned as 'struct error *', which is
-        -- not considered equal to 'const struct error &', and is
-        -- is not accepted by functions like box.error(). Need to
-        -- cast explicitly.
-        err = ffi.cast('const struct error &', err)
-    else
-        -- Error unpacker installs fail reason into diag.
-        box.error()
-    end
-    return err, ptr[0]
-end
-
-local response_decoder = {
-    [IPROTO_ERROR_24] = decode,
-    [IPROTO_ERROR] = decode_error,
-}
-
 local function next_id(id) return band(id + 1, 0x7FFFFFFF) end
 
 --
@@ -251,6 +173,10 @@ local function on_push_sync_default() end
 --  'state_changed', state, error
 --  'handshake', greeting -> nil (accept) / errno, error (reject)
 --  'will_fetch_schema'   -> true (approve) / false (skip fetch)
+--  'fetch_transport'     -> 'shm' to switch to a shared memory
+--                           channel after auth, else nil
+--  'fetch_send_timeout'  -> true to send request timeouts to the
+--                           server, else nil
 --  'did_fetch_schema', schema_version, spaces, indices
 --  'reconnect_timeout'   -> get reconnect timeout if set and > 0,
 --                           else nil is returned.
@@ -273,172 +199,23 @@ local function create_transport(host, port, user, password, callback,
     local state_cond       = fiber.cond() -- signaled when the state changes
 
     -- Async requests currently 'in flight', keyed by a request
-    -- id. Value refs are weak hence if a client dies
+    -- id, see net.box.registry in net_box.c. The registry does
+    -- not reference requests hence if a client dies
     -- unexpectedly, GC cleans the mess.
     -- Async request can not be timed out completely. Instead a
     -- user must decide when he does not want to wait for
     -- response anymore.
     -- Sync requests are implemented as async call + immediate
     -- wait for a result.
-    local requests         = setmetatable({}, { __mode = 'v' })
+    local registry         = internal.new_registry()
     local next_request_id  = 1
 
     local worker_fiber
+    -- Shared memory channel replacing the socket, if attached.
+    local shm
     local send_buf         = buffer.ibuf(buffer.READAHEAD)
     local recv_buf         = buffer.ibuf(buffer.READAHEAD)
 
-    --
-    -- Async request metamethods.
-    --
-    local request_index = {}
-    --
-    -- When an async request is finalized (with ok or error - no
-    -- matter), its 'id' field is nullified by a response
-    -- dispatcher.
-    --
-    function request_index:is_ready()
-        return self.id == nil or worker_fiber == nil
-    end
-    --
-    -- When a request is finished, a result can be got from a
-    -- future object anytime.
-    -- @retval result, nil Success, the response is returned.
-    -- @retval nil, error Error occured.
-    --
-    function request_index:result()
-        if self.errno then
-            if type(self.response) ~= 'cdata' then
-                -- Error could be set by the connection state
-                -- machine, and it is usually a string explaining
-                -- a reason.
-                self.response = box.error.new({code = self.errno,
-                                               reason = self.response})
-            end
-            return nil, self.response
-        elseif not self.id then
-            return self.response
-        elseif not worker_fiber then
-            return nil, box.error.new(E_NO_CONNECTION)
-        else
-            return nil, box.error.new(box.error.PROC_LUA,
-                                      'Response is not ready')
-        end
-    end
-    --
-    -- Get the next message or the final result.
-    -- @param iterator Iterator object.
-    -- @param i Index to get a next message from.
-    --
-    -- @retval nil, nil The request is finished.
-    -- @retval i + 1, object A message/response and its index.
-    -- @retval box.NULL, error An error occured. When this
-    --         function is called in 'for k, v in future:pairs()',
-    --         `k` becomes box.NULL, and `v` becomes error object.
-    --         On error the key becomes exactly box.NULL instead
-    --         of nil, because nil is treated by Lua as iteration
-    --         end marker. Nil does not participate in iteration,
-    --         and does not allow to continue it.
-    --
-    local function request_iterator_next(iterator, i)
-        if i == box.NULL then
-            return nil, nil
-        else
-            i = i + 1
-        end
-        local request = iterator.request
-        local messages = request.on_push_ctx
-    ::retry::
-        if i <= #messages then
-            return i, messages[i]
-        end
-        if request:is_ready() then
-            -- After all the messages are iterated, `i` is equal
-            -- to #messages + 1. After response reading `i`
-            -- becomes #messages + 2. It is the trigger to finish
-            -- the iteration.
-            if i > #messages + 1 then
-                return nil, nil
-            end
-            local response, err = request:result()
-            if err then
-                return box.NULL, err
-            end
-            return i, response
-        end
-        local old_message_count = #messages
-        local timeout = iterator.timeout
-        repeat
-            local ts = fiber_clock()
-            request.cond:wait(timeout)
-            timeout = timeout - (fiber_clock() - ts)
-            if request:is_ready() or old_message_count ~= #messages then
-                goto retry
-            end
-        until timeout <= 0
-        return box.NULL, box.error.new(E_TIMEOUT)
-    end
-    --
-    -- Iterate over all messages, received by a request. @Sa
-    -- request_iterator_next for details what to expect in `for`
-    -- key/value pairs.
-    -- @param timeout One iteration timeout.
-    -- @retval next() callback, iterator, zero key.
-    --
-    function request_index:pairs(timeout)
-        if timeout then
-            if type(timeout) ~= 'number' or timeout < 0 then
-                error('Usage: future:pairs(timeout)')
-            end
-        else
-            timeout = TIMEOUT_INFINITY
-        end
-        local iterator = {request = self, timeout = timeout}
-        return request_iterator_next, iterator, 0
-    end
-    --
-    -- Wait for a response or error max timeout seconds.
-    -- @param timeout Max seconds to wait.
-    -- @retval result, nil Success, the response is returned.
-    -- @retval nil, error Error occured.
-    --
-    function request_index:wait_result(timeout)
-        if timeout then
-            if type(timeout) ~= 'number' or timeout < 0 then
-                error('Usage: future:wait_result(timeout)')
-            end
-        else
-            timeout = TIMEOUT_INFINITY
-        end
-        if not self:is_ready() then
-            -- When a response is ready before timeout, the
-            -- waiting client is waked up prematurely.
-            while timeout > 0 and not self:is_ready() do
-                local ts = fiber.clock()
-                self.cond:wait(timeout)
-                timeout = timeout - (fiber.clock() - ts)
-            end
-            if not self:is_ready() then
-                return nil, box.error.new(E_TIMEOUT)
-            end
-        end
-        return self:result()
-    end
-    --
-    -- Make a connection forget about the response. When it will
-    -- be received, it will be ignored. It reduces size of
-    -- requests table speeding up other requests.
-    --
-    function request_index:discard()
-        if self.id then
-            requests[self.id] = nil
-            self.id = nil
-            self.errno = box.error.PROC_LUA
-            self.response = 'Response is discarded'
-        end
-    end
-
-    local request_mt = { __index = request_index }
-
     -- STATE SWITCHING --
     local function set_state(new_state, new_errno, new_error)
         state = new_state
@@ -448,13 +225,7 @@ local function create_transport(host, port, user, password, callback,
         state_cond:broadcast()
         if state == 'error' or state == 'error_reconnect' or
            state == 'closed' then
-            for _, request in pairs(requests) do
-                request.id = nil
-                request.errno = new_errno
-                request.response = new_error
-                request.cond:broadcast()
-            end
-            requests = {}
+            registry:reset(new_errno, new_error)
         end
     end
 
@@ -484,6 +255,10 @@ local function create_transport(host, port, user, password, callback,
             if not (ok or is_final_state[state]) then
                 set_state('error', E_UNKNOWN, err)
             end
+            if shm then
+                shm:close()
+                shm = nil
+            end
             if connection then
                 connection:close()
                 connection = nil
@@ -512,6 +287,7 @@ local function create_transport(host, port, user, password, callback,
             set_state('error_reconnect', E_NO_CONNECTION, greeting)
             goto do_reconnect
     ::stop::
+            registry:reset(E_NO_CONNECTION)
             send_buf:recycle()
             recv_buf:recycle()
             worker_fiber = nil
@@ -530,11 +306,14 @@ local function create_transport(host, port, user, password, callback,
 
     --
     -- Send a request and do not wait for response.
+    -- @param send_timeout Time the server may spend on the
+    --        request, see IPROTO_TIMEOUT. nil if not limited.
     -- @retval nil, error Error occured.
     -- @retval not nil Future object.
     --
-    local function perform_async_request(buffer, skip_header, method, on_push,
-                                         on_push_ctx, request_ctx, ...)
+    local function perform_async_request(send_timeout, buffer, skip_header,
+                                         method, on_push, on_push_ctx,
+                                         request_ctx, ...)
         if state ~= 'active' and state ~= 'fetch_schema' then
             return nil, box.error.new({code = last_errno or E_NO_CONNECTION,
                                        reason = last_error})
@@ -545,22 +324,11 @@ local function create_transport(host, port, user, password, callback,
             worker_fiber:wakeup()
         end
         local id = next_request_id
-        method_encoder[method](send_buf, id, ...)
+        method_encoder[method](send_buf, id, send_timeout, ...)
         next_request_id = next_id(id)
-        -- Request in most cases has maximum 10 members:
-        -- method, buffer, skip_header, id, cond, errno, response,
-        -- on_push, on_push_ctx and ctx.
-        local request = setmetatable(table_new(0, 10), request_mt)
-        request.method = method
-        request.buffer = buffer
-        request.skip_header = skip_header
-        request.id = id
-        request.cond = fiber.cond()
-        requests[id] = request
-        request.on_push = on_push
-        request.on_push_ctx = on_push_ctx
-        request.ctx = request_ctx
-        return request
+        return registry:new_request(netbox_method[method], id, buffer,
+                                    skip_header, on_push, on_push_ctx,
+                                    request_ctx)
     end
 
     --
@@ -570,106 +338,16 @@ local function create_transport(host, port, user, password, callback,
     --
     local function perform_request(timeout, buffer, skip_header, method,
                                    on_push, on_push_ctx, request_ctx, ...)
+        local send_timeout = callback('fetch_send_timeout') and timeout or nil
         local request, err =
-            perform_async_request(buffer, skip_header, method, on_push,
-                                  on_push_ctx, request_ctx, ...)
+            perform_async_request(send_timeout, buffer, skip_header, method,
+                                  on_push, on_push_ctx, request_ctx, ...)
         if not request then
             return nil, err
         end
         return request:wait_result(timeout)
     end
 
-    local function dispatch_response_iproto(hdr, body_rpos, body_end)
-        local id = hdr[IPROTO_SYNC_KEY]
-        local request = requests[id]
-        if request == nil then -- nobody is waiting for the response
-            return
-        end
-        local status = hdr[IPROTO_STATUS_KEY]
-        local body
-        local body_len = body_end - body_rpos
-
-        if status > IPROTO_CHUNK_KEY then
-            -- Handle errors
-            requests[id] = nil
-            request.id = nil
-            local map_len, key
-            map_len, body_rpos = decode_map_header(body_rpos, body_len)
-            -- Reserve for 2 keys and 2 array indexes. Because no
-            -- any guarantees how Lua will decide to save the
-            -- sparse table.
-            body = table_new(2, 2)
-            for _ = 1, map_len do
-                key, body_rpos = decode(body_rpos)
-                local rdec = response_decoder[key]
-                if rdec then
-                    body[key], body_rpos = rdec(body_rpos)
-                else
-                    _, body_rpos = decode(body_rpos)
-                end
-            end
-            assert(body_end == body_rpos, "invalid xrow length")
-            request.errno = band(status, IPROTO_ERRNO_MASK)
-            -- IPROTO_ERROR comprises error encoded with
-            -- IPROTO_ERROR_24, so we may ignore content of that
-            -- key.
-            if body[IPROTO_ERROR] ~= nil then
-                request.response = body[IPROTO_ERROR]
-                assert(type(request.response) == 'cdata')
-            else
-                request.response = box.error.new({
-                    code = request.errno,
-                    reason = body[IPROTO_ERROR_24]
-                })
-            end
-            request.cond:broadcast()
-            return
-        end
-
-        local buffer = request.buffer
-        if buffer ~= nil then
-            -- Copy xrow.body to user-provided buffer
-            if request.skip_header then
-                -- Skip {[IPROTO_DATA_KEY] = ...} wrapper.
-                local map_len, key
-                map_len, body_rpos = decode_map_header(body_rpos, body_len)
-                assert(map_len == 1)
-                key, body_rpos = decode(body_rpos)
-                assert(key == IPROTO_DATA_KEY)
-                body_len = body_end - body_rpos
-            end
-            local wpos = buffer:alloc(body_len)
-            ffi.copy(wpos, body_rpos, body_len)
-            body_len = tonumber(body_len)
-            if status == IPROTO_OK_KEY then
-                request.response = body_len
-                requests[id] = nil
-                request.id = nil
-            else
-                request.on_push(request.on_push_ctx, body_len)
-            end
-            request.cond:broadcast()
-            return
-        end
-
-        local real_end
-        -- Decode xrow.body[DATA] to Lua objects
-        if status == IPROTO_OK_KEY then
-            request.response, real_end, request.errno =
-                method_decoder[request.method](body_rpos, body_end, request.ctx)
-            assert(real_end == body_end, "invalid body length")
-            requests[id] = nil
-            request.id = nil
-        else
-            local msg
-            msg, real_end, request.errno =
-                method_decoder.push(body_rpos, body_end)
-            assert(real_end == body_end, "invalid body length")
-            request.on_push(request.on_push_ctx, msg)
-        end
-        request.cond:broadcast()
-    end
-
     local function new_request_id()
         local id = next_request_id;
         next_request_id = next_id(id)
@@ -678,6 +356,10 @@ local function create_transport(host, port, user, password, callback,
 
     -- IO (WORKER FIBER) --
     local function send_and_recv(limit_or_boundary, timeout)
+        if shm then
+            return shm_communicate(shm, send_buf, recv_buf,
+                                   limit_or_boundary, timeout)
+        end
         return communicate(connection:fd(), send_buf, recv_buf,
                            limit_or_boundary, timeout)
     end
@@ -725,7 +407,8 @@ local function create_transport(host, port, user, password, callback,
     -- tail-recursive calls to each other. Yep, Lua optimizes
     -- such calls, and yep, this is the canonical way to implement
     -- a state machine in Lua.
-    local console_sm, iproto_auth_sm, iproto_schema_sm, iproto_sm, error_sm
+    local console_sm, iproto_auth_sm, iproto_shm_sm, iproto_schema_sm
+    local iproto_sm, error_sm
 
     --
     -- Protocol_sm is a core function of netbox. It calls all
@@ -747,7 +430,7 @@ local function create_transport(host, port, user, password, callback,
             log.warn("Netbox text protocol support is deprecated since 1.10, "..
                      "please use require('console').connect() instead")
             local setup_delimiter = 'require("console").delimiter("$EOF$")\n'
-            method_encoder.inject(send_buf, nil, setup_delimiter)
+            method_encoder.inject(send_buf, nil, nil, setup_delimiter)
             local err, response = send_and_recv_console()
             if err then
                 return error_sm(err, response)
@@ -770,14 +453,10 @@ local function create_transport(host, port, user, password, callback,
         if err then
             return error_sm(err, response)
         else
-            local request = requests[rid]
-            if request == nil then -- nobody is waiting for the response
+            if not registry:complete(rid, response) then
+                -- nobody is waiting for the response
                 return
             end
-            request.id = nil
-            requests[rid] = nil
-            request.response = response
-            request.cond:broadcast()
             return console_sm(next_id(rid))
         end
     end
@@ -785,10 +464,9 @@ local function create_transport(host, port, user, password, callback,
     iproto_auth_sm = function(salt)
         set_state('auth')
         if not user or not password then
-            set_state('fetch_schema')
-            return iproto_schema_sm()
+            return iproto_shm_sm()
         end
-        encode_auth(send_buf, new_request_id(), user, password, salt)
+        encode_auth(send_buf, new_request_id(), nil, user, password, salt)
         local err, hdr, body_rpos = send_and_recv_iproto()
         if err then
             return error_sm(err, hdr)
@@ -797,6 +475,34 @@ local function create_transport(host, port, user, password, callback,
             local body = decode(body_rpos)
             return error_sm(E_NO_CONNECTION, body[IPROTO_ERROR_24])
         end
+        return iproto_shm_sm(hdr[IPROTO_SCHEMA_VERSION_KEY])
+    end
+
+    iproto_shm_sm = function(schema_version)
+        if callback('fetch_transport') ~= 'shm' then
+            set_state('fetch_schema')
+            return iproto_schema_sm(schema_version)
+        end
+        encode_shm_attach(send_buf, new_request_id(), nil)
+        local err, channel = shm_attach(connection:fd(), send_buf, recv_buf)
+        if err then
+            return error_sm(err, channel)
+        end
+        local hdr, body_rpos
+        err, hdr, body_rpos = send_and_recv_iproto()
+        if err then
+            if channel then channel:close() end
+            return error_sm(err, hdr)
+        end
+        if hdr[IPROTO_STATUS_KEY] ~= 0 or not channel then
+            if channel then channel:close() end
+            local body = decode(body_rpos)
+            return error_sm(E_NO_CONNECTION, body[IPROTO_ERROR_24] or
+                            'Failed to attach a shared memory channel')
+        end
+        -- The socket is kept open, the server watches it to
+        -- learn the client is gone.
+        shm = channel
         set_state('fetch_schema')
         return iproto_schema_sm(hdr[IPROTO_SCHEMA_VERSION_KEY])
     end
@@ -814,13 +520,15 @@ local function create_transport(host, port, user, password, callback,
         local select3_id
         local response = {}
         -- fetch everything from space _vspace, 2 = ITER_ALL
-        encode_select(send_buf, select1_id, VSPACE_ID, 0, 2, 0, 0xFFFFFFFF, nil)
+        encode_select(send_buf, select1_id, nil, VSPACE_ID, 0, 2, 0, 0xFFFFFFFF,
+                      nil)
         -- fetch everything from space _vindex, 2 = ITER_ALL
-        encode_select(send_buf, select2_id, VINDEX_ID, 0, 2, 0, 0xFFFFFFFF, nil)
+        encode_select(send_buf, select2_id, nil, VINDEX_ID, 0, 2, 0, 0xFFFFFFFF,
+                      nil)
         -- fetch everything from space _vcollation, 2 = ITER_ALL
         if peer_has_vcollation then
             select3_id = new_request_id()
-            encode_select(send_buf, select3_id, VCOLLATION_ID, 0, 2, 0,
+            encode_select(send_buf, select3_id, nil, VCOLLATION_ID, 0, 2, 0,
                           0xFFFFFFFF, nil)
         end
 
@@ -829,8 +537,8 @@ local function create_transport(host, port, user, password, callback,
         repeat
             local err, hdr, body_rpos, body_end = send_and_recv_iproto()
             if err then return error_sm(err, hdr) end
-            dispatch_response_iproto(hdr, body_rpos, body_end)
             local id = hdr[IPROTO_SYNC_KEY]
+            registry:dispatch(id, hdr[IPROTO_STATUS_KEY], body_rpos, body_end)
             -- trick: omit check for peer_has_vcollation: id is
             -- not nil
             if id == select1_id or id == select2_id or id == select3_id then
@@ -868,21 +576,23 @@ local function create_transport(host, port, user, password, callback,
     end
 
     iproto_sm = function(schema_version)
-        local err, hdr, body_rpos, body_end = send_and_recv_iproto()
-        if err then return error_sm(err, hdr) end
-        dispatch_response_iproto(hdr, body_rpos, body_end)
-        local response_schema_version = hdr[IPROTO_SCHEMA_VERSION_KEY]
-        if response_schema_version > 0 and
-           response_schema_version ~= schema_version then
+        -- Responses are decoded and matched to requests in C, all
+        -- the received ones at once.
+        local required, response_schema_version =
+            registry:dispatch_responses(recv_buf, schema_version)
+        if response_schema_version then
             -- schema_version has been changed - start to load a new version.
             -- Sic: self.schema_version will be updated only after reload.
             set_state('fetch_schema')
             return iproto_schema_sm(schema_version)
         end
+        local err, msg = send_and_recv(required)
+        if err then return error_sm(err, msg) end
         return iproto_sm(schema_version)
     end
 
     error_sm = function(err, msg)
+        if shm then shm:close(); shm = nil end
         if connection then connection:close(); connection = nil end
         send_buf:recycle()
         recv_buf:recycle()
@@ -984,7 +694,7 @@ local console_mt = {
     __metatable = false
 }
 
-local space_metatable, index_metatable
+local space_metatable, index_metatable, cursor_metatable
 
 local function new_sm(host, port, opts, connection, greeting)
     local user, password = opts.user, opts.password; opts.password = nil
@@ -1030,6 +740,10 @@ local function new_sm(host, port, opts, connection, greeting)
             return not opts.console
         elseif what == 'fetch_connect_timeout' then
             return opts.connect_timeout or DEFAULT_CONNECT_TIMEOUT
+        elseif what == 'fetch_transport' then
+            return opts.transport
+        elseif what == 'fetch_send_timeout' then
+            return opts.send_timeout
         elseif what == 'did_fetch_schema' then
             remote:_install_schema(...)
         elseif what == 'reconnect_timeout' then
@@ -1051,6 +765,7 @@ local function new_sm(host, port, opts, connection, greeting)
 
         remote._space_mt = space_metatable(remote)
         remote._index_mt = index_metatable(remote)
+        remote._cursor_mt = cursor_metatable(remote)
         if opts.call_16 then
             remote.call = remote.call_16
             remote.eval = remote.eval_16
@@ -1166,9 +881,9 @@ function remote_methods:_request(method, opts, request_ctx, ...)
                 error('To handle pushes in an async request use future:pairs()')
             end
             local res, err =
-                transport.perform_async_request(buffer, skip_header, method,
-                                                table.insert, {}, request_ctx,
-                                                ...)
+                transport.perform_async_request(nil, buffer, skip_header,
+                                                method, table.insert, {},
+                                                request_ctx, ...)
             if err then
                 box.error(err)
             end
@@ -1230,13 +945,24 @@ function remote_methods:call(func_name, args, opts)
     check_remote_arg(self, 'call')
     check_call_args(args)
     args = args or {}
-    local res = self:_request('call_17', opts, nil, tostring(func_name), args)
+    -- A number is a function id returned by prepare_call().
+    if type(func_name) ~= 'number' then
+        func_name = tostring(func_name)
+    end
+    local res = self:_request('call_17', opts, nil, func_name, args)
     if type(res) ~= 'table' or opts and opts.is_async then
         return res
     end
     return unpack(res)
 end
 
+-- Resolve the function name to the id to call the function by,
+-- without the name lookup and the access check on every call.
+function remote_methods:prepare_call(func_name, opts)
+    check_remote_arg(self, 'prepare_call')
+    return self:_request('prepare_call', opts, nil, tostring(func_name))
+end
+
 -- @deprecated since 1.7.4
 function remote_methods:eval_16(code, ...)
     check_remote_arg(self, 'eval')
@@ -1468,6 +1194,18 @@ space_metatable = function(remote)
         return remote:_request('replace', opts, self._format_cdata, self.id, tuple)
     end
 
+    -- Insert or replace all the tuples in one transaction with
+    -- one request, returns the number of tuples written.
+    function methods:insert_many(tuples, opts)
+        check_space_arg(self, 'insert_many')
+        return remote:_request('insert_many', opts, nil, self.id, tuples)
+    end
+
+    function methods:replace_many(tuples, opts)
+        check_space_arg(self, 'replace_many')
+        return remote:_request('replace_many', opts, nil, self.id, tuples)
+    end
+
     function methods:select(key, opts)
         check_space_arg(self, 'select')
         return check_primary_index(self):select(key, opts)
@@ -1494,6 +1232,11 @@ space_metatable = function(remote)
         return check_primary_index(self):get(key, opts)
     end
 
+    function methods:cursor(key, opts)
+        check_space_arg(self, 'cursor')
+        return check_primary_index(self):cursor(key, opts)
+    end
+
     function methods:format(format)
         if format == nil then
             return self._format
@@ -1520,6 +1263,24 @@ index_metatable = function(remote)
                                 limit, key))
     end
 
+    -- Open a server-side cursor to read the result set of a
+    -- select in batches with cursor:fetch().
+    function methods:cursor(key, opts)
+        check_index_arg(self, 'cursor')
+        if opts and (opts.buffer or opts.is_async) then
+            error("index:cursor() doesn't support `buffer` and "..
+                  "`is_async` arguments")
+        end
+        local key_is_nil = (key == nil or
+                            (type(key) == 'table' and #key == 0))
+        local iterator = check_iterator_type(opts, key_is_nil)
+        local id = remote:_request('cursor_open', opts, nil, self.space.id,
+                                   self.id, iterator, key)
+        return setmetatable({id = id, is_closed = false,
+                             _format_cdata = self.space._format_cdata},
+                            remote._cursor_mt)
+    end
+
     function methods:get(key, opts)
         check_index_arg(self, 'get')
         if opts and opts.buffer then
@@ -1581,6 +1342,44 @@ index_metatable = function(remote)
     return { __index = methods, __metatable = false }
 end
 
+cursor_metatable = function(remote)
+    local methods = {}
+
+    -- Fetch up to limit next tuples. The server closes the
+    -- cursor once less than limit tuples are returned.
+    function methods:fetch(limit, opts)
+        if type(self) ~= 'table' or self.id == nil then
+            error('Use cursor:fetch(...) instead of cursor.fetch(...)')
+        end
+        limit = tonumber(limit)
+        if limit == nil or limit < 0 then
+            error('Usage: cursor:fetch(limit)')
+        end
+        if self.is_closed then
+            return {}
+        end
+        local res = remote:_request('cursor_fetch', opts, self._format_cdata,
+                                    self.id, limit)
+        if type(res) == 'table' and #res < limit then
+            self.is_closed = true
+        end
+        return res
+    end
+
+    function methods:close(opts)
+        if type(self) ~= 'table' or self.id == nil then
+            error('Use cursor:close(...) instead of cursor.close(...)')
+        end
+        if self.is_closed then
+            return
+        end
+        self.is_closed = true
+        remote:_request('cursor_close', opts, nil, self.id)
+    end
+
+    return { __index = methods, __metatable = false }
+end
+
 local this_module = {
     create_transport = create_transport,
     connect = connect,
@@ -412,6 +412,8 @@ box.schema.space.create = function(name, options)
         is_local = 'boolean',
         temporary = 'boolean',
         is_sync = 'boolean',
+        compression = 'string',
+        dense_field_map = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -456,7 +458,9 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
-        is_sync = options.is_sync
+        is_sync = options.is_sync,
+        compression = options.compression,
+        dense_field_map = options.dense_field_map,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -545,6 +549,7 @@ local alter_space_template = {
     format = 'table',
     temporary = 'boolean',
     is_sync = 'boolean',
+    dense_field_map = 'boolean',
     name = 'string',
 }
 
@@ -581,6 +586,10 @@ box.schema.space.alter = function(space_id, options)
         flags.is_sync = options.is_sync
     end
 
+    if options.dense_field_map ~= nil then
+        flags.dense_field_map = options.dense_field_map
+    end
+
     local format
     if options.format ~= nil then
         format = update_format(options.format)
@@ -1000,6 +1009,7 @@ local index_options = {
     page_size = 'number',
     bloom_fpr = 'number',
     func = 'number, string',
+    normalized_key = 'boolean',
 }
 
 --
@@ -1050,6 +1060,7 @@ box.schema.index.create = function(space_id, name, options)
     local type_dependent_defaults = {
         rtree = {parts = { 2, 'array' }, unique = false},
         bitset = {parts = { 2, 'unsigned' }, unique = false},
+        column = {parts = { 2, 'unsigned' }, unique = false},
         other = {parts = { 1, 'unsigned' }, unique = true},
     }
     options_defaults = type_dependent_defaults[options.type]
@@ -1115,6 +1126,7 @@ box.schema.index.create = function(space_id, name, options)
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
             func = options.func,
+            normalized_key = options.normalized_key,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -1636,6 +1648,34 @@ base_index_mt.compact = function(index)
     return internal.compact(index.space_id, index.id)
 end
 
+-- crc32 and count of tuples in the key range [from, to)
+base_index_mt.checksum = function(index, from, to)
+    check_index_arg(index, 'checksum')
+    return internal.checksum(index.space_id, index.id, keify(from),
+                             keify(to))
+end
+
+-- count, sum, min or max of a key part, optionally only over
+-- rows whose other key part passes {part, iterator, value}
+base_index_mt.aggregate = function(index, func, part, filter)
+    check_index_arg(index, 'aggregate')
+    part = part or 1
+    if type(func) ~= 'string' or type(part) ~= 'number' or part < 1 or
+       (filter ~= nil and (type(filter) ~= 'table' or
+                           type(filter[1]) ~= 'number' or filter[1] < 1)) then
+        box.error(box.error.ILLEGAL_PARAMS, "usage: index:aggregate(func"..
+                  "[, part[, {part, iterator, value}]])")
+    end
+    local filter_part, filter_type, filter_key = 0, box.index.ALL, {}
+    if filter ~= nil then
+        filter_part = filter[1] - 1
+        filter_type = check_iterator_type({iterator = filter[2]}, false)
+        filter_key = {filter[3]}
+    end
+    return internal.aggregate(index.space_id, index.id, func, part - 1,
+                              filter_part, filter_type, filter_key)
+end
+
 base_index_mt.drop = function(index)
     check_index_arg(index, 'drop')
     return box.schema.index.drop(index.space_id, index.id)
@@ -1706,6 +1746,14 @@ space_mt.replace = function(space, tuple)
     return internal.replace(space.id, tuple);
 end
 space_mt.put = space_mt.replace; -- put is an alias for replace
+space_mt.insert_many = function(space, tuples)
+    check_space_arg(space, 'insert_many')
+    return internal.insert_many(space.id, tuples)
+end
+space_mt.replace_many = function(space, tuples)
+    check_space_arg(space, 'replace_many')
+    return internal.replace_many(space.id, tuples)
+end
 space_mt.update = function(space, key, ops)
     check_space_arg(space, 'update')
     return check_primary_index(space):update(key, ops)
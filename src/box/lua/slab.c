@@ -167,6 +167,29 @@ lbox_slab_info(struct lua_State *L)
 	lua_pushstring(L, ratio_buf);
 	lua_settable(L, -3);
 
+	/*
+	 * Free memory of partially used slabs that can't be
+	 * reused for tuples of other sizes. This is what
+	 * memtx_defrag_threshold is compared with.
+	 */
+	size_t items_total;
+	size_t fragmented = memtx_engine_fragmented_size(memtx, &items_total);
+	lua_pushstring(L, "items_fragmented");
+	luaL_pushuint64(L, fragmented);
+	lua_settable(L, -3);
+
+	ratio = 100 * ((double) fragmented
+		/ ((double) items_total + 0.0001));
+	snprintf(ratio_buf, sizeof(ratio_buf), "%0.2lf%%", ratio);
+	lua_pushstring(L, "items_fragmented_ratio");
+	lua_pushstring(L, ratio_buf);
+	lua_settable(L, -3);
+
+	/** How many tuples the defragmentation has moved. */
+	lua_pushstring(L, "items_moved");
+	luaL_pushuint64(L, memtx->defrag.moved);
+	lua_settable(L, -3);
+
 	/** How much address space has been already touched
 	 * (tuples and indexes) */
 	lua_pushstring(L, "arena_size");
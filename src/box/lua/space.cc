@@ -378,6 +378,13 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 
 		lua_settable(L, -3); /* space.index[k].parts */
 
+		lua_pushstring(L, "normalized_key");
+		if (index_opts->normalized_key)
+			lua_pushboolean(L, true);
+		else
+			lua_pushnil(L);
+		lua_rawset(L, -3);
+
 		lua_pushstring(L, "sequence_id");
 		if (k == 0 && space->sequence != NULL) {
 			lua_pushnumber(L, space->sequence->def->id);
@@ -43,6 +43,10 @@
 #include "box/engine.h"
 #include "box/vinyl.h"
 #include "box/sql.h"
+#include "box/replication.h"
+#include "box/applier.h"
+#include "box/relay.h"
+#include "box/lua/info.h"
 #include "info/info.h"
 #include "lua/info.h"
 #include "lua/utils.h"
@@ -127,6 +131,56 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_classes(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	box_net_msg_class_stat(&h);
+	return 1;
+}
+
+/**
+ * Push a table of replication stage latencies by replica id:
+ * apply and wal of the applier, read, send and ack of the relay,
+ * the same as in box.info.replication.
+ */
+static int
+lbox_stat_replication(struct lua_State *L)
+{
+	lua_newtable(L);
+	replicaset_foreach(replica) {
+		if (replica->id == REPLICA_ID_NIL)
+			continue;
+		struct applier *applier = replica->applier;
+		struct relay *relay = replica->relay;
+		bool has_relay = relay != NULL &&
+				 relay_get_state(relay) == RELAY_FOLLOW;
+		if (applier == NULL && !has_relay)
+			continue;
+		lua_newtable(L);
+		if (applier != NULL) {
+			lbox_pushlatency(L, "apply",
+				latency_get(&applier->apply_latency, 50),
+				latency_get(&applier->apply_latency, 99));
+			lbox_pushlatency(L, "wal",
+				latency_get(&applier->wal_latency, 50),
+				latency_get(&applier->wal_latency, 99));
+		}
+		if (has_relay) {
+			const struct relay_stat *stat = relay_get_stat(relay);
+			lbox_pushlatency(L, "read", stat->read_p50,
+					 stat->read_p99);
+			lbox_pushlatency(L, "send", stat->send_p50,
+					 stat->send_p99);
+			lbox_pushlatency(L, "ack", stat->ack_p50,
+					 stat->ack_p99);
+		}
+		lua_rawseti(L, -2, replica->id);
+	}
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
@@ -231,6 +285,8 @@ box_lua_stat_init(struct lua_State *L)
 		{"vinyl", lbox_stat_vinyl},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
+		{"classes", lbox_stat_classes},
+		{"replication", lbox_stat_replication},
 		{NULL, NULL}
 	};
 
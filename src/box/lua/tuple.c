@@ -284,6 +284,20 @@ luamp_encode_tuple(struct lua_State *L, struct luaL_serializer *cfg,
 void
 tuple_to_mpstream(struct tuple *tuple, struct mpstream *stream)
 {
+	if (tuple_format(tuple)->compression != COMPRESSION_TYPE_NONE) {
+		/*
+		 * The stream may be backed by the fiber region
+		 * too, so the decompressed data is not truncated.
+		 */
+		uint32_t bsize;
+		const char *data = tuple_data_range_decompressed(tuple, &bsize);
+		if (data == NULL) {
+			stream->error(stream->error_ctx);
+			return;
+		}
+		mpstream_memcpy(stream, data, bsize);
+		return;
+	}
 	size_t bsize = box_tuple_bsize(tuple);
 	char *ptr = mpstream_reserve(stream, bsize);
 	box_tuple_to_buf(tuple, ptr, bsize);
@@ -426,9 +440,11 @@ lbox_tuple_transform(struct lua_State *L)
 	mpstream_flush(&stream);
 
 	uint32_t new_size = 0, bsize;
-	const char *old_data = tuple_data_range(tuple, &bsize);
 	struct region *region = &fiber()->gc;
 	size_t used = region_used(region);
+	const char *old_data = tuple_data_range_decompressed(tuple, &bsize);
+	if (old_data == NULL)
+		luaT_error(L);
 	struct tuple_format *format = tuple_format(tuple);
 	struct tuple *new_tuple = NULL;
 	/*
@@ -478,14 +494,36 @@ lbox_tuple_field_by_path(struct lua_State *L)
 	const char *field = NULL, *path = lua_tolstring(L, 2, &len);
 	if (len == 0)
 		return 0;
-	field = tuple_field_raw_by_full_path(tuple_format(tuple),
-					     tuple_data(tuple),
-					     tuple_field_map(tuple),
-					     path, (uint32_t)len,
-					     lua_hashstring(L, 2));
-	if (field == NULL)
+	/*
+	 * Compressed fields follow all indexed ones, so the
+	 * field map is valid for the decompressed data too.
+	 */
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t bsize;
+	const char *data = tuple_data_range_decompressed(tuple, &bsize);
+	if (data == NULL)
+		return luaT_error(L);
+	struct tuple_format *format = tuple_format(tuple);
+	uint32_t path_hash = lua_hashstring(L, 2);
+	const struct tuple_accessor *accessor =
+		tuple_format_accessor(format, path, len, path_hash);
+	if (accessor != NULL) {
+		field = tuple_field_raw_by_accessor(format, data,
+						    tuple_field_map(tuple),
+						    accessor);
+	} else {
+		field = tuple_field_raw_by_full_path(format, data,
+						     tuple_field_map(tuple),
+						     path, (uint32_t)len,
+						     path_hash);
+	}
+	if (field == NULL) {
+		region_truncate(region, region_svp);
 		return 0;
+	}
 	luamp_decode(L, luaL_msgpack_default, &field);
+	region_truncate(region, region_svp);
 	return 1;
 }
 
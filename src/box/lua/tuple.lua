@@ -255,8 +255,17 @@ local function tuple_to_msgpack(buf, tuple)
     assert(ffi.istype(tuple_t, tuple))
     local bsize = builtin.box_tuple_bsize(tuple)
     buf:reserve(bsize)
-    builtin.box_tuple_to_buf(tuple, buf.wpos, bsize)
-    buf.wpos = buf.wpos + bsize
+    local size = builtin.box_tuple_to_buf(tuple, buf.wpos, bsize)
+    if size < 0 then
+        return box.error()
+    end
+    if size > bsize then
+        -- Compressed fields are decompressed, retry with
+        -- the real size.
+        buf:reserve(size)
+        builtin.box_tuple_to_buf(tuple, buf.wpos, size)
+    end
+    buf.wpos = buf.wpos + size
 end
 
 local function tuple_bsize(tuple)
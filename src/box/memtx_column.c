@@ -0,0 +1,909 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "memtx_column.h"
+
+#include <math.h>
+#include <string.h>
+#include <small/mempool.h>
+#include <small/matras.h>
+
+#include "trivia/util.h"
+#include "tt_static.h"
+#include "assoc.h"
+
+#include "fiber.h"
+#include "index.h"
+#include "schema.h"
+#include "tuple.h"
+#include "txn.h"
+#include "memtx_tx.h"
+#include "memtx_engine.h"
+
+/*
+ * COLUMN index stores each key part in a separate dense array
+ * (a column) of 8-byte values. Row i of every column belongs to
+ * the tuple stored at position i of the row array, so an
+ * aggregate over a part scans contiguous memory instead of
+ * chasing tuple pointers and decoding MsgPack. Deletion moves
+ * the last row into the freed slot, so the arrays never have
+ * holes and need no tombstones. Iterators read a read view of
+ * the row array, so a moved row is neither skipped nor returned
+ * twice.
+ *
+ * Signed integers are not supported: a column of 8-byte values
+ * can't hold both negative numbers and unsigned ones greater
+ * than INT64_MAX.
+ *
+ * Strings are stored as dictionary codes. Codes are assigned in
+ * order of first appearance and are never reclaimed, so strings
+ * support only equality filters and count().
+ */
+
+/** A value stored in a column. */
+union column_value {
+	/** FIELD_TYPE_UNSIGNED or a string dictionary code. */
+	uint64_t u;
+	/** FIELD_TYPE_DOUBLE. */
+	double d;
+};
+
+enum {
+	/**
+	 * Number of column values in one matras extent. Values
+	 * of a block starting at a multiple of this number are
+	 * stored contiguously, so kernels scan them as an array.
+	 */
+	COLUMN_BLOCK_SIZE = MEMTX_EXTENT_SIZE / sizeof(union column_value),
+};
+
+struct column_hash_entry {
+	struct tuple *tuple;
+	uint32_t row;
+};
+
+#define mh_int_t uint32_t
+#define mh_arg_t int
+
+#if UINTPTR_MAX == 0xffffffff
+#define mh_hash_key(a, arg) ((uintptr_t)(a))
+#else
+#define mh_hash_key(a, arg) ((uint32_t)(((uintptr_t)(a)) >> 33 ^ ((uintptr_t)(a)) ^ ((uintptr_t)(a)) << 11))
+#endif
+#define mh_hash(a, arg) mh_hash_key((a)->tuple, arg)
+#define mh_cmp(a, b, arg) ((a)->tuple != (b)->tuple)
+#define mh_cmp_key(a, b, arg) ((a) != (b)->tuple)
+
+#define mh_node_t struct column_hash_entry
+#define mh_key_t struct tuple *
+#define mh_name _column_index
+#define MH_SOURCE 1
+#include <salad/mhash.h>
+
+struct memtx_column_index {
+	struct index base;
+	/** Row number -> tuple. */
+	struct matras rows;
+	/** One column per key part, indexed by row number. */
+	struct matras *columns;
+	/** Tuple -> row number. */
+	struct mh_column_index_t *tuple_to_row;
+	/** String -> dictionary code. */
+	struct mh_strnptr_t *dict;
+	/** Memory used by dictionary strings. */
+	size_t dict_bsize;
+	/** Number of rows in the index. */
+	uint32_t row_count;
+};
+
+/**
+ * Find the dictionary code of a string, adding the string to
+ * the dictionary if it is not there yet.
+ */
+static int
+memtx_column_index_dict_code(struct memtx_column_index *index,
+			     const char *str, uint32_t len, uint64_t *code)
+{
+	mh_int_t k = mh_strnptr_find_inp(index->dict, str, len);
+	if (k != mh_end(index->dict)) {
+		*code = (uintptr_t)mh_strnptr_node(index->dict, k)->val;
+		return 0;
+	}
+	char *copy = (char *)malloc(len);
+	if (copy == NULL) {
+		diag_set(OutOfMemory, len, "malloc", "column dictionary");
+		return -1;
+	}
+	memcpy(copy, str, len);
+	*code = mh_size(index->dict);
+	struct mh_strnptr_node_t node = {
+		copy, len, mh_strn_hash(copy, len), (void *)(uintptr_t)*code
+	};
+	if (mh_strnptr_put(index->dict, &node, NULL, NULL) ==
+	    mh_end(index->dict)) {
+		free(copy);
+		diag_set(OutOfMemory, sizeof(node), "malloc",
+			 "column dictionary");
+		return -1;
+	}
+	index->dict_bsize += len;
+	return 0;
+}
+
+/** Decode the value of a key part of a tuple into a column value. */
+static int
+memtx_column_index_extract(struct memtx_column_index *index,
+			   struct tuple *tuple, struct key_part *part,
+			   union column_value *value)
+{
+	const char *field = tuple_field_by_part(tuple, part, MULTIKEY_NONE);
+	assert(field != NULL);
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+		value->u = mp_decode_uint(&field);
+		return 0;
+	case FIELD_TYPE_DOUBLE:
+		if (mp_typeof(*field) == MP_FLOAT)
+			value->d = mp_decode_float(&field);
+		else
+			value->d = mp_decode_double(&field);
+		return 0;
+	case FIELD_TYPE_STRING: {
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		return memtx_column_index_dict_code(index, str, len,
+						    &value->u);
+	}
+	default:
+		unreachable();
+		return -1;
+	}
+}
+
+/** Append a tuple to the end of all columns. */
+static int
+memtx_column_index_append(struct memtx_column_index *index,
+			  struct tuple *tuple)
+{
+	struct key_def *key_def = index->base.def->key_def;
+	uint32_t row;
+	if (matras_alloc(&index->rows, &row) == NULL)
+		return -1;
+	/* The extent may be shared with an iterator read view. */
+	struct tuple **place = (struct tuple **)matras_touch(&index->rows,
+							     row);
+	if (place == NULL) {
+		matras_dealloc(&index->rows);
+		return -1;
+	}
+	*place = tuple;
+	uint32_t i;
+	for (i = 0; i < key_def->part_count; i++) {
+		uint32_t id;
+		union column_value *value = (union column_value *)
+			matras_alloc(&index->columns[i], &id);
+		if (value == NULL)
+			goto rollback;
+		assert(id == row);
+		if (memtx_column_index_extract(index, tuple, &key_def->parts[i],
+					       value) != 0) {
+			i++;
+			goto rollback;
+		}
+	}
+	struct column_hash_entry entry = { tuple, row };
+	mh_int_t k = mh_column_index_put(index->tuple_to_row, &entry, NULL, 0);
+	if (k == mh_end(index->tuple_to_row)) {
+		diag_set(OutOfMemory, (ssize_t)k, "hash", "key");
+		goto rollback;
+	}
+	index->row_count++;
+	return 0;
+rollback:
+	while (i-- > 0)
+		matras_dealloc(&index->columns[i]);
+	matras_dealloc(&index->rows);
+	return -1;
+}
+
+/**
+ * Remove a row, moving the last row into its place. The slot
+ * of the row must have been touched with matras_touch(), so
+ * that the removal can't fail.
+ */
+static void
+memtx_column_index_remove(struct memtx_column_index *index, mh_int_t k)
+{
+	uint32_t row = mh_column_index_node(index->tuple_to_row, k)->row;
+	mh_column_index_del(index->tuple_to_row, k, 0);
+	uint32_t last = --index->row_count;
+	uint32_t part_count = index->base.def->key_def->part_count;
+	if (row != last) {
+		struct tuple *moved =
+			*(struct tuple **)matras_get(&index->rows, last);
+		struct tuple **place =
+			(struct tuple **)matras_touch(&index->rows, row);
+		assert(place != NULL);
+		*place = moved;
+		for (uint32_t i = 0; i < part_count; i++) {
+			memcpy(matras_get(&index->columns[i], row),
+			       matras_get(&index->columns[i], last),
+			       sizeof(union column_value));
+		}
+		k = mh_column_index_find(index->tuple_to_row, moved, 0);
+		assert(k != mh_end(index->tuple_to_row));
+		mh_column_index_node(index->tuple_to_row, k)->row = row;
+	}
+	for (uint32_t i = 0; i < part_count; i++)
+		matras_dealloc(&index->columns[i]);
+	matras_dealloc(&index->rows);
+}
+
+struct column_index_iterator {
+	struct iterator base; /* Must be the first member. */
+	/**
+	 * Rows as of the iterator creation. Removal moves rows,
+	 * so the iterator can't walk the live array.
+	 */
+	struct matras_view view;
+	/** Next row to return. */
+	uint32_t row;
+	/** Memory pool the iterator was allocated from. */
+	struct mempool *pool;
+};
+
+static_assert(sizeof(struct column_index_iterator) <= MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct column_index_iterator) must be less than or equal "
+	      "to MEMTX_ITERATOR_SIZE");
+
+static void
+column_index_iterator_free(struct iterator *iterator)
+{
+	assert(iterator->free == column_index_iterator_free);
+	struct column_index_iterator *it =
+		(struct column_index_iterator *)iterator;
+	struct memtx_column_index *index =
+		(struct memtx_column_index *)iterator->index;
+	matras_destroy_read_view(&index->rows, &it->view);
+	index_unref(&index->base);
+	mempool_free(it->pool, it);
+}
+
+static int
+column_index_iterator_next(struct iterator *iterator, struct tuple **ret)
+{
+	assert(iterator->free == column_index_iterator_free);
+	struct column_index_iterator *it =
+		(struct column_index_iterator *)iterator;
+	struct memtx_column_index *index =
+		(struct memtx_column_index *)iterator->index;
+	do {
+		if (it->row >= it->view.block_count) {
+			*ret = NULL;
+			return 0;
+		}
+		struct tuple *tuple = *(struct tuple **)
+			matras_view_get(&index->rows, &it->view, it->row++);
+		/* Skip tuples removed after the iterator creation. */
+		if (mh_column_index_find(index->tuple_to_row, tuple, 0) ==
+		    mh_end(index->tuple_to_row)) {
+			*ret = NULL;
+			continue;
+		}
+		uint32_t iid = iterator->index->def->iid;
+		struct txn *txn = in_txn();
+		struct space *space = space_by_id(iterator->space_id);
+		bool is_rw = txn != NULL;
+		*ret = memtx_tx_tuple_clarify(txn, space, tuple, iid, 0, is_rw);
+	} while (*ret == NULL);
+	return 0;
+}
+
+static void
+memtx_column_index_destroy(struct index *base)
+{
+	struct memtx_column_index *index = (struct memtx_column_index *)base;
+	mh_int_t k;
+	mh_foreach(index->dict, k)
+		free((void *)mh_strnptr_node(index->dict, k)->str);
+	mh_strnptr_delete(index->dict);
+	mh_column_index_delete(index->tuple_to_row);
+	for (uint32_t i = 0; i < base->def->key_def->part_count; i++)
+		matras_destroy(&index->columns[i]);
+	free(index->columns);
+	matras_destroy(&index->rows);
+	free(index);
+}
+
+static ssize_t
+memtx_column_index_size(struct index *base)
+{
+	struct memtx_column_index *index = (struct memtx_column_index *)base;
+	return index->row_count;
+}
+
+static ssize_t
+memtx_column_index_bsize(struct index *base)
+{
+	struct memtx_column_index *index = (struct memtx_column_index *)base;
+	size_t extents = matras_extent_count(&index->rows);
+	for (uint32_t i = 0; i < base->def->key_def->part_count; i++)
+		extents += matras_extent_count(&index->columns[i]);
+	return extents * MEMTX_EXTENT_SIZE +
+	       mh_column_index_memsize(index->tuple_to_row) +
+	       mh_strnptr_memsize(index->dict) + index->dict_bsize;
+}
+
+static int
+memtx_column_index_replace(struct index *base, struct tuple *old_tuple,
+			   struct tuple *new_tuple, enum dup_replace_mode mode,
+			   struct tuple **result)
+{
+	struct memtx_column_index *index = (struct memtx_column_index *)base;
+	(void)mode;
+	*result = NULL;
+	/*
+	 * Touch the slot of the removed row and append first:
+	 * these are the only steps that can fail, and the index
+	 * must stay intact on failure.
+	 */
+	if (old_tuple != NULL) {
+		mh_int_t k = mh_column_index_find(index->tuple_to_row,
+						  old_tuple, 0);
+		if (k != mh_end(index->tuple_to_row)) {
+			uint32_t row =
+				mh_column_index_node(index->tuple_to_row,
+						     k)->row;
+			if (matras_touch(&index->rows, row) == NULL)
+				return -1;
+		}
+	}
+	if (new_tuple != NULL &&
+	    memtx_column_index_append(index, new_tuple) != 0)
+		return -1;
+	if (old_tuple != NULL) {
+		mh_int_t k = mh_column_index_find(index->tuple_to_row,
+						  old_tuple, 0);
+		if (k != mh_end(index->tuple_to_row)) {
+			memtx_column_index_remove(index, k);
+			*result = old_tuple;
+		}
+	}
+	return 0;
+}
+
+static struct iterator *
+memtx_column_index_create_iterator(struct index *base, enum iterator_type type,
+				   const char *key, uint32_t part_count)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	struct memtx_column_index *index = (struct memtx_column_index *)base;
+	(void)key;
+	if (type != ITER_ALL && part_count > 0) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "requested iterator type");
+		return NULL;
+	}
+	struct column_index_iterator *it = mempool_alloc(&memtx->iterator_pool);
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(*it),
+			 "memtx_column_index", "iterator");
+		return NULL;
+	}
+	iterator_create(&it->base, base);
+	it->pool = &memtx->iterator_pool;
+	it->base.next = column_index_iterator_next;
+	it->base.free = column_index_iterator_free;
+	it->row = 0;
+	matras_create_read_view(&index->rows, &it->view);
+	index_ref(base);
+	return &it->base;
+}
+
+/* {{{ Aggregate kernels ****************************************/
+
+/*
+ * The kernels below process one block of a column. They are
+ * written as plain loops without early exits or data dependent
+ * branches, so that the compiler can vectorize them. A selection
+ * mask, if given, has one byte per row, 1 for the rows that
+ * passed the filter and 0 for the rest.
+ */
+
+#define COLUMN_FILTER_DEF(name, type)					\
+static void								\
+column_filter_##name(const type *values, uint32_t count,		\
+		     enum iterator_type op, type value, uint8_t *mask)	\
+{									\
+	switch (op) {							\
+	case ITER_EQ:							\
+		for (uint32_t i = 0; i < count; i++)			\
+			mask[i] = values[i] == value;			\
+		break;							\
+	case ITER_LT:							\
+		for (uint32_t i = 0; i < count; i++)			\
+			mask[i] = values[i] < value;			\
+		break;							\
+	case ITER_LE:							\
+		for (uint32_t i = 0; i < count; i++)			\
+			mask[i] = values[i] <= value;			\
+		break;							\
+	case ITER_GT:							\
+		for (uint32_t i = 0; i < count; i++)			\
+			mask[i] = values[i] > value;			\
+		break;							\
+	case ITER_GE:							\
+		for (uint32_t i = 0; i < count; i++)			\
+			mask[i] = values[i] >= value;			\
+		break;							\
+	default:							\
+		unreachable();						\
+	}								\
+}
+
+COLUMN_FILTER_DEF(u64, uint64_t)
+COLUMN_FILTER_DEF(double, double)
+
+#undef COLUMN_FILTER_DEF
+
+static uint32_t
+column_count(const uint8_t *mask, uint32_t count)
+{
+	if (mask == NULL)
+		return count;
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < count; i++)
+		result += mask[i];
+	return result;
+}
+
+/**
+ * A sum of 64-bit integers, kept as separate sums of their low
+ * and high 32-bit halves. Adding a half never overflows for
+ * fewer than 2^32 rows, so the kernel needs no overflow checks.
+ */
+struct column_sum {
+	uint64_t lo;
+	uint64_t hi;
+};
+
+/** Add values of a block to a sum. */
+static void
+column_sum_u64(const uint64_t *values, const uint8_t *mask, uint32_t count,
+	       struct column_sum *sum)
+{
+	uint64_t lo = 0, hi = 0;
+	if (mask == NULL) {
+		for (uint32_t i = 0; i < count; i++) {
+			uint64_t v = values[i];
+			lo += v & UINT32_MAX;
+			hi += v >> 32;
+		}
+	} else {
+		for (uint32_t i = 0; i < count; i++) {
+			uint64_t v = values[i] & -(uint64_t)mask[i];
+			lo += v & UINT32_MAX;
+			hi += v >> 32;
+		}
+	}
+	sum->lo += lo;
+	sum->hi += hi;
+}
+
+static double
+column_sum_double(const double *values, const uint8_t *mask, uint32_t count)
+{
+	double sum = 0;
+	if (mask == NULL) {
+		for (uint32_t i = 0; i < count; i++)
+			sum += values[i];
+	} else {
+		for (uint32_t i = 0; i < count; i++)
+			sum += mask[i] ? values[i] : 0;
+	}
+	return sum;
+}
+
+#define COLUMN_MINMAX_DEF(name, type, type_min, type_max)		\
+static type								\
+column_min_##name(const type *values, const uint8_t *mask,		\
+		  uint32_t count, type min)				\
+{									\
+	if (mask == NULL) {						\
+		for (uint32_t i = 0; i < count; i++)			\
+			min = values[i] < min ? values[i] : min;	\
+	} else {							\
+		for (uint32_t i = 0; i < count; i++) {			\
+			type v = mask[i] ? values[i] : type_max;	\
+			min = v < min ? v : min;			\
+		}							\
+	}								\
+	return min;							\
+}									\
+									\
+static type								\
+column_max_##name(const type *values, const uint8_t *mask,		\
+		  uint32_t count, type max)				\
+{									\
+	if (mask == NULL) {						\
+		for (uint32_t i = 0; i < count; i++)			\
+			max = values[i] > max ? values[i] : max;	\
+	} else {							\
+		for (uint32_t i = 0; i < count; i++) {			\
+			type v = mask[i] ? values[i] : type_min;	\
+			max = v > max ? v : max;			\
+		}							\
+	}								\
+	return max;							\
+}
+
+COLUMN_MINMAX_DEF(u64, uint64_t, 0, UINT64_MAX)
+COLUMN_MINMAX_DEF(double, double, -HUGE_VAL, HUGE_VAL)
+
+#undef COLUMN_MINMAX_DEF
+
+/* }}} */
+
+/** Filter applied to rows before aggregation. */
+struct column_filter {
+	/** Comparison, ITER_ALL if every row passes. */
+	enum iterator_type op;
+	/** True if no row can pass. */
+	bool is_empty;
+	/** Column the filter is applied to. */
+	struct matras *column;
+	/** Type of the column. */
+	enum field_type type;
+	/** Value the column is compared with. */
+	union column_value value;
+};
+
+/**
+ * Convert index:aggregate() filter arguments to a comparison in
+ * the column domain. Values out of the column range turn into
+ * a filter that passes all or no rows.
+ */
+static int
+column_filter_create(struct column_filter *filter,
+		     struct memtx_column_index *index,
+		     const struct index_aggregate *aggregate)
+{
+	filter->op = aggregate->filter_type;
+	filter->is_empty = false;
+	if (filter->op == ITER_ALL)
+		return 0;
+	if (filter->op != ITER_EQ && filter->op != ITER_LT &&
+	    filter->op != ITER_LE && filter->op != ITER_GT &&
+	    filter->op != ITER_GE) {
+		diag_set(UnsupportedIndexFeature, index->base.def,
+			 "requested iterator type");
+		return -1;
+	}
+	struct key_part *part =
+		&index->base.def->key_def->parts[aggregate->filter_part];
+	filter->column = &index->columns[aggregate->filter_part];
+	filter->type = part->type;
+	const char *value = aggregate->filter_value;
+	enum mp_type mp_type = mp_typeof(*value);
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+		if (mp_type == MP_UINT) {
+			filter->value.u = mp_decode_uint(&value);
+			return 0;
+		}
+		if (mp_type != MP_INT)
+			goto type_error;
+		/* A negative value is less than all values. */
+		if (filter->op == ITER_GT || filter->op == ITER_GE)
+			filter->op = ITER_ALL;
+		else
+			filter->is_empty = true;
+		return 0;
+	case FIELD_TYPE_DOUBLE:
+		switch (mp_type) {
+		case MP_UINT:
+			filter->value.d = mp_decode_uint(&value);
+			return 0;
+		case MP_INT:
+			filter->value.d = mp_decode_int(&value);
+			return 0;
+		case MP_FLOAT:
+			filter->value.d = mp_decode_float(&value);
+			return 0;
+		case MP_DOUBLE:
+			filter->value.d = mp_decode_double(&value);
+			return 0;
+		default:
+			goto type_error;
+		}
+	case FIELD_TYPE_STRING: {
+		if (mp_type != MP_STR)
+			goto type_error;
+		if (filter->op != ITER_EQ) {
+			diag_set(UnsupportedIndexFeature, index->base.def,
+				 "requested iterator type on a string part");
+			return -1;
+		}
+		uint32_t len;
+		const char *str = mp_decode_str(&value, &len);
+		mh_int_t k = mh_strnptr_find_inp(index->dict, str, len);
+		if (k == mh_end(index->dict)) {
+			filter->is_empty = true;
+			return 0;
+		}
+		filter->value.u =
+			(uintptr_t)mh_strnptr_node(index->dict, k)->val;
+		return 0;
+	}
+	default:
+		unreachable();
+		return -1;
+	}
+type_error:
+	diag_set(ClientError, ER_KEY_PART_TYPE, aggregate->filter_part,
+		 field_type_strs[part->type]);
+	return -1;
+}
+
+/** Fill the selection mask of a block. */
+static void
+column_filter_block(struct column_filter *filter, uint32_t start,
+		    uint32_t count, uint8_t *mask)
+{
+	const void *values = matras_get(filter->column, start);
+	switch (filter->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_STRING:
+		column_filter_u64((const uint64_t *)values, count,
+				  filter->op, filter->value.u, mask);
+		break;
+	case FIELD_TYPE_DOUBLE:
+		column_filter_double((const double *)values, count,
+				     filter->op, filter->value.d, mask);
+		break;
+	default:
+		unreachable();
+	}
+}
+
+/**
+ * Encode an unsigned sum, or set an error if it does not fit
+ * into 64 bits.
+ */
+static char *
+column_sum_encode(struct column_sum *sum, struct key_part *part,
+		  char *result)
+{
+	assert(part->type == FIELD_TYPE_UNSIGNED);
+	uint64_t hi;
+	if (__builtin_add_overflow(sum->hi, sum->lo >> 32, &hi) ||
+	    hi > UINT32_MAX) {
+		diag_set(ClientError, ER_UPDATE_INTEGER_OVERFLOW, '+',
+			 int2str(part->fieldno + TUPLE_INDEX_BASE));
+		return NULL;
+	}
+	return mp_encode_uint(result, hi << 32 | (sum->lo & UINT32_MAX));
+}
+
+static char *
+memtx_column_index_aggregate(struct index *base,
+			     const struct index_aggregate *aggregate,
+			     char *result)
+{
+	struct memtx_column_index *index = (struct memtx_column_index *)base;
+	/*
+	 * Columns contain rows that are not yet committed and
+	 * the kernels can't tell them apart.
+	 */
+	if (memtx_tx_manager_use_mvcc_engine) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "aggregate() with MVCC enabled");
+		return NULL;
+	}
+	struct key_part *part = &base->def->key_def->parts[aggregate->part];
+	if (part->type == FIELD_TYPE_STRING &&
+	    aggregate->func != AGGREGATE_COUNT) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 tt_sprintf("%s() of a string part",
+				    aggregate_func_strs[aggregate->func]));
+		return NULL;
+	}
+	struct column_filter filter;
+	if (column_filter_create(&filter, index, aggregate) != 0)
+		return NULL;
+
+	struct matras *column = &index->columns[aggregate->part];
+	uint64_t count = 0;
+	struct column_sum sum = { 0, 0 };
+	double dsum = 0;
+	union column_value min, max;
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_STRING:
+		min.u = UINT64_MAX;
+		max.u = 0;
+		break;
+	case FIELD_TYPE_DOUBLE:
+		min.d = HUGE_VAL;
+		max.d = -HUGE_VAL;
+		break;
+	default:
+		unreachable();
+	}
+	uint8_t mask_buf[COLUMN_BLOCK_SIZE];
+	uint32_t row_count = filter.is_empty ? 0 : index->row_count;
+	for (uint32_t start = 0; start < row_count;
+	     start += COLUMN_BLOCK_SIZE) {
+		uint32_t n = MIN((uint32_t)COLUMN_BLOCK_SIZE,
+				 row_count - start);
+		const uint8_t *mask = NULL;
+		if (filter.op != ITER_ALL) {
+			column_filter_block(&filter, start, n, mask_buf);
+			mask = mask_buf;
+		}
+		count += column_count(mask, n);
+		if (aggregate->func == AGGREGATE_COUNT)
+			continue;
+		const void *values = matras_get(column, start);
+		switch (aggregate->func) {
+		case AGGREGATE_SUM:
+			if (part->type == FIELD_TYPE_DOUBLE)
+				dsum += column_sum_double(
+					(const double *)values, mask, n);
+			else
+				column_sum_u64((const uint64_t *)values, mask,
+					       n, &sum);
+			break;
+		case AGGREGATE_MIN:
+			if (part->type == FIELD_TYPE_UNSIGNED)
+				min.u = column_min_u64(
+					(const uint64_t *)values, mask, n,
+					min.u);
+			else
+				min.d = column_min_double(
+					(const double *)values, mask, n,
+					min.d);
+			break;
+		case AGGREGATE_MAX:
+			if (part->type == FIELD_TYPE_UNSIGNED)
+				max.u = column_max_u64(
+					(const uint64_t *)values, mask, n,
+					max.u);
+			else
+				max.d = column_max_double(
+					(const double *)values, mask, n,
+					max.d);
+			break;
+		default:
+			unreachable();
+		}
+	}
+
+	union column_value *value;
+	switch (aggregate->func) {
+	case AGGREGATE_COUNT:
+		return mp_encode_uint(result, count);
+	case AGGREGATE_SUM:
+		if (part->type == FIELD_TYPE_DOUBLE)
+			return mp_encode_double(result, dsum);
+		return column_sum_encode(&sum, part, result);
+	case AGGREGATE_MIN:
+		value = &min;
+		break;
+	case AGGREGATE_MAX:
+		value = &max;
+		break;
+	default:
+		unreachable();
+		return NULL;
+	}
+	if (count == 0)
+		return mp_encode_nil(result);
+	if (part->type == FIELD_TYPE_DOUBLE)
+		return mp_encode_double(result, value->d);
+	return mp_encode_uint(result, value->u);
+}
+
+static const struct index_vtab memtx_column_index_vtab = {
+	/* .destroy = */ memtx_column_index_destroy,
+	/* .commit_create = */ generic_index_commit_create,
+	/* .abort_create = */ generic_index_abort_create,
+	/* .commit_modify = */ generic_index_commit_modify,
+	/* .commit_drop = */ generic_index_commit_drop,
+	/* .update_def = */ generic_index_update_def,
+	/* .depends_on_pk = */ generic_index_depends_on_pk,
+	/* .def_change_requires_rebuild = */
+		memtx_index_def_change_requires_rebuild,
+	/* .size = */ memtx_column_index_size,
+	/* .bsize = */ memtx_column_index_bsize,
+	/* .min = */ generic_index_min,
+	/* .max = */ generic_index_max,
+	/* .random = */ generic_index_random,
+	/* .count = */ generic_index_count,
+	/* .get = */ generic_index_get,
+	/* .replace = */ memtx_column_index_replace,
+	/* .create_iterator = */ memtx_column_index_create_iterator,
+	/* .create_snapshot_iterator = */
+		generic_index_create_snapshot_iterator,
+	/* .create_read_view_iterator = */
+		generic_index_create_read_view_iterator,
+	/* .aggregate = */ memtx_column_index_aggregate,
+	/* .stat = */ generic_index_stat,
+	/* .compact = */ generic_index_compact,
+	/* .reset_stat = */ generic_index_reset_stat,
+	/* .begin_build = */ generic_index_begin_build,
+	/* .reserve = */ generic_index_reserve,
+	/* .build_next = */ generic_index_build_next,
+	/* .end_build = */ generic_index_end_build,
+};
+
+struct index *
+memtx_column_index_new(struct memtx_engine *memtx, struct index_def *def)
+{
+	assert(def->iid > 0);
+	assert(!def->opts.is_unique);
+
+	struct memtx_column_index *index =
+		(struct memtx_column_index *)calloc(1, sizeof(*index));
+	if (index == NULL) {
+		diag_set(OutOfMemory, sizeof(*index),
+			 "malloc", "struct memtx_column_index");
+		return NULL;
+	}
+	uint32_t part_count = def->key_def->part_count;
+	index->columns = (struct matras *)calloc(part_count,
+						 sizeof(*index->columns));
+	if (index->columns == NULL) {
+		diag_set(OutOfMemory, part_count * sizeof(*index->columns),
+			 "malloc", "memtx_column_index columns");
+		free(index);
+		return NULL;
+	}
+	if (index_create(&index->base, (struct engine *)memtx,
+			 &memtx_column_index_vtab, def) != 0) {
+		free(index->columns);
+		free(index);
+		return NULL;
+	}
+	matras_create(&index->rows, MEMTX_EXTENT_SIZE, sizeof(struct tuple *),
+		      memtx_index_extent_alloc, memtx_index_extent_free, memtx);
+	for (uint32_t i = 0; i < part_count; i++) {
+		matras_create(&index->columns[i], MEMTX_EXTENT_SIZE,
+			      sizeof(union column_value),
+			      memtx_index_extent_alloc,
+			      memtx_index_extent_free, memtx);
+	}
+	index->tuple_to_row = mh_column_index_new();
+	index->dict = mh_strnptr_new();
+	if (index->tuple_to_row == NULL || index->dict == NULL)
+		panic("failed to allocate memtx column index");
+	return &index->base;
+}
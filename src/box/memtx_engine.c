@@ -145,6 +145,8 @@ memtx_engine_shutdown(struct engine *engine)
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
 	xdir_destroy(&memtx->snap_dir);
+	free(memtx->defrag.space_ids);
+	free(memtx->defrag.key);
 	free(memtx);
 }
 
@@ -404,6 +406,9 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 	if (stmt->engine_savepoint == NULL)
 		return;
 
+	if (stmt->old_tuple == stmt->new_tuple)
+		return memtx_space_rollback_update_in_place(stmt);
+
 	if (stmt->add_story != NULL || stmt->del_story != NULL)
 		return memtx_tx_history_rollback_stmt(stmt);
 
@@ -1049,10 +1054,167 @@ memtx_engine_gc_f(va_list va)
 	return 0;
 }
 
+static int
+small_stats_fragmented_cb(const struct mempool_stats *stats, void *cb_ctx)
+{
+	size_t *fragmented = (size_t *)cb_ctx;
+	/*
+	 * Free space of one slab per pool is unavoidable: new
+	 * objects are allocated from it.
+	 */
+	size_t free = stats->totals.total - stats->totals.used;
+	if (free > stats->slabsize)
+		*fragmented += free - stats->slabsize;
+	return 0;
+}
+
+size_t
+memtx_engine_fragmented_size(struct memtx_engine *memtx, size_t *total)
+{
+	struct small_stats totals;
+	size_t fragmented = 0;
+	small_stats(&memtx->alloc, &totals, small_stats_fragmented_cb,
+		    &fragmented);
+	*total = totals.total;
+	return fragmented;
+}
+
+/**
+ * Collect ids of memtx spaces to visit during a
+ * defragmentation pass.
+ */
+static int
+memtx_engine_defrag_add_space(struct space *space, void *arg)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)arg;
+	if (space->engine != &memtx->base)
+		return 0;
+	if (memtx->defrag.space_count == memtx->defrag.space_capacity) {
+		uint32_t capacity = MAX(memtx->defrag.space_capacity * 2, 16);
+		uint32_t *ids = realloc(memtx->defrag.space_ids,
+					capacity * sizeof(*ids));
+		if (ids == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*ids),
+				 "realloc", "space ids");
+			return -1;
+		}
+		memtx->defrag.space_ids = ids;
+		memtx->defrag.space_capacity = capacity;
+	}
+	memtx->defrag.space_ids[memtx->defrag.space_count++] =
+		space_id(space);
+	return 0;
+}
+
+/**
+ * Check if the arena is fragmented enough to start a
+ * defragmentation pass and, if it is, start it.
+ */
+static bool
+memtx_engine_defrag_begin(struct memtx_engine *memtx)
+{
+	if (memtx->defrag_threshold <= 0 || memtx->state != MEMTX_OK)
+		return false;
+	size_t total;
+	size_t fragmented = memtx_engine_fragmented_size(memtx, &total);
+	if (total == 0 ||
+	    (double)fragmented / total < memtx->defrag_threshold)
+		return false;
+	memtx->defrag.space_count = 0;
+	memtx->defrag.space_pos = 0;
+	if (space_foreach(memtx_engine_defrag_add_space, memtx) != 0) {
+		diag_log();
+		return false;
+	}
+	say_info("memtx defragmentation started: %zu of %zu bytes "
+		 "fragmented", fragmented, total);
+	return memtx->defrag.space_count > 0;
+}
+
+/**
+ * Run one step of the defragmentation pass. Set @done if the
+ * pass is over.
+ */
+static void
+memtx_engine_defrag_step(struct memtx_engine *memtx, bool *done)
+{
+	struct memtx_defrag *defrag = &memtx->defrag;
+	*done = false;
+	struct space *space = space_by_id(defrag->space_ids[defrag->space_pos]);
+	/* The saved key may not fit the altered primary key. */
+	if (defrag->schema_version != schema_version) {
+		free(defrag->key);
+		defrag->key = NULL;
+	}
+	const char *key = defrag->key;
+	uint32_t part_count = 0;
+	if (key != NULL)
+		part_count = mp_decode_array(&key);
+	struct tuple *last = NULL;
+	uint32_t moved = 0;
+	/* The space may have been dropped meanwhile. */
+	if (space != NULL && space->engine == &memtx->base &&
+	    memtx_space_defrag(space, key, part_count, &last, &moved) != 0) {
+		diag_log();
+		last = NULL;
+	}
+	defrag->moved += moved;
+	free(defrag->key);
+	defrag->key = NULL;
+	if (last != NULL) {
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		uint32_t key_size;
+		const char *last_key = tuple_extract_key(last,
+					space->index[0]->def->key_def,
+					MULTIKEY_NONE, &key_size);
+		if (last_key != NULL)
+			defrag->key = malloc(key_size);
+		if (defrag->key != NULL)
+			memcpy(defrag->key, last_key, key_size);
+		defrag->schema_version = schema_version;
+		region_truncate(region, region_svp);
+		tuple_unref(last);
+	}
+	if (defrag->key == NULL && ++defrag->space_pos == defrag->space_count) {
+		say_info("memtx defragmentation finished");
+		*done = true;
+	}
+}
+
+static int
+memtx_engine_defrag_f(va_list va)
+{
+	struct memtx_engine *memtx = va_arg(va, struct memtx_engine *);
+	bool in_progress = false;
+	while (!fiber_is_cancelled()) {
+		/*
+		 * Tuples seen by a read view can't be freed, so
+		 * there is no point in moving them.
+		 */
+		if (memtx->delayed_free_mode > 0 ||
+		    (!in_progress && !memtx_engine_defrag_begin(memtx))) {
+			fiber_yield_timeout(MEMTX_DEFRAG_CHECK_INTERVAL);
+			continue;
+		}
+		in_progress = true;
+		bool done;
+		memtx_engine_defrag_step(memtx, &done);
+		if (done)
+			in_progress = false;
+		/*
+		 * Yield after each step so as not to block
+		 * tx thread for too long.
+		 */
+		fiber_sleep(0);
+	}
+	return 0;
+}
+
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size, uint32_t objsize_min,
-		 bool dontdump, float alloc_factor)
+		 bool dontdump, bool huge_pages, float alloc_factor)
 {
 	struct memtx_engine *memtx = calloc(1, sizeof(*memtx));
 	if (memtx == NULL) {
@@ -1099,6 +1261,9 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->gc_fiber = fiber_new("memtx.gc", memtx_engine_gc_f);
 	if (memtx->gc_fiber == NULL)
 		goto fail;
+	memtx->defrag_fiber = fiber_new("memtx.defrag", memtx_engine_defrag_f);
+	if (memtx->defrag_fiber == NULL)
+		goto fail;
 
 	/* Apply lowest allowed objsize bound. */
 	if (objsize_min < OBJSIZE_MIN)
@@ -1107,7 +1272,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	/* Initialize tuple allocator. */
 	quota_init(&memtx->quota, tuple_arena_max_size);
 	tuple_arena_create(&memtx->arena, &memtx->quota, tuple_arena_max_size,
-			   SLAB_SIZE, dontdump, "memtx");
+			   SLAB_SIZE, dontdump, huge_pages, "memtx");
 	slab_cache_create(&memtx->slab_cache, &memtx->arena);
 	small_alloc_create(&memtx->alloc, &memtx->slab_cache,
 			   objsize_min, alloc_factor);
@@ -1131,6 +1296,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->base.name = "memtx";
 
 	fiber_start(memtx->gc_fiber, memtx);
+	fiber_start(memtx->defrag_fiber, memtx);
 	return memtx;
 fail:
 	xdir_destroy(&memtx->snap_dir);
@@ -1170,6 +1336,13 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_defrag_threshold(struct memtx_engine *memtx, double threshold)
+{
+	memtx->defrag_threshold = threshold;
+	fiber_wakeup(memtx->defrag_fiber);
+}
+
 void
 memtx_enter_delayed_free_mode(struct memtx_engine *memtx)
 {
@@ -1194,25 +1367,41 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	struct tuple *tuple = NULL;
 	struct region *region = &fiber()->gc;
 	size_t region_svp = region_used(region);
+	/*
+	 * Field types are checked on decompressed data, because
+	 * snapshot and replication feed tuples compressed. The
+	 * field map stays valid after compression, since it only
+	 * points before compressed fields.
+	 */
+	if (format->compression != COMPRESSION_TYPE_NONE &&
+	    tuple_decompress_raw(format, &data, &end) != 0)
+		goto end;
 	struct field_map_builder builder;
 	if (tuple_field_map_create(format, data, true, &builder) != 0)
 		goto end;
+	if (format->compression != COMPRESSION_TYPE_NONE &&
+	    tuple_compress_raw(format, &data, &end) != 0)
+		goto end;
 	uint32_t field_map_size = field_map_build_size(&builder);
+	size_t tuple_len = end - data;
 	/*
 	 * Data offset is calculated from the begin of the struct
 	 * tuple base, not from memtx_tuple, because the struct
 	 * tuple is not the first field of the memtx_tuple.
+	 * Small tuples use a compact header without bsize_bulky.
 	 */
-	uint32_t data_offset = sizeof(struct tuple) + field_map_size;
-	if (data_offset > INT16_MAX) {
-		/** tuple->data_offset is 15 bits */
+	uint32_t data_offset = TUPLE_COMPACT_SIZE + field_map_size;
+	bool is_compact = tuple_can_be_compact(data_offset, tuple_len);
+	if (!is_compact)
+		data_offset = sizeof(struct tuple) + field_map_size;
+	if (data_offset > TUPLE_DATA_OFFSET_MAX) {
+		/** Data offset of a tuple is 14 bits. */
 		diag_set(ClientError, ER_TUPLE_METADATA_IS_TOO_BIG,
 			 data_offset);
 		goto end;
 	}
-
-	size_t tuple_len = end - data;
-	size_t total = sizeof(struct memtx_tuple) + field_map_size + tuple_len;
+	size_t total = offsetof(struct memtx_tuple, base) + data_offset +
+		       tuple_len;
 
 	ERROR_INJECT(ERRINJ_TUPLE_ALLOC, {
 		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
@@ -1239,12 +1428,11 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	tuple->refs = 0;
 	memtx_tuple->version = memtx->snapshot_version;
 	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
-	tuple->bsize = tuple_len;
+	tuple_set_data_offset_bsize(tuple, data_offset, tuple_len, is_compact);
 	tuple->format_id = tuple_format_id(format);
 	tuple_format_ref(format);
-	tuple->data_offset = data_offset;
 	tuple->is_dirty = false;
-	char *raw = (char *) tuple + tuple->data_offset;
+	char *raw = (char *) tuple + data_offset;
 	field_map_build(&builder, raw - field_map_size);
 	memcpy(raw, data, tuple_len);
 	say_debug("%s(%zu) = %p", __func__, tuple_len, memtx_tuple);
@@ -1271,6 +1459,44 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	tuple_format_unref(format);
 }
 
+struct tuple *
+memtx_tuple_move(struct tuple_format *format, struct tuple *tuple)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	size_t total = tuple_size(tuple) + offsetof(struct memtx_tuple, base);
+	struct memtx_tuple *copy = smalloc(&memtx->alloc, total);
+	if (copy == NULL)
+		return NULL;
+	/*
+	 * The allocator reuses free space of the slabs with the
+	 * lowest addresses first, so moving tuples down lets it
+	 * release slabs at the end of the arena.
+	 */
+	if (copy > memtx_tuple) {
+		smfree(&memtx->alloc, copy, total);
+		return NULL;
+	}
+	memcpy(copy, memtx_tuple, total);
+	copy->version = memtx->snapshot_version;
+	copy->base.refs = 0;
+	tuple_format_ref(format);
+	return &copy->base;
+}
+
+bool
+memtx_tuple_in_read_view(struct tuple_format *format, struct tuple *tuple)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	/* See memtx_tuple_delete(). */
+	return memtx->alloc.free_mode == SMALL_DELAYED_FREE &&
+	       memtx_tuple->version != memtx->snapshot_version &&
+	       !format->is_temporary;
+}
+
 void
 metmx_tuple_chunk_delete(struct tuple_format *format, const char *data)
 {
@@ -1398,6 +1624,8 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.func_id != new_def->opts.func_id)
 		return true;
+	if (old_def->opts.normalized_key != new_def->opts.normalized_key)
+		return true;
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
@@ -1423,6 +1651,15 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 			return true;
 		if (old_part->coll != new_part->coll)
 			return true;
+		/*
+		 * Normalized key hints depend on part types and
+		 * nullability, see key_hint_normalized().
+		 */
+		if (new_def->opts.normalized_key &&
+		    (old_part->type != new_part->type ||
+		     key_part_is_nullable(old_part) !=
+		     key_part_is_nullable(new_part)))
+			return true;
 		if (json_path_cmp(old_part->path, old_part->path_len,
 				  new_part->path, new_part->path_len,
 				  TUPLE_INDEX_BASE) != 0)
@@ -107,6 +107,28 @@ enum memtx_reserve_extents_num {
  */
 #define MEMTX_ITERATOR_SIZE (152)
 
+/** State of a memtx defragmentation pass. */
+struct memtx_defrag {
+	/** Ids of the spaces to visit. */
+	uint32_t *space_ids;
+	/** Number of ids in @space_ids. */
+	uint32_t space_count;
+	/** Number of ids @space_ids has room for. */
+	uint32_t space_capacity;
+	/** Position in @space_ids of the space being visited. */
+	uint32_t space_pos;
+	/**
+	 * Primary key of the last visited tuple of the space,
+	 * allocated with malloc(). NULL if the space is to be
+	 * visited from the beginning.
+	 */
+	char *key;
+	/** Schema version @key was taken at. */
+	uint32_t schema_version;
+	/** Number of tuples moved since the instance start. */
+	uint64_t moved;
+};
+
 struct memtx_engine {
 	struct engine base;
 	/** Engine recovery state. */
@@ -178,6 +200,19 @@ struct memtx_engine {
 	 * memtx_gc_task::link.
 	 */
 	struct stailq gc_queue;
+	/**
+	 * Defragmentation fiber. Moves tuples to lower addresses
+	 * when the tuple arena is fragmented.
+	 */
+	struct fiber *defrag_fiber;
+	/**
+	 * Share of free memory the tuple allocator can't reuse
+	 * for objects of any size that triggers defragmentation,
+	 * box.cfg.memtx_defrag_threshold. Zero disables it.
+	 */
+	double defrag_threshold;
+	/** Current defragmentation pass. */
+	struct memtx_defrag defrag;
 };
 
 struct memtx_gc_task;
@@ -209,11 +244,19 @@ void
 memtx_engine_schedule_gc(struct memtx_engine *memtx,
 			 struct memtx_gc_task *task);
 
+enum {
+	/**
+	 * How often the defragmentation fiber checks the
+	 * fragmentation of the tuple arena, in seconds.
+	 */
+	MEMTX_DEFRAG_CHECK_INTERVAL = 1,
+};
+
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size,
 		 uint32_t objsize_min, bool dontdump,
-		 float alloc_factor);
+		 bool huge_pages, float alloc_factor);
 
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
@@ -228,6 +271,18 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+void
+memtx_engine_set_defrag_threshold(struct memtx_engine *memtx, double threshold);
+
+/**
+ * Return the size of free memory of the tuple allocator that
+ * is scattered over partially used slabs, beyond one slab per
+ * object size class. @a total is set to the size of all slabs
+ * used for tuples.
+ */
+size_t
+memtx_engine_fragmented_size(struct memtx_engine *memtx, size_t *total);
+
 /**
  * Enter tuple delayed free mode: tuple allocated before the call
  * won't be freed until memtx_leave_delayed_free_mode() is called.
@@ -253,6 +308,21 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 
+/**
+ * Check if a read view (a checkpoint or a replica join) may
+ * see the tuple, so it must not be freed or modified in place.
+ */
+bool
+memtx_tuple_in_read_view(struct tuple_format *format, struct tuple *tuple);
+
+/**
+ * Allocate a copy of a memtx tuple at a lower address than
+ * the tuple has. Return NULL if there is no such free memory.
+ * The copy is not referenced.
+ */
+struct tuple *
+memtx_tuple_move(struct tuple_format *format, struct tuple *tuple);
+
 /** Tuple format vtab for memtx engine. */
 extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
@@ -299,13 +369,13 @@ static inline struct memtx_engine *
 memtx_engine_new_xc(const char *snap_dirname, bool force_recovery,
 		    uint64_t tuple_arena_max_size,
 		    uint32_t objsize_min, bool dontdump,
-		    float alloc_factor)
+		    bool huge_pages, float alloc_factor)
 {
 	struct memtx_engine *memtx;
 	memtx = memtx_engine_new(snap_dirname, force_recovery,
 				 tuple_arena_max_size,
 				 objsize_min, dontdump,
-				 alloc_factor);
+				 huge_pages, alloc_factor);
 	if (memtx == NULL)
 		diag_raise();
 	return memtx;
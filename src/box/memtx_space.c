@@ -40,6 +40,7 @@
 #include "memtx_tree.h"
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
+#include "memtx_column.h"
 #include "memtx_engine.h"
 #include "column_mask.h"
 #include "sequence.h"
@@ -377,6 +378,164 @@ memtx_space_execute_delete(struct space *space, struct txn *txn,
 	return 0;
 }
 
+/**
+ * Check if an update of @a tuple may be applied in place. That
+ * is only possible if nobody but the space references the tuple,
+ * no read view, trigger or MVCC story may see its old version,
+ * the update doesn't change any key and keeps the tuple size.
+ */
+static bool
+memtx_space_can_update_in_place(struct space *space, struct txn *txn,
+				struct tuple *tuple, uint32_t new_size,
+				uint64_t column_mask)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct tuple_format *format = space->format;
+	if (tuple->refs != 1 || tuple_bsize(tuple) != new_size ||
+	    tuple_format(tuple) != format)
+		return false;
+	/*
+	 * on_commit and on_rollback triggers of an explicit
+	 * transaction see both old and new tuples.
+	 */
+	if (!txn_has_flag(txn, TXN_IS_AUTOCOMMIT))
+		return false;
+	if (memtx_tx_manager_use_mvcc_engine ||
+	    format->compression != COMPRESSION_TYPE_NONE ||
+	    !rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace))
+		return false;
+	/* See memtx_engine_rollback_statement(). */
+	if (memtx_space->replace != memtx_space_replace_all_keys &&
+	    memtx_space->replace != memtx_space_replace_primary_key)
+		return false;
+	if (memtx_tuple_in_read_view(format, tuple))
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct key_def *key_def = space->index[i]->def->key_def;
+		if (key_def->for_func_index ||
+		    !key_update_can_be_skipped(key_def->column_mask,
+					       column_mask))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Overwrite the data of @a tuple with the result of an update.
+ * Indexes are not touched, since keys stay the same. The old
+ * data is saved on the transaction region and the statement
+ * refers to the tuple as both old and new one.
+ *
+ * @retval 0 The update is applied.
+ * @retval 1 The new data has another field map, the tuple must
+ *           be replaced.
+ * @retval -1 Error.
+ */
+static int
+memtx_space_update_in_place(struct txn *txn, struct txn_stmt *stmt,
+			    struct tuple *tuple, const char *new_data,
+			    uint32_t new_size)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = -1;
+	struct field_map_builder builder;
+	if (tuple_field_map_create(format, new_data, true, &builder) != 0)
+		goto end;
+	rc = 1;
+	uint32_t field_map_size = field_map_build_size(&builder);
+	uint32_t header_size = tuple->is_compact ? TUPLE_COMPACT_SIZE :
+			       sizeof(struct tuple);
+	if (tuple_data_offset(tuple) - header_size != field_map_size)
+		goto end;
+	if (field_map_size > 0) {
+		char *field_map = (char *)region_alloc(region, field_map_size);
+		if (field_map == NULL) {
+			diag_set(OutOfMemory, field_map_size, "region_alloc",
+				 "field_map");
+			rc = -1;
+			goto end;
+		}
+		field_map_build(&builder, field_map);
+		if (memcmp(field_map, (char *)tuple + header_size,
+			   field_map_size) != 0)
+			goto end;
+	}
+	char *undo = (char *)region_alloc(&txn->region, new_size);
+	if (undo == NULL) {
+		diag_set(OutOfMemory, new_size, "region_alloc", "undo");
+		rc = -1;
+		goto end;
+	}
+	char *data = (char *)tuple + tuple_data_offset(tuple);
+	memcpy(undo, data, new_size);
+	memcpy(data, new_data, new_size);
+	/* Both references are dropped by txn_stmt_destroy(). */
+	tuple_ref(tuple);
+	tuple_ref(tuple);
+	stmt->old_tuple = tuple;
+	stmt->new_tuple = tuple;
+	stmt->engine_savepoint = undo;
+	rc = 0;
+end:
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+void
+memtx_space_rollback_update_in_place(struct txn_stmt *stmt)
+{
+	struct tuple *tuple = stmt->new_tuple;
+	assert(tuple == stmt->old_tuple);
+	struct space *space = stmt->space;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct tuple_format *format = tuple_format(tuple);
+	const char *undo = (const char *)stmt->engine_savepoint;
+	uint32_t bsize = tuple_bsize(tuple);
+	/*
+	 * The statement holds two references and the space one.
+	 * If nobody else got the tuple and no read view was
+	 * opened while the WAL write was in progress, the old
+	 * data may be copied back.
+	 */
+	if (tuple->refs == 3 && !memtx_tuple_in_read_view(format, tuple)) {
+		memcpy((char *)tuple + tuple_data_offset(tuple), undo, bsize);
+		return;
+	}
+	/*
+	 * The new data has been seen, so the tuple must stay as
+	 * is. Replace it with a new tuple made of the old data.
+	 * Keys are the same, so rollback of the following
+	 * statements finds it.
+	 */
+	struct tuple *old_tuple = memtx_tuple_new(format, undo, undo + bsize);
+	if (old_tuple == NULL) {
+		/*
+		 * Out of memory. A reader seeing the tuple
+		 * change is still better than a crash.
+		 */
+		diag_log();
+		memcpy((char *)tuple + tuple_data_offset(tuple), undo, bsize);
+		return;
+	}
+	uint32_t index_count = 1;
+	if (memtx_space->replace == memtx_space_replace_all_keys)
+		index_count = space->index_count;
+	for (uint32_t i = 0; i < index_count; i++) {
+		struct tuple *unused;
+		if (index_replace(space->index[i], tuple, old_tuple,
+				  DUP_REPLACE, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback change");
+		}
+	}
+	tuple_ref(old_tuple);
+	tuple_unref(tuple);
+}
+
 static int
 memtx_space_execute_update(struct space *space, struct txn *txn,
 			   struct request *request, struct tuple **result)
@@ -402,15 +561,32 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 
 	/* Update the tuple; legacy, request ops are in request->tuple */
 	uint32_t new_size = 0, bsize;
+	uint64_t column_mask = COLUMN_MASK_FULL;
 	struct tuple_format *format = space->format;
-	const char *old_data = tuple_data_range(old_tuple, &bsize);
+	/* Update ops can't work on compressed fields. */
+	const char *old_data = tuple_data_range_decompressed(old_tuple, &bsize);
+	if (old_data == NULL)
+		return -1;
 	const char *new_data =
 		xrow_update_execute(request->tuple, request->tuple_end,
 				    old_data, old_data + bsize, format,
-				    &new_size, request->index_base, NULL);
+				    &new_size, request->index_base,
+				    &column_mask);
 	if (new_data == NULL)
 		return -1;
 
+	if (memtx_space_can_update_in_place(space, txn, old_tuple, new_size,
+					    column_mask)) {
+		int rc = memtx_space_update_in_place(txn, stmt, old_tuple,
+						     new_data, new_size);
+		if (rc < 0)
+			return -1;
+		if (rc == 0) {
+			*result = old_tuple;
+			return 0;
+		}
+	}
+
 	stmt->new_tuple = memtx_tuple_new(format, new_data,
 					  new_data + new_size);
 	if (stmt->new_tuple == NULL)
@@ -489,7 +665,10 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 		tuple_ref(stmt->new_tuple);
 	} else {
 		uint32_t new_size = 0, bsize;
-		const char *old_data = tuple_data_range(old_tuple, &bsize);
+		const char *old_data =
+			tuple_data_range_decompressed(old_tuple, &bsize);
+		if (old_data == NULL)
+			return -1;
 		/*
 		 * Update the tuple.
 		 * xrow_upsert_execute() fails on totally wrong
@@ -636,6 +815,12 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (index_def->opts.normalized_key && index_def->type != TREE) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "normalized_key is supported only by TREE index");
+		return -1;
+	}
 	switch (index_def->type) {
 	case HASH:
 		if (! index_def->opts.is_unique) {
@@ -658,7 +843,14 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 		}
 		break;
 	case TREE:
-		/* TREE index has no limitations. */
+		if (index_def->opts.normalized_key &&
+		    (key_def->is_multikey || key_def->for_func_index)) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "normalized_key can not be used with "
+				 "a multikey or functional index");
+			return -1;
+		}
 		break;
 	case RTREE:
 		if (key_def->part_count != 1) {
@@ -727,6 +919,50 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 		}
 		/* no furter checks of parts needed */
 		return 0;
+	case COLUMN:
+		if (index_def->opts.is_unique) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "COLUMN index can not be unique");
+			return -1;
+		}
+		if (key_def->is_multikey) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "COLUMN index cannot be multikey");
+			return -1;
+		}
+		if (key_def->for_func_index) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "COLUMN index can not use a function");
+			return -1;
+		}
+		for (uint32_t i = 0; i < key_def->part_count; i++) {
+			struct key_part *part = &key_def->parts[i];
+			if (part->type != FIELD_TYPE_UNSIGNED &&
+			    part->type != FIELD_TYPE_DOUBLE &&
+			    part->type != FIELD_TYPE_STRING) {
+				diag_set(ClientError, ER_MODIFY_INDEX,
+					 index_def->name, space_name(space),
+					 "COLUMN index field type must be "
+					 "unsigned, double or string");
+				return -1;
+			}
+			if (key_part_is_nullable(part)) {
+				diag_set(ClientError, ER_MODIFY_INDEX,
+					 index_def->name, space_name(space),
+					 "COLUMN index can not be nullable");
+				return -1;
+			}
+			if (part->coll != NULL) {
+				diag_set(ClientError, ER_MODIFY_INDEX,
+					 index_def->name, space_name(space),
+					 "COLUMN index can not use a collation");
+				return -1;
+			}
+		}
+		return 0;
 	default:
 		diag_set(ClientError, ER_INDEX_TYPE,
 			 index_def->name, space_name(space));
@@ -800,6 +1036,8 @@ memtx_space_create_index(struct space *space, struct index_def *index_def)
 		return memtx_rtree_index_new(memtx, index_def);
 	case BITSET:
 		return memtx_bitset_index_new(memtx, index_def);
+	case COLUMN:
+		return memtx_column_index_new(memtx, index_def);
 	default:
 		unreachable();
 		return NULL;
@@ -979,6 +1217,31 @@ memtx_init_ephemeral_space(struct space *space)
 	memtx_space_add_primary_key(space);
 }
 
+/**
+ * Check that a tuple doesn't have compressed fields covered by
+ * indexes of @a format. A new index over fields compressed in
+ * existing tuples can't be built: the fields would be neither
+ * comparable nor decompressed on read.
+ */
+static int
+memtx_space_check_compressed_fields(struct space *space,
+				    struct tuple_format *format,
+				    struct tuple *tuple)
+{
+	if (format->compression == COMPRESSION_TYPE_NONE)
+		return 0;
+	uint32_t fieldno;
+	if (tuple_find_compressed_indexed_field(format, tuple_data(tuple),
+						&fieldno)) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 tt_sprintf("field %u is compressed in existing "
+				    "tuples and can't be indexed",
+				    fieldno + TUPLE_INDEX_BASE));
+		return -1;
+	}
+	return 0;
+}
+
 static int
 memtx_build_on_replace(struct trigger *trigger, void *event)
 {
@@ -997,7 +1260,9 @@ memtx_build_on_replace(struct trigger *trigger, void *event)
 		return 0;
 
 	if (stmt->new_tuple != NULL &&
-	    tuple_validate(state->format, stmt->new_tuple) != 0) {
+	    (memtx_space_check_compressed_fields(stmt->space, state->format,
+						 stmt->new_tuple) != 0 ||
+	     tuple_validate(state->format, stmt->new_tuple) != 0)) {
 		state->rc = -1;
 		diag_move(diag_get(), &state->diag);
 		return 0;
@@ -1091,6 +1356,10 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 		 * Check that the tuple is OK according to the
 		 * new format.
 		 */
+		rc = memtx_space_check_compressed_fields(src_space, new_format,
+							 tuple);
+		if (rc != 0)
+			break;
 		rc = tuple_validate(new_format, tuple);
 		if (rc != 0)
 			break;
@@ -1163,6 +1432,90 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 
 /* }}} DDL */
 
+/* {{{ Defragmentation */
+
+/**
+ * Check if tuples of the space can be moved to another place
+ * in memory without a transaction. Only tree and hash indexes
+ * are known to swap a tuple for an equal one without memory
+ * allocation, and nobody but the indexes must see the change.
+ */
+static bool
+memtx_space_can_defrag(struct space *space)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_tx_manager_use_mvcc_engine ||
+	    memtx_space->replace != memtx_space_replace_all_keys ||
+	    !rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace))
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index_def *def = space->index[i]->def;
+		if (def->key_def->for_func_index ||
+		    (def->type != TREE && def->type != HASH))
+			return false;
+	}
+	return true;
+}
+
+int
+memtx_space_defrag(struct space *space, const char *key, uint32_t part_count,
+		   struct tuple **last, uint32_t *moved)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	*last = NULL;
+	*moved = 0;
+	if (space->index_count == 0 || !memtx_space_can_defrag(space))
+		return 0;
+	struct index *pk = space->index[0];
+	struct iterator *it = index_create_iterator(pk, key == NULL ? ITER_ALL :
+						    ITER_GT, key, part_count);
+	if (it == NULL)
+		return -1;
+	struct tuple *batch[MEMTX_DEFRAG_BATCH_SIZE];
+	uint32_t count = 0;
+	struct tuple *tuple;
+	int rc = 0;
+	while (count < MEMTX_DEFRAG_BATCH_SIZE &&
+	       (rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		tuple_ref(tuple);
+		batch[count++] = tuple;
+	}
+	iterator_delete(it);
+	if (rc != 0)
+		goto out;
+	for (uint32_t i = 0; i < count; i++) {
+		tuple = batch[i];
+		struct tuple_format *format = tuple_format(tuple);
+		/* Referenced by the batch and the space only. */
+		if (tuple->refs != 2 ||
+		    memtx_tuple_in_read_view(format, tuple))
+			continue;
+		struct tuple *copy = memtx_tuple_move(format, tuple);
+		if (copy == NULL)
+			continue;
+		struct tuple *result;
+		if (memtx_space->replace(space, tuple, copy, DUP_REPLACE,
+					 &result) != 0) {
+			tuple_delete(copy);
+			rc = -1;
+			goto out;
+		}
+		assert(result == tuple);
+		tuple_unref(result);
+		++*moved;
+	}
+	/* The last tuple is the position to continue from. */
+	if (count == MEMTX_DEFRAG_BATCH_SIZE)
+		*last = batch[--count];
+out:
+	for (uint32_t i = 0; i < count; i++)
+		tuple_unref(batch[i]);
+	return rc;
+}
+
+/* }}} Defragmentation */
+
 static const struct space_vtab memtx_space_vtab = {
 	/* .destroy = */ memtx_space_destroy,
 	/* .bsize = */ memtx_space_bsize,
@@ -1213,7 +1566,14 @@ memtx_space_new(struct memtx_engine *memtx,
 		free(memtx_space);
 		return NULL;
 	}
+	format->compression = def->opts.compression;
 	tuple_format_ref(format);
+	if (def->opts.dense_field_map &&
+	    tuple_format_enable_dense_field_map(format) != 0) {
+		tuple_format_unref(format);
+		free(memtx_space);
+		return NULL;
+	}
 
 	if (space_create((struct space *)memtx_space, (struct engine *)memtx,
 			 &memtx_space_vtab, def, key_list, format) != 0) {
@@ -37,6 +37,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct memtx_engine;
+struct txn_stmt;
 
 struct memtx_space {
 	struct space base;
@@ -83,6 +84,38 @@ int
 memtx_space_replace_all_keys(struct space *, struct tuple *, struct tuple *,
 			     enum dup_replace_mode, struct tuple **);
 
+/**
+ * Restore the data of a tuple updated in place by the
+ * statement, see memtx_space_execute_update(). If the tuple
+ * was seen by anyone since the update, it is replaced with a
+ * new tuple holding the old data instead.
+ */
+void
+memtx_space_rollback_update_in_place(struct txn_stmt *stmt);
+
+enum {
+	/** Number of tuples visited by one defragmentation step. */
+	MEMTX_DEFRAG_BATCH_SIZE = 256,
+};
+
+/**
+ * Move up to MEMTX_DEFRAG_BATCH_SIZE tuples of the space that
+ * follow @a key in the primary index (from the beginning of the
+ * index if @a key is NULL) to lower memory addresses, so that
+ * slabs at the end of the arena get released. A tuple is left
+ * in place if anybody but the space refers to it.
+ *
+ * @param[out] last The last visited tuple, referenced, the next
+ *             step is to continue from. NULL if the space is
+ *             visited completely.
+ * @param[out] moved Number of tuples moved.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+int
+memtx_space_defrag(struct space *space, const char *key, uint32_t part_count,
+		   struct tuple **last, uint32_t *moved);
+
 struct space *
 memtx_space_new(struct memtx_engine *memtx,
 		struct space_def *def, struct rlist *key_list);
@@ -1326,14 +1326,17 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
 }
 
 /**
- * Create an ALL iterator with personal read view so further
- * index modifications will not affect the iteration results.
+ * Create an iterator with personal read view so further index
+ * modifications will not affect the iteration results. The
+ * iterator starts at the first tuple not less than @a key or
+ * at the first tuple in the tree if @a key is NULL.
  * Must be destroyed by iterator->free after usage.
  */
 static struct snapshot_iterator *
-memtx_tree_index_create_snapshot_iterator(struct index *base)
+tree_snapshot_iterator_new(struct memtx_tree_index *index,
+			   const char *key, uint32_t part_count)
 {
-	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct index *base = &index->base;
 	struct tree_snapshot_iterator *it =
 		(struct tree_snapshot_iterator *) calloc(1, sizeof(*it));
 	if (it == NULL) {
@@ -1353,12 +1356,44 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
 	it->base.next = tree_snapshot_iterator_next;
 	it->index = index;
 	index_ref(base);
-	it->tree_iterator = memtx_tree_iterator_first(&index->tree);
+	if (key == NULL || part_count == 0) {
+		it->tree_iterator = memtx_tree_iterator_first(&index->tree);
+	} else {
+		struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+		struct memtx_tree_key_data key_data;
+		key_data.key = key;
+		key_data.part_count = part_count;
+		key_data.hint = key_hint(key, part_count, cmp_def);
+		it->tree_iterator = memtx_tree_lower_bound(&index->tree,
+							   &key_data, NULL);
+	}
 	memtx_tree_iterator_freeze(&index->tree, &it->tree_iterator);
 	memtx_enter_delayed_free_mode((struct memtx_engine *)base->engine);
 	return (struct snapshot_iterator *) it;
 }
 
+static struct snapshot_iterator *
+memtx_tree_index_create_snapshot_iterator(struct index *base)
+{
+	return tree_snapshot_iterator_new((struct memtx_tree_index *)base,
+					  NULL, 0);
+}
+
+/**
+ * Multikey and functional indexes keep a tuple more than once
+ * and their keys are not a part of the tuple, so the range read
+ * view is only provided by plain tree indexes.
+ * @sa index_vtab::create_read_view_iterator.
+ */
+static struct snapshot_iterator *
+memtx_tree_index_create_read_view_iterator(struct index *base,
+					   const char *key,
+					   uint32_t part_count)
+{
+	return tree_snapshot_iterator_new((struct memtx_tree_index *)base,
+					  key, part_count);
+}
+
 static const struct index_vtab memtx_tree_index_vtab = {
 	/* .destroy = */ memtx_tree_index_destroy,
 	/* .commit_create = */ generic_index_commit_create,
@@ -1380,6 +1415,9 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
+	/* .create_read_view_iterator = */
+		memtx_tree_index_create_read_view_iterator,
+	/* .aggregate = */ generic_index_aggregate,
 	/* .stat = */ generic_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
@@ -1410,6 +1448,9 @@ static const struct index_vtab memtx_tree_index_multikey_vtab = {
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
+	/* .create_read_view_iterator = */
+		generic_index_create_read_view_iterator,
+	/* .aggregate = */ generic_index_aggregate,
 	/* .stat = */ generic_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
@@ -1440,6 +1481,9 @@ static const struct index_vtab memtx_tree_func_index_vtab = {
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
+	/* .create_read_view_iterator = */
+		generic_index_create_read_view_iterator,
+	/* .aggregate = */ generic_index_aggregate,
 	/* .stat = */ generic_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
@@ -1476,6 +1520,9 @@ static const struct index_vtab memtx_tree_disabled_index_vtab = {
 	/* .create_iterator = */ generic_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
+	/* .create_read_view_iterator = */
+		generic_index_create_read_view_iterator,
+	/* .aggregate = */ generic_index_aggregate,
 	/* .stat = */ generic_index_stat,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
@@ -43,8 +43,10 @@
 #include "engine.h"
 #include "gc.h"
 #include "iproto_constants.h"
+#include "latency.h"
 #include "recovery.h"
 #include "replication.h"
+#include "schema_def.h"
 #include "trigger.h"
 #include "vclock.h"
 #include "version.h"
@@ -65,6 +67,8 @@ struct relay_status_msg {
 	struct relay *relay;
 	/** Replica vclock. */
 	struct vclock vclock;
+	/** Relay latency statistics. */
+	struct relay_stat stat;
 };
 
 /**
@@ -117,6 +121,16 @@ struct relay {
 	 * is passed by the replica on subscribe.
 	 */
 	uint32_t id_filter;
+	/**
+	 * Sorted array of ids of spaces the replica is interested
+	 * in. Rows of other non-system spaces are replaced with
+	 * NOPs so that the replica vclock is still promoted. No
+	 * filtering is done if the array is empty. The list is
+	 * passed by the replica on subscribe.
+	 */
+	uint32_t *space_filter;
+	/** Number of ids in the space filter. */
+	uint32_t space_filter_size;
 	/**
 	 * Local vclock at the moment of subscribe, used to check
 	 * dataset on the other side and send missing data rows if any.
@@ -138,6 +152,31 @@ struct relay {
 	struct stailq pending_gc;
 	/** Time when last row was sent to peer. */
 	double last_row_time;
+	/**
+	 * Time since a row was written to WAL till it was read
+	 * by the relay. Accessed only from the relay thread.
+	 */
+	struct latency read_latency;
+	/**
+	 * Time it takes to write a row to the replica socket.
+	 * Accessed only from the relay thread.
+	 */
+	struct latency send_latency;
+	/**
+	 * Time since a row was sent to the replica till the
+	 * replica acknowledged it. Accessed only from the relay
+	 * thread.
+	 */
+	struct latency ack_latency;
+	/**
+	 * The row the ack latency is being measured on: the
+	 * origin and LSN of a row sent to the replica and the
+	 * time it was sent. One row is measured at a time,
+	 * ack_sample_lsn is 0 if none is.
+	 */
+	uint32_t ack_sample_replica_id;
+	int64_t ack_sample_lsn;
+	double ack_sample_time;
 	/** Relay sync state. */
 	enum relay_state state;
 
@@ -146,6 +185,8 @@ struct relay {
 		alignas(CACHELINE_SIZE)
 		/** Known relay vclock. */
 		struct vclock vclock;
+		/** Known relay latency statistics. */
+		struct relay_stat stat;
 		/**
 		 * True if the relay needs Raft updates. It can live fine
 		 * without sending Raft updates, if it is a relay to an
@@ -173,6 +214,12 @@ relay_vclock(const struct relay *relay)
 	return &relay->tx.vclock;
 }
 
+const struct relay_stat *
+relay_get_stat(const struct relay *relay)
+{
+	return &relay->tx.stat;
+}
+
 double
 relay_last_row_time(const struct relay *relay)
 {
@@ -195,6 +242,12 @@ relay_new(struct replica *replica)
 			  "struct relay");
 		return NULL;
 	}
+	if (latency_create(&relay->read_latency) != 0)
+		goto fail_read_latency;
+	if (latency_create(&relay->send_latency) != 0)
+		goto fail_send_latency;
+	if (latency_create(&relay->ack_latency) != 0)
+		goto fail_ack_latency;
 	relay->replica = replica;
 	relay->last_row_time = ev_monotonic_now(loop());
 	fiber_cond_create(&relay->reader_cond);
@@ -202,6 +255,16 @@ relay_new(struct replica *replica)
 	stailq_create(&relay->pending_gc);
 	relay->state = RELAY_OFF;
 	return relay;
+
+fail_ack_latency:
+	latency_destroy(&relay->send_latency);
+fail_send_latency:
+	latency_destroy(&relay->read_latency);
+fail_read_latency:
+	diag_set(OutOfMemory, sizeof(struct latency), "malloc",
+		 "struct latency");
+	free(relay);
+	return NULL;
 }
 
 static void
@@ -264,6 +327,9 @@ relay_stop(struct relay *relay)
 	if (relay->r != NULL)
 		recovery_delete(relay->r);
 	relay->r = NULL;
+	free(relay->space_filter);
+	relay->space_filter = NULL;
+	relay->space_filter_size = 0;
 	relay->state = RELAY_STOPPED;
 	/*
 	 * Needed to track whether relay thread is running or not
@@ -280,6 +346,9 @@ relay_delete(struct relay *relay)
 		relay_stop(relay);
 	fiber_cond_destroy(&relay->reader_cond);
 	diag_destroy(&relay->diag);
+	latency_destroy(&relay->read_latency);
+	latency_destroy(&relay->send_latency);
+	latency_destroy(&relay->ack_latency);
 	TRASH(relay);
 	free(relay);
 }
@@ -412,6 +481,7 @@ tx_status_update(struct cmsg *msg)
 {
 	struct relay_status_msg *status = (struct relay_status_msg *)msg;
 	vclock_copy(&status->relay->tx.vclock, &status->vclock);
+	status->relay->tx.stat = status->stat;
 	/*
 	 * Let pending synchronous transactions know, which of
 	 * them were successfully sent to the replica. Acks are
@@ -531,6 +601,18 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 	}
 }
 
+/** Fill relay latency statistics to be delivered to tx. */
+static void
+relay_stat_collect(struct relay *relay, struct relay_stat *stat)
+{
+	stat->read_p50 = latency_get(&relay->read_latency, 50);
+	stat->read_p99 = latency_get(&relay->read_latency, 99);
+	stat->send_p50 = latency_get(&relay->send_latency, 50);
+	stat->send_p99 = latency_get(&relay->send_latency, 99);
+	stat->ack_p50 = latency_get(&relay->ack_latency, 50);
+	stat->ack_p99 = latency_get(&relay->ack_latency, 99);
+}
+
 /*
  * Relay reader fiber function.
  * Read xrow encoded vclocks sent by the replica.
@@ -553,6 +635,15 @@ relay_reader_f(va_list ap)
 			/* vclock is followed while decoding, zeroing it. */
 			vclock_create(&relay->recv_vclock);
 			xrow_decode_vclock_xc(&xrow, &relay->recv_vclock);
+			if (relay->ack_sample_lsn != 0 &&
+			    vclock_get(&relay->recv_vclock,
+				       relay->ack_sample_replica_id) >=
+			    relay->ack_sample_lsn) {
+				latency_collect(&relay->ack_latency,
+						ev_monotonic_now(loop()) -
+						relay->ack_sample_time);
+				relay->ack_sample_lsn = 0;
+			}
 			fiber_cond_signal(&relay->reader_cond);
 		}
 	} catch (Exception *e) {
@@ -746,6 +837,7 @@ relay_subscribe_f(va_list ap)
 		};
 		cmsg_init(&relay->status_msg.msg, route);
 		vclock_copy(&relay->status_msg.vclock, send_vclock);
+		relay_stat_collect(relay, &relay->status_msg.stat);
 		relay->status_msg.relay = relay;
 		cpipe_push(&relay->tx_pipe, &relay->status_msg.msg);
 	}
@@ -783,11 +875,45 @@ relay_subscribe_f(va_list ap)
 	return -1;
 }
 
+static int
+relay_space_id_cmp(const void *a, const void *b)
+{
+	uint32_t id_a = *(const uint32_t *)a;
+	uint32_t id_b = *(const uint32_t *)b;
+	return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/**
+ * Check if a row must not be relayed to the replica, because
+ * it modifies a space missing in the replica's space filter.
+ * System spaces are always relayed, because the replica needs
+ * them to keep its schema up to date.
+ */
+static bool
+relay_space_is_filtered(struct relay *relay, struct xrow_header *packet)
+{
+	if (relay->space_filter_size == 0 || packet->type == IPROTO_NOP ||
+	    !iproto_type_is_dml(packet->type))
+		return false;
+	struct request request;
+	if (xrow_decode_dml(packet, &request, 0) != 0) {
+		/* Let the replica report the error. */
+		diag_clear(diag_get());
+		return false;
+	}
+	if (request.space_id <= BOX_SYSTEM_ID_MAX)
+		return false;
+	return bsearch(&request.space_id, relay->space_filter,
+		       relay->space_filter_size, sizeof(request.space_id),
+		       relay_space_id_cmp) == NULL;
+}
+
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		struct vclock *replica_clock, uint32_t replica_version_id,
-		uint32_t replica_id_filter)
+		uint32_t replica_id_filter, const uint32_t *space_filter,
+		uint32_t space_filter_size)
 {
 	assert(replica->anon || replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -813,9 +939,24 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 	vclock_copy(&relay->local_vclock_at_subscribe, &replicaset.vclock);
 	relay->r = recovery_new(wal_dir(), false, replica_clock);
 	vclock_copy(&relay->tx.vclock, replica_clock);
+	memset(&relay->tx.stat, 0, sizeof(relay->tx.stat));
+	latency_reset(&relay->read_latency);
+	latency_reset(&relay->send_latency);
+	latency_reset(&relay->ack_latency);
+	relay->ack_sample_lsn = 0;
 	relay->version_id = replica_version_id;
 
 	relay->id_filter = replica_id_filter;
+	if (space_filter_size > 0) {
+		size_t size = space_filter_size * sizeof(*space_filter);
+		relay->space_filter = (uint32_t *)malloc(size);
+		if (relay->space_filter == NULL)
+			tnt_raise(OutOfMemory, size, "malloc", "space_filter");
+		memcpy(relay->space_filter, space_filter, size);
+		qsort(relay->space_filter, space_filter_size,
+		      sizeof(*space_filter), relay_space_id_cmp);
+		relay->space_filter_size = space_filter_size;
+	}
 
 	int rc = cord_costart(&relay->cord, "subscribe",
 			      relay_subscribe_f, relay);
@@ -831,8 +972,11 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 	ERROR_INJECT_YIELD(ERRINJ_RELAY_SEND_DELAY);
 
 	packet->sync = relay->sync;
-	relay->last_row_time = ev_monotonic_now(loop());
+	double start = ev_monotonic_now(loop());
+	relay->last_row_time = start;
 	coio_write_xrow(&relay->io, packet);
+	latency_collect(&relay->send_latency,
+			ev_monotonic_now(loop()) - start);
 	fiber_gc();
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
@@ -966,6 +1110,15 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 	/* Check if the rows from the instance are filtered. */
 	if ((1 << packet->replica_id & relay->id_filter) != 0)
 		return;
+	/*
+	 * Rows of spaces the replica is not interested in are
+	 * sent as NOPs: the replica still needs them to promote
+	 * its vclock.
+	 */
+	if (relay_space_is_filtered(relay, packet)) {
+		packet->type = IPROTO_NOP;
+		packet->bodycnt = 0;
+	}
 	/*
 	 * We're feeding a WAL, thus responding to FINAL JOIN or SUBSCRIBE
 	 * request. If this is FINAL JOIN (i.e. relay->replica is NULL),
@@ -982,6 +1135,10 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 	    packet->replica_id != relay->replica->id ||
 	    packet->lsn <= vclock_get(&relay->local_vclock_at_subscribe,
 				      packet->replica_id)) {
+		if (packet->tm != 0) {
+			latency_collect(&relay->read_latency,
+					ev_now(loop()) - packet->tm);
+		}
 		struct errinj *inj = errinj(ERRINJ_RELAY_BREAK_LSN,
 					    ERRINJ_INT);
 		if (inj != NULL && packet->lsn == inj->iparam) {
@@ -990,5 +1147,10 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 				 (long long) packet->lsn);
 		}
 		relay_send(relay, packet);
+		if (relay->ack_sample_lsn == 0 && packet->lsn > 0) {
+			relay->ack_sample_replica_id = packet->replica_id;
+			relay->ack_sample_lsn = packet->lsn;
+			relay->ack_sample_time = ev_monotonic_now(loop());
+		}
 	}
 }
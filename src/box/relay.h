@@ -42,6 +42,32 @@ struct replica;
 struct tt_uuid;
 struct vclock;
 
+/**
+ * Latencies of relaying rows to a replica, in seconds.
+ * Collected in the relay thread and delivered to tx along
+ * with the replica vclock.
+ */
+struct relay_stat {
+	/**
+	 * Time since a row was written to WAL till it was read
+	 * by the relay, 50th and 99th percentile.
+	 */
+	double read_p50;
+	double read_p99;
+	/**
+	 * Time it takes to write a row to the replica socket,
+	 * 50th and 99th percentile.
+	 */
+	double send_p50;
+	double send_p99;
+	/**
+	 * Time since a row was sent to the replica till the
+	 * replica acknowledged it, 50th and 99th percentile.
+	 */
+	double ack_p50;
+	double ack_p99;
+};
+
 enum relay_state {
 	/**
 	 * Applier has not connected to the master or not expected.
@@ -85,6 +111,13 @@ relay_get_state(const struct relay *relay);
 const struct vclock *
 relay_vclock(const struct relay *relay);
 
+/**
+ * Returns relay's latency statistics as of the last status
+ * update received from the relay thread.
+ */
+const struct relay_stat *
+relay_get_stat(const struct relay *relay);
+
 /**
  * Returns relay's last_row_time
  * @param relay relay
@@ -127,11 +160,15 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 /**
  * Subscribe a replica to updates.
  *
+ * @param space_filter ids of spaces to relay changes of, changes
+ *		       of other user spaces are sent as NOPs.
+ *		       Ignored if @a space_filter_size is 0.
  * @return none.
  */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		struct vclock *replica_vclock, uint32_t replica_version_id,
-		uint32_t replica_id_filter);
+		uint32_t replica_id_filter, const uint32_t *space_filter,
+		uint32_t space_filter_size);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -56,6 +56,8 @@ double replication_synchro_timeout = 5.0; /* seconds */
 double replication_sync_timeout = 300.0; /* seconds */
 bool replication_skip_conflict = false;
 bool replication_anon = false;
+uint32_t *replication_space_filter = NULL;
+uint32_t replication_space_filter_size = 0;
 
 struct replicaset replicaset;
 
@@ -113,6 +115,7 @@ replication_free(void)
 		relay_cancel(replica->relay);
 
 	diag_destroy(&replicaset.applier.diag);
+	free(replication_space_filter);
 }
 
 int
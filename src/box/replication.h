@@ -155,6 +155,17 @@ extern bool replication_skip_conflict;
  */
 extern bool replication_anon;
 
+/**
+ * Ids of spaces whose changes this replica wants to receive.
+ * Changes of other user spaces are replaced with NOPs by the
+ * master. No filtering is done if the list is empty. Set by
+ * box.cfg.replication_space_filter.
+ */
+extern uint32_t *replication_space_filter;
+
+/** Number of ids in replication_space_filter. */
+extern uint32_t replication_space_filter_size;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
@@ -63,6 +63,7 @@ static struct mh_i32ptr_t *sequences;
 /** Public change counter. On its update clients need to fetch
  *  new space data from the instance. */
 uint32_t schema_version = 0;
+uint32_t func_access_version = 0;
 /**
  * Internal change counter. Grows faster, than the public one,
  * because we need to remember when to update pointers to already
@@ -571,6 +572,7 @@ func_cache_delete(uint32_t fid)
 	mh_int_t k = mh_i32ptr_find(funcs, fid, NULL);
 	if (k == mh_end(funcs))
 		return;
+	++func_access_version;
 	struct func *func = (struct func *)
 		mh_i32ptr_node(funcs, k)->val;
 	mh_i32ptr_del(funcs, k, NULL);
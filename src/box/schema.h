@@ -44,6 +44,11 @@ struct func;
 
 extern uint32_t schema_version;
 extern uint32_t space_cache_version;
+/**
+ * Change counter of privileges and of the function cache.
+ * Invalidates access checks cached by prepared CALLs.
+ */
+extern uint32_t func_access_version;
 
 /** Triggers invoked after schema initialization. */
 extern struct rlist on_schema_init;
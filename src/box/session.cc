@@ -37,6 +37,7 @@
 #include "error.h"
 #include "tt_static.h"
 #include "sql_stmt_cache.h"
+#include "cursor.h"
 
 const char *session_type_strs[] = {
 	"background",
@@ -142,6 +143,11 @@ session_create(enum session_type type)
 	session->sql_flags = default_flags;
 	session->sql_default_engine = SQL_STORAGE_ENGINE_MEMTX;
 	session->sql_stmts = NULL;
+	session->prepared_calls = NULL;
+	session->prepared_calls_version = 0;
+	session->prepared_calls_uid = 0;
+	session->cursors = NULL;
+	session->cursor_id_max = 0;
 
 	/* For on_connect triggers. */
 	credentials_create(&session->credentials, guest_user);
@@ -261,6 +267,9 @@ session_destroy(struct session *session)
 	mh_i64ptr_remove(session_registry, &node, NULL);
 	credentials_destroy(&session->credentials);
 	sql_session_stmt_hash_erase(session->sql_stmts);
+	if (session->prepared_calls != NULL)
+		mh_i32ptr_delete(session->prepared_calls);
+	box_cursor_close_all(session);
 	mempool_free(&session_pool, session);
 }
 
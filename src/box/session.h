@@ -119,6 +119,23 @@ struct session {
 	 * This map is allocated on demand.
 	 */
 	struct mh_i32ptr_t *sql_stmts;
+	/**
+	 * Functions prepared for CALL by id in current session,
+	 * function id -> struct func. The access to them is
+	 * checked already. This map is allocated on demand.
+	 */
+	struct mh_i32ptr_t *prepared_calls;
+	/** func_access_version the prepared calls are valid for. */
+	uint32_t prepared_calls_version;
+	/** Id of the user the prepared calls are checked for. */
+	uint32_t prepared_calls_uid;
+	/**
+	 * Cursors open in current session, cursor id ->
+	 * struct cursor. This map is allocated on demand.
+	 */
+	struct mh_i32ptr_t *cursors;
+	/** Id of the last cursor opened in current session. */
+	uint32_t cursor_id_max;
 	/** Session user id and global grants */
 	struct credentials credentials;
 	/** Trigger for fiber on_stop to cleanup created on-demand session */
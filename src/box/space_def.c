@@ -42,6 +42,8 @@ const struct space_opts space_opts_default = {
 	/* .is_ephemeral = */ false,
 	/* .view = */ false,
 	/* .is_sync = */ false,
+	/* .compression = */ COMPRESSION_TYPE_NONE,
+	/* .dense_field_map = */ false,
 	/* .sql        = */ NULL,
 };
 
@@ -50,6 +52,10 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, is_temporary),
 	OPT_DEF("view", OPT_BOOL, struct space_opts, is_view),
 	OPT_DEF("is_sync", OPT_BOOL, struct space_opts, is_sync),
+	OPT_DEF_ENUM("compression", compression_type, struct space_opts,
+		     compression, NULL),
+	OPT_DEF("dense_field_map", OPT_BOOL, struct space_opts,
+		dense_field_map),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_DEF_LEGACY("checks"),
 	OPT_END,
@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 #include "tuple_dictionary.h"
+#include "tuple_compression.h"
 #include "schema_def.h"
 #include <stdint.h>
 #include <stdlib.h>
@@ -73,6 +74,16 @@ struct space_opts {
 	 * until replicated to a quorum of replicas.
 	 */
 	bool is_sync;
+	/**
+	 * Compression of non-indexed fields of the space tuples.
+	 * Can't be changed after space creation.
+	 */
+	enum compression_type compression;
+	/**
+	 * Record offsets of all fields of the space tuples, not
+	 * only of the indexed ones, to access any field in O(1).
+	 */
+	bool dense_field_map;
 	/** SQL statement that produced this space. */
 	char *sql;
 };
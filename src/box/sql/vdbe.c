@@ -875,6 +875,17 @@ vdbe_field_ref_fetch(struct vdbe_field_ref *field_ref, uint32_t fieldno,
 	}
 	assert(sqlVdbeCheckMemInvariants(dest_mem) != 0);
 	const char *data = vdbe_field_ref_fetch_data(field_ref, fieldno);
+	/*
+	 * A compressed field is decompressed into the fiber
+	 * region, which doesn't live as long as the tuple, so
+	 * the value is copied out of it below.
+	 */
+	bool is_compressed = mp_is_compressed(data);
+	if (unlikely(is_compressed)) {
+		data = mp_decompress_field(data);
+		if (data == NULL)
+			return -1;
+	}
 	uint32_t dummy;
 	if (vdbe_decode_msgpack_into_mem(data, dest_mem, &dummy) != 0)
 		return -1;
@@ -885,8 +896,15 @@ vdbe_field_ref_fetch(struct vdbe_field_ref *field_ref, uint32_t fieldno,
 	 */
 	if (dest_mem->flags == 0) {
 		dest_mem->z = (char *) data;
-		dest_mem->n = vdbe_field_ref_fetch_data(field_ref,
-							fieldno + 1) - data;
+		if (is_compressed) {
+			const char *end = data;
+			mp_next(&end);
+			dest_mem->n = end - data;
+		} else {
+			dest_mem->n = vdbe_field_ref_fetch_data(field_ref,
+								fieldno + 1) -
+				      data;
+		}
 		dest_mem->flags = MEM_Blob | MEM_Ephem | MEM_Subtype;
 		dest_mem->subtype = SQL_SUBTYPE_MSGPACK;
 	}
@@ -908,6 +926,9 @@ vdbe_field_ref_fetch(struct vdbe_field_ref *field_ref, uint32_t fieldno,
 		dest_mem->z[len] = 0;
 		dest_mem->flags |= MEM_Term;
 	}
+	if (is_compressed && (dest_mem->flags & MEM_Ephem) != 0 &&
+	    sqlVdbeMemMakeWriteable(dest_mem) != 0)
+		return -1;
 	UPDATE_MAX_BLOBSIZE(dest_mem);
 	dest_mem->field_type = vdbe_field_ref_fetch_type(field_ref, fieldno);
 	return 0;
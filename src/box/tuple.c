@@ -38,6 +38,8 @@
 #include "xrow_update.h"
 #include "coll_id_cache.h"
 
+#include <sys/mman.h>
+
 static struct mempool tuple_iterator_pool;
 static struct small_alloc runtime_alloc;
 
@@ -83,16 +85,19 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 	if (tuple_field_map_create(format, data, true, &builder) != 0)
 		goto end;
 	uint32_t field_map_size = field_map_build_size(&builder);
-	uint32_t data_offset = sizeof(struct tuple) + field_map_size;
-	if (data_offset > INT16_MAX) {
-		/** tuple->data_offset is 15 bits */
+	size_t data_len = end - data;
+	uint32_t data_offset = TUPLE_COMPACT_SIZE + field_map_size;
+	bool is_compact = tuple_can_be_compact(data_offset, data_len);
+	if (!is_compact)
+		data_offset = sizeof(struct tuple) + field_map_size;
+	if (data_offset > TUPLE_DATA_OFFSET_MAX) {
+		/** Data offset of a tuple is 14 bits. */
 		diag_set(ClientError, ER_TUPLE_METADATA_IS_TOO_BIG,
 			 data_offset);
 		goto end;
 	}
 
-	size_t data_len = end - data;
-	size_t total = sizeof(struct tuple) + field_map_size + data_len;
+	size_t total = data_offset + data_len;
 	tuple = (struct tuple *) smalloc(&runtime_alloc, total);
 	if (tuple == NULL) {
 		diag_set(OutOfMemory, (unsigned) total,
@@ -101,10 +106,9 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 	}
 
 	tuple->refs = 0;
-	tuple->bsize = data_len;
+	tuple_set_data_offset_bsize(tuple, data_offset, data_len, is_compact);
 	tuple->format_id = tuple_format_id(format);
 	tuple_format_ref(format);
-	tuple->data_offset = data_offset;
 	tuple->is_dirty = false;
 	char *raw = (char *) tuple + data_offset;
 	field_map_build(&builder, raw - field_map_size);
@@ -135,7 +139,15 @@ tuple_validate_raw(struct tuple_format *format, const char *tuple)
 	struct region *region = &fiber()->gc;
 	size_t region_svp = region_used(region);
 	struct field_map_builder builder;
-	int rc = tuple_field_map_create(format, tuple, true, &builder);
+	int rc = 0;
+	if (format->compression != COMPRESSION_TYPE_NONE) {
+		/* The end is needed only to decompress. */
+		const char *tuple_end = tuple;
+		mp_next(&tuple_end);
+		rc = tuple_decompress_raw(format, &tuple, &tuple_end);
+	}
+	if (rc == 0)
+		rc = tuple_field_map_create(format, tuple, true, &builder);
 	region_truncate(region, region_svp);
 	return rc;
 }
@@ -332,7 +344,7 @@ tuple_init(field_name_hash_f hash)
 void
 tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
-		   bool dontdump, const char *arena_name)
+		   bool dontdump, bool huge_pages, const char *arena_name)
 {
 	/*
 	 * Ensure that quota is a multiple of slab_size, to
@@ -361,8 +373,24 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		}
 	}
 
-	say_debug("tuple arena %s: addr %p size %zu flags %#x dontdump %d",
-		  arena_name, arena->arena, prealloc, flags, dontdump);
+	/*
+	 * The arena is a single anonymous mapping aligned by
+	 * slab size, so transparent huge pages can back it as
+	 * a whole. This cuts TLB misses on large datasets.
+	 */
+	if (huge_pages) {
+#ifdef MADV_HUGEPAGE
+		if (madvise(arena->arena, prealloc, MADV_HUGEPAGE) != 0)
+			say_syserror("failed to enable huge pages for %s "
+				     "tuple arena", arena_name);
+#else
+		say_warn("huge pages are not supported on this platform");
+#endif
+	}
+
+	say_debug("tuple arena %s: addr %p size %zu flags %#x dontdump %d "
+		  "huge_pages %d", arena_name, arena->arena, prealloc, flags,
+		  dontdump, huge_pages);
 }
 
 void
@@ -385,6 +413,8 @@ tuple_free(void)
 
 	tuple_format_free();
 
+	tuple_compression_free();
+
 	coll_id_cache_destroy();
 
 	bigref_list_destroy();
@@ -400,8 +430,7 @@ tuple_field_go_to_index(const char **field, uint64_t index)
 		uint32_t count = mp_decode_array(field);
 		if (index >= count)
 			return -1;
-		for (; index > 0; --index)
-			mp_next(field);
+		mp_scan_next(field, index);
 		return 0;
 	} else if (type == MP_MAP) {
 		index += TUPLE_INDEX_BASE;
@@ -610,17 +639,22 @@ size_t
 box_tuple_bsize(box_tuple_t *tuple)
 {
 	assert(tuple != NULL);
-	return tuple->bsize;
+	return tuple_bsize(tuple);
 }
 
 ssize_t
 tuple_to_buf(struct tuple *tuple, char *buf, size_t size)
 {
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
 	uint32_t bsize;
-	const char *data = tuple_data_range(tuple, &bsize);
+	const char *data = tuple_data_range_decompressed(tuple, &bsize);
+	if (data == NULL)
+		return -1;
 	if (likely(bsize <= size)) {
 		memcpy(buf, data, bsize);
 	}
+	region_truncate(region, region_svp);
 	return bsize;
 }
 
@@ -642,7 +676,7 @@ const char *
 box_tuple_field(box_tuple_t *tuple, uint32_t fieldno)
 {
 	assert(tuple != NULL);
-	return tuple_field(tuple, fieldno);
+	return mp_decompress_field(tuple_field(tuple, fieldno));
 }
 
 typedef struct tuple_iterator box_tuple_iterator_t;
@@ -685,22 +719,24 @@ box_tuple_rewind(box_tuple_iterator_t *it)
 const char *
 box_tuple_seek(box_tuple_iterator_t *it, uint32_t fieldno)
 {
-	return tuple_seek(it, fieldno);
+	return mp_decompress_field(tuple_seek(it, fieldno));
 }
 
 const char *
 box_tuple_next(box_tuple_iterator_t *it)
 {
-	return tuple_next(it);
+	return mp_decompress_field(tuple_next(it));
 }
 
 box_tuple_t *
 box_tuple_update(box_tuple_t *tuple, const char *expr, const char *expr_end)
 {
 	uint32_t new_size = 0, bsize;
-	const char *old_data = tuple_data_range(tuple, &bsize);
 	struct region *region = &fiber()->gc;
 	size_t used = region_used(region);
+	const char *old_data = tuple_data_range_decompressed(tuple, &bsize);
+	if (old_data == NULL)
+		return NULL;
 	struct tuple_format *format = tuple_format(tuple);
 	const char *new_data =
 		xrow_update_execute(expr, expr_end, old_data, old_data + bsize,
@@ -720,9 +756,11 @@ box_tuple_t *
 box_tuple_upsert(box_tuple_t *tuple, const char *expr, const char *expr_end)
 {
 	uint32_t new_size = 0, bsize;
-	const char *old_data = tuple_data_range(tuple, &bsize);
 	struct region *region = &fiber()->gc;
 	size_t used = region_used(region);
+	const char *old_data = tuple_data_range_decompressed(tuple, &bsize);
+	if (old_data == NULL)
+		return NULL;
 	struct tuple_format *format = tuple_format(tuple);
 	const char *new_data =
 		xrow_upsert_execute(expr, expr_end, old_data, old_data + bsize,
@@ -36,6 +36,7 @@
 #include "error.h"
 #include "uuid/tt_uuid.h" /* tuple_field_uuid */
 #include "tt_static.h"
+#include "mp_scan.h"
 #include "tuple_format.h"
 
 #if defined(__cplusplus)
@@ -65,12 +66,14 @@ tuple_free(void);
  * @param arena[out] Arena to initialize.
  * @param quota Arena's quota.
  * @param arena_max_size Maximal size of @arena.
+ * @param huge_pages Advise the kernel to back @arena with
+ *        transparent huge pages.
  * @param arena_name Name of @arena for logs.
  */
 void
 tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
-		   bool dontdump, const char *arena_name);
+		   bool dontdump, bool huge_pages, const char *arena_name);
 
 void
 tuple_arena_destroy(struct slab_arena *arena);
@@ -145,6 +148,7 @@ box_tuple_bsize(box_tuple_t *tuple);
  * Upon successful return, the function returns the number of bytes written.
  * If buffer size is not enough then the return value is the number of bytes
  * which would have been written if enough space had been available.
+ * Compressed fields are decompressed, so it may exceed box_tuple_bsize().
  */
 ssize_t
 box_tuple_to_buf(box_tuple_t *tuple, char *buf, size_t size);
@@ -161,6 +165,9 @@ box_tuple_format(box_tuple_t *tuple);
  * Return the raw tuple field in MsgPack format.
  *
  * The buffer is valid until next call to box_tuple_* functions.
+ * A compressed field is returned decompressed into memory that
+ * is freed at the end of the current request, like the memory
+ * returned by box_txn_alloc().
  *
  * \param tuple a tuple
  * \param fieldno zero-based index in MsgPack array.
@@ -296,6 +303,13 @@ box_tuple_upsert(box_tuple_t *tuple, const char *expr, const char *expr_end);
  * +---------------------------------------data_offset
  *
  * Each 'off_i' is the offset to the i-th indexed field.
+ *
+ * A small tuple may have a compact header (see is_compact), in
+ * which case both the data offset and bsize are packed into
+ * data_offset_bsize_raw and bsize_bulky is not allocated: the
+ * offsets array (or MessagePack) starts right after
+ * data_offset_bsize_raw. Always use tuple_data_offset() and
+ * tuple_bsize() to access these values.
  */
 struct PACKED tuple
 {
@@ -312,20 +326,28 @@ struct PACKED tuple
 	/** Format identifier. */
 	uint16_t format_id;
 	/**
-	 * Length of the MessagePack data in raw part of the
-	 * tuple.
+	 * Offset to the MessagePack from the begin of the tuple
+	 * in a regular tuple. In a compact tuple the lower
+	 * TUPLE_COMPACT_DATA_OFFSET_BITS store the data offset and
+	 * the rest store the length of the MessagePack data.
 	 */
-	uint32_t bsize;
+	uint16_t data_offset_bsize_raw : 14;
 	/**
-	 * Offset to the MessagePack from the begin of the tuple.
+	 * Set if the tuple has a compact header, i.e. bsize_bulky
+	 * is not allocated.
 	 */
-	uint16_t data_offset : 15;
+	bool is_compact : 1;
 	/**
 	 * The tuple (if it's found in index for example) could be invisible
 	 * for current transactions. The flag means that the tuple must
 	 * be clarified by transaction engine.
 	 */
 	bool is_dirty : 1;
+	/**
+	 * Length of the MessagePack data in raw part of the
+	 * tuple. Present only if the tuple is not compact.
+	 */
+	uint32_t bsize_bulky;
 	/**
 	 * Engine specific fields and offsets array concatenated
 	 * with MessagePack fields array.
@@ -333,12 +355,80 @@ struct PACKED tuple
 	 */
 };
 
+enum {
+	/** Max data offset of a regular tuple. */
+	TUPLE_DATA_OFFSET_MAX = (1 << 14) - 1,
+	/** Number of bits storing the data offset of a compact tuple. */
+	TUPLE_COMPACT_DATA_OFFSET_BITS = 6,
+	/** Max data offset of a compact tuple. */
+	TUPLE_COMPACT_DATA_OFFSET_MAX =
+		(1 << TUPLE_COMPACT_DATA_OFFSET_BITS) - 1,
+	/** Max MessagePack size of a compact tuple. */
+	TUPLE_COMPACT_BSIZE_MAX =
+		(1 << (14 - TUPLE_COMPACT_DATA_OFFSET_BITS)) - 1,
+	/** Size of the header of a compact tuple. */
+	TUPLE_COMPACT_SIZE = offsetof(struct tuple, bsize_bulky),
+};
+
+/**
+ * Check if a tuple with the given data offset (counted as if the
+ * header were compact) and MessagePack size may use a compact
+ * header.
+ */
+static inline bool
+tuple_can_be_compact(uint32_t data_offset, uint32_t bsize)
+{
+	return data_offset <= TUPLE_COMPACT_DATA_OFFSET_MAX &&
+	       bsize <= TUPLE_COMPACT_BSIZE_MAX;
+}
+
+/**
+ * Set the data offset and MessagePack size of a tuple. If
+ * @a is_compact is set, the tuple must have been allocated with
+ * a compact header, see tuple_can_be_compact().
+ */
+static inline void
+tuple_set_data_offset_bsize(struct tuple *tuple, uint32_t data_offset,
+			    uint32_t bsize, bool is_compact)
+{
+	tuple->is_compact = is_compact;
+	if (is_compact) {
+		assert(tuple_can_be_compact(data_offset, bsize));
+		tuple->data_offset_bsize_raw = data_offset |
+			(bsize << TUPLE_COMPACT_DATA_OFFSET_BITS);
+	} else {
+		assert(data_offset <= TUPLE_DATA_OFFSET_MAX);
+		tuple->data_offset_bsize_raw = data_offset;
+		tuple->bsize_bulky = bsize;
+	}
+}
+
+/** Offset to the MessagePack from the begin of the tuple. */
+static inline uint32_t
+tuple_data_offset(struct tuple *tuple)
+{
+	if (tuple->is_compact)
+		return tuple->data_offset_bsize_raw &
+		       TUPLE_COMPACT_DATA_OFFSET_MAX;
+	return tuple->data_offset_bsize_raw;
+}
+
+/** Length of the MessagePack data of the tuple. */
+static inline uint32_t
+tuple_bsize(struct tuple *tuple)
+{
+	if (tuple->is_compact)
+		return tuple->data_offset_bsize_raw >>
+		       TUPLE_COMPACT_DATA_OFFSET_BITS;
+	return tuple->bsize_bulky;
+}
+
 /** Size of the tuple including size of struct tuple. */
 static inline size_t
 tuple_size(struct tuple *tuple)
 {
-	/* data_offset includes sizeof(struct tuple). */
-	return tuple->data_offset + tuple->bsize;
+	/* Data offset includes the size of the tuple header. */
+	return tuple_data_offset(tuple) + tuple_bsize(tuple);
 }
 
 /**
@@ -349,7 +439,7 @@ tuple_size(struct tuple *tuple)
 static inline const char *
 tuple_data(struct tuple *tuple)
 {
-	return (const char *) tuple + tuple->data_offset;
+	return (const char *) tuple + tuple_data_offset(tuple);
 }
 
 /**
@@ -370,8 +460,8 @@ tuple_data_or_null(struct tuple *tuple)
 static inline const char *
 tuple_data_range(struct tuple *tuple, uint32_t *p_size)
 {
-	*p_size = tuple->bsize;
-	return (const char *) tuple + tuple->data_offset;
+	*p_size = tuple_bsize(tuple);
+	return (const char *) tuple + tuple_data_offset(tuple);
 }
 
 /**
@@ -524,7 +614,8 @@ tuple_validate(struct tuple_format *format, struct tuple *tuple)
 static inline const uint32_t *
 tuple_field_map(struct tuple *tuple)
 {
-	return (const uint32_t *) ((const char *) tuple + tuple->data_offset);
+	return (const uint32_t *) ((const char *) tuple +
+				   tuple_data_offset(tuple));
 }
 
 /**
@@ -655,14 +746,21 @@ offset_slot_access:
 			return NULL;
 		tuple += offset;
 	} else {
-		uint32_t field_count;
+		uint32_t field_count, offset;
 parse:
 		ERROR_INJECT(ERRINJ_TUPLE_FIELD, return NULL);
-		field_count = mp_decode_array(&tuple);
-		if (unlikely(fieldno >= field_count))
-			return NULL;
-		for (uint32_t k = 0; k < fieldno; k++)
-			mp_next(&tuple);
+		offset = 0;
+		if (format->dense_field_map_slot != TUPLE_OFFSET_SLOT_NIL)
+			offset = field_map_get_dense_offset(field_map,
+					format->dense_field_map_slot, fieldno);
+		if (offset != 0) {
+			tuple += offset;
+		} else {
+			field_count = mp_decode_array(&tuple);
+			if (unlikely(fieldno >= field_count))
+				return NULL;
+			mp_scan_next(&tuple, fieldno);
+		}
 		if (path != NULL &&
 		    unlikely(tuple_go_to_path(&tuple, path, path_len,
 					      multikey_idx) != 0))
@@ -725,6 +823,33 @@ tuple_field_raw_by_full_path(struct tuple_format *format, const char *tuple,
 			     const uint32_t *field_map, const char *path,
 			     uint32_t path_len, uint32_t path_hash);
 
+/**
+ * Get tuple field by an accessor resolved for the tuple format.
+ * An indexed field is read directly by the cached offset slot.
+ * @param format Tuple format.
+ * @param tuple MessagePack tuple's body.
+ * @param field_map Tuple field map.
+ * @param accessor Accessor returned by tuple_format_accessor().
+ *
+ * @retval field data if field exists or NULL
+ */
+static inline const char *
+tuple_field_raw_by_accessor(struct tuple_format *format, const char *tuple,
+			    const uint32_t *field_map,
+			    const struct tuple_accessor *accessor)
+{
+	if (!accessor->is_resolved)
+		return NULL;
+	uint32_t subpath_len = accessor->path_len - accessor->subpath_offset;
+	const char *subpath = subpath_len > 0 ?
+			      accessor->path + accessor->subpath_offset : NULL;
+	int32_t offset_slot = accessor->offset_slot;
+	return tuple_field_raw_by_path(format, tuple, field_map,
+				       accessor->fieldno, subpath, subpath_len,
+				       offset_slot != TUPLE_OFFSET_SLOT_NIL ?
+				       &offset_slot : NULL, MULTIKEY_NONE);
+}
+
 /**
  * Get a tuple field pointed to by an index part and multikey
  * index hint.
@@ -874,7 +874,7 @@ tuple_compare_with_key_sequential(struct tuple *tuple, hint_t tuple_hint,
 		 * Key's and tuple's first field_count fields are
 		 * equal, and their bsize too.
 		 */
-		key += tuple->bsize - mp_sizeof_array(field_count);
+		key += tuple_bsize(tuple) - mp_sizeof_array(field_count);
 		for (uint32_t i = field_count; i < part_count;
 		     ++i, mp_next(&key)) {
 			if (mp_typeof(*key) != MP_NIL)
@@ -1002,9 +1002,37 @@ field_compare<FIELD_TYPE_STRING>(const char **field_a, const char **field_b)
 	return r;
 }
 
+template <>
+inline int
+field_compare<FIELD_TYPE_INTEGER>(const char **field_a, const char **field_b)
+{
+	return mp_compare_integer_with_type(*field_a, mp_typeof(**field_a),
+					    *field_b, mp_typeof(**field_b));
+}
+
+template <>
+inline int
+field_compare<FIELD_TYPE_NUMBER>(const char **field_a, const char **field_b)
+{
+	return mp_compare_number(*field_a, *field_b);
+}
+
+template <>
+inline int
+field_compare<FIELD_TYPE_UUID>(const char **field_a, const char **field_b)
+{
+	return mp_compare_uuid(*field_a, *field_b);
+}
+
 template <int TYPE>
 static inline int
-field_compare_and_next(const char **field_a, const char **field_b);
+field_compare_and_next(const char **field_a, const char **field_b)
+{
+	int r = field_compare<TYPE>(field_a, field_b);
+	mp_next(field_a);
+	mp_next(field_b);
+	return r;
+}
 
 template <>
 inline int
@@ -1159,6 +1187,37 @@ static const comparator_signature cmp_arr[] = {
 	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING)
 	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING)
 	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_NUMBER)
+	COMPARATOR(0, FIELD_TYPE_UUID)
+	COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_INTEGER)
+	COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_STRING)
+	COMPARATOR(0, FIELD_TYPE_UUID    , 1, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UUID)
+	/* Non-unique secondary keys merged with a primary key. */
+	COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_INTEGER , 0, FIELD_TYPE_UNSIGNED)
+	COMPARATOR(1, FIELD_TYPE_UUID    , 0, FIELD_TYPE_UNSIGNED)
 };
 
 #undef COMPARATOR
@@ -1168,7 +1227,11 @@ static const comparator_signature cmp_arr[] = {
 /* {{{ tuple_compare_with_key */
 
 template <int TYPE>
-static inline int field_compare_with_key(const char **field, const char **key);
+static inline int
+field_compare_with_key(const char **field, const char **key)
+{
+	return field_compare<TYPE>(field, key);
+}
 
 template <>
 inline int
@@ -1192,7 +1255,10 @@ field_compare_with_key<FIELD_TYPE_STRING>(const char **field, const char **key)
 
 template <int TYPE>
 static inline int
-field_compare_with_key_and_next(const char **field_a, const char **field_b);
+field_compare_with_key_and_next(const char **field_a, const char **field_b)
+{
+	return field_compare_and_next<TYPE>(field_a, field_b);
+}
 
 template <>
 inline int
@@ -1244,7 +1310,13 @@ struct FieldCompareWithKey<FLD_ID, IDX, TYPE, IDX2, TYPE2, MORE_TYPES...>
 			if (r || part_count == FLD_ID + 1)
 				return r;
 		} else {
-			r = field_compare_with_key<TYPE>(&field, &key);
+			/*
+			 * The string comparator moves the key past
+			 * the string header, so compare a copy and
+			 * skip the whole key part then.
+			 */
+			const char *k = key;
+			r = field_compare_with_key<TYPE>(&field, &k);
 			if (r || part_count == FLD_ID + 1)
 				return r;
 			field = tuple_field_raw(format, tuple_data(tuple),
@@ -1344,8 +1416,252 @@ static const comparator_with_key_signature cmp_wk_arr[] = {
 	KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED)
 	KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING)
 	KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING)
+
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 3, FIELD_TYPE_STRING)
+
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_NUMBER)
+	KEY_COMPARATOR(0, FIELD_TYPE_UUID)
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_INTEGER , 1, FIELD_TYPE_STRING)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_STRING  , 1, FIELD_TYPE_INTEGER)
+	KEY_COMPARATOR(0, FIELD_TYPE_UUID    , 1, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(0, FIELD_TYPE_UNSIGNED, 1, FIELD_TYPE_UUID)
+
+	KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_INTEGER , 0, FIELD_TYPE_UNSIGNED)
+	KEY_COMPARATOR(1, FIELD_TYPE_UUID    , 0, FIELD_TYPE_UNSIGNED)
+};
+
+/* {{{ nullable tuple_compare and tuple_compare_with_key */
+
+/**
+ * Compare a nullable field of two tuples. A missing field is
+ * treated as NULL and NULL is less than any other value. Sets
+ * @a was_null_met if both fields are NULL.
+ */
+template <int IDX, int TYPE>
+static inline int
+field_compare_nullable(struct tuple *tuple_a, struct tuple *tuple_b,
+		       bool *was_null_met)
+{
+	const char *field_a = tuple_field_raw(tuple_format(tuple_a),
+					      tuple_data(tuple_a),
+					      tuple_field_map(tuple_a), IDX);
+	const char *field_b = tuple_field_raw(tuple_format(tuple_b),
+					      tuple_data(tuple_b),
+					      tuple_field_map(tuple_b), IDX);
+	bool a_is_nil = field_a == NULL || mp_typeof(*field_a) == MP_NIL;
+	bool b_is_nil = field_b == NULL || mp_typeof(*field_b) == MP_NIL;
+	if (a_is_nil) {
+		if (!b_is_nil)
+			return -1;
+		*was_null_met = true;
+		return 0;
+	}
+	if (b_is_nil)
+		return 1;
+	return field_compare<TYPE>(&field_a, &field_b);
+}
+
+/**
+ * Compare a nullable field of a tuple with a key part. A missing
+ * field is treated as NULL.
+ */
+template <int IDX, int TYPE>
+static inline int
+field_compare_with_key_nullable(struct tuple *tuple, const char *key)
+{
+	const char *field = tuple_field_raw(tuple_format(tuple),
+					    tuple_data(tuple),
+					    tuple_field_map(tuple), IDX);
+	bool field_is_nil = field == NULL || mp_typeof(*field) == MP_NIL;
+	bool key_is_nil = mp_typeof(*key) == MP_NIL;
+	if (field_is_nil)
+		return key_is_nil ? 0 : -1;
+	if (key_is_nil)
+		return 1;
+	return field_compare_with_key<TYPE>(&field, &key);
+}
+
+namespace /* local symbols */ {
+
+template <int FLD_ID, int IDX, int TYPE, int ...MORE_TYPES>
+struct FieldCompareNullable {};
+
+/**
+ * Same as tuple_compare_slowpath<true, ...>: once all unique
+ * parts are equal, extended parts are compared only if one of
+ * the unique parts is NULL. It gives NULL != NULL semantics in
+ * unique secondary indexes.
+ */
+template <int FLD_ID, int IDX, int TYPE, int IDX2, int TYPE2, int ...MORE_TYPES>
+struct FieldCompareNullable<FLD_ID, IDX, TYPE, IDX2, TYPE2, MORE_TYPES...>
+{
+	inline static int
+	compare(struct tuple *tuple_a, struct tuple *tuple_b,
+		struct key_def *key_def, bool was_null_met)
+	{
+		int r = field_compare_nullable<IDX, TYPE>(tuple_a, tuple_b,
+							  &was_null_met);
+		if (r != 0)
+			return r;
+		if (FLD_ID + 1 == key_def->unique_part_count && !was_null_met)
+			return 0;
+		return FieldCompareNullable<FLD_ID + 1, IDX2, TYPE2,
+					    MORE_TYPES...>::
+			compare(tuple_a, tuple_b, key_def, was_null_met);
+	}
+};
+
+template <int FLD_ID, int IDX, int TYPE>
+struct FieldCompareNullable<FLD_ID, IDX, TYPE>
+{
+	inline static int
+	compare(struct tuple *tuple_a, struct tuple *tuple_b,
+		struct key_def *, bool was_null_met)
+	{
+		return field_compare_nullable<IDX, TYPE>(tuple_a, tuple_b,
+							 &was_null_met);
+	}
+};
+
+template <int IDX, int TYPE, int ...MORE_TYPES>
+struct TupleCompareNullable
+{
+	static int
+	compare(struct tuple *tuple_a, hint_t tuple_a_hint,
+		struct tuple *tuple_b, hint_t tuple_b_hint,
+		struct key_def *key_def)
+	{
+		int rc = hint_cmp(tuple_a_hint, tuple_b_hint);
+		if (rc != 0)
+			return rc;
+		return FieldCompareNullable<0, IDX, TYPE, MORE_TYPES...>::
+			compare(tuple_a, tuple_b, key_def, false);
+	}
+};
+
+template <int FLD_ID, int IDX, int TYPE, int ...MORE_TYPES>
+struct FieldCompareWithKeyNullable {};
+
+template <int FLD_ID, int IDX, int TYPE, int IDX2, int TYPE2, int ...MORE_TYPES>
+struct FieldCompareWithKeyNullable<FLD_ID, IDX, TYPE, IDX2, TYPE2,
+				   MORE_TYPES...>
+{
+	inline static int
+	compare(struct tuple *tuple, const char *key, uint32_t part_count)
+	{
+		int r = field_compare_with_key_nullable<IDX, TYPE>(tuple, key);
+		if (r || part_count == FLD_ID + 1)
+			return r;
+		mp_next(&key);
+		return FieldCompareWithKeyNullable<FLD_ID + 1, IDX2, TYPE2,
+						   MORE_TYPES...>::
+			compare(tuple, key, part_count);
+	}
+};
+
+template <int FLD_ID, int IDX, int TYPE>
+struct FieldCompareWithKeyNullable<FLD_ID, IDX, TYPE>
+{
+	inline static int
+	compare(struct tuple *tuple, const char *key, uint32_t)
+	{
+		return field_compare_with_key_nullable<IDX, TYPE>(tuple, key);
+	}
 };
 
+template <int IDX, int TYPE, int ...MORE_TYPES>
+struct TupleCompareWithKeyNullable
+{
+	static int
+	compare(struct tuple *tuple, hint_t tuple_hint,
+		const char *key, uint32_t part_count,
+		hint_t key_hint, struct key_def *)
+	{
+		/* Part count can be 0 in wildcard searches. */
+		if (part_count == 0)
+			return 0;
+		int rc = hint_cmp(tuple_hint, key_hint);
+		if (rc != 0)
+			return rc;
+		return FieldCompareWithKeyNullable<0, IDX, TYPE, MORE_TYPES...>::
+			compare(tuple, key, part_count);
+	}
+};
+
+} /* end of anonymous namespace */
+
+#define NULLABLE_COMPARATOR(...) \
+	{ TupleCompareNullable<__VA_ARGS__>::compare, { __VA_ARGS__, UINT32_MAX } },
+
+/**
+ * Nullable keys, mostly secondary ones merged with a primary
+ * key. The key part of field 0 is not nullable in them, but any
+ * part is checked for NULL, so it doesn't matter which parts of
+ * a key are nullable.
+ */
+static const comparator_signature cmp_nullable_arr[] = {
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_STRING)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_INTEGER)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_NUMBER)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UUID)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_INTEGER , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_NUMBER  , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UUID    , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_STRING)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_STRING)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+};
+
+#undef NULLABLE_COMPARATOR
+
+#define NULLABLE_KEY_COMPARATOR(...) \
+	{ TupleCompareWithKeyNullable<__VA_ARGS__>::compare, { __VA_ARGS__ } },
+
+static const comparator_with_key_signature cmp_wk_nullable_arr[] = {
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_INTEGER , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_NUMBER  , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_UUID    , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_STRING)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 0, FIELD_TYPE_STRING)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_UNSIGNED, 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_UNSIGNED, 2, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+	NULLABLE_KEY_COMPARATOR(1, FIELD_TYPE_STRING  , 2, FIELD_TYPE_STRING  , 0, FIELD_TYPE_UNSIGNED)
+};
+
+#undef NULLABLE_KEY_COMPARATOR
+
+/* }}} nullable tuple_compare and tuple_compare_with_key */
+
 /**
  * A functional index tuple compare.
  * tuple_a_hint and tuple_b_hint are expected to be valid
@@ -1855,6 +2171,278 @@ tuple_hint(struct tuple *tuple, struct key_def *key_def)
 	return field_hint<type, is_nullable>(field, key_def->parts->coll);
 }
 
+/**
+ * Normalized key hints are used by indexes created with the
+ * normalized_key option. Instead of a hint built from the first
+ * key part only, such a hint stores the first bytes of a key
+ * encoded in such a way that comparing two encoded keys with
+ * memcmp() is equivalent to comparing the keys with the index
+ * key definition. All key parts contribute to the encoding, so
+ * a tie in the first part doesn't render the hint useless.
+ *
+ * The encoding of a key is a concatenation of its parts:
+ *
+ *  - A nullable part starts with 0x00 if it is NULL (and then
+ *    it ends) or with 0x01 otherwise.
+ *
+ *  - A boolean is encoded as 0x00 or 0x01.
+ *
+ *  - An integer is encoded as a tag byte followed by its
+ *    significant bytes in big-endian order. The tag is 0x80
+ *    plus the number of significant bytes for a non-negative
+ *    number. For a negative number, the tag is 0x7f minus the
+ *    number of significant bytes of the bitwise complement of
+ *    the number, which is then followed by the bytes of the
+ *    number itself.
+ *
+ *  - A string or a varbinary is encoded as is, with 0x00 bytes
+ *    escaped as 0x00 0xff, and terminated with 0x00 0x01. If
+ *    a string part has an ICU collation, the collation sort
+ *    key terminated with 0x00 is used instead.
+ *
+ *  - A UUID is encoded as its 16-byte packed representation.
+ *
+ * The encoding of a part never is a prefix of the encoding of
+ * another value of the same part, so the first differing byte
+ * of two encoded keys determines their order. The encoding
+ * stops at the first part of any other type, so all tuples
+ * encode the same set of parts; a hint of a key that doesn't
+ * cover all of them is only valid if it is long enough to fill
+ * a hint.
+ *
+ * The prefix is limited to the size of a hint, because it is
+ * kept inline in a tree element in place of a regular hint. If
+ * two keys share the first eight encoded bytes, they are
+ * compared in full. Making the prefix wider would need another
+ * tree element layout; see tree_normalized_key_bench for the
+ * effect of a long shared prefix.
+ */
+struct normalized_key {
+	/** First bytes of the normalized key. */
+	unsigned char data[sizeof(hint_t)];
+	/** Number of bytes stored in data. */
+	uint32_t len;
+};
+
+static inline bool
+normalized_key_is_full(const struct normalized_key *nk)
+{
+	return nk->len == sizeof(nk->data);
+}
+
+static inline void
+normalized_key_append_byte(struct normalized_key *nk, unsigned char c)
+{
+	if (!normalized_key_is_full(nk))
+		nk->data[nk->len++] = c;
+}
+
+static inline void
+normalized_key_append(struct normalized_key *nk, const char *data,
+		      uint32_t len)
+{
+	len = MIN(len, sizeof(nk->data) - nk->len);
+	memcpy(nk->data + nk->len, data, len);
+	nk->len += len;
+}
+
+/** Append the low @a n bytes of @a val in big-endian order. */
+static inline void
+normalized_key_append_be(struct normalized_key *nk, uint64_t val,
+			 uint32_t n)
+{
+	for (uint32_t i = n; i > 0 && !normalized_key_is_full(nk); i--)
+		nk->data[nk->len++] = (unsigned char)(val >> (i - 1) * 8);
+}
+
+/** Return the number of significant bytes of @a val. */
+static inline uint32_t
+normalized_key_byte_count(uint64_t val)
+{
+	return val == 0 ? 0 : 8 - __builtin_clzll(val) / 8;
+}
+
+static inline void
+normalized_key_append_uint(struct normalized_key *nk, uint64_t val)
+{
+	uint32_t n = normalized_key_byte_count(val);
+	normalized_key_append_byte(nk, 0x80 + n);
+	normalized_key_append_be(nk, val, n);
+}
+
+static inline void
+normalized_key_append_int(struct normalized_key *nk, int64_t val)
+{
+	if (val >= 0)
+		return normalized_key_append_uint(nk, val);
+	uint64_t inv = ~(uint64_t)val;
+	uint32_t n = normalized_key_byte_count(inv);
+	normalized_key_append_byte(nk, 0x7f - n);
+	normalized_key_append_be(nk, (uint64_t)val, n);
+}
+
+static inline void
+normalized_key_append_str(struct normalized_key *nk, const char *s,
+			  uint32_t len)
+{
+	for (uint32_t i = 0; i < len && !normalized_key_is_full(nk); i++) {
+		normalized_key_append_byte(nk, s[i]);
+		if (s[i] == '\0')
+			normalized_key_append_byte(nk, 0xff);
+	}
+	normalized_key_append_byte(nk, 0x00);
+	normalized_key_append_byte(nk, 0x01);
+}
+
+static inline void
+normalized_key_append_str_coll(struct normalized_key *nk, const char *s,
+			       uint32_t len, struct coll *coll)
+{
+	/*
+	 * Request one byte more than we can store to learn
+	 * whether the sort key fits so that the terminator
+	 * has to be appended.
+	 */
+	char buf[sizeof(nk->data) + 1];
+	uint32_t size = sizeof(nk->data) - nk->len + 1;
+	uint32_t buf_len = coll->hint(s, len, buf, size, coll);
+	normalized_key_append(nk, buf, buf_len);
+	if (buf_len < size)
+		normalized_key_append_byte(nk, 0x00);
+}
+
+/** Return true if a key part can be normalized. */
+static inline bool
+key_part_is_normalizable(const struct key_part *part)
+{
+	switch (part->type) {
+	case FIELD_TYPE_BOOLEAN:
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_STRING:
+	case FIELD_TYPE_VARBINARY:
+	case FIELD_TYPE_UUID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Append a key part to a normalized key. @a field is NULL if
+ * a nullable field is absent in the tuple. Returns false if
+ * the field value can't be normalized.
+ */
+static bool
+normalized_key_append_field(struct normalized_key *nk, const char *field,
+			    struct key_part *part)
+{
+	if (key_part_is_nullable(part)) {
+		if (field == NULL || mp_typeof(*field) == MP_NIL) {
+			normalized_key_append_byte(nk, 0x00);
+			return true;
+		}
+		normalized_key_append_byte(nk, 0x01);
+	}
+	if (field == NULL)
+		return false;
+	uint32_t len;
+	switch (mp_typeof(*field)) {
+	case MP_BOOL:
+		normalized_key_append_byte(nk, mp_decode_bool(&field) ? 1 : 0);
+		return true;
+	case MP_UINT:
+		normalized_key_append_uint(nk, mp_decode_uint(&field));
+		return true;
+	case MP_INT:
+		normalized_key_append_int(nk, mp_decode_int(&field));
+		return true;
+	case MP_STR:
+		len = mp_decode_strl(&field);
+		if (part->coll != NULL && part->coll->type == COLL_TYPE_ICU)
+			normalized_key_append_str_coll(nk, field, len,
+						       part->coll);
+		else
+			normalized_key_append_str(nk, field, len);
+		return true;
+	case MP_BIN:
+		len = mp_decode_binl(&field);
+		normalized_key_append_str(nk, field, len);
+		return true;
+	case MP_EXT:
+	{
+		int8_t type;
+		const char *data = mp_decode_ext(&field, &type, &len);
+		if (type != MP_UUID || len != UUID_PACKED_LEN)
+			return false;
+		normalized_key_append(nk, data, len);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+static inline hint_t
+normalized_key_hint(const struct normalized_key *nk)
+{
+	uint64_t val = 0;
+	for (uint32_t i = 0; i < sizeof(nk->data); i++) {
+		val <<= CHAR_BIT;
+		if (i < nk->len)
+			val |= nk->data[i];
+	}
+	return (hint_t)val;
+}
+
+static hint_t
+key_hint_normalized(const char *key, uint32_t part_count,
+		    struct key_def *key_def)
+{
+	assert(!key_def->is_multikey && !key_def->for_func_index);
+	struct normalized_key nk;
+	nk.len = 0;
+	uint32_t i;
+	for (i = 0; i < part_count; i++) {
+		struct key_part *part = &key_def->parts[i];
+		if (!key_part_is_normalizable(part))
+			break;
+		if (!normalized_key_append_field(&nk, key, part))
+			return HINT_NONE;
+		if (normalized_key_is_full(&nk))
+			return normalized_key_hint(&nk);
+		mp_next(&key);
+	}
+	/*
+	 * A short key that doesn't cover all parts stored in
+	 * tuple hints can't be compared with them.
+	 */
+	if (i == 0 || (i == part_count && i < key_def->part_count &&
+		       key_part_is_normalizable(&key_def->parts[i])))
+		return HINT_NONE;
+	return normalized_key_hint(&nk);
+}
+
+static hint_t
+tuple_hint_normalized(struct tuple *tuple, struct key_def *key_def)
+{
+	assert(!key_def->is_multikey && !key_def->for_func_index);
+	struct normalized_key nk;
+	nk.len = 0;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		struct key_part *part = &key_def->parts[i];
+		if (!key_part_is_normalizable(part))
+			break;
+		const char *field = tuple_field_by_part(tuple, part,
+							MULTIKEY_NONE);
+		if (!normalized_key_append_field(&nk, field, part))
+			return HINT_NONE;
+		if (normalized_key_is_full(&nk))
+			break;
+	}
+	return nk.len == 0 ? HINT_NONE : normalized_key_hint(&nk);
+}
+
 static hint_t
 key_hint_stub(const char *key, uint32_t part_count, struct key_def *key_def)
 {
@@ -1910,6 +2498,11 @@ key_def_set_hint_func(struct key_def *def)
 		def->tuple_hint = key_hint_stub;
 		return;
 	}
+	if (def->has_normalized_hint) {
+		def->key_hint = key_hint_normalized;
+		def->tuple_hint = tuple_hint_normalized;
+		return;
+	}
 	switch (def->parts->type) {
 	case FIELD_TYPE_BOOLEAN:
 		key_def_set_hint_func<FIELD_TYPE_BOOLEAN>(def);
@@ -2024,6 +2617,45 @@ key_def_set_compare_func_plain(struct key_def *def)
 	}
 }
 
+/**
+ * Use pre-compiled nullable comparators if available, otherwise
+ * fall back on generic ones. Missing optional parts are treated
+ * as NULLs by the pre-compiled comparators.
+ */
+template<bool has_optional_parts>
+static void
+key_def_set_compare_func_nullable(struct key_def *def)
+{
+	assert(def->is_nullable);
+	assert(!def->has_json_paths);
+	assert(!key_def_has_collation(def));
+	key_def_set_compare_func_plain<true, has_optional_parts>(def);
+	for (uint32_t k = 0; k < lengthof(cmp_nullable_arr); k++) {
+		const uint32_t *p = cmp_nullable_arr[k].p;
+		uint32_t i = 0;
+		for (; i < def->part_count; i++)
+			if (def->parts[i].fieldno != p[i * 2] ||
+			    def->parts[i].type != p[i * 2 + 1])
+				break;
+		if (i == def->part_count && p[i * 2] == UINT32_MAX) {
+			def->tuple_compare = cmp_nullable_arr[k].f;
+			break;
+		}
+	}
+	for (uint32_t k = 0; k < lengthof(cmp_wk_nullable_arr); k++) {
+		const uint32_t *p = cmp_wk_nullable_arr[k].p;
+		uint32_t i = 0;
+		for (; i < def->part_count; i++)
+			if (def->parts[i].fieldno != p[i * 2] ||
+			    def->parts[i].type != p[i * 2 + 1])
+				break;
+		if (i == def->part_count) {
+			def->tuple_compare_with_key = cmp_wk_nullable_arr[k].f;
+			break;
+		}
+	}
+}
+
 template<bool is_nullable, bool has_optional_parts>
 static void
 key_def_set_compare_func_json(struct key_def *def)
@@ -2062,6 +2694,11 @@ key_def_set_compare_func(struct key_def *def)
 	} else if (!key_def_has_collation(def) &&
 	    !def->is_nullable && !def->has_json_paths) {
 		key_def_set_compare_func_fast(def);
+	} else if (!def->has_json_paths && !key_def_has_collation(def)) {
+		if (def->has_optional_parts)
+			key_def_set_compare_func_nullable<true>(def);
+		else
+			key_def_set_compare_func_nullable<false>(def);
 	} else if (!def->has_json_paths) {
 		if (def->is_nullable && def->has_optional_parts) {
 			key_def_set_compare_func_plain<true, true>(def);
@@ -0,0 +1,368 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "tuple_compression.h"
+
+#include <string.h>
+#include <zstd.h>
+
+#include "fiber.h"
+#include "diag.h"
+#include "errcode.h"
+#include "tuple.h"
+#include "tuple_format.h"
+
+const char *compression_type_strs[] = {
+	/* [COMPRESSION_TYPE_NONE] = */ "none",
+	/* [COMPRESSION_TYPE_ZSTD] = */ "zstd",
+};
+
+enum {
+	/**
+	 * Tuples are compressed on the insertion path, so favor
+	 * speed over ratio.
+	 */
+	TUPLE_COMPRESSION_ZSTD_LEVEL = 1,
+};
+
+/** Compression context, created on demand. */
+static ZSTD_CCtx *tuple_zcctx;
+/** Decompression context, created on demand. */
+static ZSTD_DCtx *tuple_zdctx;
+
+static ZSTD_CCtx *
+tuple_zcctx_get(void)
+{
+	assert(cord_is_main());
+	if (tuple_zcctx == NULL) {
+		tuple_zcctx = ZSTD_createCCtx();
+		if (tuple_zcctx == NULL)
+			diag_set(OutOfMemory, sizeof(tuple_zcctx), "malloc",
+				 "zstd context");
+	}
+	return tuple_zcctx;
+}
+
+static ZSTD_DCtx *
+tuple_zdctx_get(void)
+{
+	assert(cord_is_main());
+	if (tuple_zdctx == NULL) {
+		tuple_zdctx = ZSTD_createDCtx();
+		if (tuple_zdctx == NULL)
+			diag_set(OutOfMemory, sizeof(tuple_zdctx), "malloc",
+				 "zstd context");
+	}
+	return tuple_zdctx;
+}
+
+void
+tuple_compression_free(void)
+{
+	if (tuple_zcctx != NULL) {
+		ZSTD_freeCCtx(tuple_zcctx);
+		tuple_zcctx = NULL;
+	}
+	if (tuple_zdctx != NULL) {
+		ZSTD_freeDCtx(tuple_zdctx);
+		tuple_zdctx = NULL;
+	}
+}
+
+/**
+ * Check if a non-indexed field may be replaced with a compressed
+ * one without breaking the format. Type mismatches are left for
+ * the format validation to report.
+ */
+static bool
+tuple_field_is_compressible(struct tuple_format *format, uint32_t fieldno,
+			    const char *field)
+{
+	assert(fieldno >= format->index_field_count);
+	switch (mp_typeof(*field)) {
+	case MP_STR:
+	case MP_BIN:
+	case MP_ARRAY:
+	case MP_MAP:
+		break;
+	default:
+		return false;
+	}
+	if (fieldno >= tuple_format_field_count(format))
+		return true;
+	struct tuple_field *f = tuple_format_field(format, fieldno);
+	if (f->type != FIELD_TYPE_ANY && f->type != FIELD_TYPE_MAP &&
+	    f->type != FIELD_TYPE_ARRAY)
+		return false;
+	return field_mp_type_is_compatible(f->type, field,
+					   tuple_field_is_nullable(f));
+}
+
+int
+tuple_compress_raw(struct tuple_format *format, const char **data,
+		   const char **data_end)
+{
+	assert(format->compression == COMPRESSION_TYPE_ZSTD);
+	const char *pos = *data;
+	if (mp_typeof(*pos) != MP_ARRAY)
+		return 0;
+	uint32_t field_count = mp_decode_array(&pos);
+	uint32_t fieldno = 0;
+	for (; fieldno < field_count &&
+	       fieldno < format->index_field_count; fieldno++)
+		mp_next(&pos);
+	/*
+	 * A compressed field is never longer than the original
+	 * one, so the whole tuple fits in a buffer of the
+	 * original size. It is allocated on the first
+	 * compressed field.
+	 */
+	char *buf = NULL;
+	char *w = NULL;
+	const char *copied = *data;
+	for (; fieldno < field_count; fieldno++) {
+		const char *field = pos;
+		mp_next(&pos);
+		size_t size = pos - field;
+		if (size < TUPLE_COMPRESSION_MIN_SIZE ||
+		    !tuple_field_is_compressible(format, fieldno, field))
+			continue;
+		ZSTD_CCtx *zctx = tuple_zcctx_get();
+		if (zctx == NULL)
+			return -1;
+		if (buf == NULL) {
+			size_t total = *data_end - *data;
+			buf = region_alloc(&fiber()->gc, total);
+			if (buf == NULL) {
+				diag_set(OutOfMemory, total, "region_alloc",
+					 "buf");
+				return -1;
+			}
+			w = buf;
+		}
+		memcpy(w, copied, field - copied);
+		w += field - copied;
+		copied = field;
+		/*
+		 * Compress right into the output buffer leaving
+		 * room for the extension header. If the result
+		 * doesn't fit, the field isn't worth compressing.
+		 */
+		uint32_t header_size = mp_sizeof_extl(size);
+		size_t len = ZSTD_compressCCtx(zctx, w + header_size,
+					       size - header_size, field, size,
+					       TUPLE_COMPRESSION_ZSTD_LEVEL);
+		if (ZSTD_isError(len))
+			continue;
+		uint32_t real_header_size = mp_sizeof_extl(len);
+		assert(real_header_size <= header_size);
+		if (real_header_size < header_size)
+			memmove(w + real_header_size, w + header_size, len);
+		mp_encode_extl(w, MP_COMPRESSION, len);
+		w += real_header_size + len;
+		copied = pos;
+	}
+	if (buf == NULL)
+		return 0;
+	memcpy(w, copied, *data_end - copied);
+	w += *data_end - copied;
+	*data = buf;
+	*data_end = w;
+	return 0;
+}
+
+/**
+ * Get the size of a field compressed into @a src of @a len bytes.
+ * Return -1 and set diag if the frame is corrupted.
+ */
+static int64_t
+compressed_field_size(const char *src, uint32_t len)
+{
+	unsigned long long size = ZSTD_getFrameContentSize(src, len);
+	if (size == ZSTD_CONTENTSIZE_UNKNOWN ||
+	    size == ZSTD_CONTENTSIZE_ERROR || size > UINT32_MAX) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "corrupted compressed field");
+		return -1;
+	}
+	return size;
+}
+
+/**
+ * Decompress a field compressed into @a src of @a len bytes into
+ * @a dst of @a size bytes, which is the size returned by
+ * compressed_field_size().
+ */
+static int
+compressed_field_decode(const char *src, uint32_t len, char *dst, size_t size)
+{
+	ZSTD_DCtx *zctx = tuple_zdctx_get();
+	if (zctx == NULL)
+		return -1;
+	size_t rc = ZSTD_decompressDCtx(zctx, dst, size, src, len);
+	if (ZSTD_isError(rc) || rc != size) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "corrupted compressed field");
+		return -1;
+	}
+	return 0;
+}
+
+const char *
+mp_decompress(const char **data, uint32_t *size)
+{
+	int8_t type;
+	uint32_t len = mp_decode_extl(data, &type);
+	assert(type == MP_COMPRESSION);
+	const char *src = *data;
+	*data += len;
+	int64_t raw_size = compressed_field_size(src, len);
+	if (raw_size < 0)
+		return NULL;
+	char *buf = region_alloc(&fiber()->gc, raw_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, raw_size, "region_alloc", "buf");
+		return NULL;
+	}
+	if (compressed_field_decode(src, len, buf, raw_size) != 0)
+		return NULL;
+	*size = raw_size;
+	return buf;
+}
+
+int
+tuple_decompress_raw(struct tuple_format *format, const char **data,
+		     const char **data_end)
+{
+	const char *pos = *data;
+	if (mp_typeof(*pos) != MP_ARRAY)
+		return 0;
+	uint32_t field_count = mp_decode_array(&pos);
+	uint32_t fieldno = 0;
+	for (; fieldno < field_count &&
+	       fieldno < format->index_field_count; fieldno++)
+		mp_next(&pos);
+	/* Calculate the size of the decompressed tuple. */
+	const char *first = pos;
+	bool is_compressed = false;
+	size_t total = first - *data;
+	for (uint32_t i = fieldno; i < field_count; i++) {
+		const char *field = pos;
+		if (!mp_is_compressed(field)) {
+			mp_next(&pos);
+			total += pos - field;
+			continue;
+		}
+		int8_t type;
+		uint32_t len = mp_decode_extl(&pos, &type);
+		int64_t raw_size = compressed_field_size(pos, len);
+		if (raw_size < 0)
+			return -1;
+		pos += len;
+		total += raw_size;
+		is_compressed = true;
+	}
+	assert(pos == *data_end);
+	if (!is_compressed)
+		return 0;
+	char *buf = region_alloc(&fiber()->gc, total);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, total, "region_alloc", "buf");
+		return -1;
+	}
+	char *w = buf;
+	memcpy(w, *data, first - *data);
+	w += first - *data;
+	pos = first;
+	for (uint32_t i = fieldno; i < field_count; i++) {
+		const char *field = pos;
+		if (!mp_is_compressed(field)) {
+			mp_next(&pos);
+			memcpy(w, field, pos - field);
+			w += pos - field;
+			continue;
+		}
+		int8_t type;
+		uint32_t len = mp_decode_extl(&pos, &type);
+		int64_t raw_size = compressed_field_size(pos, len);
+		assert(raw_size >= 0);
+		if (compressed_field_decode(pos, len, w, raw_size) != 0)
+			return -1;
+		pos += len;
+		w += raw_size;
+	}
+	assert(w == buf + total);
+	*data = buf;
+	*data_end = w;
+	return 0;
+}
+
+const char *
+tuple_data_range_decompressed(struct tuple *tuple, uint32_t *size)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	const char *data = tuple_data_range(tuple, size);
+	if (likely(format->compression == COMPRESSION_TYPE_NONE))
+		return data;
+	const char *data_end = data + *size;
+	if (tuple_decompress_raw(format, &data, &data_end) != 0)
+		return NULL;
+	*size = data_end - data;
+	return data;
+}
+
+const char *
+mp_decompress_field(const char *field)
+{
+	if (field == NULL || !mp_is_compressed(field))
+		return field;
+	uint32_t size;
+	return mp_decompress(&field, &size);
+}
+
+bool
+tuple_find_compressed_indexed_field(struct tuple_format *format,
+				    const char *data, uint32_t *fieldno)
+{
+	assert(format->compression != COMPRESSION_TYPE_NONE);
+	if (mp_typeof(*data) != MP_ARRAY)
+		return false;
+	uint32_t field_count = mp_decode_array(&data);
+	for (uint32_t i = 0; i < field_count &&
+	     i < format->index_field_count; i++) {
+		if (mp_is_compressed(data)) {
+			*fieldno = i;
+			return true;
+		}
+		mp_next(&data);
+	}
+	return false;
+}
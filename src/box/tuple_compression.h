@@ -0,0 +1,178 @@
+#ifndef TARANTOOL_BOX_TUPLE_COMPRESSION_H_INCLUDED
+#define TARANTOOL_BOX_TUPLE_COMPRESSION_H_INCLUDED
+
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "msgpuck.h"
+#include "mp_extension_types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct tuple;
+struct tuple_format;
+
+/** Tuple compression algorithm, see space option "compression". */
+enum compression_type {
+	COMPRESSION_TYPE_NONE = 0,
+	COMPRESSION_TYPE_ZSTD,
+	compression_type_MAX
+};
+
+extern const char *compression_type_strs[];
+
+enum {
+	/**
+	 * Fields whose MessagePack is shorter than this are never
+	 * compressed: zstd frame overhead eats any gain.
+	 */
+	TUPLE_COMPRESSION_MIN_SIZE = 64,
+};
+
+/** Check if @a data points to a compressed field. */
+static inline bool
+mp_is_compressed(const char *data)
+{
+	if (mp_typeof(*data) != MP_EXT)
+		return false;
+	int8_t type;
+	mp_decode_extl(&data, &type);
+	return type == MP_COMPRESSION;
+}
+
+/**
+ * Compress fields of a tuple to be stored in a space with
+ * compression enabled. Only fields following all indexed ones
+ * are compressed, so the tuple field map is valid for both the
+ * compressed and decompressed MessagePack. A field is replaced
+ * with an MP_COMPRESSION extension if it is big enough and
+ * compression makes it shorter.
+ *
+ * @param format Format of the tuple.
+ * @param[in, out] data MessagePack array. Set to the compressed
+ *                 array on the fiber region if any field was
+ *                 compressed.
+ * @param[in, out] data_end End of @a data.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+tuple_compress_raw(struct tuple_format *format, const char **data,
+		   const char **data_end);
+
+/**
+ * Decompress an MP_COMPRESSION field @a data points to into the
+ * fiber region and advance @a data past it.
+ *
+ * @param[in, out] data Compressed field.
+ * @param[out] size Size of the decompressed MessagePack.
+ *
+ * @retval not NULL Decompressed MessagePack value.
+ * @retval NULL Memory error or corrupted data, diag is set.
+ */
+const char *
+mp_decompress(const char **data, uint32_t *size);
+
+/**
+ * Decompress fields of a tuple of a space with compression
+ * enabled. Fields preceding all indexed ones are never
+ * compressed and are copied as is.
+ *
+ * @param format Format of the tuple.
+ * @param[in, out] data MessagePack array. Set to the
+ *                 decompressed array on the fiber region if any
+ *                 field was compressed.
+ * @param[in, out] data_end End of @a data.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error or corrupted data, diag is set.
+ */
+int
+tuple_decompress_raw(struct tuple_format *format, const char **data,
+		     const char **data_end);
+
+/**
+ * Decompress @a field if it is an MP_COMPRESSION extension. The
+ * result is allocated on the fiber region. Used by the C module
+ * API, where the region is freed once the function returns.
+ *
+ * @retval not NULL @a field or its decompressed MessagePack.
+ * @retval NULL @a field is NULL, or memory error or corrupted
+ *         data with diag set.
+ */
+const char *
+mp_decompress_field(const char *field);
+
+/**
+ * Find a compressed field among the fields of MessagePack array
+ * @a data that precede all indexed fields of @a format. Such a
+ * tuple can't be stored with this format: its field map and
+ * decompression rely on all those fields being plain. It
+ * happens when a new index covers fields compressed in existing
+ * tuples.
+ *
+ * @param format Format of a space with compression enabled.
+ * @param data MessagePack array.
+ * @param[out] fieldno Number of the compressed field.
+ *
+ * @retval true A compressed field is found.
+ * @retval false All fields preceding indexed ones are plain.
+ */
+bool
+tuple_find_compressed_indexed_field(struct tuple_format *format,
+				    const char *data, uint32_t *fieldno);
+
+/**
+ * Get MessagePack of a tuple with all compressed fields
+ * decompressed. The result is allocated on the fiber region
+ * unless the tuple format has no compression, in which case the
+ * tuple data is returned as is.
+ *
+ * @retval not NULL Tuple MessagePack.
+ * @retval NULL Memory error or corrupted data, diag is set.
+ */
+const char *
+tuple_data_range_decompressed(struct tuple *tuple, uint32_t *size);
+
+/** Free compression contexts. */
+void
+tuple_compression_free(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_TUPLE_COMPRESSION_H_INCLUDED */
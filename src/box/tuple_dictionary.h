@@ -57,6 +57,11 @@ struct tuple_dictionary {
 	uint32_t name_count;
 	/** Reference counter. */
 	int refs;
+	/**
+	 * Incremented each time the names are changed, so that
+	 * the names resolved by formats can be invalidated.
+	 */
+	uint32_t version;
 };
 
 /**
@@ -72,7 +77,7 @@ tuple_dictionary_new(const struct field_def *fields, uint32_t field_count);
 
 /**
  * Swap content of two dictionaries. Reference counters are not
- * swaped.
+ * swaped, versions of both dictionaries are incremented.
  */
 void
 tuple_dictionary_swap(struct tuple_dictionary *a, struct tuple_dictionary *b);
@@ -32,6 +32,7 @@
 #include "fiber.h"
 #include "json/json.h"
 #include "tuple_format.h"
+#include "tuple.h"
 #include "coll_id_cache.h"
 #include "tt_static.h"
 
@@ -481,8 +482,8 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 	assert(tuple_format_field(format, 0)->offset_slot == TUPLE_OFFSET_SLOT_NIL
 	       || json_token_is_multikey(&tuple_format_field(format, 0)->token));
 	size_t field_map_size = -current_slot * sizeof(uint32_t);
-	if (field_map_size > INT16_MAX) {
-		/** tuple->data_offset is 15 bits */
+	if (field_map_size > TUPLE_DATA_OFFSET_MAX) {
+		/** Data offset of a tuple is 14 bits. */
 		diag_set(ClientError, ER_INDEX_FIELD_COUNT_LIMIT,
 			 -current_slot);
 		return -1;
@@ -669,6 +670,8 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 	}
 	format->total_field_count = field_count;
 	format->required_fields = NULL;
+	format->accessors = NULL;
+	format->accessors_dict_version = 0;
 	format->fields_depth = 1;
 	format->refs = 0;
 	format->id = FORMAT_ID_NIL;
@@ -688,6 +691,7 @@ static inline void
 tuple_format_destroy(struct tuple_format *format)
 {
 	free(format->required_fields);
+	free(format->accessors);
 	tuple_format_destroy_fields(format);
 	tuple_dictionary_unref(format->dict);
 }
@@ -788,6 +792,8 @@ tuple_format_new(struct tuple_format_vtab *vtab, void *engine,
 	format->engine = engine;
 	format->is_temporary = is_temporary;
 	format->is_ephemeral = is_ephemeral;
+	format->compression = COMPRESSION_TYPE_NONE;
+	format->dense_field_map_slot = TUPLE_OFFSET_SLOT_NIL;
 	format->exact_field_count = exact_field_count;
 	format->epoch = ++formats_epoch;
 	if (tuple_format_create(format, keys, key_count, space_fields,
@@ -852,6 +858,148 @@ tuple_format1_can_store_format2_tuples(struct tuple_format *format1,
 	return true;
 }
 
+/** @sa declaration for details. */
+int
+tuple_format_enable_dense_field_map(struct tuple_format *format)
+{
+	assert(format->dense_field_map_slot == TUPLE_OFFSET_SLOT_NIL);
+	int32_t slot = -(int32_t)(format->field_map_size /
+				  sizeof(uint32_t)) - 1;
+	size_t field_map_size = -slot * sizeof(uint32_t);
+	if (field_map_size > TUPLE_DATA_OFFSET_MAX) {
+		diag_set(ClientError, ER_INDEX_FIELD_COUNT_LIMIT, -slot);
+		return -1;
+	}
+	format->field_map_size = field_map_size;
+	format->dense_field_map_slot = slot;
+	return 0;
+}
+
+/**
+ * Resolve a field name or a full JSON path the same way
+ * tuple_field_raw_by_full_path() does and store the result
+ * in @a accessor.
+ */
+static void
+tuple_format_resolve_accessor(struct tuple_format *format,
+			      struct tuple_accessor *accessor,
+			      const char *path, uint32_t path_len,
+			      uint32_t path_hash)
+{
+	memcpy(accessor->path, path, path_len);
+	accessor->path_len = path_len;
+	accessor->path_hash = path_hash;
+	accessor->is_resolved = false;
+	accessor->subpath_offset = path_len;
+	accessor->offset_slot = TUPLE_OFFSET_SLOT_NIL;
+	path = accessor->path;
+	uint32_t fieldno;
+	/* A field name that looks like a JSON path goes first. */
+	if (tuple_fieldno_by_name(format->dict, path, path_len, path_hash,
+				  &fieldno) != 0) {
+		struct json_lexer lexer;
+		struct json_token token;
+		json_lexer_create(&lexer, path, path_len, TUPLE_INDEX_BASE);
+		if (json_lexer_next_token(&lexer, &token) != 0)
+			return;
+		if (token.type == JSON_TOKEN_NUM) {
+			fieldno = token.num;
+		} else if (token.type == JSON_TOKEN_STR) {
+			uint32_t name_hash = path_len == (uint32_t)token.len ?
+				path_hash : field_name_hash(token.str,
+							    token.len);
+			if (tuple_fieldno_by_name(format->dict, token.str,
+						  token.len, name_hash,
+						  &fieldno) != 0)
+				return;
+		} else {
+			return;
+		}
+		accessor->subpath_offset = lexer.offset;
+	}
+	accessor->fieldno = fieldno;
+	accessor->is_resolved = true;
+	uint32_t subpath_len = path_len - accessor->subpath_offset;
+	if (fieldno >= format->index_field_count ||
+	    (fieldno == 0 && subpath_len == 0))
+		return;
+	struct tuple_field *field = tuple_format_field_by_path(format,
+		fieldno, subpath_len > 0 ? path + accessor->subpath_offset :
+		NULL, subpath_len);
+	/* See tuple_field_raw_by_path() on multikey fields. */
+	if (field != NULL && !field->is_multikey_part)
+		accessor->offset_slot = field->offset_slot;
+}
+
+const struct tuple_accessor *
+tuple_format_accessor(struct tuple_format *format, const char *path,
+		      uint32_t path_len, uint32_t path_hash)
+{
+	assert(path_len > 0);
+	if (path_len > TUPLE_ACCESSOR_PATH_MAX)
+		return NULL;
+	size_t size = TUPLE_ACCESSOR_CACHE_SIZE * sizeof(*format->accessors);
+	if (format->accessors == NULL) {
+		format->accessors = calloc(1, size);
+		if (format->accessors == NULL)
+			return NULL;
+		format->accessors_dict_version = format->dict->version;
+	} else if (format->accessors_dict_version != format->dict->version) {
+		/* Field names have been changed by alter. */
+		memset(format->accessors, 0, size);
+		format->accessors_dict_version = format->dict->version;
+	}
+	struct tuple_accessor *accessor =
+		&format->accessors[path_hash % TUPLE_ACCESSOR_CACHE_SIZE];
+	if (accessor->path_len != path_len ||
+	    accessor->path_hash != path_hash ||
+	    memcmp(accessor->path, path, path_len) != 0)
+		tuple_format_resolve_accessor(format, accessor, path,
+					      path_len, path_hash);
+	return accessor;
+}
+
+/**
+ * Fill the dense extent with offsets of all top-level fields.
+ * The extent is omitted if it would make the tuple metadata
+ * too big, tuple_field_raw() falls back to MessagePack walk
+ * then.
+ */
+static int
+tuple_field_map_create_dense(struct tuple_format *format, const char *tuple,
+			     struct field_map_builder *builder,
+			     struct region *region)
+{
+	const char *pos = tuple;
+	uint32_t field_count = mp_decode_array(&pos);
+	/* Space left for the offsets, assuming the biggest header. */
+	uint32_t used = sizeof(struct tuple) + field_map_build_size(builder) +
+			sizeof(uint32_t);
+	if (used > TUPLE_DATA_OFFSET_MAX)
+		return 0;
+	uint32_t max_size = TUPLE_DATA_OFFSET_MAX - used;
+	if (field_count > max_size / sizeof(uint16_t))
+		return 0;
+	struct field_map_builder_slot_extent *extent =
+		field_map_builder_dense_extent_new(builder,
+				format->dense_field_map_slot, field_count,
+				region);
+	if (extent == NULL)
+		return -1;
+	for (uint32_t i = 0; i < field_count; i++) {
+		extent->offset[i] = pos - tuple;
+		mp_next(&pos);
+	}
+	if (field_map_dense_extent_size(extent) - sizeof(uint32_t) >
+	    max_size) {
+		/* 32-bit offsets don't fit, forget the extent. */
+		builder->slots[format->dense_field_map_slot].has_extent = false;
+		builder->slots[format->dense_field_map_slot].offset = 0;
+		builder->dense_extent = NULL;
+	}
+	return 0;
+}
+
 /** @sa declaration for details. */
 int
 tuple_field_map_create(struct tuple_format *format, const char *tuple,
@@ -862,7 +1010,7 @@ tuple_field_map_create(struct tuple_format *format, const char *tuple,
 				     region) != 0)
 		return -1;
 	if (tuple_format_field_count(format) == 0)
-		return 0; /* Nothing to initialize */
+		goto dense; /* Nothing to initialize */
 
 	uint32_t field_count;
 	struct tuple_format_iterator it;
@@ -881,7 +1029,13 @@ tuple_field_map_create(struct tuple_format *format, const char *tuple,
 					entry.multikey_count, region) != 0)
 			return -1;
 	}
-	return entry.data == NULL ? 0 : -1;
+	if (entry.data != NULL)
+		return -1;
+dense:
+	if (format->dense_field_map_slot != TUPLE_OFFSET_SLOT_NIL)
+		return tuple_field_map_create_dense(format, tuple, builder,
+						    region);
+	return 0;
 }
 
 uint32_t
@@ -37,6 +37,7 @@
 #include "json/json.h"
 #include "tuple_dictionary.h"
 #include "field_map.h"
+#include "tuple_compression.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -157,6 +158,46 @@ tuple_field_is_nullable(struct tuple_field *tuple_field)
 	return tuple_field->nullable_action == ON_CONFLICT_ACTION_NONE;
 }
 
+enum {
+	/** Number of entries in tuple_format::accessors. */
+	TUPLE_ACCESSOR_CACHE_SIZE = 64,
+	/** Maximal length of a path cached in tuple_format::accessors. */
+	TUPLE_ACCESSOR_PATH_MAX = 48,
+};
+
+/**
+ * A field name or a full JSON path resolved against a tuple
+ * format once, so that the field can be found in any tuple of
+ * the format without the name lookup and path parsing.
+ * \sa tuple_format_accessor(), tuple_field_raw_by_accessor().
+ */
+struct tuple_accessor {
+	/** The path, not null-terminated. */
+	char path[TUPLE_ACCESSOR_PATH_MAX];
+	/** Length of @path, 0 if the entry is unused. */
+	uint32_t path_len;
+	/** Hash of @path. */
+	uint32_t path_hash;
+	/**
+	 * False if tuples of the format can't have such field:
+	 * the first path token is neither a field name nor an
+	 * index, or the path is invalid.
+	 */
+	bool is_resolved;
+	/** Top-level field number. */
+	uint32_t fieldno;
+	/**
+	 * Offset in @path of the JSON path within the top-level
+	 * field. Equal to @path_len if there is no such path.
+	 */
+	uint32_t subpath_offset;
+	/**
+	 * Offset slot of the field if it is indexed,
+	 * TUPLE_OFFSET_SLOT_NIL otherwise.
+	 */
+	int32_t offset_slot;
+};
+
 /**
  * @brief Tuple format
  * Tuple format describes how tuple is stored and information about its fields
@@ -193,6 +234,18 @@ struct tuple_format {
 	 * be shared with other ephemeral spaces.
 	 */
 	bool is_ephemeral;
+	/**
+	 * Compression of non-indexed fields of tuples of this
+	 * format, see tuple_compress_raw().
+	 */
+	enum compression_type compression;
+	/**
+	 * Offset slot of the dense extent with offsets of all
+	 * top-level fields, or TUPLE_OFFSET_SLOT_NIL if tuples
+	 * of this format don't have it.
+	 * \sa tuple_format_enable_dense_field_map()
+	 */
+	int32_t dense_field_map_slot;
 	/**
 	 * Size of minimal field map of tuple where each indexed
 	 * field has own offset slot (in bytes). The real tuple
@@ -241,6 +294,13 @@ struct tuple_format {
 	 * tuple_field::token.
 	 */
 	struct json_tree fields;
+	/**
+	 * Direct-mapped cache of accessors indexed by path hash,
+	 * allocated on demand. \sa tuple_format_accessor().
+	 */
+	struct tuple_accessor *accessors;
+	/** Version of @dict the accessors were resolved with. */
+	uint32_t accessors_dict_version;
 };
 
 /**
@@ -407,6 +467,37 @@ box_tuple_format_unref(box_tuple_format_t *format);
 
 /** \endcond public */
 
+/**
+ * Reserve an offset slot for the dense extent, so that
+ * tuple_field_map_create() records offsets of all top-level
+ * fields and tuple_field_raw() never has to walk MessagePack.
+ * Must be called before any tuple of the format is created.
+ *
+ * @retval  0 Success.
+ * @retval -1 The field map would be too big.
+ */
+int
+tuple_format_enable_dense_field_map(struct tuple_format *format);
+
+/**
+ * Find an accessor for a field name or a full JSON path in the
+ * format cache, resolving and caching it on a miss. The result
+ * is valid until the next call for the same format.
+ *
+ * @param format Tuple format.
+ * @param path Field name or full JSON path.
+ * @param path_len Length of @a path, must not be 0.
+ * @param path_hash Hash of @a path, the same as used by the
+ *                  format dictionary.
+ *
+ * @retval not NULL Accessor.
+ * @retval NULL The path is too long to be cached or memory
+ *              error. Use tuple_field_raw_by_full_path().
+ */
+const struct tuple_accessor *
+tuple_format_accessor(struct tuple_format *format, const char *path,
+		      uint32_t path_len, uint32_t path_hash);
+
 /**
  * Allocate a field map for the given tuple on the region.
  *
@@ -90,6 +90,12 @@ enum txn_flag {
 	 * example, when applier receives snapshot from master.
 	 */
 	TXN_FORCE_ASYNC,
+	/**
+	 * The transaction was started implicitly for a single
+	 * DML request, so no user code can look at its statements
+	 * between the request and the commit.
+	 */
+	TXN_IS_AUTOCOMMIT,
 };
 
 enum {
@@ -582,6 +582,16 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.compression != COMPRESSION_TYPE_NONE) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support compression");
+		return -1;
+	}
+	if (def->opts.dense_field_map) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support dense field map");
+		return -1;
+	}
 	return 0;
 }
 
@@ -675,6 +685,11 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			 "functional index");
 		return -1;
 	}
+	if (index_def->opts.normalized_key) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "normalized_key");
+		return -1;
+	}
 	return 0;
 }
 
@@ -4564,6 +4579,9 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .create_iterator = */ vinyl_index_create_iterator,
 	/* .create_snapshot_iterator = */
 		vinyl_index_create_snapshot_iterator,
+	/* .create_read_view_iterator = */
+		generic_index_create_read_view_iterator,
+	/* .aggregate = */ generic_index_aggregate,
 	/* .stat = */ vinyl_index_stat,
 	/* .compact = */ vinyl_index_compact,
 	/* .reset_stat = */ vinyl_index_reset_stat,
@@ -44,6 +44,7 @@
 #include "scramble.h"
 #include "iproto_constants.h"
 #include "mpstream/mpstream.h"
+#include "mp_scan.h"
 
 static_assert(IPROTO_DATA < 0x7f && IPROTO_METADATA < 0x7f &&
 	      IPROTO_SQL_INFO < 0x7f, "encoded IPROTO_BODY keys must fit into "\
@@ -137,7 +138,7 @@ xrow_header_decode(struct xrow_header *header, const char **pos,
 	memset(header, 0, sizeof(struct xrow_header));
 	const char *tmp = *pos;
 	const char * const start = *pos;
-	if (mp_check(&tmp, end) != 0) {
+	if (mp_scan_check(&tmp, end) != 0) {
 error:
 		xrow_on_decode_err(start, end, ER_INVALID_MSGPACK, "packet header");
 		return -1;
@@ -153,8 +154,11 @@ error:
 		if (mp_typeof(**pos) != MP_UINT)
 			goto error;
 		uint64_t key = mp_decode_uint(pos);
-		if (key >= IPROTO_KEY_MAX ||
-		    iproto_key_type[key] != mp_typeof(**pos))
+		if (key >= IPROTO_KEY_MAX)
+			goto error;
+		/* A whole number of seconds may come as MP_UINT. */
+		if (iproto_key_type[key] != mp_typeof(**pos) &&
+		    !(key == IPROTO_TIMEOUT && mp_typeof(**pos) == MP_UINT))
 			goto error;
 		switch (key) {
 		case IPROTO_REQUEST_TYPE:
@@ -186,6 +190,12 @@ error:
 			flags = mp_decode_uint(pos);
 			header->is_commit = flags & IPROTO_FLAG_COMMIT;
 			break;
+		case IPROTO_TIMEOUT:
+			if (mp_typeof(**pos) == MP_UINT)
+				header->timeout = mp_decode_uint(pos);
+			else
+				header->timeout = mp_decode_double(pos);
+			break;
 		default:
 			/* unknown header */
 			mp_next(pos);
@@ -205,7 +215,7 @@ error:
 	/* Nop requests aren't supposed to have a body. */
 	if (*pos < end && header->type != IPROTO_NOP) {
 		const char *body = *pos;
-		if (mp_check(pos, end)) {
+		if (mp_scan_check(pos, end)) {
 			xrow_on_decode_err(start, end, ER_INVALID_MSGPACK, "packet body");
 			return -1;
 		}
@@ -587,11 +597,19 @@ iproto_prepare_header(struct obuf *buf, struct obuf_svp *svp, size_t size)
 void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count)
+{
+	iproto_reply_select_ref(buf, svp, sync, schema_version, count, 0);
+}
+
+void
+iproto_reply_select_ref(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+			uint32_t schema_version, uint32_t count,
+			size_t ref_size)
 {
 	char *pos = (char *) obuf_svp_to_ptr(buf, svp);
 	iproto_header_encode(pos, IPROTO_OK, sync, schema_version,
 			        obuf_size(buf) - svp->used -
-				IPROTO_HEADER_LEN);
+				IPROTO_HEADER_LEN + ref_size);
 
 	struct iproto_body_bin body = iproto_body_bin;
 	body.v_data_len = mp_bswap_u32(count);
@@ -716,7 +734,7 @@ error:
 		}
 		uint64_t key = mp_decode_uint(&data);
 		const char *value = data;
-		if (mp_check(&data, end) ||
+		if (mp_scan_check(&data, end) ||
 		    key >= IPROTO_KEY_MAX ||
 		    iproto_key_type[key] != mp_typeof(*value))
 			goto error;
@@ -740,6 +758,9 @@ error:
 		case IPROTO_ITERATOR:
 			request->iterator = mp_decode_uint(&value);
 			break;
+		case IPROTO_CURSOR_ID:
+			request->cursor_id = mp_decode_uint(&value);
+			break;
 		case IPROTO_TUPLE:
 			request->tuple = value;
 			request->tuple_end = data;
@@ -1116,6 +1137,8 @@ error:
 
 	memset(request, 0, sizeof(*request));
 	request->header = row;
+	bool has_func_id = false;
+	uint64_t func_id;
 
 	uint32_t map_size = mp_decode_map(&data);
 	for (uint32_t i = 0; i < map_size; ++i) {
@@ -1133,6 +1156,15 @@ error:
 				goto error;
 			request->name = value;
 			break;
+		case IPROTO_FUNCTION_ID:
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			func_id = mp_decode_uint(&value);
+			if (func_id > UINT32_MAX)
+				goto error;
+			request->func_id = func_id;
+			has_func_id = true;
+			break;
 		case IPROTO_EXPR:
 			if (mp_typeof(*value) != MP_STR)
 				goto error;
@@ -1159,9 +1191,11 @@ error:
 					   iproto_key_name(IPROTO_EXPR));
 			return -1;
 		}
-	} else if (request->name == NULL) {
+	} else if (request->name == NULL &&
+		   (!has_func_id || row->type == IPROTO_PREPARE_CALL)) {
 		assert(row->type == IPROTO_CALL_16 ||
-		       row->type == IPROTO_CALL);
+		       row->type == IPROTO_CALL ||
+		       row->type == IPROTO_PREPARE_CALL);
 		xrow_on_decode_err(row->body[0].iov_base, end, ER_MISSING_REQUEST_FIELD,
 				   iproto_key_name(IPROTO_FUNCTION_NAME));
 		return -1;
@@ -1456,11 +1490,14 @@ xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
 		      const struct vclock *vclock, bool anon,
-		      uint32_t id_filter)
+		      uint32_t id_filter, const uint32_t *space_filter,
+		      uint32_t space_filter_size)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX +
-		      mp_sizeof_vclock_ignore0(vclock);
+		      mp_sizeof_vclock_ignore0(vclock) +
+		      mp_sizeof_array(space_filter_size) +
+		      space_filter_size * mp_sizeof_uint(UINT32_MAX);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
@@ -1468,7 +1505,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 	}
 	char *data = buf;
 	int filter_size = bit_count_u32(id_filter);
-	data = mp_encode_map(data, filter_size != 0 ? 6 : 5);
+	data = mp_encode_map(data, 5 + (filter_size != 0) +
+				   (space_filter_size != 0));
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1490,6 +1528,12 @@ xrow_encode_subscribe(struct xrow_header *row,
 			data = mp_encode_uint(data, id);
 		}
 	}
+	if (space_filter_size != 0) {
+		data = mp_encode_uint(data, IPROTO_SPACE_FILTER);
+		data = mp_encode_array(data, space_filter_size);
+		for (uint32_t i = 0; i < space_filter_size; i++)
+			data = mp_encode_uint(data, space_filter[i]);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1502,7 +1546,8 @@ int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
 		      uint32_t *version_id, bool *anon,
-		      uint32_t *id_filter)
+		      uint32_t *id_filter, uint32_t **space_filter,
+		      uint32_t *space_filter_size)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1522,6 +1567,10 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		*anon = false;
 	if (id_filter)
 		*id_filter = 0;
+	if (space_filter != NULL) {
+		*space_filter = NULL;
+		*space_filter_size = 0;
+	}
 	d = data;
 	uint32_t map_size = mp_decode_map(&d);
 	for (uint32_t i = 0; i < map_size; i++) {
@@ -1597,6 +1646,35 @@ id_filter_decode_err:		xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
 				*id_filter |= 1 << val;
 			}
 			break;
+		case IPROTO_SPACE_FILTER:
+			if (space_filter == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_ARRAY) {
+space_filter_decode_err:	xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid SPACE_FILTER");
+				return -1;
+			}
+			uint32_t count = mp_decode_array(&d);
+			size_t size;
+			uint32_t *ids = region_alloc_array(&fiber()->gc,
+							   typeof(ids[0]),
+							   count, &size);
+			if (ids == NULL) {
+				diag_set(OutOfMemory, size,
+					 "region_alloc_array", "ids");
+				return -1;
+			}
+			for (uint32_t i = 0; i < count; ++i) {
+				if (mp_typeof(*d) != MP_UINT)
+					goto space_filter_decode_err;
+				uint64_t val = mp_decode_uint(&d);
+				if (val > UINT32_MAX)
+					goto space_filter_decode_err;
+				ids[i] = val;
+			}
+			*space_filter = ids;
+			*space_filter_size = count;
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -88,6 +88,11 @@ struct xrow_header {
 	 * tsn and is_commit flag to save space.
 	 */
 	bool is_commit;
+	/**
+	 * Time the client waits for the response to a request,
+	 * 0 if not set. Is not written to WAL.
+	 */
+	double timeout;
 
 	int bodycnt;
 	uint32_t schema_version;
@@ -174,6 +179,8 @@ struct request {
 	const char *tuple_meta_end;
 	/** Base field offset for UPDATE/UPSERT, e.g. 0 for C and 1 for Lua. */
 	int index_base;
+	/** Server-side cursor id, see IPROTO_CURSOR_FETCH. */
+	uint32_t cursor_id;
 };
 
 /**
@@ -285,8 +292,13 @@ xrow_decode_raft(const struct xrow_header *row, struct raft_request *r,
 struct call_request {
 	/** Request header */
 	const struct xrow_header *header;
-	/** Function name for CALL request. MessagePack String. */
+	/**
+	 * Function name for CALL request. MessagePack String.
+	 * NULL if the function is called by func_id.
+	 */
 	const char *name;
+	/** Function id for CALL request, see IPROTO_FUNCTION_ID. */
+	uint32_t func_id;
 	/** Expression for EVAL request. MessagePack String. */
 	const char *expr;
 	/** CALL/EVAL parameters. MessagePack Array. */
@@ -401,6 +413,10 @@ xrow_encode_register(struct xrow_header *row,
  * @param anon Whether it is an anonymous subscribe request or not.
  * @param id_filter A List of replica ids to skip rows from
  *		    when feeding a replica.
+ * @param space_filter A list of space ids to feed the replica
+ *		       with. Rows of other user spaces are replaced
+ *		       with NOPs. Not sent if empty.
+ * @param space_filter_size Number of ids in @a space_filter.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -410,7 +426,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
 		      const struct vclock *vclock, bool anon,
-		      uint32_t id_filter);
+		      uint32_t id_filter, const uint32_t *space_filter,
+		      uint32_t space_filter_size);
 
 /**
  * Decode SUBSCRIBE command.
@@ -422,6 +439,10 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] anon Whether it is an anonymous subscribe.
  * @param[out] id_filter A list of ids to skip rows from when
  *			 feeding a replica.
+ * @param[out] space_filter A list of space ids to feed the
+ *			    replica with. Allocated on the fiber
+ *			    region. NULL if there is no filter.
+ * @param[out] space_filter_size Number of ids in @a space_filter.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -430,7 +451,8 @@ int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
 		      uint32_t *version_id, bool *anon,
-		      uint32_t *id_filter);
+		      uint32_t *id_filter, uint32_t **space_filter,
+		      uint32_t *space_filter_size);
 
 /**
  * Encode JOIN command.
@@ -594,6 +616,16 @@ void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t schema_version, uint32_t count);
 
+/**
+ * Same as iproto_reply_select(), but @a ref_size bytes of the
+ * body are not in the buffer and are sent to the socket apart
+ * from it.
+ */
+void
+iproto_reply_select_ref(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+			uint32_t schema_version, uint32_t count,
+			size_t ref_size);
+
 /**
  * Encode iproto header with IPROTO_OK response code.
  * @param out Encode to.
@@ -904,10 +936,12 @@ xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
 			 const struct vclock *vclock, bool anon,
-			 uint32_t id_filter)
+			 uint32_t id_filter, const uint32_t *space_filter,
+			 uint32_t space_filter_size)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, anon, id_filter) != 0)
+				  vclock, anon, id_filter, space_filter,
+				  space_filter_size) != 0)
 		diag_raise();
 }
 
@@ -917,11 +951,13 @@ xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 			 struct tt_uuid *instance_uuid, struct vclock *vclock,
 			 uint32_t *replica_version_id, bool *anon,
-			 uint32_t *id_filter)
+			 uint32_t *id_filter, uint32_t **space_filter,
+			 uint32_t *space_filter_size)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
 				  vclock, replica_version_id, anon,
-				  id_filter) != 0)
+				  id_filter, space_filter,
+				  space_filter_size) != 0)
 		diag_raise();
 }
 
@@ -114,6 +114,33 @@ sse42_enabled_cpu()
 	return (cx & (1 << 20)) != 0;
 }
 
+bool
+avx2_enabled_cpu()
+{
+	unsigned int ax, bx, cx, dx;
+
+	if (__get_cpuid(1, &ax, &bx, &cx, &dx) == 0)
+		return false;
+	/* The OS must enable XSAVE to preserve YMM registers. */
+	if ((cx & (1 << 27)) == 0)
+		return false;
+	unsigned int xcr0_lo, xcr0_hi;
+	/* xgetbv */
+	__asm__ __volatile__(
+		".byte 0x0f, 0x01, 0xd0"
+		:"=a"(xcr0_lo), "=d"(xcr0_hi)
+		:"c"(0)
+	);
+	(void)xcr0_hi;
+	/* XMM and YMM state must be enabled. */
+	if ((xcr0_lo & 0x6) != 0x6)
+		return false;
+	if (__get_cpuid_max(0, NULL) < 7)
+		return false;
+	__cpuid_count(7, 0, ax, bx, cx, dx);
+	return (bx & (1 << 5)) != 0;
+}
+
 #else /* !(defined (__x86_64__) || defined (__i386__)) */
 
 bool
@@ -122,4 +149,10 @@ sse42_enabled_cpu()
 	return false;
 }
 
+bool
+avx2_enabled_cpu()
+{
+	return false;
+}
+
 #endif
@@ -88,6 +88,11 @@ struct cmsg {
 	const struct cmsg_hop *route;
 	/** The current hop the message is at. */
 	const struct cmsg_hop *hop;
+	/**
+	 * Time when the message was fetched by a fiber pool,
+	 * used to account the time it waits for a worker fiber.
+	 */
+	double fetch_time;
 };
 
 static inline struct cmsg *cmsg(void *ptr) { return (struct cmsg *) ptr; }
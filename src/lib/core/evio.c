@@ -149,9 +149,18 @@ evio_setsockopt_server(int fd, int family, int type)
 		       &linger, sizeof(linger)))
 		return -1;
 #endif
-	if (type == SOCK_STREAM && family != AF_UNIX &&
-	    evio_setsockopt_keepalive(fd) != 0)
-		return -1;
+	if (type == SOCK_STREAM && family != AF_UNIX) {
+		if (evio_setsockopt_keepalive(fd) != 0)
+			return -1;
+		/*
+		 * Not used by the listening socket itself, but
+		 * inherited by accepted ones on Linux, see
+		 * evio_service_accept_cb().
+		 */
+		if (sio_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY,
+				   &on, sizeof(on)))
+			return -1;
+	}
 	return 0;
 }
 
@@ -181,17 +190,25 @@ evio_service_accept_cb(ev_loop *loop, ev_io *watcher, int events)
 		 */
 		struct sockaddr_storage addr;
 		socklen_t addrlen = sizeof(addr);
-		fd = sio_accept(service->ev.fd, (struct sockaddr *)&addr,
-				&addrlen);
+		fd = sio_accept_nonblock(service->ev.fd,
+					 (struct sockaddr *)&addr, &addrlen);
 
 		if (fd < 0) {
 			if (! sio_wouldblock(errno))
 				break;
 			return;
 		}
+		/*
+		 * On Linux an accepted socket inherits keepalive
+		 * and TCP_NODELAY from the listening one, see
+		 * evio_setsockopt_server(), so a connection costs
+		 * one accept4() instead of eight syscalls.
+		 */
+#ifndef __linux__
 		if (evio_setsockopt_client(fd, service->addr.sa_family,
 					   SOCK_STREAM) != 0)
 			break;
+#endif
 		if (service->on_accept(service, fd, (struct sockaddr *)&addr,
 				       addrlen) != 0)
 			break;
@@ -29,6 +29,100 @@
  * SUCH DAMAGE.
  */
 #include "fiber_pool.h"
+
+#include <string.h>
+
+/** Return the class of a message. */
+static inline struct fiber_pool_class *
+fiber_pool_class_of(struct fiber_pool *pool, struct cmsg *msg)
+{
+	int cls = pool->classify != NULL ? pool->classify(msg) : 0;
+	assert(cls >= 0 && cls < pool->class_count);
+	return &pool->classes[cls];
+}
+
+/** Check if a worker fiber may take a message of the class. */
+static inline bool
+fiber_pool_class_is_ready(struct fiber_pool_class *cls)
+{
+	return cls->queue_size > 0 &&
+	       (cls->max_size == 0 || cls->size < cls->max_size);
+}
+
+/** Check if there is a message a worker fiber may take. */
+static bool
+fiber_pool_has_ready(struct fiber_pool *pool)
+{
+	if (!pool->use_classes)
+		return !stailq_empty(&pool->output);
+	for (int i = 0; i < pool->class_count; i++) {
+		if (fiber_pool_class_is_ready(&pool->classes[i]))
+			return true;
+	}
+	return false;
+}
+
+/** Account a message taken by a worker fiber. */
+static void
+fiber_pool_class_collect(struct fiber_pool *pool, struct fiber_pool_class *cls,
+			 struct cmsg *msg)
+{
+	double queue_time = ev_monotonic_now(pool->consumer) - msg->fetch_time;
+	double limit = 1e-6;
+	int bucket = 0;
+	while (bucket < FIBER_POOL_QUEUE_TIME_BUCKETS - 1 &&
+	       queue_time >= limit) {
+		bucket++;
+		limit *= 2;
+	}
+	cls->queue_time[bucket]++;
+	cls->total++;
+	cls->size++;
+}
+
+/**
+ * Take the next message to work on. When classes are in use,
+ * the class is chosen by smooth weighted round robin among the
+ * classes which have messages and are below their limit: each
+ * of them gains its weight, and the one with the biggest gain
+ * pays back the sum of the weights.
+ *
+ * @param[out] p_cls The class of the message.
+ * @retval NULL There is nothing to work on.
+ */
+static struct cmsg *
+fiber_pool_shift(struct fiber_pool *pool, struct fiber_pool_class **p_cls)
+{
+	struct fiber_pool_class *cls;
+	struct cmsg *msg;
+	if (!pool->use_classes) {
+		if (stailq_empty(&pool->output))
+			return NULL;
+		msg = stailq_shift_entry(&pool->output, struct cmsg, fifo);
+		cls = fiber_pool_class_of(pool, msg);
+	} else {
+		cls = NULL;
+		int total_weight = 0;
+		for (int i = 0; i < pool->class_count; i++) {
+			struct fiber_pool_class *c = &pool->classes[i];
+			if (!fiber_pool_class_is_ready(c))
+				continue;
+			c->current_weight += c->weight;
+			total_weight += c->weight;
+			if (cls == NULL || c->current_weight > cls->current_weight)
+				cls = c;
+		}
+		if (cls == NULL)
+			return NULL;
+		cls->current_weight -= total_weight;
+		msg = stailq_shift_entry(&cls->queue, struct cmsg, fifo);
+		cls->queue_size--;
+	}
+	fiber_pool_class_collect(pool, cls, msg);
+	*p_cls = cls;
+	return msg;
+}
+
 /**
  * Main function of the fiber invoked to handle all outstanding
  * tasks in a queue.
@@ -40,16 +134,17 @@ fiber_pool_f(va_list ap)
 	struct cord *cord = cord();
 	struct fiber *f = fiber();
 	struct ev_loop *loop = pool->consumer;
-	struct stailq *output = &pool->output;
+	struct fiber_pool_class *cls;
 	struct cmsg *msg;
+	bool is_active;
 	ev_tstamp last_active_at = ev_monotonic_now(loop);
 	pool->size++;
 restart:
-	msg = NULL;
-	while (!stailq_empty(output) && !fiber_is_cancelled()) {
-		 msg = stailq_shift_entry(output, struct cmsg, fifo);
-
-		if (f->caller == &cord->sched && ! stailq_empty(output) &&
+	is_active = false;
+	while (!fiber_is_cancelled() &&
+	       (msg = fiber_pool_shift(pool, &cls)) != NULL) {
+		is_active = true;
+		if (f->caller == &cord->sched && fiber_pool_has_ready(pool) &&
 		    ! rlist_empty(&pool->idle)) {
 			/*
 			 * Activate a "backup" fiber for the next
@@ -72,11 +167,13 @@ restart:
 		 * visible lifecycle.
 		 */
 		fiber_on_stop(f);
+		/* The message may be gone, but not its class. */
+		cls->size--;
 	}
 	/** Put the current fiber into a fiber cache. */
-	if (!fiber_is_cancelled() && (msg != NULL ||
+	if (!fiber_is_cancelled() && (is_active ||
 	    ev_monotonic_now(loop) - last_active_at < pool->idle_timeout)) {
-		if (msg != NULL)
+		if (is_active)
 			last_active_at = ev_monotonic_now(loop);
 		/*
 		 * Add the fiber to the front of the list, so that
@@ -118,10 +215,28 @@ fiber_pool_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
 	(void) events;
 	struct fiber_pool *pool = (struct fiber_pool *) watcher->data;
 	/** Fetch messages */
-	cbus_endpoint_fetch(&pool->endpoint, &pool->output);
+	struct stailq fetched;
+	stailq_create(&fetched);
+	cbus_endpoint_fetch(&pool->endpoint, &fetched);
+
+	double now = ev_monotonic_now(pool->consumer);
+	struct cmsg *msg;
+	if (!pool->use_classes) {
+		stailq_foreach_entry(msg, &fetched, fifo)
+			msg->fetch_time = now;
+		stailq_concat(&pool->output, &fetched);
+	} else {
+		while (!stailq_empty(&fetched)) {
+			msg = stailq_shift_entry(&fetched, struct cmsg, fifo);
+			msg->fetch_time = now;
+			struct fiber_pool_class *cls =
+				fiber_pool_class_of(pool, msg);
+			stailq_add_tail_entry(&cls->queue, msg, fifo);
+			cls->queue_size++;
+		}
+	}
 
-	struct stailq *output = &pool->output;
-	while (! stailq_empty(output)) {
+	while (fiber_pool_has_ready(pool)) {
 		struct fiber *f;
 		if (! rlist_empty(&pool->idle)) {
 			f = rlist_shift_entry(&pool->idle, struct fiber, state);
@@ -152,6 +267,98 @@ fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size)
 	pool->max_size = new_max_size;
 }
 
+/**
+ * Make the pool look for messages to work on in the next event
+ * loop iteration, after its classes are changed.
+ */
+static void
+fiber_pool_schedule(struct fiber_pool *pool)
+{
+	ev_feed_event(pool->consumer, &pool->endpoint.async, EV_CUSTOM);
+}
+
+void
+fiber_pool_set_classifier(struct fiber_pool *pool, int class_count,
+			  fiber_pool_classify_f classify)
+{
+	assert(class_count > 0 && class_count <= FIBER_POOL_CLASS_MAX);
+	/* Classes may not be changed while messages are queued. */
+	assert(!pool->use_classes);
+	pool->classify = classify;
+	pool->class_count = class_count;
+	for (int i = 0; i < class_count; i++) {
+		pool->classes[i].weight = 1;
+		pool->classes[i].max_size = 0;
+	}
+}
+
+void
+fiber_pool_set_class(struct fiber_pool *pool, int cls, int weight,
+		     int max_size)
+{
+	assert(cls >= 0 && cls < pool->class_count);
+	assert(weight > 0 && max_size >= 0);
+	pool->classes[cls].weight = weight;
+	pool->classes[cls].max_size = max_size;
+	if (pool->use_classes)
+		fiber_pool_schedule(pool);
+}
+
+void
+fiber_pool_use_classes(struct fiber_pool *pool, bool use_classes)
+{
+	if (pool->use_classes == use_classes)
+		return;
+	pool->use_classes = use_classes;
+	if (use_classes) {
+		while (!stailq_empty(&pool->output)) {
+			struct cmsg *msg = stailq_shift_entry(&pool->output,
+							      struct cmsg, fifo);
+			struct fiber_pool_class *cls =
+				fiber_pool_class_of(pool, msg);
+			stailq_add_tail_entry(&cls->queue, msg, fifo);
+			cls->queue_size++;
+		}
+		return;
+	}
+	/*
+	 * The queued messages are handled class by class, the
+	 * order they arrived in is lost.
+	 */
+	for (int i = 0; i < pool->class_count; i++) {
+		struct fiber_pool_class *cls = &pool->classes[i];
+		stailq_concat(&pool->output, &cls->queue);
+		cls->queue_size = 0;
+		cls->current_weight = 0;
+	}
+	fiber_pool_schedule(pool);
+}
+
+double
+fiber_pool_class_queue_time(struct fiber_pool_class *cls, int pct)
+{
+	uint64_t count = cls->total * pct / 100;
+	uint64_t seen = 0;
+	double limit = 1e-6;
+	for (int i = 0; i < FIBER_POOL_QUEUE_TIME_BUCKETS - 1; i++) {
+		seen += cls->queue_time[i];
+		if (seen > count || seen == cls->total)
+			return limit;
+		limit *= 2;
+	}
+	return limit;
+}
+
+void
+fiber_pool_reset_stat(struct fiber_pool *pool)
+{
+	for (int i = 0; i < pool->class_count; i++) {
+		struct fiber_pool_class *cls = &pool->classes[i];
+		cls->total = 0;
+		memset(cls->queue_time, 0, sizeof(cls->queue_time));
+	}
+}
+
 void
 fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 		  float idle_timeout)
@@ -167,6 +374,14 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 	pool->max_size = max_pool_size;
 	stailq_create(&pool->output);
 	fiber_cond_create(&pool->worker_cond);
+	pool->classify = NULL;
+	pool->use_classes = false;
+	for (int i = 0; i < FIBER_POOL_CLASS_MAX; i++) {
+		struct fiber_pool_class *cls = &pool->classes[i];
+		memset(cls, 0, sizeof(*cls));
+		stailq_create(&cls->queue);
+	}
+	fiber_pool_set_classifier(pool, 1, NULL);
 	/* Join fiber pool to cbus */
 	cbus_endpoint_create(&pool->endpoint, name, fiber_pool_cb, pool);
 }
@@ -44,6 +44,51 @@ extern "C" {
 /** Period after which an idle fiber in the pool is shut down. */
 enum { FIBER_POOL_IDLE_TIMEOUT = 1 };
 
+enum {
+	/** The maximal number of message classes in a pool. */
+	FIBER_POOL_CLASS_MAX = 8,
+	/**
+	 * Number of buckets of the queue time histogram of a
+	 * class. Bucket i counts messages which waited for less
+	 * than 2^i microseconds, the last one counts the rest.
+	 */
+	FIBER_POOL_QUEUE_TIME_BUCKETS = 24,
+};
+
+/**
+ * Return the class of a message, a number less than the
+ * class count of the pool.
+ */
+typedef int (*fiber_pool_classify_f)(struct cmsg *msg);
+
+/**
+ * A class of messages in a fiber pool. When classes are in use,
+ * each class has its own queue, and a free worker fiber takes a
+ * message of the class chosen by weighted round robin among the
+ * classes which have messages and are below their limit.
+ */
+struct fiber_pool_class {
+	/** Messages of the class waiting for a worker fiber. */
+	struct stailq queue;
+	/** Number of messages in the queue. */
+	int queue_size;
+	/** Share of worker fibers the class gets, >= 1. */
+	int weight;
+	/**
+	 * The limit on the number of fibers working on messages
+	 * of the class, 0 means no limit.
+	 */
+	int max_size;
+	/** Number of fibers working on messages of the class. */
+	int size;
+	/** Current priority for the smooth weighted round robin. */
+	int current_weight;
+	/** Number of messages of the class handled so far. */
+	uint64_t total;
+	/** Histogram of the time messages wait for a worker. */
+	uint64_t queue_time[FIBER_POOL_QUEUE_TIME_BUCKETS];
+};
+
 /**
  * A pool of worker fibers to handle messages,
  * so that each message is handled in its own fiber.
@@ -67,6 +112,19 @@ struct fiber_pool {
 		struct ev_timer idle_timer;
 		/** Condition for worker exit signaling */
 		struct fiber_cond worker_cond;
+		/** Message classifier, NULL if there is one class. */
+		fiber_pool_classify_f classify;
+		/** Number of message classes. */
+		int class_count;
+		/**
+		 * If set, messages are queued and scheduled by
+		 * classes, otherwise all of them are handled in
+		 * the order they arrive via the output queue and
+		 * classes are only used for statistics.
+		 */
+		bool use_classes;
+		/** Message classes. */
+		struct fiber_pool_class classes[FIBER_POOL_CLASS_MAX];
 	};
 	struct {
 		/** The consumer thread loop. */
@@ -92,6 +150,48 @@ fiber_pool_create(struct fiber_pool *pool, const char *name, int max_pool_size,
 void
 fiber_pool_set_max_size(struct fiber_pool *pool, int new_max_size);
 
+/**
+ * Set the message classifier of a fiber pool. All classes get
+ * weight 1 and no limit.
+ * @param pool Fiber pool.
+ * @param class_count Number of classes, <= FIBER_POOL_CLASS_MAX.
+ * @param classify Function returning the class of a message.
+ */
+void
+fiber_pool_set_classifier(struct fiber_pool *pool, int class_count,
+			  fiber_pool_classify_f classify);
+
+/**
+ * Set the weight and the limit on the number of fibers of a
+ * message class.
+ */
+void
+fiber_pool_set_class(struct fiber_pool *pool, int cls, int weight,
+		     int max_size);
+
+/**
+ * Turn scheduling by message classes on or off. When turned off
+ * messages are handled in the order they arrive. Messages of
+ * different classes may be started out of their arrival order
+ * when it is on.
+ */
+void
+fiber_pool_use_classes(struct fiber_pool *pool, bool use_classes);
+
+/**
+ * Return the upper bound of the @a pct-th percentile of the
+ * time messages of a class waited for a worker fiber, in
+ * seconds.
+ */
+double
+fiber_pool_class_queue_time(struct fiber_pool_class *cls, int pct);
+
+/**
+ * Reset statistics of message classes.
+ */
+void
+fiber_pool_reset_stat(struct fiber_pool *pool);
+
 /**
  * Destroy a fiber pool
  */
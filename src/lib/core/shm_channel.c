@@ -0,0 +1,330 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "shm_channel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(HAVE_EVENTFD)
+#include <sys/eventfd.h>
+#endif
+#include <pmatomic.h>
+
+#include "diag.h"
+#include "say.h"
+
+static_assert(sizeof(struct shm_channel_header) <= CACHELINE_SIZE,
+	      "the channel header fits in a cache line");
+
+/** Offset of a ring in the channel memory. */
+static inline size_t
+shm_channel_ring_offset(uint32_t ring_size, int ringno)
+{
+	return CACHELINE_SIZE + ringno * (sizeof(struct shm_ring) + ring_size);
+}
+
+/** Check if the ring size keeps the rings aligned. */
+static inline bool
+shm_channel_ring_size_is_valid(uint32_t ring_size)
+{
+	return ring_size >= CACHELINE_SIZE &&
+	       (ring_size & (ring_size - 1)) == 0;
+}
+
+/** Set the process local part of a mapped channel. */
+static void
+shm_channel_set(struct shm_channel *channel, void *map, uint32_t ring_size,
+		bool is_server)
+{
+	channel->map = map;
+	channel->map_size = shm_channel_ring_offset(ring_size, 2);
+	channel->header = (struct shm_channel_header *)map;
+	channel->ring_size = ring_size;
+	struct shm_ring *rings[2] = {
+		/* Requests: written by the client. */
+		(struct shm_ring *)((char *)map +
+				    shm_channel_ring_offset(ring_size, 0)),
+		/* Responses: written by the server. */
+		(struct shm_ring *)((char *)map +
+				    shm_channel_ring_offset(ring_size, 1)),
+	};
+	channel->in = rings[!is_server];
+	channel->out = rings[is_server];
+}
+
+int
+shm_channel_create(struct shm_channel *channel, uint32_t ring_size, int *fd)
+{
+	assert(shm_channel_ring_size_is_valid(ring_size));
+#if defined(HAVE_MEMFD_CREATE)
+	size_t size = shm_channel_ring_offset(ring_size, 2);
+	*fd = memfd_create("tarantool_shm_channel", MFD_CLOEXEC);
+	if (*fd < 0) {
+		diag_set(SystemError, "failed to create shared memory");
+		return -1;
+	}
+	if (ftruncate(*fd, size) != 0) {
+		diag_set(SystemError, "failed to allocate %zu bytes of "
+			 "shared memory", size);
+		goto fail;
+	}
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			 *fd, 0);
+	if (map == MAP_FAILED) {
+		diag_set(SystemError, "failed to map shared memory");
+		goto fail;
+	}
+	/* The file is zero-filled, rings are empty. */
+	struct shm_channel_header *header = (struct shm_channel_header *)map;
+	header->magic = SHM_CHANNEL_MAGIC;
+	header->version = SHM_CHANNEL_VERSION;
+	header->ring_size = ring_size;
+	shm_channel_set(channel, map, ring_size, true);
+	return 0;
+fail:
+	close(*fd);
+	*fd = -1;
+	return -1;
+#else
+	(void)channel;
+	(void)ring_size;
+	*fd = -1;
+	errno = ENOTSUP;
+	diag_set(SystemError, "shared memory channels are not supported");
+	return -1;
+#endif
+}
+
+int
+shm_channel_attach(struct shm_channel *channel, int fd)
+{
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		diag_set(SystemError, "failed to stat shared memory");
+		return -1;
+	}
+	if ((size_t)st.st_size < shm_channel_ring_offset(CACHELINE_SIZE, 2)) {
+		diag_set(IllegalParams, "invalid shared memory channel");
+		return -1;
+	}
+	void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		diag_set(SystemError, "failed to map shared memory");
+		return -1;
+	}
+	struct shm_channel_header *header = (struct shm_channel_header *)map;
+	uint32_t ring_size = header->ring_size;
+	if (header->magic != SHM_CHANNEL_MAGIC ||
+	    header->version != SHM_CHANNEL_VERSION ||
+	    !shm_channel_ring_size_is_valid(ring_size) ||
+	    shm_channel_ring_offset(ring_size, 2) != (size_t)st.st_size) {
+		munmap(map, st.st_size);
+		diag_set(IllegalParams, "invalid shared memory channel");
+		return -1;
+	}
+	shm_channel_set(channel, map, ring_size, false);
+	return 0;
+}
+
+void
+shm_channel_destroy(struct shm_channel *channel)
+{
+	if (munmap(channel->map, channel->map_size) != 0)
+		say_syserror("munmap");
+	TRASH(channel);
+}
+
+void
+shm_channel_close(struct shm_channel *channel)
+{
+	pm_atomic_store(&channel->header->is_closed, 1);
+}
+
+bool
+shm_channel_is_closed(struct shm_channel *channel)
+{
+	return pm_atomic_load(&channel->header->is_closed) != 0;
+}
+
+/** Number of bytes in a ring, capped by the ring size. */
+static inline size_t
+shm_ring_used(struct shm_ring *ring, uint32_t ring_size)
+{
+	uint64_t wpos = pm_atomic_load_explicit(&ring->wpos,
+						pm_memory_order_acquire);
+	uint64_t rpos = pm_atomic_load_explicit(&ring->rpos,
+						pm_memory_order_acquire);
+	return MIN(wpos - rpos, (uint64_t)ring_size);
+}
+
+size_t
+shm_channel_used(struct shm_channel *channel)
+{
+	return shm_ring_used(channel->in, channel->ring_size);
+}
+
+size_t
+shm_channel_unused(struct shm_channel *channel)
+{
+	return channel->ring_size -
+	       shm_ring_used(channel->out, channel->ring_size);
+}
+
+size_t
+shm_channel_read(struct shm_channel *channel, void *buf, size_t size)
+{
+	struct shm_ring *ring = channel->in;
+	uint32_t ring_size = channel->ring_size;
+	uint64_t rpos = pm_atomic_load_explicit(&ring->rpos,
+						pm_memory_order_relaxed);
+	size = MIN(size, shm_ring_used(ring, ring_size));
+	if (size == 0)
+		return 0;
+	size_t offset = rpos & (ring_size - 1);
+	size_t chunk = MIN(size, ring_size - offset);
+	memcpy(buf, ring->data + offset, chunk);
+	memcpy((char *)buf + chunk, ring->data, size - chunk);
+	pm_atomic_store_explicit(&ring->rpos, rpos + size,
+				 pm_memory_order_release);
+	return size;
+}
+
+size_t
+shm_channel_writev(struct shm_channel *channel, const struct iovec *iov,
+		   int iovcnt)
+{
+	struct shm_ring *ring = channel->out;
+	uint32_t ring_size = channel->ring_size;
+	uint64_t wpos = pm_atomic_load_explicit(&ring->wpos,
+						pm_memory_order_relaxed);
+	size_t unused = ring_size - shm_ring_used(ring, ring_size);
+	size_t total = 0;
+	for (int i = 0; i < iovcnt && unused > 0; i++) {
+		size_t size = MIN(iov[i].iov_len, unused);
+		size_t offset = (wpos + total) & (ring_size - 1);
+		size_t chunk = MIN(size, ring_size - offset);
+		memcpy(ring->data + offset, iov[i].iov_base, chunk);
+		memcpy(ring->data, (char *)iov[i].iov_base + chunk,
+		       size - chunk);
+		total += size;
+		unused -= size;
+	}
+	if (total > 0) {
+		pm_atomic_store_explicit(&ring->wpos, wpos + total,
+					 pm_memory_order_release);
+	}
+	return total;
+}
+
+/*
+ * A side going to sleep sets its flag and then checks the ring,
+ * while the peer moves data and then checks the flag. Full
+ * fences between the two operations on both sides guarantee
+ * either the sleeping side sees the data or the peer sees the
+ * flag, so a wakeup is never lost.
+ */
+
+bool
+shm_channel_prepare_read_wait(struct shm_channel *channel)
+{
+	struct shm_ring *ring = channel->in;
+	pm_atomic_store_explicit(&ring->reader_waits, 1,
+				 pm_memory_order_relaxed);
+	pm_atomic_thread_fence(pm_memory_order_seq_cst);
+	return shm_ring_used(ring, channel->ring_size) == 0;
+}
+
+bool
+shm_channel_prepare_write_wait(struct shm_channel *channel, size_t size)
+{
+	struct shm_ring *ring = channel->out;
+	pm_atomic_store_explicit(&ring->writer_waits, 1,
+				 pm_memory_order_relaxed);
+	pm_atomic_thread_fence(pm_memory_order_seq_cst);
+	size = MIN(size, (size_t)channel->ring_size);
+	return shm_channel_unused(channel) < size;
+}
+
+bool
+shm_channel_peer_waits_data(struct shm_channel *channel)
+{
+	struct shm_ring *ring = channel->out;
+	pm_atomic_thread_fence(pm_memory_order_seq_cst);
+	if (pm_atomic_load_explicit(&ring->reader_waits,
+				    pm_memory_order_relaxed) == 0)
+		return false;
+	return pm_atomic_exchange(&ring->reader_waits, 0) != 0;
+}
+
+bool
+shm_channel_peer_waits_space(struct shm_channel *channel)
+{
+	struct shm_ring *ring = channel->in;
+	pm_atomic_thread_fence(pm_memory_order_seq_cst);
+	if (pm_atomic_load_explicit(&ring->writer_waits,
+				    pm_memory_order_relaxed) == 0)
+		return false;
+	return pm_atomic_exchange(&ring->writer_waits, 0) != 0;
+}
+
+int
+shm_notify_create(void)
+{
+#if defined(HAVE_EVENTFD)
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0)
+		diag_set(SystemError, "failed to create eventfd");
+	return fd;
+#else
+	errno = ENOTSUP;
+	diag_set(SystemError, "shared memory channels are not supported");
+	return -1;
+#endif
+}
+
+void
+shm_notify_signal(int fd)
+{
+	uint64_t value = 1;
+	ssize_t unused = write(fd, &value, sizeof(value));
+	(void)unused;
+}
+
+void
+shm_notify_clear(int fd)
+{
+	uint64_t value;
+	ssize_t unused = read(fd, &value, sizeof(value));
+	(void)unused;
+}
@@ -0,0 +1,233 @@
+#ifndef TARANTOOL_LIB_CORE_SHM_CHANNEL_H_INCLUDED
+#define TARANTOOL_LIB_CORE_SHM_CHANNEL_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "trivia/util.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * A shared memory channel connects two processes on the same
+ * host with a pair of byte rings, one per direction. Each ring
+ * has one writer and one reader, so it needs no locks: the
+ * writer only advances the write position, the reader only
+ * advances the read position.
+ *
+ * The channel doesn't wake up the peer by itself. A side which
+ * finds its input ring empty (or output ring full) announces it
+ * is going to sleep with shm_channel_prepare_read_wait()
+ * (shm_channel_prepare_write_wait()) and waits for a
+ * notification, see shm_notify_create(). The peer checks with
+ * shm_channel_peer_waits_data() (shm_channel_peer_waits_space())
+ * after moving data whether it has to notify.
+ *
+ * The memory is shared with another process, so nothing read
+ * from it is trusted: ring bounds are kept in the process
+ * local part of the channel.
+ */
+
+enum {
+	/** "TSHM" */
+	SHM_CHANNEL_MAGIC = 0x4d485354,
+	SHM_CHANNEL_VERSION = 1,
+	/** Default size of a channel ring. */
+	SHM_CHANNEL_RING_SIZE = 1024 * 1024,
+};
+
+/** Single producer single consumer byte ring. */
+struct shm_ring {
+	/** Number of bytes ever read, advanced by the reader. */
+	alignas(CACHELINE_SIZE) uint64_t rpos;
+	/** Set when the writer waits for the ring to drain. */
+	uint32_t writer_waits;
+	/** Number of bytes ever written, advanced by the writer. */
+	alignas(CACHELINE_SIZE) uint64_t wpos;
+	/** Set when the reader waits for data. */
+	uint32_t reader_waits;
+	/** Ring data follows. */
+	alignas(CACHELINE_SIZE) char data[0];
+};
+
+/** Header of the channel memory, followed by the rings. */
+struct shm_channel_header {
+	uint32_t magic;
+	uint32_t version;
+	/** Size of each ring. */
+	uint32_t ring_size;
+	/** Set by a side which closes the channel. */
+	uint32_t is_closed;
+};
+
+/** A process end of a shared memory channel. */
+struct shm_channel {
+	/** Mapped memory of the channel. */
+	void *map;
+	/** Size of the mapped memory. */
+	size_t map_size;
+	/** Channel header. */
+	struct shm_channel_header *header;
+	/** Ring this side reads from. */
+	struct shm_ring *in;
+	/** Ring this side writes to. */
+	struct shm_ring *out;
+	/** Size of each ring, a power of two. */
+	uint32_t ring_size;
+};
+
+/**
+ * Create a channel in a new anonymous shared memory file and
+ * open the server end of it. The file descriptor is returned
+ * in @a fd, pass it to the client to attach.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+int
+shm_channel_create(struct shm_channel *channel, uint32_t ring_size, int *fd);
+
+/**
+ * Open the client end of a channel created by
+ * shm_channel_create() from its file descriptor.
+ * @retval 0 Success.
+ * @retval -1 Error, diag is set.
+ */
+int
+shm_channel_attach(struct shm_channel *channel, int fd);
+
+/** Unmap the channel memory. */
+void
+shm_channel_destroy(struct shm_channel *channel);
+
+/** Mark the channel closed for the peer. */
+void
+shm_channel_close(struct shm_channel *channel);
+
+/** Check if the peer closed the channel. */
+bool
+shm_channel_is_closed(struct shm_channel *channel);
+
+/** Number of bytes available for reading. */
+size_t
+shm_channel_used(struct shm_channel *channel);
+
+/** Number of bytes available for writing. */
+size_t
+shm_channel_unused(struct shm_channel *channel);
+
+/**
+ * Read up to @a size bytes from the channel.
+ * @retval Number of bytes read, 0 if there's no data.
+ */
+size_t
+shm_channel_read(struct shm_channel *channel, void *buf, size_t size);
+
+/**
+ * Write as much of the data as fits to the channel.
+ * @retval Number of bytes written, 0 if the output ring is full.
+ */
+size_t
+shm_channel_writev(struct shm_channel *channel, const struct iovec *iov,
+		   int iovcnt);
+
+/** Write up to @a size bytes to the channel. */
+static inline size_t
+shm_channel_write(struct shm_channel *channel, const void *buf, size_t size)
+{
+	struct iovec iov = {(void *)buf, size};
+	return shm_channel_writev(channel, &iov, 1);
+}
+
+/**
+ * Announce this side is going to wait for data.
+ * @retval true There's still no data, the side may sleep until
+ *         notified.
+ * @retval false Data arrived meanwhile, the side must not
+ *         sleep. A notification may be sent anyway.
+ */
+bool
+shm_channel_prepare_read_wait(struct shm_channel *channel);
+
+/**
+ * Announce this side is going to wait for @a size bytes to
+ * become available for writing.
+ * @retval true The output ring is still full, the side may
+ *         sleep until notified.
+ * @retval false Space was freed meanwhile, the side must not
+ *         sleep. A notification may be sent anyway.
+ */
+bool
+shm_channel_prepare_write_wait(struct shm_channel *channel, size_t size);
+
+/**
+ * Called after writing: check if the peer waits for data and
+ * reset its flag.
+ * @retval true The peer has to be notified.
+ */
+bool
+shm_channel_peer_waits_data(struct shm_channel *channel);
+
+/**
+ * Called after reading: check if the peer waits for space and
+ * reset its flag.
+ * @retval true The peer has to be notified.
+ */
+bool
+shm_channel_peer_waits_space(struct shm_channel *channel);
+
+/**
+ * Create a non-blocking notification descriptor (an eventfd)
+ * for a channel side to sleep on: it becomes readable when
+ * signalled.
+ * @retval >= 0 The descriptor.
+ * @retval -1 Error, diag is set.
+ */
+int
+shm_notify_create(void);
+
+/** Wake up a side sleeping on the descriptor. */
+void
+shm_notify_signal(int fd);
+
+/** Reset the descriptor after a wakeup. */
+void
+shm_notify_clear(int fd);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_LIB_CORE_SHM_CHANNEL_H_INCLUDED */
@@ -33,7 +33,9 @@
 #include <sys/un.h>
 #include <sys/uio.h>
 #include <stdio.h>
+#include <string.h>
 #include <limits.h>
+#include <unistd.h>
 #include <netinet/in.h> /* TCP_NODELAY */
 #include <netinet/tcp.h> /* TCP_NODELAY */
 #include <arpa/inet.h>
@@ -223,6 +225,24 @@ sio_accept(int fd, struct sockaddr *addr, socklen_t *addrlen)
 	return newfd;
 }
 
+int
+sio_accept_nonblock(int fd, struct sockaddr *addr, socklen_t *addrlen)
+{
+#if defined(HAVE_ACCEPT4)
+	int newfd = accept4(fd, addr, addrlen, SOCK_NONBLOCK);
+	if (newfd < 0 && !sio_wouldblock(errno))
+		diag_set(SocketError, sio_socketname(fd), "accept4");
+	return newfd;
+#else
+	int newfd = sio_accept(fd, addr, addrlen);
+	if (newfd >= 0 && sio_setfl(newfd, O_NONBLOCK, 1) < 0) {
+		close(newfd);
+		return -1;
+	}
+	return newfd;
+#endif
+}
+
 ssize_t
 sio_read(int fd, void *buf, size_t count)
 {
@@ -291,6 +311,62 @@ sio_recvfrom(int fd, void *buf, size_t len, int flags,
 	return n;
 }
 
+ssize_t
+sio_sendfds(int fd, const void *buf, size_t len, const int *fds, int fd_count)
+{
+	assert(fd_count > 0 && fd_count <= SIO_FDS_MAX);
+	char control[CMSG_SPACE(sizeof(int) * SIO_FDS_MAX)];
+	memset(control, 0, sizeof(control));
+	struct iovec iov = {(void *)buf, len};
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+	ssize_t n = sendmsg(fd, &msg, 0);
+	if (n < 0 && !sio_wouldblock(errno))
+		diag_set(SocketError, sio_socketname(fd), "sendmsg(%zd)", len);
+	return n;
+}
+
+ssize_t
+sio_recvfds(int fd, void *buf, size_t len, int *fds, int *fd_count)
+{
+	char control[CMSG_SPACE(sizeof(int) * SIO_FDS_MAX)];
+	struct iovec iov = {buf, len};
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	*fd_count = 0;
+	ssize_t n = recvmsg(fd, &msg, 0);
+	if (n < 0) {
+		if (!sio_wouldblock(errno)) {
+			diag_set(SocketError, sio_socketname(fd),
+				 "recvmsg(%zd)", len);
+		}
+		return n;
+	}
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET ||
+		    cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+		int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		memcpy(fds + *fd_count, CMSG_DATA(cmsg), sizeof(int) * count);
+		*fd_count += count;
+	}
+	return n;
+}
+
 int
 sio_getpeername(int fd, struct sockaddr *addr, socklen_t *addrlen)
 {
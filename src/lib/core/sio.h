@@ -186,6 +186,14 @@ int sio_listen(int fd);
  */
 int sio_accept(int fd, struct sockaddr *addr, socklen_t *addrlen);
 
+/**
+ * Accept a client connection on a server socket and make the
+ * client socket non-blocking, in one syscall if the platform
+ * allows. The diagnostics is not set for inprogress errors
+ * (@sa sio_wouldblock())
+ */
+int sio_accept_nonblock(int fd, struct sockaddr *addr, socklen_t *addrlen);
+
 /**
  * Read *up to* 'count' bytes from a socket.
  * The diagnostics is not set for sio_wouldblock() errors.
@@ -218,6 +226,26 @@ ssize_t sio_sendto(int fd, const void *buf, size_t len, int flags,
 ssize_t sio_recvfrom(int fd, void *buf, size_t len, int flags,
 		     struct sockaddr *src_addr, socklen_t *addrlen);
 
+enum {
+	/** Max number of descriptors passed with one message. */
+	SIO_FDS_MAX = 8,
+};
+
+/**
+ * Send a message on a Unix socket along with file descriptors.
+ * The diagnostics is not set for sio_wouldblock() errors.
+ */
+ssize_t sio_sendfds(int fd, const void *buf, size_t len,
+		    const int *fds, int fd_count);
+
+/**
+ * Receive a message on a Unix socket along with file
+ * descriptors, up to SIO_FDS_MAX. The number of descriptors
+ * received is returned in @a fd_count, the caller owns them.
+ * The diagnostics is not set for sio_wouldblock() errors.
+ */
+ssize_t sio_recvfds(int fd, void *buf, size_t len, int *fds, int *fd_count);
+
 /**
  * Convert a string URI like "ip:port" or "unix/:path" to
  * sockaddr_in/un structure.
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2010-2021, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "mp_scan.h"
+
+#include <trivia/config.h>
+#include <trivia/util.h>
+#include <cpu_feature.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+static size_t
+mp_scan_single_generic(const char *data, size_t size)
+{
+	size_t i = 0;
+	while (i < size && mp_scan_is_single((uint8_t)data[i]))
+		i++;
+	return i;
+}
+
+#if defined(__x86_64__)
+
+/*
+ * A byte is a single byte value if, read as a signed char,
+ * it is greater than -33 (positive and negative fixint), or
+ * it is 0xc0 (nil), or 0xc2/0xc3 (booleans). SSE2 is a part
+ * of the x86_64 baseline, so no dispatch is needed for it.
+ */
+static size_t
+mp_scan_single_sse2(const char *data, size_t size)
+{
+	const __m128i fixint = _mm_set1_epi8(-33);
+	const __m128i nil = _mm_set1_epi8((char)0xc0);
+	const __m128i bool_mask = _mm_set1_epi8((char)0xfe);
+	const __m128i bool_val = _mm_set1_epi8((char)0xc2);
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i m = _mm_cmpgt_epi8(v, fixint);
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(v, nil));
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_and_si128(v, bool_mask),
+						   bool_val));
+		unsigned mask = (unsigned)_mm_movemask_epi8(m);
+		if (mask != 0xffff)
+			return i + __builtin_ctz(~mask);
+	}
+	return i + mp_scan_single_generic(data + i, size - i);
+}
+
+#if defined(HAVE_CPUID)
+
+__attribute__((target("avx2")))
+static size_t
+mp_scan_single_avx2(const char *data, size_t size)
+{
+	const __m256i fixint = _mm256_set1_epi8(-33);
+	const __m256i nil = _mm256_set1_epi8((char)0xc0);
+	const __m256i bool_mask = _mm256_set1_epi8((char)0xfe);
+	const __m256i bool_val = _mm256_set1_epi8((char)0xc2);
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+		__m256i m = _mm256_cmpgt_epi8(v, fixint);
+		m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, nil));
+		m = _mm256_or_si256(m, _mm256_cmpeq_epi8(
+				_mm256_and_si256(v, bool_mask), bool_val));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(m);
+		if (mask != UINT32_MAX)
+			return i + __builtin_ctz(~mask);
+	}
+	return i + mp_scan_single_sse2(data + i, size - i);
+}
+
+#endif /* defined(HAVE_CPUID) */
+
+mp_scan_func mp_scan_single = mp_scan_single_sse2;
+
+#else /* !defined(__x86_64__) */
+
+mp_scan_func mp_scan_single = mp_scan_single_generic;
+
+#endif /* defined(__x86_64__) */
+
+void
+mp_scan_init(void)
+{
+#if defined(__x86_64__) && defined(HAVE_CPUID)
+	mp_scan_single = avx2_enabled_cpu() ? mp_scan_single_avx2 :
+					      mp_scan_single_sse2;
+#endif
+}
+
+void
+mp_scan_next_bulk(const char **data, uint32_t count)
+{
+	while (count > 0) {
+		if (mp_scan_is_single(**data)) {
+			/*
+			 * The remaining values take at least
+			 * count bytes, so it's safe to read them.
+			 */
+			size_t n = mp_scan_single(*data, count);
+			*data += n;
+			count -= n;
+			if (count == 0)
+				break;
+		}
+		mp_next(data);
+		count--;
+	}
+}
+
+int
+mp_scan_check(const char **data, const char *end)
+{
+	/* Number of values left to check. */
+	uint64_t k = 1;
+	while (k > 0) {
+		if (*data >= end)
+			return 1;
+		if (mp_scan_is_single(**data)) {
+			size_t n = mp_scan_single(*data, MIN((uint64_t)(end - *data),
+							     k));
+			*data += n;
+			k -= n;
+			if (k == 0)
+				break;
+			if (*data >= end)
+				return 1;
+		}
+		switch (mp_typeof(**data)) {
+		case MP_ARRAY:
+			if (mp_check_array(*data, end) > 0)
+				return 1;
+			k += mp_decode_array(data);
+			break;
+		case MP_MAP:
+			if (mp_check_map(*data, end) > 0)
+				return 1;
+			k += 2 * (uint64_t)mp_decode_map(data);
+			break;
+		default:
+			if (mp_check(data, end) != 0)
+				return 1;
+			break;
+		}
+		k--;
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+#ifndef TARANTOOL_MP_SCAN_H_INCLUDED
+#define TARANTOOL_MP_SCAN_H_INCLUDED
+/*
+ * Copyright 2010-2021, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <msgpuck.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Bulk MessagePack scanning.
+ *
+ * Typical tuples are dominated by values which are encoded
+ * in a single byte: small integers, nil and booleans. A run
+ * of such values can be skipped or validated by classifying
+ * many bytes at once, which is what the kernels below do.
+ * Everything else is handed over to msgpuck.
+ */
+
+/**
+ * Up to this number of values a plain mp_next() loop is
+ * cheaper than a call to the vectorized kernel.
+ */
+enum { MP_SCAN_BULK_MIN = 8 };
+
+/**
+ * Return the length of the longest prefix of @a data which
+ * consists of single byte MessagePack values only. Never reads
+ * beyond @a data + @a size.
+ */
+typedef size_t (*mp_scan_func)(const char *data, size_t size);
+
+/**
+ * Pointer to an architecture-specific implementation of
+ * the single byte run scanner.
+ */
+extern mp_scan_func mp_scan_single;
+
+/** Select the best scanner supported by the CPU. */
+void
+mp_scan_init(void);
+
+/** True if @a c is a complete single byte MessagePack value. */
+static inline bool
+mp_scan_is_single(uint8_t c)
+{
+	/* positive and negative fixint, nil, false and true. */
+	return c <= 0x7f || c >= 0xe0 || c == 0xc0 || (c & 0xfe) == 0xc2;
+}
+
+/** Out-of-line part of mp_scan_next(). */
+void
+mp_scan_next_bulk(const char **data, uint32_t count);
+
+/**
+ * Skip @a count MessagePack values. Same as calling mp_next()
+ * @a count times.
+ */
+static inline void
+mp_scan_next(const char **data, uint32_t count)
+{
+	if (count < MP_SCAN_BULK_MIN) {
+		for (; count > 0; --count)
+			mp_next(data);
+		return;
+	}
+	mp_scan_next_bulk(data, count);
+}
+
+/**
+ * Check that @a data points to a valid MessagePack value which
+ * ends before @a end. Drop-in replacement for mp_check().
+ * @retval 0 the value is valid, @a data is moved past it.
+ * @retval 1 the value is invalid or truncated.
+ */
+int
+mp_scan_check(const char **data, const char *end);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_MP_SCAN_H_INCLUDED */
@@ -94,6 +94,11 @@
 #endif
 #endif
 
+/*
+ * Defined if this platform has accept4(), which sets flags of
+ * the accepted socket in the same syscall.
+ */
+#cmakedefine HAVE_ACCEPT4 1
 /*
  * Defined if this platform has GNU specific memmem().
  */
@@ -170,6 +175,8 @@
 #cmakedefine HAVE_FALLOCATE 1
 #cmakedefine HAVE_MREMAP 1
 #cmakedefine HAVE_SYNC_FILE_RANGE 1
+#cmakedefine HAVE_EVENTFD 1
+#cmakedefine HAVE_MEMFD_CREATE 1
 
 #cmakedefine HAVE_MSG_NOSIGNAL 1
 #cmakedefine HAVE_SO_NOSIGPIPE 1
@@ -0,0 +1,92 @@
+test_run = require('test_run').new()
+
+--
+-- COLUMN index stores key parts column-wise and computes
+-- aggregates over them without visiting tuples.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+c = s:create_index('c', {type = 'column', parts = {{2, 'unsigned'}, {3, 'unsigned'}, {4, 'double'}, {5, 'string'}}})
+c.type
+for i = 1, 5000 do s:insert{i, i, 5000 - i, i + 0.5, 'k' .. i % 3} end
+c:len()
+c:aggregate('count')
+c:aggregate('sum')
+c:aggregate('min')
+c:aggregate('max')
+c:aggregate('sum', 2)
+c:aggregate('min', 2)
+c:aggregate('max', 2)
+c:aggregate('sum', 3)
+c:aggregate('count', 4)
+
+-- Filter on another part of the index.
+c:aggregate('count', 1, {4, 'EQ', 'k1'})
+c:aggregate('count', 1, {4, 'EQ', 'nope'})
+c:aggregate('sum', 1, {1, 'GT', 4000})
+c:aggregate('max', 1, {2, 'LT', 2500})
+c:aggregate('min', 2, {3, 'GE', 2500})
+c:aggregate('min', 1, {1, 'GE', 6000})
+c:aggregate('count', 1, {1, 'GE', -1})
+c:aggregate('count', 1, {1, 'LT', -1})
+
+-- Deletes and updates keep the columns dense.
+for i = 1, 5000, 2 do s:delete{i} end
+c:len()
+c:aggregate('sum')
+c:aggregate('sum', 2)
+c:aggregate('max', 2)
+c:aggregate('count', 1, {4, 'EQ', 'k1'})
+_ = s:update({2}, {{'=', 2, 100000}})
+c:aggregate('max')
+#c:select()
+
+-- Iterators neither skip nor repeat rows moved by a removal.
+u = box.schema.space.create('u')
+_ = u:create_index('pk')
+uc = u:create_index('c', {type = 'column', parts = {{2, 'unsigned'}}})
+for i = 1, 1000 do u:insert{i, i} end
+seen = {}
+n = 0 for _, t in uc:pairs() do seen[t[1]] = true n = n + 1 u:delete{t[1]} end
+n
+#seen
+uc:len()
+for i = 1, 1000 do u:insert{i, i} end
+n = 0 for _, t in uc:pairs() do n = n + 1 u:delete{1001 - t[1]} end
+n
+uc:len()
+u:drop()
+
+-- Integer overflow of sum().
+t = box.schema.space.create('t')
+_ = t:create_index('pk')
+tc = t:create_index('c', {type = 'column', parts = {{2, 'unsigned'}}})
+_ = t:insert{1, 18446744073709551615ULL}
+tc:aggregate('sum')
+_ = t:insert{2, 1}
+tc:aggregate('sum')
+t:drop()
+
+-- Errors.
+c:aggregate('sum', 4)
+c:aggregate('min', 1, {4, 'GT', 'k'})
+c:aggregate('count', 1, {1, 'GE', 'x'})
+c:aggregate('count', 1, {1, 'BITS_ALL_SET', 1})
+c:aggregate('count', 1, {1, 'EQ'})
+c:aggregate('sum', 5)
+c:aggregate('avg')
+c:aggregate()
+s.index.pk:aggregate('count')
+s:create_index('bad', {type = 'column', parts = {{6, 'array'}}})
+s:create_index('bad', {type = 'column', parts = {{6, 'integer'}}})
+s:create_index('bad', {type = 'column', unique = true})
+s:create_index('bad', {type = 'column', parts = {{6, 'unsigned', is_nullable = true}}})
+
+-- The index is rebuilt on recovery.
+test_run:cmd('restart server default')
+s = box.space.test
+c = s.index.c
+c:len()
+c:aggregate('max')
+c:aggregate('sum', 2)
+s:drop()
@@ -0,0 +1,74 @@
+test_run = require('test_run').new()
+
+--
+-- A space with dense_field_map keeps offsets of all fields
+-- in the field map, not only of the indexed ones.
+--
+s = box.schema.space.create('test', {dense_field_map = true})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {3, 'unsigned'}, unique = false})
+t = {} for i = 1, 200 do t[i] = i * 10 end
+_ = s:insert(t)
+tuple = s:get{10}
+tuple[1]
+tuple[2]
+tuple[150]
+tuple[200]
+tuple[201]
+tuple['[150]']
+#tuple:totable()
+
+-- Offsets beyond 64KB need the wide form of the table.
+big = string.rep('x', 70000)
+_ = s:insert{20, big, 30, 'after'}
+s:get{20}[4]
+#s:get{20}[2]
+s.index.sk:get{30}[1]
+
+-- JSON paths start from the field found in the table.
+_ = s:replace{30, {a = {1, 2, 3}}, 40}
+s:get{30}['[2].a[2]']
+s:get{30}['[2].b']
+
+-- Updates rebuild the table.
+_ = s:update(10, {{'=', 150, 'x'}, {'#', 2, 1}})
+s:get{10}[149]
+s:get{10}[150]
+#s:get{10}:totable()
+
+-- The option can be switched on a non-empty space: old tuples
+-- keep their field maps.
+s:alter({dense_field_map = false})
+s:get{10}[149]
+_ = s:replace{40, 50, 60, 70}
+s:get{40}[4]
+s:alter({dense_field_map = true})
+s:get{40}[4]
+_ = s:replace{40, 50, 60, 70, 80}
+s:get{40}[5]
+
+-- Too many fields to fit the table in the tuple metadata:
+-- such tuples are stored without it.
+t = {} for i = 1, 10000 do t[i] = i end
+_ = s:insert(t)
+s:get{1}[9999]
+s:get{1}[10000]
+s:drop()
+
+-- Multikey extents and the dense one share the field map.
+s = box.schema.space.create('test', {dense_field_map = true})
+_ = s:create_index('pk')
+_ = s:create_index('mk', {parts = {{field = 3, type = 'unsigned', path = '[*]'}}})
+_ = s:insert{1, 'a', {10, 20, 30}, 'b', 'c'}
+_ = s:insert{2, 'd', {40}, 'e'}
+s:get{1}[4], s:get{1}[5]
+s.index.mk:get{20}[5]
+s.index.mk:get{40}[4]
+#s.index.mk:select{}
+_ = s:update(1, {{'=', 5, 'z'}, {'=', 3, {50, 60}}})
+s.index.mk:get{60}[5]
+s.index.mk:get{10}
+s:drop()
+
+box.schema.space.create('test', {engine = 'vinyl', dense_field_map = true})
+box.schema.space.create('test', {compression = 'zstd', dense_field_map = true})
@@ -0,0 +1,49 @@
+--
+-- index:checksum() returns crc32 and count of tuples in a key
+-- range, so that two instances can find differing ranges.
+--
+m = box.schema.space.create('m', {engine = 'memtx'})
+_ = m:create_index('pk')
+v = box.schema.space.create('v', {engine = 'vinyl'})
+_ = v:create_index('pk')
+for i = 1, 100 do m:insert{i, 'x'} v:insert{i, 'x'} end
+
+crc, count = m.index.pk:checksum()
+count
+crc == v.index.pk:checksum()
+select(2, m.index.pk:checksum({10}, {20}))
+select(2, m.index.pk:checksum({95}))
+select(2, m.index.pk:checksum({}, {3}))
+select(2, m.index.pk:checksum({200}))
+m.index.pk:checksum({10}, {20}) == v.index.pk:checksum({10}, {20})
+
+-- A change is visible only in the range that contains it.
+_ = v:replace{15, 'y'}
+m.index.pk:checksum({10}, {20}) == v.index.pk:checksum({10}, {20})
+m.index.pk:checksum({20}, {30}) == v.index.pk:checksum({20}, {30})
+m.index.pk:checksum() == v.index.pk:checksum()
+
+m.index.pk:checksum({'a'})
+
+-- A big range is scanned with yields over a read view, unless
+-- in a transaction.
+fiber = require('fiber')
+b = box.schema.space.create('b')
+_ = b:create_index('pk')
+_ = b:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+box.begin() for i = 1, 3000 do b:insert{i, i % 10} end box.commit()
+crc = b.index.pk:checksum()
+flag = false f = fiber.new(function() flag = true end) _, count = b.index.pk:checksum() flag, count
+flag = false f = fiber.new(function() flag = true end) box.begin() _, count = b.index.pk:checksum() box.commit() flag, count
+select(2, b.index.sk:checksum({3}, {5}))
+b.index.sk:checksum({3}, {5}) == box.atomic(b.index.sk.checksum, b.index.sk, {3}, {5})
+-- Changes made during a yield are not visible.
+f = fiber.new(function() b:truncate() end) sum, count = b.index.pk:checksum() sum == crc, count
+b:count()
+-- The space is dropped during a yield.
+box.begin() for i = 1, 3000 do b:insert{i, i % 10} end box.commit()
+f = fiber.new(function() b:drop() end) sum, count = b.index.pk:checksum() sum == crc, count
+box.space.b == nil
+
+m:drop()
+v:drop()
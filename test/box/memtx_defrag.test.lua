@@ -0,0 +1,33 @@
+test_run = require('test_run').new()
+
+--
+-- Online defragmentation of the memtx tuple arena.
+--
+box.cfg{memtx_defrag_threshold = -1}
+box.cfg{memtx_defrag_threshold = 1}
+box.cfg{memtx_use_huge_pages = true}
+box.cfg.memtx_defrag_threshold
+box.cfg.memtx_use_huge_pages
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {type = 'hash', parts = {2, 'unsigned'}})
+pad = string.rep('x', 100)
+box.begin() for i = 1, 20000 do s:insert{i, i, pad} end box.commit()
+box.begin() for i = 1, 20000, 2 do s:delete{i} end box.commit()
+box.slab.info().items_fragmented > 0
+
+moved = box.slab.info().items_moved
+box.cfg{memtx_defrag_threshold = 0.01}
+test_run:wait_cond(function() return box.slab.info().items_moved > moved end)
+box.cfg{memtx_defrag_threshold = 0}
+
+-- Moved tuples are still accessible via all indexes.
+s:count()
+s.index.sk:count()
+check = true
+for i = 2, 20000, 2 do local t = s:get{i} if t == nil or t[2] ~= i or t[3] ~= pad then check = false end end
+check
+for i = 2, 20000, 2 do if s.index.sk:get{i}[1] ~= i then check = false end end
+check
+s:drop()
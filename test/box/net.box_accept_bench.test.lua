@@ -0,0 +1,64 @@
+-- A connection storm and small requests over TCP. The connection
+-- and request rates are written to the log.
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+log = require('log')
+
+old_listen = box.cfg.listen
+box.cfg{listen = '127.0.0.1:0'}
+uri = box.info.listen
+
+CONNECTIONS = 10000
+FIBERS = 100
+PINGS = 1000000
+
+test_run:cmd("setopt delimiter ';'")
+function connector(id, result, count)
+    local ok = 0
+    for _ = 1, count do
+        local c = net.connect(uri)
+        if c:ping() then
+            ok = ok + 1
+        end
+        c:close()
+    end
+    result[id] = ok
+end;
+function pinger(id, result, c, count)
+    local ok = 0
+    for _ = 1, count do
+        if c:ping() then
+            ok = ok + 1
+        end
+    end
+    result[id] = ok
+end;
+function bench(name, total, f, ...)
+    local result = {}
+    local fibers = {}
+    local start = fiber.clock()
+    for i = 1, FIBERS do
+        fibers[i] = fiber.new(f, i, result, ...)
+        fibers[i]:set_joinable(true)
+    end
+    local done = 0
+    for i = 1, FIBERS do
+        fibers[i]:join()
+        done = done + result[i]
+    end
+    local rate = total / (fiber.clock() - start)
+    log.info('net.box accept bench: %d %s/s', rate, name)
+    return done
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Every connection is accepted, pinged and closed.
+bench('connections', CONNECTIONS, connector, CONNECTIONS / FIBERS) == CONNECTIONS
+
+-- Small requests over one connection.
+c = net.connect(uri)
+bench('pings', PINGS, pinger, c, PINGS / FIBERS) == PINGS
+c:close()
+
+box.cfg{listen = old_listen}
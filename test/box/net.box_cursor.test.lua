@@ -0,0 +1,85 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+
+--
+-- Server-side cursors read a big result set in batches without
+-- a new index lookup per batch.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read', 'space', 'test')
+for i = 1, 10 do s:replace{i} end
+
+c = net.connect(box.cfg.listen)
+cur = c.space.test:cursor()
+res = cur:fetch(4)
+#res, res[1][1], res[4][1]
+res = cur:fetch(4)
+#res, res[1][1], res[4][1]
+cur.is_closed
+-- Less than the limit: the cursor is exhausted and closed.
+res = cur:fetch(4)
+#res, res[1][1], res[2][1]
+cur.is_closed
+#cur:fetch(4)
+
+-- A key and an iterator as for select.
+cur = c.space.test.index.pk:cursor({7}, {iterator = 'LT'})
+res = cur:fetch(2)
+#res, res[1][1], res[2][1]
+cur:close()
+cur.is_closed
+ok, err = pcall(c._request, c, 'cursor_fetch', nil, nil, cur.id, 1)
+ok, err.code == box.error.NO_SUCH_CURSOR
+
+-- A full scan of a memtx primary index reads the space as of
+-- the open: changes made between fetches are not seen.
+cur = c.space.test:cursor()
+res = cur:fetch(3)
+#res, res[1][1], res[3][1]
+s:delete{4}
+_ = s:replace{0}
+_ = s:replace{11}
+res = cur:fetch(100)
+#res, res[1][1], res[7][1]
+cur.is_closed
+_ = s:replace{4}
+_ = s:delete{0}
+_ = s:delete{11}
+
+-- Other cursors read the index itself and see the changes.
+cur = c.space.test.index.pk:cursor({0}, {iterator = 'GE'})
+res = cur:fetch(3)
+#res, res[1][1], res[3][1]
+s:delete{4}
+res = cur:fetch(2)
+#res, res[1][1], res[2][1]
+cur:close()
+_ = s:replace{4}
+
+-- Errors of open are reported by open.
+c.space.test:cursor({'a'})
+
+-- The number of cursors open in a session is limited.
+box.cfg{net_cursor_max = 0}
+box.cfg{net_cursor_max = 2}
+cur1 = c.space.test:cursor()
+cur2 = c.space.test:cursor()
+c.space.test:cursor()
+cur1:close()
+cur3 = c.space.test:cursor()
+cur2:close()
+cur3:close()
+box.cfg{net_cursor_max = 64}
+
+-- An idle cursor is closed on the timeout.
+box.cfg{net_cursor_timeout = 0}
+box.cfg{net_cursor_timeout = 0.1}
+cur = c.space.test:cursor()
+fiber.sleep(0.2)
+cur:fetch(1)
+box.cfg{net_cursor_timeout = 60}
+
+c:close()
+s:drop()
@@ -0,0 +1,32 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+errinj = box.error.injection
+
+--
+-- A fetch of a vinyl cursor may yield on a disk read. A
+-- concurrent fetch of the cursor fails, and a close leaves
+-- the cursor to the fetch in progress.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 5})
+box.schema.user.grant('guest', 'read', 'space', 'test')
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+
+c = net.connect(box.cfg.listen)
+cur = c.space.test:cursor()
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', true)
+ch = fiber.channel(1)
+_ = fiber.create(function() ch:put(cur:fetch(4)) end)
+ok, err = pcall(cur.fetch, cur, 4)
+ok, err.code == box.error.CURSOR_BUSY
+cur:close()
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', false)
+res = ch:get()
+#res, res[1][1], res[4][1]
+ok, err = pcall(c._request, c, 'cursor_fetch', nil, nil, cur.id, 1)
+ok, err.code == box.error.NO_SUCH_CURSOR
+
+c:close()
+s:drop()
@@ -0,0 +1,49 @@
+test_run = require('test_run').new()
+net = require('net.box')
+clock = require('clock')
+
+--
+-- net.box with send_timeout sends the request timeout to the
+-- server, which does not execute the request once the client
+-- does not wait for it anymore.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:insert{1}
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+function busy(t) local deadline = clock.monotonic() + t while clock.monotonic() < deadline do end end
+
+c = net.connect(box.cfg.listen, {send_timeout = true})
+box.stat.reset()
+c.space.test:select({}, {timeout = 1})
+box.stat.net().EXPIRED.total
+
+-- The select waits in the queue while tx is busy and expires.
+f = c:call('busy', {0.3}, {is_async = true}) ok, err = pcall(c.space.test.select, c.space.test, {}, {timeout = 0.05})
+ok, err.code == box.error.TIMEOUT
+f:wait_result()
+test_run:wait_cond(function() return box.stat.net().EXPIRED.total == 1 end)
+box.stat.net().SHED.total
+
+-- Without send_timeout the timeout is not sent.
+c2 = net.connect(box.cfg.listen)
+f = c2:call('busy', {0.3}, {is_async = true}) ok, err = pcall(c2.space.test.select, c2.space.test, {}, {timeout = 0.05})
+ok, err.code == box.error.TIMEOUT
+f:wait_result()
+c2:ping()
+box.stat.net().EXPIRED.total
+
+-- A request read up before net_msg_max stopped the input is
+-- dropped without a response once it expires.
+box.cfg{net_msg_max = 2}
+fs = {} for i = 1, 3 do fs[i] = c:call('busy', {0.2}, {is_async = true}) end ok, err = pcall(c.space.test.select, c.space.test, {}, {timeout = 0.05})
+ok, err.code == box.error.TIMEOUT
+for i = 1, 3 do fs[i]:wait_result() end
+test_run:wait_cond(function() return box.stat.net().SHED.total == 1 end)
+box.stat.net().EXPIRED.total
+box.cfg{net_msg_max = 768}
+
+c:close()
+c2:close()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+s:drop()
@@ -0,0 +1,26 @@
+test_run = require('test_run').new()
+net = require('net.box')
+
+--
+-- Network buffers grown by a big request and response are given
+-- back to the net thread once the connection becomes idle.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+
+c = net.connect(box.cfg.listen)
+c:ping()
+mem = box.info.memory().net
+_ = c.space.test:replace{1, string.rep('x', 1024 * 1024)}
+test_run:wait_cond(function() return box.info.memory().net < mem + 512 * 1024 end)
+-- An output buffer grown by a big response is freed without
+-- waiting for the next request.
+box.schema.user.grant('guest', 'execute', 'universe')
+_ = c:eval("return string.rep('x', 1024 * 1024)")
+test_run:wait_cond(function() return box.info.memory().net < mem + 512 * 1024 end)
+c:ping()
+
+box.schema.user.revoke('guest', 'execute', 'universe')
+c:close()
+s:drop()
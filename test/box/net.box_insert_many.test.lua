@@ -0,0 +1,38 @@
+net = require('net.box')
+
+--
+-- space:insert_many() and space:replace_many() write many
+-- tuples with one request in one transaction.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+c = net.connect(box.cfg.listen)
+
+c.space.test:insert_many({{1, 'a'}, {2, 'b'}, box.tuple.new{3, 'c'}})
+s:select()
+c.space.test:replace_many({{1, 'x'}, {4, 'd'}})
+s:select()
+c.space.test:insert_many({})
+
+-- All or nothing.
+c.space.test:insert_many({{5}, {6}, {1}})
+s:count()
+c.space.test:insert_many({{5}, 6})
+s:count()
+
+-- The tuples are written as usual INSERT/REPLACE statements.
+inserts = box.stat().INSERT.total
+c.space.test:insert_many({{10}, {11}, {12}})
+box.stat().INSERT.total - inserts
+
+-- Async and local.
+f = c.space.test:replace_many({{20}, {21}}, {is_async = true})
+f:wait_result()
+s:insert_many({{30}, {31}})
+box.begin() s:insert_many({{40}}) box.rollback()
+s:get{40}
+s:count()
+
+c:close()
+s:drop()
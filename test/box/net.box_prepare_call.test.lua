@@ -0,0 +1,40 @@
+test_run = require('test_run').new()
+net = require('net.box')
+
+--
+-- prepare_call() resolves the function name to the id to call
+-- the function by, the access is checked once for the session.
+--
+function sum(a, b) return a + b end
+box.schema.func.create('sum')
+box.schema.user.create('test', {password = 'test'})
+box.schema.user.grant('test', 'execute', 'function', 'sum')
+
+c = net.connect(box.cfg.listen, {user = 'test', password = 'test'})
+id = c:prepare_call('sum')
+id == box.func.sum.id
+c:call(id, {1, 2})
+c:call(id, {3, 4})
+c:call('sum', {5, 6})
+
+-- Revoke invalidates the checked access.
+box.schema.user.revoke('test', 'execute', 'function', 'sum')
+c:call(id, {1, 2})
+box.schema.user.grant('test', 'execute', 'function', 'sum')
+c:call(id, {1, 2})
+
+-- A function can be called by id without prepare_call().
+c2 = net.connect(box.cfg.listen, {user = 'test', password = 'test'})
+c2:call(id, {2, 2})
+c2:close()
+
+-- Errors.
+c:prepare_call('unknown')
+c:call(100500)
+box.schema.func.drop('sum')
+ok, err = pcall(c.call, c, id, {1, 2})
+ok, err.code == box.error.NO_SUCH_FUNCTION
+
+c:close()
+box.schema.user.drop('test')
+sum = nil
@@ -0,0 +1,58 @@
+-- A router fanning out calls to storages over a few net.box
+-- connections. The request rate is written to the log.
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+log = require('log')
+
+box.schema.func.create('storage_call')
+box.schema.user.grant('guest', 'execute', 'function', 'storage_call')
+function storage_call(key) return key end
+
+CONNECTIONS = 4
+FIBERS = 100
+CALLS = 1000000
+BATCH = 100
+connections = {}
+for i = 1, CONNECTIONS do connections[i] = net.connect(box.cfg.listen) end
+
+test_run:cmd("setopt delimiter ';'")
+function router(id, calls, result)
+    local futures = {}
+    local ok = 0
+    for i = 1, calls, BATCH do
+        for j = 1, BATCH do
+            local c = connections[(i + j) % CONNECTIONS + 1]
+            futures[j] = c:call('storage_call', {i + j}, {is_async = true})
+        end
+        for j = 1, BATCH do
+            if futures[j]:wait_result()[1] == i + j then
+                ok = ok + 1
+            end
+        end
+    end
+    result[id] = ok
+end;
+function bench()
+    local result = {}
+    local fibers = {}
+    local start = fiber.clock()
+    for i = 1, FIBERS do
+        fibers[i] = fiber.new(router, i, CALLS / FIBERS, result)
+        fibers[i]:set_joinable(true)
+    end
+    local total = 0
+    for i = 1, FIBERS do
+        fibers[i]:join()
+        total = total + result[i]
+    end
+    local rate = CALLS / (fiber.clock() - start)
+    log.info('net.box router bench: %d calls/s', rate)
+    return total
+end;
+test_run:cmd("setopt delimiter ''");
+
+bench() == CALLS
+
+for _, c in ipairs(connections) do c:close() end
+box.schema.func.drop('storage_call')
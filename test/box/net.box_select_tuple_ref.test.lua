@@ -0,0 +1,31 @@
+test_run = require('test_run').new()
+
+-- Big tuples selected over iproto are sent right from the tuple
+-- memory, small ones are copied to the output buffer. Check both
+-- kinds mixed in one response and in a series of responses.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 200 do s:insert{i, string.rep(tostring(i % 10), i % 3 == 0 and 10 or 4000)} end
+
+box.schema.user.grant('guest', 'read', 'space', 'test')
+net = require('net.box')
+c = net.connect(box.cfg.listen)
+
+function equal(a, b) if #a ~= #b then return false end for i = 1, #a do if a[i][1] ~= b[i][1] or a[i][2] ~= b[i][2] then return false end end return true end
+equal(c.space.test:select(), s:select())
+equal(c.space.test:select({100}, {iterator = 'LE', limit = 50}), s:select({100}, {iterator = 'LE', limit = 50}))
+equal(c.space.test:select({3}), s:select({3}))
+equal(c.space.test:select({4}), s:select({4}))
+
+-- Many responses queued on one connection.
+fibers = {}
+ok = 0
+for i = 1, 50 do fibers[i] = require('fiber').create(function() if equal(c.space.test:select({i}, {iterator = 'GE'}), s:select({i}, {iterator = 'GE'})) then ok = ok + 1 end end) end
+test_run:wait_cond(function() return ok == 50 end)
+
+-- Tuples which have been sent can be updated.
+c:close()
+s:update({4}, {{'=', 2, 'x'}})[2]
+
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+s:drop()
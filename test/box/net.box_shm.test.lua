@@ -0,0 +1,41 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+
+-- A client on the same host can switch a Unix socket connection
+-- to a shared memory channel after the handshake.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read,write', 'space', 'test')
+box.schema.user.grant('guest', 'execute', 'universe')
+connections = box.stat.net().CONNECTIONS.current
+
+c = net.connect(box.cfg.listen, {transport = 'shm'})
+c.state
+c:ping()
+c.space.test:insert{1, 'a'}
+c.space.test:select()
+c:eval('return box.session.peer() ~= nil')
+
+-- A message bigger than the channel ring goes in parts.
+big = string.rep('x', 3 * 1024 * 1024)
+c:call('string.len', {big})
+#c:eval('return string.rep("y", 3 * 1024 * 1024)')
+
+-- Many requests in flight.
+ok = 0
+for i = 1, 100 do fiber.create(function() if c.space.test:replace{i, i}[2] == i then ok = ok + 1 end end) end
+test_run:wait_cond(function() return ok == 100 end)
+s:count()
+
+-- The server learns the client is gone.
+box.stat.net().CONNECTIONS.current == connections + 1
+c:close()
+test_run:wait_cond(function() return box.stat.net().CONNECTIONS.current == connections end)
+
+-- Requests fail once the connection is closed.
+c:ping()
+
+box.schema.user.revoke('guest', 'execute', 'universe')
+box.schema.user.revoke('guest', 'read,write', 'space', 'test')
+s:drop()
@@ -0,0 +1,60 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+
+--
+-- box.cfg.net_msg_classes: requests of the tx fiber pool are
+-- queued by classes with their own weights and fiber limits.
+--
+box.cfg{net_msg_classes = {foo = {}}}
+box.cfg{net_msg_classes = {read = {weight = 0}}}
+box.cfg{net_msg_classes = {call = {max = -1}}}
+box.cfg{net_msg_classes = {call = {functions = {1}}}}
+box.cfg.net_msg_classes
+
+running = 0
+running_max = 0
+function slow() running = running + 1 running_max = math.max(running, running_max) fiber.sleep(0.05) running = running - 1 end
+function fast() return true end
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+box.cfg{net_msg_classes = {read = {weight = 4, functions = {'fast'}}, call = {max = 2}}}
+c = net.connect(box.cfg.listen)
+box.stat.reset()
+
+-- Heavy calls are limited, reads are not stuck behind them.
+fibers = {}
+for i = 1, 6 do fibers[i] = fiber.create(function() c:call('slow') end) end
+c:call('fast')
+c.space.test:insert{1}
+c.space.test:select{}
+running > 0
+test_run:wait_cond(function() return running == 0 and box.stat.classes().call.total == 6 end)
+running_max
+
+stat = box.stat.classes()
+stat.read.total
+stat.write.total
+stat.call.queued
+stat.call.queue_time.p99 >= 0.05
+stat.read.queue_time.p50 < 0.05
+
+-- A table replaced with another table is applied.
+box.cfg{net_msg_classes = {read = {weight = 4}}}
+box.cfg{net_msg_classes = {call = {max = 1}}}
+box.cfg.net_msg_classes
+running_max = 0
+for i = 1, 3 do fibers[i] = fiber.create(function() c:call('slow') end) end
+test_run:wait_cond(function() return running == 0 and box.stat.classes().call.total == 9 end)
+running_max
+
+-- Classes may be turned off.
+box.cfg{net_msg_classes = box.NULL}
+c:call('fast')
+box.stat.classes().call.total
+
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -0,0 +1,85 @@
+test_run = require('test_run').new()
+msgpack = require('msgpack')
+net = require('net.box')
+
+--
+-- Space option compression stores big fields following all
+-- indexed ones compressed, transparently for readers.
+--
+format = {{'id', 'unsigned'}, {'name', 'string'}, {'doc', 'map'}, {'blob'}}
+s = box.schema.space.create('test', {compression = 'zstd', format = format})
+_ = s:create_index('pk')
+_ = s:create_index('name', {parts = {'name'}})
+doc = {} for i = 1, 50 do doc['key' .. i] = string.rep('value', 3) end
+blob = string.rep('abcdefgh', 100)
+_ = s:insert{1, 'one', doc, blob}
+t = s:get{1}
+t:bsize() < #blob
+t.doc.key7
+t['doc.key10']
+t[4] == blob
+t.blob == blob
+#t:tomap().blob
+t:totable()[3].key1
+msgpack.encode(t) == msgpack.encode(box.tuple.new{1, 'one', doc, blob})
+s.index.name:get{'one'}.id
+
+-- Small fields are stored as is.
+s:insert{2, 'two', {a = 1}, 'x'}
+s:update(2, {{'=', 4, blob}}):bsize() < #blob
+s:update(1, {{'=', 2, 'uno'}}).doc.key1
+s.index.name:select{'uno'}[1].blob == blob
+
+-- Updates see decompressed fields.
+s:update(1, {{':', 4, 1, 8, 'XY'}}).blob == 'XY' .. blob:sub(9)
+s:update(1, {{'=', 'doc.key3', 'new'}}).doc.key3
+s:get{1}:bsize() < #blob
+s:upsert({1, 'x', {}, ''}, {{'=', 'doc.key4', 'up'}, {'=', 4, blob}})
+s:get{1}.doc.key4, s:get{1}.blob == blob
+s:get{1}:update({{'=', 'doc.key5', 'x'}}).doc.key5
+
+-- So do FFI, SQL and the C API.
+msgpackffi = require('msgpackffi')
+t = s:get{1}
+msgpackffi.decode(msgpackffi.encode(t))[4] == blob
+n = 0 for _, v in t:pairs() do n = n + (v == blob and 1 or 0) end n
+t:totable(4)[1] == blob
+box.execute([[SELECT "blob" FROM "test" WHERE "id" = 1;]]).rows[1][1] == blob
+box.execute([[SELECT "doc" FROM "test" WHERE "id" = 1;]]).rows[1][1].key50
+
+-- Type of a compressed field is checked.
+s:insert{3, 'three', string.rep('x', 100)}
+
+-- Remote clients get decompressed tuples.
+box.schema.user.grant('guest', 'read', 'space', 'test')
+c = net.connect(box.cfg.listen)
+c.space.test:get{1}.blob == blob
+c.space.test:get{2}.blob == blob
+c:close()
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+
+-- Compressed tuples survive recovery.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+blob = string.rep('abcdefgh', 100)
+s:get{1}.blob == blob
+s:get{1}.doc.key50
+s:get{2}.blob == blob
+
+-- Fields compressed in existing tuples can't be indexed.
+c = box.schema.space.create('c', {compression = 'zstd'})
+_ = c:create_index('pk')
+_ = c:insert{1, string.rep('x', 100), 'y'}
+c:create_index('sk', {parts = {3, 'string'}})
+c:truncate()
+_ = c:create_index('sk', {parts = {3, 'string'}})
+_ = c:insert{1, string.rep('x', 100), 'y'}
+c.index.sk:get{'y'}[2] == string.rep('x', 100)
+c:drop()
+
+-- Compression is immutable and memtx only.
+box.space._space:update(s.id, {{'=', 6, {compression = 'none'}}})
+s:drop()
+box.schema.space.create('test', {compression = 'lz4'})
+box.schema.space.create('test', {engine = 'vinyl', compression = 'zstd'})
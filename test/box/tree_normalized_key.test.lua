@@ -0,0 +1,82 @@
+--
+-- TREE index option normalized_key stores a memcmp-comparable
+-- prefix of the whole key in comparison hints. Check that an
+-- index built this way orders tuples the same way as a regular
+-- one and supports lookups by partial keys.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('n', {unique = false, normalized_key = true, parts = {{2, 'string'}, {3, 'integer'}, {4, 'string', is_nullable = true}}})
+_ = s:create_index('r', {unique = false, parts = {{2, 'string'}, {3, 'integer'}, {4, 'string', is_nullable = true}}})
+s.index.n.normalized_key
+s.index.r.normalized_key
+
+prefixes = {'', 'a', 'ab', 'abcdefgh', 'abcdefghij', 'ab\0c', 'b'}
+ints = {-1000000, -257, -256, -1, 0, 1, 255, 256, 1000000}
+test_run = require('test_run').new()
+test_run:cmd("setopt delimiter ';'")
+id = 0;
+for _, p in ipairs(prefixes) do
+    for _, i in ipairs(ints) do
+        for _, t in ipairs({box.NULL, '', 'x', 'xyz'}) do
+            id = id + 1
+            s:insert{id, p, i, t}
+        end
+    end
+end;
+function check(key, opts)
+    local a = s.index.n:select(key, opts)
+    local b = s.index.r:select(key, opts)
+    if #a ~= #b then
+        return false
+    end
+    for i = 1, #a do
+        if a[i] ~= b[i] then
+            return false
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+check()
+check({}, {iterator = 'REQ'})
+check({'ab'})
+check({'ab', -256})
+check({'ab', -256, box.NULL})
+check({'abcdefgh'}, {iterator = 'GT'})
+check({'abcdefghij', 1}, {iterator = 'LE'})
+check({'ab\0c', 0, 'x'}, {iterator = 'GE'})
+check({'ab\0c', 0, 'x'}, {iterator = 'LT'})
+s.index.n:count({'abcdefgh'})
+s.index.n:count({'ab', 256})
+
+-- Changing a part type requires an index rebuild.
+s.index.n:alter({parts = {{2, 'string'}, {3, 'number'}, {4, 'string', is_nullable = true}}})
+check()
+s.index.n:alter({normalized_key = false})
+s.index.n.normalized_key == nil
+check()
+s.index.n:alter({normalized_key = true})
+check({'ab'}, {iterator = 'GE'})
+
+-- Collations.
+c = box.schema.space.create('coll')
+_ = c:create_index('pk', {parts = {{1, 'string', collation = 'unicode_ci'}, {2, 'unsigned'}}, normalized_key = true})
+_ = c:insert{'Ab', 1}
+_ = c:insert{'aB', 2}
+_ = c:insert{'ab', 0}
+_ = c:insert{'a', 5}
+_ = c:insert{'B', 0}
+c:select()
+c:select({'AB'})
+c:drop()
+
+-- Unsupported configurations.
+s:create_index('h', {type = 'hash', normalized_key = true})
+s:create_index('mk', {unique = false, normalized_key = true, parts = {{5, 'unsigned', path = '[*]'}}})
+v = box.schema.space.create('v', {engine = 'vinyl'})
+v:create_index('pk', {normalized_key = true})
+v:drop()
+
+s:drop()
@@ -0,0 +1,71 @@
+-- TREE index option normalized_key on keys where the regular
+-- first-part hint is useless: a low-cardinality first part
+-- followed by strings sharing a prefix. Insert, lookup and scan
+-- rates with and without the option are written to the log.
+--
+-- The normalized prefix is 8 bytes long. Without a shared
+-- prefix the keys differ within it; with a long one they don't,
+-- and the option is expected to give no gain.
+test_run = require('test_run').new()
+fiber = require('fiber')
+log = require('log')
+
+ROWS = 200000
+LOOKUPS = 1000000
+
+test_run:cmd("setopt delimiter ';'")
+function key(prefix, i)
+    return {i % 4, prefix .. string.format('%06d', i)}
+end;
+function bench(normalized, prefix)
+    local s = box.schema.space.create('bench')
+    s:create_index('pk')
+    local sk = s:create_index('sk', {normalized_key = normalized,
+                                     parts = {{2, 'unsigned'},
+                                              {3, 'string'}}})
+    local name = string.format('%s, prefix %d',
+                               normalized and 'normalized' or 'regular',
+                               #prefix)
+    local start = fiber.clock()
+    box.begin()
+    for i = 1, ROWS do
+        local k = key(prefix, i)
+        s:insert{i, k[1], k[2]}
+        if i % 1000 == 0 then
+            box.commit()
+            box.begin()
+        end
+    end
+    box.commit()
+    log.info('tree normalized_key bench: %s %d inserts/s', name,
+             ROWS / (fiber.clock() - start))
+    local found = 0
+    start = fiber.clock()
+    for i = 1, LOOKUPS do
+        if sk:get(key(prefix, i % ROWS + 1)) ~= nil then
+            found = found + 1
+        end
+    end
+    log.info('tree normalized_key bench: %s %d lookups/s', name,
+             LOOKUPS / (fiber.clock() - start))
+    start = fiber.clock()
+    local scanned = 0
+    for part = 0, 3 do
+        for _ in sk:pairs({part, prefix}, {iterator = 'GE'}) do
+            scanned = scanned + 1
+            if scanned % (ROWS / 4) == 0 then
+                break
+            end
+        end
+    end
+    log.info('tree normalized_key bench: %s %d scanned/s', name,
+             scanned / (fiber.clock() - start))
+    s:drop()
+    return found == LOOKUPS and scanned == ROWS
+end;
+test_run:cmd("setopt delimiter ''");
+
+bench(false, '')
+bench(true, '')
+bench(false, string.rep('x', 16))
+bench(true, string.rep('x', 16))
@@ -34,45 +34,63 @@ tuple_bench(box_function_ctx_t *ctx, const char *args, const char *args_end)
 			      tuple_buf[2], tuple_buf[3]};
 	const uint64_t test_numbers[4] = {2, 2, 1, 3};
 	const char test_strings[4][4] = {"bce", "abb", "abb", "ccd"};
-	/* get key types from args, and build test tuples with according types*/
+	/*
+	 * Get key part types from args and build test keys of
+	 * the according types.
+	 */
 	uint32_t arg_count = mp_decode_array(&args);
 	if (arg_count < 1) {
 		return box_error_set(__FILE__, __LINE__, ER_PROC_C, "%s",
 			"invalid argument count");
 	}
 	uint32_t n = mp_decode_array(&args);
+	if (n > 4) {
+		return box_error_set(__FILE__, __LINE__, ER_PROC_C, "%s",
+			"at most 4 key parts are supported");
+	}
 	uint32_t knum = 0, kstr = 0;
 	for (uint32_t k = 0; k < 4; k++) {
 		const char *field = args;
 		tuple_end[k] = mp_encode_array(tuple_end[k], n);
-		for (uint32_t i = 0; i < n; i++, field += 3) {
-			if (mp_decode_strl(&field) != 3) {
-				say_error("Arguments must be \"STR\" or \"NUM\"");
-				return -1;
-			}
-			if (memcmp(field, "NUM", 3) == 0) {
+		for (uint32_t i = 0; i < n; i++) {
+			uint32_t len;
+			const char *type = mp_decode_str(&field, &len);
+			if (len == strlen("unsigned") &&
+			    memcmp(type, "unsigned", len) == 0) {
 				tuple_end[k] = mp_encode_uint(tuple_end[k],
 						test_numbers[knum]);
 				knum = (knum + 1) % 4;
-			} else if (memcmp(field, "STR", 3) == 0) {
+			} else if (len == strlen("integer") &&
+				   memcmp(type, "integer", len) == 0) {
+				tuple_end[k] = mp_encode_int(tuple_end[k],
+						-(int64_t)test_numbers[knum]);
+				knum = (knum + 1) % 4;
+			} else if (len == strlen("number") &&
+				   memcmp(type, "number", len) == 0) {
+				tuple_end[k] = mp_encode_double(tuple_end[k],
+						test_numbers[knum] + 0.5);
+				knum = (knum + 1) % 4;
+			} else if (len == strlen("string") &&
+				   memcmp(type, "string", len) == 0) {
 				tuple_end[k] = mp_encode_str(tuple_end[k],
 						test_strings[kstr],
 						strlen(test_strings[kstr]));
 				kstr = (kstr + 1) % 4;
 			} else {
-				say_error("Arguments must be \"STR\" or \"NUM\"");
-				return -1;
+				return box_error_set(__FILE__, __LINE__,
+					ER_PROC_C, "%s", "Arguments must be "
+					"unsigned, integer, number or string");
 			}
 		}
 	}
 
 	double t = proctime();
 	box_tuple_t *tuple;
-	for (int i = 0; i < 80000000; i++) {
+	for (int i = 0; i < 20000000; i++) {
 		int k = (i  + (i >> 2) + (i >> 5) + 13) & 3;
 		box_index_min(space_id, index_id, tuple_buf[k], tuple_end[k], &tuple);
 	}
 	t = proctime() - t;
-	say_info("%lf\n", t);
+	say_info("%u parts: %lf", n, t);
 	return 0;
 }
@@ -7,26 +7,54 @@ c = net:new(os.getenv("LISTEN"))
 
 box.schema.func.create('tuple_bench', {language = "C"})
 box.schema.user.grant('guest', 'execute', 'function', 'tuple_bench')
-space = box.schema.space.create('tester')
-key_parts = {1, 'unsigned', 2, 'string'}
-_ = space:create_index('primary', {type = 'TREE', parts =  key_parts})
-box.schema.user.grant('guest', 'read,write', 'space', 'tester')
 
-box.space.tester:insert({1, "abc", 100})
-box.space.tester:insert({2, "bcd", 200})
-box.space.tester:insert({3, "ccd", 200})
+-- Key definition shapes to benchmark, one space per shape.
+shapes = {}
+table.insert(shapes, {'unsigned'})
+table.insert(shapes, {'string'})
+table.insert(shapes, {'integer'})
+table.insert(shapes, {'number'})
+table.insert(shapes, {'unsigned', 'string'})
+table.insert(shapes, {'integer', 'integer'})
+table.insert(shapes, {'string', 'integer'})
+table.insert(shapes, {'unsigned', 'unsigned', 'unsigned'})
+table.insert(shapes, {'unsigned', 'string', 'unsigned', 'string'})
+table.insert(shapes, {'string', 'string', 'string', 'string'})
+
+test_run = require('test_run').new()
+test_run:cmd("setopt delimiter ';'")
+function bench(key_types)
+    local space = box.schema.space.create('tester')
+    local parts = {}
+    for i, t in ipairs(key_types) do
+        table.insert(parts, {i, t})
+    end
+    space:create_index('primary', {type = 'TREE', parts = parts})
+    box.schema.user.grant('guest', 'read,write', 'space', 'tester')
+    local values = {
+        unsigned = {1, 2, 3},
+        integer = {-1, -2, -3},
+        number = {1.5, 2.5, 3.5},
+        string = {'abc', 'bcd', 'ccd'},
+    }
+    for i = 1, 3 do
+        local tuple = {}
+        for _, t in ipairs(key_types) do
+            table.insert(tuple, values[t][i])
+        end
+        space:insert(tuple)
+    end
+    c:call('tuple_bench', {key_types})
+    space:drop()
+end;
+test_run:cmd("setopt delimiter ''");
 
 prof = require('gperftools.cpu')
 prof.start('tuple.prof')
 
-key_types = {}
-for i = 1, #key_parts, 2 do table.insert(key_types, key_parts[i + 1]) end  
-
-c:call('tuple_bench', key_types)
+for _, key_types in ipairs(shapes) do bench(key_types) end
 
 prof.flush()
 prof.stop()
 
 box.schema.func.drop("tuple_bench")
-
-box.space.tester:drop()
@@ -0,0 +1,37 @@
+test_run = require('test_run').new()
+msgpack = require('msgpack')
+
+--
+-- Small tuples have a compact header without a 32-bit bsize.
+-- Check tuples on both sides of the compact header limits.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {{3, 'string'}, {2, 'unsigned'}}})
+test_run:cmd("setopt delimiter ';'")
+function check(len)
+    local str = string.rep('x', len)
+    local data = {1, len, str}
+    s:replace(data)
+    local t = s:get{1}
+    local r = box.tuple.new(data)
+    return t[3] == str and t:bsize() == #msgpack.encode(data) and
+           s.index.sk:get{str, len} == t and r:bsize() == t:bsize() and
+           r[3] == str
+end;
+test_run:cmd("setopt delimiter ''");
+bad = {}
+for len = 0, 300 do if not check(len) then table.insert(bad, len) end end
+bad
+s:len()
+s:drop()
+
+-- A big field map doesn't fit a compact header.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 2, 20 do s:create_index('i' .. i, {parts = {i, 'unsigned'}}) end
+t = {} for i = 1, 20 do t[i] = i end
+_ = s:insert(t)
+s.index.i20:get{20}
+s.index.i2:select{2}
+s:drop()
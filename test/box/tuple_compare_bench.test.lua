@@ -0,0 +1,82 @@
+-- TREE index inserts and lookups for the key shapes that have
+-- pre-compiled comparators: primary keys and nullable secondary
+-- keys merged with an unsigned primary key.
+-- The rates are written to the log; compare them with a build
+-- that lacks the comparators to see the gain.
+test_run = require('test_run').new()
+fiber = require('fiber')
+log = require('log')
+uuid = require('uuid')
+
+ROWS = 200000
+LOOKUPS = 1000000
+
+test_run:cmd("setopt delimiter ';'")
+values = {
+    unsigned = function(i) return i end,
+    integer = function(i) return i - ROWS / 2 end,
+    number = function(i) return i + 0.5 end,
+    string = function(i) return string.format('key%08d', i) end,
+    uuid = function(i) return uuid.fromstr(string.format(
+                       '00000000-0000-0000-0000-%012d', i)) end,
+};
+function bench(name, parts, nullable)
+    -- Nullable keys can only be secondary: field 1 is the
+    -- primary key then and the key parts follow it.
+    local s = box.schema.space.create('bench')
+    local base = nullable and 1 or 0
+    if nullable then
+        s:create_index('pk')
+    end
+    local idx_parts = {}
+    for i, t in ipairs(parts) do
+        table.insert(idx_parts, {base + i, t, is_nullable = nullable})
+    end
+    local idx = s:create_index('idx', {parts = idx_parts})
+    local function key(i)
+        local k = {}
+        for _, t in ipairs(parts) do
+            table.insert(k, values[t](i))
+        end
+        return k
+    end
+    local start = fiber.clock()
+    box.begin()
+    for i = 1, ROWS do
+        local k = key(i)
+        if nullable then
+            table.insert(k, 1, i)
+        end
+        s:insert(k)
+        if i % 1000 == 0 then
+            box.commit()
+            box.begin()
+        end
+    end
+    box.commit()
+    log.info('tuple compare bench: %s %d inserts/s', name,
+             ROWS / (fiber.clock() - start))
+    local found = 0
+    start = fiber.clock()
+    for i = 1, LOOKUPS do
+        if idx:get(key(i % ROWS + 1)) ~= nil then
+            found = found + 1
+        end
+    end
+    log.info('tuple compare bench: %s %d lookups/s', name,
+             LOOKUPS / (fiber.clock() - start))
+    s:drop()
+    return found == LOOKUPS
+end;
+test_run:cmd("setopt delimiter ''");
+
+bench('unsigned', {'unsigned'}, false)
+bench('integer', {'integer'}, false)
+bench('number', {'number'}, false)
+bench('uuid', {'uuid'}, false)
+bench('integer, integer', {'integer', 'integer'}, false)
+bench('unsigned x4', {'unsigned', 'unsigned', 'unsigned', 'unsigned'}, false)
+bench('nullable unsigned', {'unsigned'}, true)
+bench('nullable string', {'string'}, true)
+bench('nullable uuid', {'uuid'}, true)
+bench('nullable string, unsigned', {'string', 'unsigned'}, true)
@@ -0,0 +1,24 @@
+--
+-- Named field access from Lua resolves a name or a JSON path
+-- once per tuple format.
+--
+s = box.schema.space.create('test', {format = {{'a', 'unsigned'}, {'b', 'string'}, {'c', 'map'}}})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {{'c.x', 'unsigned'}}})
+t = s:insert{1, 'x', {x = 10, y = {20, 30}}}
+t.a, t.b, t.c.x
+t['c.x'], t['c.y[2]'], t['[3].x'], t['[2]']
+t.d, t['a.b'], t['[10]'], t['c.z']
+-- Repeated access is served from the cache.
+check = true
+for i = 1, 3 do if t.a ~= 1 or t['c.x'] ~= 10 or t.b ~= 'x' then check = false end end
+check
+-- Methods are found if there is no such field.
+t:bsize() > 0
+t:totable()[1]
+
+-- Renamed fields are resolved anew.
+s:format({{'aa', 'unsigned'}, {'bb', 'string'}, {'c', 'map'}})
+t.a, t.aa, t.bb, t['c.x']
+s:get{1}.aa
+s:drop()
@@ -0,0 +1,75 @@
+test_run = require('test_run').new()
+errinj = box.error.injection
+
+--
+-- Updates which keep keys and tuple size are applied to the
+-- memtx tuple in place. Check that they are not observable.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {3, 'string'}})
+_ = s:insert{1, 0, 'a', 'xyz'}
+for i = 1, 10 do s:update(1, {{'+', 2, 1}}) end
+s:get{1}
+
+-- A tuple referenced from Lua stays the same.
+t = s:get{1}
+s:update(1, {{'+', 2, 1}})
+t
+s:get{1}
+t = nil
+collectgarbage()
+
+-- Secondary keys are updated as usual.
+s:update(1, {{'=', 3, 'b'}})
+s.index.sk:get{'a'}
+s.index.sk:get{'b'}
+s:update(1, {{'=', 4, 'zyx'}})
+s.index.sk:get{'b'}
+
+-- Failed WAL write restores the old data.
+errinj.set('ERRINJ_WAL_IO', true)
+s:update(1, {{'+', 2, 1}})
+s:update(1, {{'=', 4, 'abc'}})
+errinj.set('ERRINJ_WAL_IO', false)
+s:get{1}
+s.index.sk:select()
+
+-- A tuple got during the WAL write keeps the new data on
+-- rollback, the space gets the old data back.
+fiber = require('fiber')
+ch = fiber.channel(1)
+errinj.set('ERRINJ_WAL_DELAY', true)
+f = fiber.create(function() ch:put({pcall(s.update, s, 1, {{'+', 2, 1}})}) end)
+t = s:get{1}
+t
+errinj.set('ERRINJ_WAL_IO', true)
+errinj.set('ERRINJ_WAL_DELAY', false)
+r = ch:get()
+r[1], tostring(r[2])
+errinj.set('ERRINJ_WAL_IO', false)
+t
+s:get{1}
+s.index.sk:get{'b'}
+t = nil
+
+-- Triggers see both tuples.
+old_new = nil
+_ = s:on_replace(function(old, new) old_new = {old, new} end)
+s:update(1, {{'+', 2, 1}})
+old_new
+_ = s:on_replace(nil, s:on_replace()[1])
+
+-- So do on_commit triggers of a transaction.
+box.begin() s:update(1, {{'+', 2, 1}}) box.on_commit(function(it) for _, old, new in it() do old_new = {old, new} end end) box.commit()
+old_new
+
+-- A checkpoint in progress keeps the old data.
+errinj.set('ERRINJ_SNAP_WRITE_DELAY', true)
+f = require('fiber').create(function() box.snapshot() end)
+s:update(1, {{'+', 2, 1}})
+s:get{1}
+errinj.set('ERRINJ_SNAP_WRITE_DELAY', false)
+test_run:wait_cond(function() return f:status() == 'dead' end)
+
+s:drop()
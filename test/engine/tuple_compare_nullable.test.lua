@@ -0,0 +1,60 @@
+--
+-- Pre-compiled comparators of nullable keys: NULLs go first,
+-- NULL != NULL in unique indexes, a missing optional field is
+-- NULL.
+--
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+uuid = require('uuid')
+
+test_run:cmd("setopt delimiter ';'")
+function ids(tuples)
+    local res = {}
+    for _, t in ipairs(tuples) do
+        table.insert(res, t[1])
+    end
+    return res
+end;
+function check(type, values)
+    local s = box.schema.space.create('test', {engine = engine})
+    s:create_index('pk')
+    local u = s:create_index('u', {parts = {{2, type, is_nullable = true}}})
+    local n = s:create_index('n', {parts = {{2, type, is_nullable = true}},
+                                   unique = false})
+    s:insert{1, values[3]}
+    s:insert{2, values[2]}
+    s:insert{3, values[1]}
+    s:insert{4, box.NULL}
+    s:insert{5}
+    s:insert{6, box.NULL}
+    local ok = pcall(s.insert, s, {7, values[1]})
+    local res = {ids(u:select{}), ids(n:select{}), ids(u:select{box.NULL}),
+                 ids(u:select({values[2]}, {iterator = 'GE'})),
+                 ids(n:select({box.NULL}, {iterator = 'GT'})), ok}
+    s:drop()
+    return unpack(res)
+end;
+test_run:cmd("setopt delimiter ''");
+
+check('unsigned', {1, 2, 3})
+check('string', {'a', 'b', 'c'})
+check('integer', {-2, 0, 2})
+check('number', {-1.5, 0, 2.5})
+check('uuid', {uuid.fromstr('00000000-0000-0000-0000-000000000001'), uuid.fromstr('00000000-0000-0000-0000-000000000002'), uuid.fromstr('00000000-0000-0000-0000-000000000003')})
+
+-- Two nullable parts: the primary key is compared only if one
+-- of the unique parts is NULL.
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {{2, 'string', is_nullable = true}, {3, 'unsigned', is_nullable = true}}})
+_ = s:insert{1, 'a', 1}
+_ = s:insert{2, 'a', box.NULL}
+_ = s:insert{3, 'a', box.NULL}
+_ = s:insert{4, box.NULL, 1}
+_ = s:insert{5, 'a'}
+s:insert{6, 'a', 1}
+ids(sk:select{})
+ids(sk:select{'a'})
+ids(sk:select{'a', box.NULL})
+ids(sk:select({'a', 0}, {iterator = 'GT'}))
+s:drop()
@@ -0,0 +1,13 @@
+#!/usr/bin/env tarantool
+
+-- Start the console first to allow test-run to attach even before
+-- box.cfg is finished.
+require('console').listen(os.getenv('ADMIN'))
+
+box.cfg({
+    listen                   = os.getenv("LISTEN"),
+    replication              = os.getenv("MASTER"),
+    memtx_memory             = 107374182,
+    replication_timeout      = 0.1,
+    replication_space_filter = {tonumber(arg[1])},
+})
@@ -0,0 +1,37 @@
+test_run = require('test_run').new()
+
+--
+-- Relay-side filtering of replicated spaces. Changes of user
+-- spaces missing in box.cfg.replication_space_filter of the
+-- replica are relayed as NOPs, which still promote the vclock.
+--
+box.schema.user.grant('guest', 'replication')
+a = box.schema.space.create('a')
+_ = a:create_index('pk')
+b = box.schema.space.create('b')
+_ = b:create_index('pk')
+
+test_run:cmd('create server replica with rpl_master=default, script "replication/replica_space_filter.lua"')
+test_run:cmd(string.format('start server replica with args="%d"', a.id))
+
+for i = 1, 10 do a:insert{i} b:insert{i} end
+-- Schema changes are always relayed.
+c = box.schema.space.create('c')
+test_run:wait_lsn('replica', 'default')
+
+test_run:cmd('switch replica')
+box.space.a:count()
+box.space.b:count()
+box.space.c ~= nil
+box.cfg{replication_space_filter = {}}
+test_run:cmd('switch default')
+
+-- Cleanup.
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+test_run:cleanup_cluster()
+a:drop()
+b:drop()
+c:drop()
+box.schema.user.revoke('guest', 'replication')
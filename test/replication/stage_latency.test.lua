@@ -0,0 +1,54 @@
+test_run = require('test_run').new()
+
+--
+-- Per-stage replication latencies in box.info.replication.
+--
+box.schema.user.grant('guest', 'replication')
+test_run:cmd('create server replica with rpl_master=default, script "replication/replica.lua"')
+test_run:cmd('start server replica')
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} end
+test_run:wait_lsn('replica', 'default')
+
+d = box.info.replication[2].downstream.latency
+type(d.read.p50), type(d.read.p99), type(d.send.p50), type(d.send.p99)
+d.read.p99 >= d.read.p50, d.send.p99 >= d.send.p50
+-- The replica acknowledges the rows it has written.
+test_run:wait_cond(function() return box.info.replication[2].downstream.latency.ack.p99 > 0 end)
+d = box.info.replication[2].downstream.latency
+d.ack.p99 >= d.ack.p50
+
+test_run:cmd('switch replica')
+u = box.info.replication[1].upstream.latency
+type(u.apply.p50), type(u.apply.p99), type(u.wal.p50), type(u.wal.p99)
+u.apply.p99 >= u.apply.p50, u.wal.p99 >= u.wal.p50
+test_run:cmd('switch default')
+
+-- box.stat.replication() shows the same latencies.
+r = box.stat.replication()[2]
+type(r.read.p99), type(r.send.p99), type(r.ack.p99), r.apply == nil
+
+-- A slow stage shows up in its percentile.
+test_run:cmd('switch replica')
+box.error.injection.set('ERRINJ_WAL_DELAY', true)
+test_run:cmd('switch default')
+_ = s:insert{11}
+test_run:cmd('switch replica')
+fiber = require('fiber')
+fiber.sleep(0.5)
+box.error.injection.set('ERRINJ_WAL_DELAY', false)
+test_run:wait_cond(function() return box.space.test:get{11} ~= nil end)
+u = box.stat.replication()[1]
+u.wal.p99 >= 0.2, u.wal.p50 < 0.2
+box.info.replication[1].upstream.latency.wal.p99 == u.wal.p99
+test_run:cmd('switch default')
+
+-- Cleanup.
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
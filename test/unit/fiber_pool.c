@@ -0,0 +1,153 @@
+#include "memory.h"
+#include "fiber.h"
+#include "fiber_pool.h"
+#include "cbus.h"
+#include "unit.h"
+
+/**
+ * Test scheduling of messages by classes in a fiber pool: slow
+ * messages of a class limited to a few fibers must not delay
+ * fast messages of another class.
+ */
+
+enum {
+	/** Number of messages of each class. */
+	MSG_COUNT = 10,
+	/** The limit on fibers working on slow messages. */
+	SLOW_MAX_SIZE = 2,
+};
+
+enum { CLASS_FAST, CLASS_SLOW, CLASS_COUNT };
+
+static struct fiber_pool pool;
+/** Worker thread sending messages to the pool. */
+static struct cord worker;
+static struct cpipe pipe_to_worker;
+static struct cpipe pipe_to_main;
+
+static struct cmsg slow_msg[MSG_COUNT];
+static struct cmsg fast_msg[MSG_COUNT];
+
+static int slow_running = 0;
+static int slow_running_max = 0;
+static int slow_done = 0;
+static int fast_done = 0;
+/** Number of slow messages done when the last fast one is. */
+static int slow_done_before_fast = -1;
+static struct fiber_cond done_cond;
+
+static void
+slow_f(struct cmsg *m)
+{
+	(void) m;
+	slow_running++;
+	if (slow_running > slow_running_max)
+		slow_running_max = slow_running;
+	fiber_sleep(0.01);
+	slow_running--;
+	slow_done++;
+	fiber_cond_signal(&done_cond);
+}
+
+static void
+fast_f(struct cmsg *m)
+{
+	(void) m;
+	if (++fast_done == MSG_COUNT)
+		slow_done_before_fast = slow_done;
+	fiber_cond_signal(&done_cond);
+}
+
+static const struct cmsg_hop slow_route[] = {
+	{ slow_f, NULL },
+};
+
+static const struct cmsg_hop fast_route[] = {
+	{ fast_f, NULL },
+};
+
+static int
+classify(struct cmsg *m)
+{
+	return m->route == slow_route ? CLASS_SLOW : CLASS_FAST;
+}
+
+static int
+worker_f(va_list ap)
+{
+	(void) ap;
+	cpipe_create(&pipe_to_main, "main");
+	/* Slow messages come first. */
+	for (int i = 0; i < MSG_COUNT; i++) {
+		cmsg_init(&slow_msg[i], slow_route);
+		cpipe_push(&pipe_to_main, &slow_msg[i]);
+	}
+	for (int i = 0; i < MSG_COUNT; i++) {
+		cmsg_init(&fast_msg[i], fast_route);
+		cpipe_push(&pipe_to_main, &fast_msg[i]);
+	}
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "worker", fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&pipe_to_main);
+	return 0;
+}
+
+static int
+main_f(va_list ap)
+{
+	(void) ap;
+	fiber_cond_create(&done_cond);
+	fiber_pool_create(&pool, "main", 100, FIBER_POOL_IDLE_TIMEOUT);
+	fiber_pool_set_classifier(&pool, CLASS_COUNT, classify);
+	fiber_pool_set_class(&pool, CLASS_FAST, 4, 0);
+	fiber_pool_set_class(&pool, CLASS_SLOW, 1, SLOW_MAX_SIZE);
+	fiber_pool_use_classes(&pool, true);
+
+	fail_if(cord_costart(&worker, "worker", worker_f, NULL) != 0);
+	cpipe_create(&pipe_to_worker, "worker");
+	while (slow_done + fast_done < 2 * MSG_COUNT)
+		fiber_cond_wait(&done_cond);
+
+	is(slow_running_max, SLOW_MAX_SIZE, "slow class is limited");
+	ok(slow_done_before_fast < MSG_COUNT, "fast class is not delayed");
+	is((int) pool.classes[CLASS_FAST].total, MSG_COUNT, "fast total");
+	is((int) pool.classes[CLASS_SLOW].total, MSG_COUNT, "slow total");
+	ok(fiber_pool_class_queue_time(&pool.classes[CLASS_SLOW], 99) >= 0.01,
+	   "slow messages wait in the queue");
+	ok(fiber_pool_class_queue_time(&pool.classes[CLASS_FAST], 50) < 0.01,
+	   "fast messages do not wait");
+	fiber_pool_reset_stat(&pool);
+	is((int) pool.classes[CLASS_SLOW].total, 0, "reset stat");
+
+	cbus_stop_loop(&pipe_to_worker);
+	cpipe_destroy(&pipe_to_worker);
+	fail_if(cord_join(&worker) != 0);
+	fiber_pool_destroy(&pool);
+	fiber_cond_destroy(&done_cond);
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
+int
+main()
+{
+	header();
+	plan(7);
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	cbus_init();
+	struct fiber *main_fiber = fiber_new("main", main_f);
+	assert(main_fiber != NULL);
+	fiber_wakeup(main_fiber);
+	ev_run(loop(), 0);
+	cbus_free();
+	fiber_free();
+	memory_free();
+
+	int rc = check_plan();
+	footer();
+	return rc;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2010-2021, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unit.h"
+#include "msgpuck.h"
+#include "mp_scan.h"
+
+enum { BUF_SIZE = 64 * 1024 };
+
+static char buf[BUF_SIZE];
+
+/** Tuple shapes which are common in real spaces. */
+enum shape {
+	/** Only small integers, nil and booleans. */
+	SHAPE_SMALL,
+	/** Small integers interleaved with short strings. */
+	SHAPE_MIXED,
+	/** Large integers and doubles only. */
+	SHAPE_WIDE,
+	/** Small integers with nested arrays and maps. */
+	SHAPE_NESTED,
+	shape_MAX,
+};
+
+static const char *shape_strs[] = {"small", "mixed", "wide", "nested"};
+
+static char *
+encode_value(char *data, enum shape shape, unsigned i)
+{
+	switch (shape) {
+	case SHAPE_SMALL:
+		switch (i % 5) {
+		case 0: return mp_encode_nil(data);
+		case 1: return mp_encode_bool(data, i % 2 == 0);
+		case 2: return mp_encode_int(data, -(int64_t)(i % 32) - 1);
+		default: return mp_encode_uint(data, i % 128);
+		}
+	case SHAPE_MIXED:
+		if (i % 4 == 3)
+			return mp_encode_str(data, "tarantool", i % 10);
+		return mp_encode_uint(data, i % 100);
+	case SHAPE_WIDE:
+		if (i % 2 == 0)
+			return mp_encode_double(data, i * 1.5);
+		return mp_encode_uint(data, UINT32_MAX + (uint64_t)i);
+	case SHAPE_NESTED:
+		if (i % 7 == 6) {
+			data = mp_encode_array(data, 3);
+			data = mp_encode_uint(data, i % 128);
+			data = mp_encode_map(data, 1);
+			data = mp_encode_uint(data, 1);
+			data = mp_encode_nil(data);
+			return mp_encode_array(data, 0);
+		}
+		return mp_encode_uint(data, i % 128);
+	default:
+		unreachable();
+	}
+	return data;
+}
+
+/** Encode an array of @a count values of @a shape. */
+static const char *
+encode_tuple(enum shape shape, uint32_t count, const char **end)
+{
+	char *data = mp_encode_array(buf, count);
+	for (uint32_t i = 0; i < count; i++)
+		data = encode_value(data, shape, i);
+	*end = data;
+	return buf;
+}
+
+static void
+test_next(void)
+{
+	header();
+	const uint32_t counts[] = {1, 7, 8, 31, 100, 1000};
+	plan(shape_MAX * lengthof(counts));
+	for (int shape = 0; shape < shape_MAX; shape++) {
+		for (unsigned j = 0; j < lengthof(counts); j++) {
+			const char *end;
+			const char *data = encode_tuple(shape, counts[j], &end);
+			mp_decode_array(&data);
+			bool match = true;
+			for (uint32_t skip = 0; skip <= counts[j]; skip++) {
+				const char *a = data, *b = data;
+				mp_scan_next(&a, skip);
+				for (uint32_t k = 0; k < skip; k++)
+					mp_next(&b);
+				if (a != b)
+					match = false;
+			}
+			ok(match, "next %s %u", shape_strs[shape], counts[j]);
+		}
+	}
+	check_plan();
+	footer();
+}
+
+static void
+test_check(void)
+{
+	header();
+	const uint32_t counts[] = {0, 1, 15, 16, 33, 500};
+	plan(2 * shape_MAX * lengthof(counts));
+	for (int shape = 0; shape < shape_MAX; shape++) {
+		for (unsigned j = 0; j < lengthof(counts); j++) {
+			const char *end;
+			const char *data = encode_tuple(shape, counts[j], &end);
+			const char *pos = data;
+			is(mp_scan_check(&pos, end) == 0 && pos == end, true,
+			   "check %s %u", shape_strs[shape], counts[j]);
+			/* Every truncation must be detected. */
+			bool match = true;
+			for (const char *e = data; e < end; e++) {
+				const char *a = data, *b = data;
+				int rc = mp_scan_check(&a, e);
+				if (rc != mp_check(&b, e) || rc == 0)
+					match = false;
+			}
+			ok(match, "truncated %s %u", shape_strs[shape], counts[j]);
+		}
+	}
+	check_plan();
+	footer();
+}
+
+static void
+test_invalid(void)
+{
+	header();
+	plan(4);
+
+	const char *data;
+	char *end = mp_encode_array(buf, 20);
+	for (int i = 0; i < 19; i++)
+		end = mp_encode_uint(end, i);
+	/* A string header promising more bytes than there are. */
+	*end++ = (char)0xa5;
+	*end++ = 'a';
+	data = buf;
+	is(mp_scan_check(&data, end), 1, "truncated string after a run");
+
+	end = mp_encode_array(buf, 3);
+	end = mp_encode_uint(end, 1);
+	end = mp_encode_array(end, 2);
+	end = mp_encode_nil(end);
+	data = buf;
+	is(mp_scan_check(&data, end), 1, "truncated nested array");
+
+	end = mp_encode_map(buf, 17);
+	for (int i = 0; i < 17; i++) {
+		end = mp_encode_uint(end, i);
+		end = mp_encode_bool(end, true);
+	}
+	data = buf;
+	is(mp_scan_check(&data, end) == 0 && data == end, true,
+	   "map of single byte values");
+	/* The trailing value must not be consumed. */
+	end = mp_encode_uint(end, 1);
+	data = buf;
+	is(mp_scan_check(&data, end) == 0 && data == end - 1, true,
+	   "data after the value is untouched");
+
+	check_plan();
+	footer();
+}
+
+static double
+bench_clock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Compare the scanner with the plain msgpuck loops on the
+ * same tuple shapes. The numbers aren't stable, so they are
+ * printed only on demand: mp_scan.test bench
+ */
+static void
+bench(void)
+{
+	const uint32_t count = 64;
+	const int iterations = 1000000;
+	for (int shape = 0; shape < shape_MAX; shape++) {
+		const char *end;
+		const char *tuple = encode_tuple(shape, count, &end);
+		const char *volatile sink;
+		double t = bench_clock();
+		for (int i = 0; i < iterations; i++) {
+			const char *data = tuple;
+			mp_check(&data, end);
+			sink = data;
+		}
+		double check_plain = bench_clock() - t;
+		t = bench_clock();
+		for (int i = 0; i < iterations; i++) {
+			const char *data = tuple;
+			mp_scan_check(&data, end);
+			sink = data;
+		}
+		double check_scan = bench_clock() - t;
+		t = bench_clock();
+		for (int i = 0; i < iterations; i++) {
+			const char *data = tuple + 1;
+			for (uint32_t k = 0; k < count - 1; k++)
+				mp_next(&data);
+			sink = data;
+		}
+		double next_plain = bench_clock() - t;
+		t = bench_clock();
+		for (int i = 0; i < iterations; i++) {
+			const char *data = tuple + 1;
+			mp_scan_next(&data, count - 1);
+			sink = data;
+		}
+		double next_scan = bench_clock() - t;
+		(void)sink;
+		printf("%-8s check %.3fs -> %.3fs, next %.3fs -> %.3fs\n",
+		       shape_strs[shape], check_plain, check_scan,
+		       next_plain, next_scan);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	mp_scan_init();
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench();
+		return 0;
+	}
+
+	header();
+	plan(3);
+	test_next();
+	test_check();
+	test_invalid();
+	int rc = check_plan();
+	footer();
+	return rc;
+}
@@ -0,0 +1,121 @@
+#include <string.h>
+#include <unistd.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "shm_channel.h"
+#include "unit.h"
+
+enum { RING_SIZE = 128 };
+
+static struct shm_channel server;
+static struct shm_channel client;
+
+static void
+shm_channel_test_transfer(void)
+{
+	plan(5);
+	header();
+
+	char in[RING_SIZE * 2], out[RING_SIZE * 2];
+	for (size_t i = 0; i < sizeof(in); i++)
+		in[i] = i;
+
+	is(shm_channel_write(&client, in, 100), 100, "write");
+	is(shm_channel_read(&server, out, sizeof(out)), 100, "read");
+	ok(memcmp(in, out, 100) == 0, "data");
+
+	/* The ring wraps around. */
+	struct iovec iov[2] = {{in, 50}, {in + 50, 50}};
+	shm_channel_writev(&client, iov, 2);
+	size_t size = shm_channel_read(&server, out, 30);
+	size += shm_channel_read(&server, out + size, sizeof(out));
+	is(size, 100, "read wrapped");
+	ok(memcmp(in, out, 100) == 0, "wrapped data");
+
+	footer();
+	check_plan();
+}
+
+static void
+shm_channel_test_wait(void)
+{
+	plan(10);
+	header();
+
+	char buf[RING_SIZE * 2];
+	memset(buf, 0, sizeof(buf));
+
+	ok(shm_channel_prepare_read_wait(&server), "reader waits on empty");
+	ok(!shm_channel_peer_waits_data(&server), "no waiting client");
+	shm_channel_write(&client, buf, 1);
+	ok(shm_channel_peer_waits_data(&client), "wake up reader");
+	ok(!shm_channel_peer_waits_data(&client), "wake up once");
+	ok(!shm_channel_prepare_read_wait(&server), "don't wait on data");
+	shm_channel_read(&server, buf, 1);
+
+	is(shm_channel_write(&server, buf, sizeof(buf)), RING_SIZE,
+	   "write till full");
+	is(shm_channel_write(&server, buf, 1), 0, "write to full");
+	ok(shm_channel_prepare_write_wait(&server, 1), "writer waits on full");
+	shm_channel_read(&client, buf, 1);
+	ok(shm_channel_peer_waits_space(&client), "wake up writer");
+	shm_channel_read(&client, buf, sizeof(buf));
+	ok(!shm_channel_prepare_write_wait(&server, RING_SIZE),
+	   "don't wait on space");
+
+	footer();
+	check_plan();
+}
+
+static void
+shm_channel_test_notify(void)
+{
+	plan(5);
+	header();
+
+	int fd = shm_notify_create();
+	ok(fd >= 0, "notify create");
+	uint64_t value;
+	shm_notify_signal(fd);
+	shm_notify_signal(fd);
+	is(read(fd, &value, sizeof(value)), sizeof(value), "signalled");
+	shm_notify_signal(fd);
+	shm_notify_clear(fd);
+	is(read(fd, &value, sizeof(value)), -1, "cleared");
+	close(fd);
+
+	ok(!shm_channel_is_closed(&server), "open");
+	shm_channel_close(&client);
+	ok(shm_channel_is_closed(&server), "closed");
+
+	footer();
+	check_plan();
+}
+
+int
+main(void)
+{
+	plan(4);
+	memory_init();
+	fiber_init(fiber_c_invoke);
+
+	int fd;
+	int rc = shm_channel_create(&server, RING_SIZE, &fd);
+	if (rc == 0) {
+		rc = shm_channel_attach(&client, fd);
+		close(fd);
+	}
+	ok(rc == 0, "create and attach");
+	if (rc == 0) {
+		shm_channel_test_transfer();
+		shm_channel_test_wait();
+		shm_channel_test_notify();
+		shm_channel_destroy(&client);
+		shm_channel_destroy(&server);
+	}
+
+	fiber_free();
+	memory_free();
+	return check_plan();
+}
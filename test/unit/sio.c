@@ -33,7 +33,11 @@
 #include "fiber.h"
 #include <sys/un.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include "sio.h"
+#include "evio.h"
+#include <unistd.h>
 
 static void
 check_uri_to_addr(void)
@@ -109,6 +113,104 @@ check_auto_bind(void)
 	footer();
 }
 
+static void
+check_accept_nonblock(void)
+{
+	header();
+	plan(4);
+
+	bool is_host_empty;
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	sio_uri_to_addr("127.0.0.1:0", (struct sockaddr *) &addr,
+			&is_host_empty);
+	int fd = sio_socket(AF_INET, SOCK_STREAM, 0);
+	sio_bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+	sio_getsockname(fd, (struct sockaddr *) &addr, &addrlen);
+	sio_listen(fd);
+	sio_setfl(fd, O_NONBLOCK, 1);
+
+	addrlen = sizeof(addr);
+	int rc = sio_accept_nonblock(fd, (struct sockaddr *) &addr, &addrlen);
+	ok(rc < 0 && sio_wouldblock(errno), "no connections to accept");
+
+	int client = sio_socket(AF_INET, SOCK_STREAM, 0);
+	is(sio_connect(client, (struct sockaddr *) &addr, sizeof(addr)), 0,
+	   "connect");
+	addrlen = sizeof(addr);
+	int accepted = sio_accept_nonblock(fd, (struct sockaddr *) &addr,
+					   &addrlen);
+	ok(accepted >= 0, "accept");
+	ok((sio_getfl(accepted) & O_NONBLOCK) != 0,
+	   "accepted socket is non-blocking");
+
+	close(accepted);
+	close(client);
+	close(fd);
+	check_plan();
+	footer();
+}
+
+static int
+evio_accept_cb(struct evio_service *service, int fd, struct sockaddr *addr,
+	       socklen_t addrlen)
+{
+	(void) addr;
+	(void) addrlen;
+	*(int *) service->on_accept_param = fd;
+	return 0;
+}
+
+static int
+getsockopt_int(int fd, int level, int name)
+{
+	int value = 0;
+	socklen_t len = sizeof(value);
+	if (getsockopt(fd, level, name, &value, &len) != 0)
+		return -1;
+	return value;
+}
+
+static void
+check_evio_accept(void)
+{
+	header();
+	plan(5);
+
+	int accepted = -1;
+	struct evio_service service;
+	evio_service_init(loop(), &service, "test", evio_accept_cb,
+			  &accepted);
+	is(evio_service_bind(&service, "127.0.0.1:0"), 0, "bind");
+	is(evio_service_listen(&service), 0, "listen");
+
+	int client = sio_socket(AF_INET, SOCK_STREAM, 0);
+	sio_connect(client, &service.addr, service.addr_len);
+	while (accepted < 0)
+		ev_run(loop(), EVRUN_ONCE);
+
+	/*
+	 * The options are set on the accepted socket either
+	 * explicitly or by inheritance from the listening one.
+	 */
+	isnt(getsockopt_int(accepted, SOL_SOCKET, SO_KEEPALIVE), 0,
+	     "accepted socket has SO_KEEPALIVE");
+#ifdef __linux__
+	is(getsockopt_int(accepted, IPPROTO_TCP, TCP_KEEPIDLE), 30,
+	   "accepted socket has TCP_KEEPIDLE");
+#else
+	ok(true, "accepted socket has TCP_KEEPIDLE");
+#endif
+	isnt(getsockopt_int(accepted, IPPROTO_TCP, TCP_NODELAY), 0,
+	     "accepted socket has TCP_NODELAY");
+
+	close(accepted);
+	close(client);
+	evio_service_stop(&service);
+	check_plan();
+	footer();
+}
+
 int
 main(void)
 {
@@ -116,9 +218,11 @@ main(void)
 	fiber_init(fiber_c_invoke);
 
 	header();
-	plan(2);
+	plan(4);
 	check_uri_to_addr();
 	check_auto_bind();
+	check_accept_nonblock();
+	check_evio_accept();
 	int rc = check_plan();
 	footer();
 
@@ -242,6 +242,36 @@ test_xrow_header_encode_decode()
 	check_plan();
 }
 
+void
+test_xrow_header_decode_timeout()
+{
+	plan(3);
+	struct xrow_header header;
+	char buffer[64];
+	char *end = mp_encode_map(buffer, 1);
+	end = mp_encode_uint(end, IPROTO_TIMEOUT);
+	end = mp_encode_uint(end, 5);
+	const char *pos = buffer;
+	ok(xrow_header_decode(&header, &pos, end, true) == 0 &&
+	   header.timeout == 5, "integer timeout");
+
+	end = mp_encode_map(buffer, 1);
+	end = mp_encode_uint(end, IPROTO_TIMEOUT);
+	end = mp_encode_double(end, 0.5);
+	pos = buffer;
+	ok(xrow_header_decode(&header, &pos, end, true) == 0 &&
+	   header.timeout == 0.5, "double timeout");
+
+	end = mp_encode_map(buffer, 1);
+	end = mp_encode_uint(end, IPROTO_TIMEOUT);
+	end = mp_encode_str(end, "5", 1);
+	pos = buffer;
+	is(xrow_header_decode(&header, &pos, end, true), -1,
+	   "string timeout");
+
+	check_plan();
+}
+
 void
 test_request_str()
 {
@@ -280,13 +310,14 @@ main(void)
 {
 	memory_init();
 	fiber_init(fiber_c_invoke);
-	plan(3);
+	plan(4);
 
 	random_init();
 
 	test_iproto_constants();
 	test_greeting();
 	test_xrow_header_encode_decode();
+	test_xrow_header_decode_timeout();
 	test_request_str();
 
 	random_free();